@@ -0,0 +1,577 @@
+#!/usr/bin/env python3
+"""结果流上位机端 / 本地测试工具
+
+主机将每个导通结果包装为RESULT_STREAM_MSG(带序号)经UDP发出，上位机按序号
+发现缺口后发送NACK请求重传，空NACK用于查询主机下一个序号以发现尾部丢包。
+
+用法:
+  # 作为上位机接收真实主机的结果流
+  backend_stream.py backend --master 192.168.0.10 --loss 0.05
+
+  # 本机自测: 启动模拟主机(与固件ResultStream相同的历史环)和上位机，
+  # 注入丢包，统计吞吐和恢复情况
+  backend_stream.py selftest --count 20000 --size 256 --loss 0.05
+
+  # 查询主机缓存的最新结果，可按从机ID和驱动引脚范围过滤
+  backend_stream.py query --master 192.168.0.10 --id 0x12345678 --pins 0:16
+
+  # 查询主机运行诊断(堆、内存池、分配计数、lwIP、队列、任务栈)
+  backend_stream.py diag --master 192.168.0.10
+"""
+
+import argparse
+import collections
+import random
+import socket
+import struct
+import threading
+import time
+
+FRAME_DELIMITER = b"\xab\xcd"
+HEADER_SIZE = 7
+
+BACKEND2MASTER = 2
+MASTER2BACKEND = 3
+SLAVE2BACKEND = 4
+
+B2M_NACK = 0x04
+B2M_QUERY = 0x06
+B2M_DIAG = 0x07
+B2M_TRACE = 0x08
+M2B_NACK = 0x04
+M2B_QUERY = 0x06
+M2B_DIAG = 0x07
+M2B_TRACE = 0x08
+M2B_RESULT_STREAM = 0x20
+FLAG_RETRANSMIT = 0x01
+
+NACK_MAX_SEQS = 64
+
+
+def pack_frame(packet_id, payload):
+    return (FRAME_DELIMITER + struct.pack("<BBBH", packet_id, 0, 0,
+                                          len(payload)) + payload)
+
+
+def parse_frame(data):
+    """返回(packet_id, packet)，不是合法帧返回None"""
+    if len(data) < HEADER_SIZE or data[:2] != FRAME_DELIMITER:
+        return None
+    packet_id, _, _, length = struct.unpack_from("<BBBH", data, 2)
+    if len(data) < HEADER_SIZE + length:
+        return None
+    return packet_id, data[HEADER_SIZE:HEADER_SIZE + length]
+
+
+def pack_nack(seqs):
+    payload = struct.pack("<BB", B2M_NACK, len(seqs))
+    payload += b"".join(struct.pack("<I", s) for s in seqs)
+    return pack_frame(BACKEND2MASTER, payload)
+
+
+def pack_query(ids, pin_start=0, pin_num=0):
+    payload = struct.pack("<BB", B2M_QUERY, len(ids))
+    payload += b"".join(struct.pack("<I", i) for i in ids)
+    payload += struct.pack("<HH", pin_start, pin_num)
+    return pack_frame(BACKEND2MASTER, payload)
+
+
+QUERY_RECORD = struct.Struct("<IIIHHHHHHHH")
+
+
+def parse_query(body):
+    """解析QUERY_MSG应答负载(不含消息ID)，返回(cycle, match, records)"""
+    cycle, match, num = struct.unpack_from("<IBB", body)
+    pos = 6
+    records = []
+    for _ in range(num):
+        (slave_id, rcycle, age, status, ok, fail, retry, cond, pin_start,
+         pin_num, length) = QUERY_RECORD.unpack_from(body, pos)
+        pos += QUERY_RECORD.size
+        records.append(dict(id=slave_id, cycle=rcycle, age=age,
+                            status=status, ok=ok, fail=fail, retry=retry,
+                            cond=cond, pin_start=pin_start, pin_num=pin_num,
+                            data=body[pos:pos + length]))
+        pos += length
+    return cycle, match, records
+
+
+# 运行诊断快照，格式见Source/BSP/inc/bsp_diag.hpp
+(DIAG_HEAP, DIAG_POOL, DIAG_SUBSYS, DIAG_NET, DIAG_QUEUE, DIAG_TASK,
+ DIAG_CPU) = (0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40)
+DIAG_SUBSYSTEMS = ["other", "protocol", "uwb", "lwip", "json"]
+DIAG_TASK_STATES = ["running", "ready", "blocked", "suspended", "deleted"]
+
+
+def pack_diag(sections=0x7F):
+    return pack_frame(BACKEND2MASTER, struct.pack("<BB", B2M_DIAG, sections))
+
+
+def parse_diag(body):
+    """解析诊断快照，返回dict，只包含快照中带的部分"""
+    version, sections, uptime = struct.unpack_from("<BBI", body)
+    pos = 6
+    diag = dict(version=version, uptime=uptime)
+
+    def take(fmt):
+        nonlocal pos
+        values = struct.unpack_from("<" + fmt, body, pos)
+        pos += struct.calcsize("<" + fmt)
+        return values
+
+    def name(raw):
+        return raw.split(b"\0", 1)[0].decode("ascii", "replace")
+
+    if sections & DIAG_HEAP:
+        diag["heap"] = dict(zip(("free", "min_free", "total", "fallback"),
+                                take("IIII")))
+    if sections & DIAG_POOL:
+        num, = take("B")
+        diag["pools"] = [dict(zip(("block", "num", "used", "peak", "fail"),
+                                  take("HHHHI"))) for _ in range(num)]
+    if sections & DIAG_SUBSYS:
+        num, = take("B")
+        diag["subsys"] = []
+        for i in range(num):
+            allocs, size = take("II")
+            label = (DIAG_SUBSYSTEMS[i] if i < len(DIAG_SUBSYSTEMS) else
+                     str(i))
+            diag["subsys"].append(dict(name=label, allocs=allocs, bytes=size))
+    if sections & DIAG_NET:
+        valid, = take("B")
+        if valid:
+            diag["net"] = dict(zip(("mem_used", "mem_max", "mem_err",
+                                    "pbuf_used", "pbuf_max", "pbuf_err"),
+                                   take("IIHHHH")))
+    if sections & DIAG_QUEUE:
+        num, = take("B")
+        diag["queues"] = []
+        for _ in range(num):
+            raw, length, waiting, peak = take("8sHHH")
+            diag["queues"].append(dict(name=name(raw), length=length,
+                                       waiting=waiting, peak=peak))
+    if sections & DIAG_TASK:
+        num, = take("B")
+        diag["tasks"] = []
+        for _ in range(num):
+            raw, prio, state, stack_free = take("12sBBH")
+            diag["tasks"].append(dict(name=name(raw), prio=prio, state=state,
+                                      stack_free=stack_free))
+    if sections & DIAG_CPU:
+        valid, = take("B")
+        if valid:
+            window, isr_permille, num = take("IHB")
+            cpu = dict(window_us=window, isr=isr_permille / 10.0, isrs=[],
+                       tasks=[])
+            for _ in range(num):
+                raw, permille, count = take("8sHI")
+                cpu["isrs"].append(dict(name=name(raw), load=permille / 10.0,
+                                        count=count))
+            num, = take("B")
+            for _ in range(num):
+                raw, permille = take("12sH")
+                cpu["tasks"].append(dict(name=name(raw),
+                                         load=permille / 10.0))
+            diag["cpu"] = cpu
+    return diag
+
+
+def print_diag(diag, indent=""):
+    print("%suptime %.1fs" % (indent, diag["uptime"] / 1000.0))
+    if "heap" in diag:
+        h = diag["heap"]
+        print("%sheap free %d / %d, min ever %d, pool fallback %d" %
+              (indent, h["free"], h["total"], h["min_free"], h["fallback"]))
+    for p in diag.get("pools", []):
+        print("%spool %4d x %-3d used %3d peak %3d fail %d" %
+              (indent, p["block"], p["num"], p["used"], p["peak"], p["fail"]))
+    for s in diag.get("subsys", []):
+        print("%salloc %-8s %8d calls %10d bytes" %
+              (indent, s["name"], s["allocs"], s["bytes"]))
+    if "net" in diag:
+        n = diag["net"]
+        print("%slwip mem used %d max %d err %d, pbuf pool used %d max %d "
+              "err %d" % (indent, n["mem_used"], n["mem_max"], n["mem_err"],
+                          n["pbuf_used"], n["pbuf_max"], n["pbuf_err"]))
+    for q in diag.get("queues", []):
+        print("%squeue %-8s %4d/%-4d peak %d" %
+              (indent, q["name"], q["waiting"], q["length"], q["peak"]))
+    for t in diag.get("tasks", []):
+        state = (DIAG_TASK_STATES[t["state"]]
+                 if t["state"] < len(DIAG_TASK_STATES) else str(t["state"]))
+        print("%stask %-12s prio %2d %-9s stack free %d words" %
+              (indent, t["name"], t["prio"], state, t["stack_free"]))
+    if "cpu" in diag:
+        c = diag["cpu"]
+        print("%scpu window %.1fms, isr %.1f%%" %
+              (indent, c["window_us"] / 1000.0, c["isr"]))
+        for i in c["isrs"]:
+            print("%scpu isr  %-12s %5.1f%% %d calls" %
+                  (indent, i["name"], i["load"], i["count"]))
+        for t in c["tasks"]:
+            print("%scpu task %-12s %5.1f%%" % (indent, t["name"], t["load"]))
+
+
+def parse_cond_diag(result):
+    """从机导通数据帧末尾附带的诊断快照，没有时返回None"""
+    frame = parse_frame(result)
+    if frame is None or frame[0] != SLAVE2BACKEND or len(frame[1]) < 9:
+        return None
+    body = frame[1]
+    end = 9 + struct.unpack_from("<H", body, 7)[0]
+    if len(body) < end + 2:
+        return None
+    return struct.unpack_from("<I", body, 1)[0], parse_diag(body[end + 2:])
+
+
+class Backend:
+    """上位机端: 收结果流、发现缺口、发NACK"""
+
+    def __init__(self, sock, master_addr, loss=0.0, nack_interval=0.005,
+                 rto=0.1, probe_interval=0.2, show_diag=False):
+        self.sock = sock
+        self.master_addr = master_addr
+        self.loss = loss
+        self.nack_interval = nack_interval
+        self.rto = rto
+        self.probe_interval = probe_interval
+        self.show_diag = show_diag    # 打印从机附带的诊断快照
+
+        self.highest = -1
+        self.received = set()
+        self.missing = collections.OrderedDict()    # seq -> 上次请求时间
+        self.master_next = 0
+
+        self.results = 0
+        self.bytes = 0
+        self.dropped = 0
+        self.duplicates = 0
+        self.recovered = 0
+        self.unrecoverable = 0
+        self.nacks = 0
+        self.first_rx = None
+        self.last_rx = None
+        self.last_nack = 0.0
+
+    def on_datagram(self, data, now):
+        frame = parse_frame(data)
+        if frame is None or frame[0] != MASTER2BACKEND or not frame[1]:
+            return
+        msg_id, body = frame[1][0], frame[1][1:]
+        if msg_id == M2B_RESULT_STREAM and len(body) >= 5:
+            if random.random() < self.loss:
+                self.dropped += 1
+                return
+            seq, flags = struct.unpack_from("<IB", body)
+            self.on_result(seq, flags, body[5:], now)
+        elif msg_id == M2B_NACK and len(body) >= 5:
+            next_seq, num = struct.unpack_from("<IB", body)
+            self.master_next = max(self.master_next, next_seq)
+            self.mark_gap(next_seq - 1, now)
+            for i in range(num):
+                seq = struct.unpack_from("<I", body, 5 + i * 4)[0]
+                if self.missing.pop(seq, None) is not None:
+                    self.unrecoverable += 1
+
+    def on_result(self, seq, flags, result, now):
+        if seq in self.received:
+            self.duplicates += 1
+            return
+        if self.first_rx is None:
+            self.first_rx = now
+        self.last_rx = now
+        self.received.add(seq)
+        self.results += 1
+        self.bytes += len(result)
+        if self.show_diag:
+            slave = parse_cond_diag(result)
+            if slave is not None:
+                print("slave 0x%08X diag" % slave[0])
+                print_diag(slave[1], "  ")
+        if self.missing.pop(seq, None) is not None:
+            self.recovered += 1
+        self.mark_gap(seq - 1, now)
+        self.highest = max(self.highest, seq)
+
+    def mark_gap(self, upto, now):
+        for seq in range(self.highest + 1, upto + 1):
+            if seq not in self.received and seq not in self.missing:
+                # 首次发现的缺口立即可以请求
+                self.missing[seq] = now - self.rto
+        self.highest = max(self.highest, upto)
+
+    def poll(self, now):
+        if now - self.last_nack < self.nack_interval:
+            return
+        due = [s for s, t in self.missing.items() if now - t >= self.rto]
+        due = due[:NACK_MAX_SEQS]
+        # 空闲时发空NACK查询主机下一个序号，发现尾部丢包
+        idle = (self.last_rx is None or
+                now - self.last_rx >= self.probe_interval)
+        probe = idle and now - self.last_nack >= self.probe_interval
+        if not due and not probe:
+            return
+        for seq in due:
+            self.missing[seq] = now
+        self.sock.sendto(pack_nack(due), self.master_addr)
+        self.nacks += 1
+        self.last_nack = now
+
+    def done(self, count):
+        return self.results + self.unrecoverable >= count and not self.missing
+
+    def report(self):
+        elapsed = ((self.last_rx - self.first_rx)
+                   if self.first_rx is not None else 0.0) or 1e-9
+        print("results      %d (%.0f/s, %.2f MB/s)" %
+              (self.results, self.results / elapsed,
+               self.bytes / elapsed / 1e6))
+        print("injected     %d dropped" % self.dropped)
+        print("recovered    %d" % self.recovered)
+        print("unrecoverable %d" % self.unrecoverable)
+        print("duplicates   %d" % self.duplicates)
+        print("nacks sent   %d" % self.nacks)
+        print("outstanding  %d" % len(self.missing))
+
+    def run(self, deadline=None, count=None):
+        self.sock.settimeout(self.nack_interval)
+        while deadline is None or time.monotonic() < deadline:
+            try:
+                data, _ = self.sock.recvfrom(2048)
+                self.on_datagram(data, time.monotonic())
+            except socket.timeout:
+                pass
+            self.poll(time.monotonic())
+            if count is not None and self.done(count):
+                break
+
+
+class MasterStandIn:
+    """模拟主机，历史环与固件ResultStream一致: 条数和字节数双重限制"""
+
+    def __init__(self, sock, backend_addr, history_num=32,
+                 history_bytes=16 * 1024):
+        self.sock = sock
+        self.backend_addr = backend_addr
+        self.history_num = history_num
+        self.history_bytes = history_bytes
+        self.history = collections.OrderedDict()
+        self.bytes = 0
+        self.next_seq = 0
+        self.retransmits = 0
+        self.lock = threading.Lock()
+        self.running = True
+
+    def _send(self, seq, result, flags):
+        payload = struct.pack("<BIB", M2B_RESULT_STREAM, seq, flags) + result
+        self.sock.sendto(pack_frame(MASTER2BACKEND, payload),
+                         self.backend_addr)
+
+    def publish(self, result):
+        with self.lock:
+            seq = self.next_seq
+            self.next_seq += 1
+            while self.history and (
+                    len(self.history) >= self.history_num or
+                    self.bytes + len(result) > self.history_bytes):
+                _, old = self.history.popitem(last=False)
+                self.bytes -= len(old)
+            if len(result) <= self.history_bytes:
+                self.history[seq] = result
+                self.bytes += len(result)
+            self._send(seq, result, 0)
+
+    def on_nack(self, seqs):
+        lost = []
+        with self.lock:
+            for seq in seqs:
+                if seq in self.history:
+                    self._send(seq, self.history[seq], FLAG_RETRANSMIT)
+                    self.retransmits += 1
+                else:
+                    lost.append(seq)
+            payload = struct.pack("<BIB", M2B_NACK, self.next_seq, len(lost))
+            payload += b"".join(struct.pack("<I", s) for s in lost)
+            self.sock.sendto(pack_frame(MASTER2BACKEND, payload),
+                             self.backend_addr)
+
+    def serve(self):
+        self.sock.settimeout(0.05)
+        while self.running:
+            try:
+                data, _ = self.sock.recvfrom(2048)
+            except socket.timeout:
+                continue
+            frame = parse_frame(data)
+            if frame is None or frame[0] != BACKEND2MASTER:
+                continue
+            body = frame[1]
+            if len(body) < 2 or body[0] != B2M_NACK:
+                continue
+            num = body[1]
+            seqs = [struct.unpack_from("<I", body, 2 + i * 4)[0]
+                    for i in range(num)]
+            self.on_nack(seqs)
+
+
+def fake_result(seq, size):
+    # Slave2Backend导通数据帧: msg_id, slave_id, device_status, 数据
+    data = bytes((seq + i) & 0xFF for i in range(max(size - 7, 0)))
+    payload = struct.pack("<BIH", 0x00, 0x12345678, 0) + data
+    return pack_frame(SLAVE2BACKEND, payload)
+
+
+def make_socket(port=0):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 * 1024 * 1024)
+    sock.bind(("0.0.0.0" if port else "127.0.0.1", port))
+    return sock
+
+
+def cmd_backend(args):
+    sock = make_socket(args.port)
+    backend = Backend(sock, (args.master, args.port), loss=args.loss,
+                      rto=args.rto, show_diag=args.diag)
+    try:
+        backend.run()
+    except KeyboardInterrupt:
+        pass
+    backend.report()
+
+
+def cmd_selftest(args):
+    random.seed(args.seed)
+    master_sock = make_socket()
+    backend_sock = make_socket()
+    master = MasterStandIn(master_sock, backend_sock.getsockname(),
+                           history_num=args.history_num,
+                           history_bytes=args.history_bytes)
+    backend = Backend(backend_sock, master_sock.getsockname(),
+                      loss=args.loss, rto=args.rto)
+
+    server = threading.Thread(target=master.serve, daemon=True)
+    server.start()
+
+    def produce():
+        gap = 1.0 / args.rate if args.rate else 0.0
+        for seq in range(args.count):
+            master.publish(fake_result(seq, args.size))
+            if gap:
+                time.sleep(gap)
+
+    producer = threading.Thread(target=produce, daemon=True)
+    start = time.monotonic()
+    producer.start()
+    backend.run(deadline=start + args.timeout, count=args.count)
+    master.running = False
+    producer.join()
+
+    print("elapsed      %.2f s" % (time.monotonic() - start))
+    print("retransmits  %d" % master.retransmits)
+    backend.report()
+    # 每个序号要么送达，要么被主机明确告知已淘汰
+    ok = backend.done(args.count)
+    print("PASS" if ok else "FAIL")
+    return 0 if ok else 1
+
+
+def cmd_query(args):
+    sock = make_socket()
+    sock.settimeout(args.timeout)
+    ids = [int(i, 0) for i in args.id]
+    pin_start, pin_num = (int(v) for v in args.pins.split(":"))
+    sock.sendto(pack_query(ids, pin_start, pin_num), (args.master, args.port))
+    while True:
+        try:
+            data, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            print("no response")
+            return 1
+        frame = parse_frame(data)
+        # 跳过结果流等其他帧
+        if (frame is not None and frame[0] == MASTER2BACKEND and frame[1] and
+                frame[1][0] == M2B_QUERY):
+            break
+    cycle, match, records = parse_query(frame[1][1:])
+    print("master cycle %d, %d/%d slaves" % (cycle, len(records), match))
+    for r in records:
+        print("0x%08X cycle %d age %dms status 0x%04X ok %d fail %d "
+              "retry %d" % (r["id"], r["cycle"], r["age"], r["status"],
+                            r["ok"], r["fail"], r["retry"]))
+        # 每行为一个驱动引脚，列为本从机的导通线
+        bits = "".join("{:08b}".format(b) for b in r["data"])
+        for row in range(r["pin_num"]):
+            line = bits[row * r["cond"]:(row + 1) * r["cond"]]
+            print("  pin %4d  %s" % (r["pin_start"] + row, line))
+    return 0
+
+
+def cmd_diag(args):
+    sock = make_socket()
+    sock.settimeout(args.timeout)
+    sock.sendto(pack_diag(), (args.master, args.port))
+    while True:
+        try:
+            data, _ = sock.recvfrom(2048)
+        except socket.timeout:
+            print("no response")
+            return 1
+        frame = parse_frame(data)
+        if (frame is not None and frame[0] == MASTER2BACKEND and frame[1] and
+                frame[1][0] == M2B_DIAG):
+            break
+    print_diag(parse_diag(frame[1][1:]))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.
+                                     RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("backend", help="接收主机结果流")
+    p.add_argument("--master", required=True, help="主机IP")
+    p.add_argument("--port", type=int, default=8080)
+    p.add_argument("--loss", type=float, default=0.0, help="注入丢包率")
+    p.add_argument("--rto", type=float, default=0.1, help="重复请求间隔(s)")
+    p.add_argument("--diag", action="store_true",
+                   help="打印从机导通数据附带的诊断快照"
+                   "(从机以DIAG_SLAVE_PERIOD打开)")
+    p.set_defaults(func=cmd_backend)
+
+    p = sub.add_parser("selftest", help="本机模拟主机自测")
+    p.add_argument("--count", type=int, default=10000)
+    p.add_argument("--size", type=int, default=256, help="单个结果字节数")
+    p.add_argument("--rate", type=float, default=500,
+                   help="每秒结果数，0为不限速")
+    p.add_argument("--loss", type=float, default=0.05, help="注入丢包率")
+    p.add_argument("--rto", type=float, default=0.05)
+    p.add_argument("--history-num", type=int, default=32)
+    p.add_argument("--history-bytes", type=int, default=16 * 1024)
+    p.add_argument("--timeout", type=float, default=60)
+    p.add_argument("--seed", type=int, default=1)
+    p.set_defaults(func=cmd_selftest)
+
+    p = sub.add_parser("query", help="查询主机缓存的最新结果")
+    p.add_argument("--master", required=True, help="主机IP")
+    p.add_argument("--port", type=int, default=8080)
+    p.add_argument("--id", action="append", default=[],
+                   help="从机ID，可重复，缺省查询全部")
+    p.add_argument("--pins", default="0:0",
+                   help="驱动引脚范围 起始:数量，数量0为全部")
+    p.add_argument("--timeout", type=float, default=1.0)
+    p.set_defaults(func=cmd_query)
+
+    p = sub.add_parser("diag", help="查询主机运行诊断")
+    p.add_argument("--master", required=True, help="主机IP")
+    p.add_argument("--port", type=int, default=8080)
+    p.add_argument("--timeout", type=float, default=1.0)
+    p.set_defaults(func=cmd_diag)
+
+    args = parser.parse_args()
+    return args.func(args) or 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
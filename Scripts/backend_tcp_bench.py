@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+"""上位机TCP链路吞吐量测试客户端
+
+主机固件以CMake选项 -DBACKEND_TCP=ON -DBACKEND_TCP_BENCH=ON 编译后，
+持续通过TCP发送RESULT_STREAM_MSG帧。本脚本连接主机，按0xAB 0xCD帧分隔符
+从字节流中恢复帧，统计持续吞吐量并检查序号连续性。
+
+用法:
+  # 连接主机
+  backend_tcp_bench.py --host 192.168.0.10 --duration 30
+
+  # 本机自测: 启动模拟主机，按随机长度分段发送，验证分帧和统计
+  backend_tcp_bench.py --local --duration 5
+"""
+
+import argparse
+import random
+import socket
+import struct
+import threading
+import time
+
+FRAME_DELIMITER = b"\xab\xcd"
+HEADER_SIZE = 7
+MASTER2BACKEND = 3
+M2B_RESULT_STREAM = 0x20
+
+
+class FrameDecoder:
+    """与固件FrameDecoder一致: 分隔符或长度不合法时丢弃一个字节重新同步"""
+
+    def __init__(self, max_frame=64 * 1024):
+        self.max_frame = max_frame
+        self.buf = bytearray()
+        self.resyncs = 0
+
+    def feed(self, data):
+        self.buf += data
+        frames = []
+        pos = 0
+        while True:
+            start = self.buf.find(FRAME_DELIMITER, pos)
+            if start < 0:
+                # 保留可能是分隔符前半部分的最后一个字节
+                keep = 1 if self.buf.endswith(FRAME_DELIMITER[:1]) else 0
+                if len(self.buf) - keep > pos:
+                    self.resyncs += 1
+                pos = len(self.buf) - keep
+                break
+            if start > pos:
+                self.resyncs += 1
+            if len(self.buf) - start < HEADER_SIZE:
+                pos = start
+                break
+            length = struct.unpack_from("<H", self.buf, start + 5)[0]
+            need = HEADER_SIZE + length
+            if need > self.max_frame:
+                pos = start + 1
+                continue
+            if len(self.buf) - start < need:
+                pos = start
+                break
+            frames.append(bytes(self.buf[start:start + need]))
+            pos = start + need
+        del self.buf[:pos]
+        return frames
+
+
+class Stats:
+    def __init__(self):
+        self.frames = 0
+        self.bytes = 0
+        self.gaps = 0
+        self.last_seq = None
+
+    def add(self, frame):
+        self.frames += 1
+        self.bytes += len(frame)
+        if (len(frame) < HEADER_SIZE + 5 or frame[2] != MASTER2BACKEND or
+                frame[HEADER_SIZE] != M2B_RESULT_STREAM):
+            return
+        seq = struct.unpack_from("<I", frame, HEADER_SIZE + 1)[0]
+        if self.last_seq is not None and seq != (self.last_seq + 1) & 0xFFFFFFFF:
+            self.gaps += 1
+        self.last_seq = seq
+
+
+def run_client(host, port, duration, interval=1.0):
+    sock = socket.create_connection((host, port), timeout=5)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 1024 * 1024)
+    decoder = FrameDecoder()
+    stats = Stats()
+    start = last = time.monotonic()
+    last_bytes = 0
+    try:
+        while time.monotonic() - start < duration:
+            data = sock.recv(65536)
+            if not data:
+                print("connection closed by master")
+                break
+            for frame in decoder.feed(data):
+                stats.add(frame)
+            now = time.monotonic()
+            if now - last >= interval:
+                rate = (stats.bytes - last_bytes) / (now - last)
+                print("%6.1fs  %8.3f MB/s  frames %d  seq gaps %d" %
+                      (now - start, rate / 1e6, stats.frames, stats.gaps))
+                last, last_bytes = now, stats.bytes
+    except KeyboardInterrupt:
+        pass
+    finally:
+        sock.close()
+    elapsed = time.monotonic() - start
+    print("total %d frames, %d bytes in %.1fs: %.3f MB/s, %.0f frames/s" %
+          (stats.frames, stats.bytes, elapsed, stats.bytes / elapsed / 1e6,
+           stats.frames / elapsed))
+    print("seq gaps %d, resyncs %d" % (stats.gaps, decoder.resyncs))
+    return stats.gaps == 0 and decoder.resyncs == 0
+
+
+def local_master(listen, frame_size):
+    """模拟主机: 帧连续发送，每次send长度随机，覆盖帧被任意切分的情况"""
+    conn, _ = listen.accept()
+    body = bytes(i & 0xFF for i in range(frame_size - HEADER_SIZE - 6))
+    seq = 0
+    pending = bytearray()
+    try:
+        while True:
+            while len(pending) < 256 * 1024:
+                payload = struct.pack("<BIB", M2B_RESULT_STREAM, seq, 0) + body
+                pending += (FRAME_DELIMITER +
+                            struct.pack("<BBBH", MASTER2BACKEND, 0, 0,
+                                        len(payload)) + payload)
+                seq += 1
+            n = random.randint(1, 8192)
+            conn.sendall(pending[:n])
+            del pending[:n]
+    except OSError:
+        pass
+    finally:
+        conn.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.
+                                     RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1", help="主机IP")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--duration", type=float, default=30, help="测试时长(s)")
+    parser.add_argument("--local", action="store_true", help="连接本机模拟主机")
+    parser.add_argument("--frame-size", type=int, default=1024,
+                        help="模拟主机帧长度")
+    args = parser.parse_args()
+
+    if args.local:
+        listen = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        listen.bind(("127.0.0.1", 0))
+        listen.listen(1)
+        args.host, args.port = listen.getsockname()
+        threading.Thread(target=local_master, args=(listen, args.frame_size),
+                         daemon=True).start()
+
+    ok = run_client(args.host, args.port, args.duration)
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
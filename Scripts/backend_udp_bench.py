@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""上位机UDP链路延迟/吞吐量测试
+
+向主机发送带请求号的空NACK(REQUEST_MSG包装)，主机在解析任务中直接应答
+同一请求号的RESPONSE_MSG，不经过从机。一次往返覆盖主机的接收、解析和发送
+全路径，用于比较socket传输(默认)与原始UDP传输(CMake选项BACKEND_RAW_UDP)。
+
+  rtt: 逐个请求，统计往返延迟分布
+  pps: 保持固定数量的请求在途，统计每秒完成的请求数(每个请求收发各一个
+       数据报)
+
+用法:
+  # 分别烧录两种传输方式的固件，用相同参数测试后对比
+  backend_udp_bench.py rtt --master 192.168.0.10 --count 2000
+  backend_udp_bench.py pps --master 192.168.0.10 --window 4 --duration 10
+
+  # 本机自测: 连接模拟主机，验证脚本本身
+  backend_udp_bench.py rtt --local
+"""
+
+import argparse
+import socket
+import struct
+import threading
+import time
+
+from backend_stream import (BACKEND2MASTER, B2M_NACK, M2B_NACK,
+                            MASTER2BACKEND, make_socket, pack_frame,
+                            parse_frame)
+
+B2M_REQUEST = 0x05
+M2B_RESPONSE = 0x05
+
+
+def pack_request(req_id):
+    # 内层为空NACK: 消息ID + 序号数0
+    inner = struct.pack("<BB", B2M_NACK, 0)
+    payload = struct.pack("<BH", B2M_REQUEST, req_id) + inner
+    return pack_frame(BACKEND2MASTER, payload)
+
+
+def parse_response(data):
+    """返回应答的请求号，不是RESPONSE_MSG返回None"""
+    frame = parse_frame(data)
+    if (frame is None or frame[0] != MASTER2BACKEND or len(frame[1]) < 3 or
+            frame[1][0] != M2B_RESPONSE):
+        return None
+    return struct.unpack_from("<H", frame[1], 1)[0]
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p / 100.0))]
+
+
+def run_rtt(sock, addr, count, timeout):
+    sock.settimeout(timeout)
+    rtts = []
+    lost = 0
+    for i in range(count):
+        req_id = i & 0xFFFF
+        start = time.perf_counter()
+        sock.sendto(pack_request(req_id), addr)
+        while True:
+            try:
+                data, _ = sock.recvfrom(2048)
+            except socket.timeout:
+                lost += 1
+                break
+            # 跳过结果流等其他帧和超时请求的迟到应答
+            if parse_response(data) == req_id:
+                rtts.append(time.perf_counter() - start)
+                break
+    if not rtts:
+        print("no response")
+        return False
+    rtts.sort()
+    us = [r * 1e6 for r in rtts]
+    print("requests %d, lost %d" % (count, lost))
+    print("rtt us    min %.0f  avg %.0f  p50 %.0f  p99 %.0f  max %.0f" %
+          (us[0], sum(us) / len(us), percentile(us, 50), percentile(us, 99),
+           us[-1]))
+    return True
+
+
+def run_pps(sock, addr, window, duration, timeout):
+    sock.settimeout(timeout / 4)
+    inflight = {}    # 请求号 -> 发出时间
+    next_id = 0
+    done = 0
+    resent = 0
+    start = last = time.perf_counter()
+    last_done = 0
+    while True:
+        now = time.perf_counter()
+        if now - start >= duration:
+            break
+        while len(inflight) < window:
+            inflight[next_id] = now
+            sock.sendto(pack_request(next_id), addr)
+            next_id = (next_id + 1) & 0xFFFF
+        try:
+            data, _ = sock.recvfrom(2048)
+            if inflight.pop(parse_response(data), None) is not None:
+                done += 1
+        except socket.timeout:
+            pass
+        now = time.perf_counter()
+        # 超时的请求视为丢失，以新的请求号补发
+        for req_id in [r for r, t in inflight.items() if now - t >= timeout]:
+            del inflight[req_id]
+            resent += 1
+        if now - last >= 1.0:
+            print("%5.1fs  %8.0f req/s" % (now - start,
+                                           (done - last_done) / (now - last)))
+            last, last_done = now, done
+    elapsed = time.perf_counter() - start
+    print("window %d: %d requests in %.1fs, %.0f req/s, %.0f datagrams/s, "
+          "timeouts %d" % (window, done, elapsed, done / elapsed,
+                           2 * done / elapsed, resent))
+    return done > 0
+
+
+def local_master(sock):
+    """模拟主机: 对REQUEST_MSG包装的空NACK回复RESPONSE_MSG"""
+    while True:
+        data, addr = sock.recvfrom(2048)
+        frame = parse_frame(data)
+        if (frame is None or frame[0] != BACKEND2MASTER or
+                frame[1][0] != B2M_REQUEST):
+            continue
+        req_id = struct.unpack_from("<H", frame[1], 1)[0]
+        inner = struct.pack("<BIB", M2B_NACK, 0, 0)
+        payload = struct.pack("<BH", M2B_RESPONSE, req_id) + inner
+        sock.sendto(pack_frame(MASTER2BACKEND, payload), addr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.
+                                     RawDescriptionHelpFormatter)
+    parser.add_argument("mode", choices=["rtt", "pps"])
+    parser.add_argument("--master", default="127.0.0.1", help="主机IP")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--count", type=int, default=1000, help="rtt请求数")
+    parser.add_argument("--window", type=int, default=4, help="pps在途请求数")
+    parser.add_argument("--duration", type=float, default=10,
+                        help="pps测试时长(s)")
+    parser.add_argument("--timeout", type=float, default=0.5,
+                        help="单个请求超时(s)")
+    parser.add_argument("--local", action="store_true", help="连接本机模拟主机")
+    args = parser.parse_args()
+
+    addr = (args.master, args.port)
+    if args.local:
+        master = make_socket()
+        addr = master.getsockname()
+        threading.Thread(target=local_master, args=(master,),
+                         daemon=True).start()
+
+    # 主机回复发往最近一次发来数据的地址，本机端口与主机端口一致
+    sock = make_socket(0 if args.local else args.port)
+    if args.mode == "rtt":
+        ok = run_rtt(sock, addr, args.count, args.timeout)
+    else:
+        ok = run_pps(sock, addr, args.window, args.duration, args.timeout)
+    return 0 if ok else 1
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,214 @@
+/**
+ * 上位机json指令解析基准测试(主机端运行)
+ *
+ * 对比原DOM解析(json::accept + json::parse + 遍历 + dump回复)与
+ * JsonCmdSax单遍解析 + JsonRsp定长回复，在1~64个从机的配置指令下的
+ * 解析耗时和堆内存占用，并校验两者得到的CfgCmd和回复内容一致。
+ *
+ * 编译运行(仓库根目录):
+ *   g++ -O2 -std=c++17 -Wall -Wextra -ISource/Core/master \
+ *       -ISource/Middlewares/json/single_include/nlohmann \
+ *       Scripts/json_cmd_bench.cpp -o /tmp/json_cmd_bench
+ *   /tmp/json_cmd_bench [每组迭代次数]
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "json_cmd.hpp"
+
+using json = nlohmann::json;
+
+// 堆统计--------------------------------------------------------------
+static size_t g_heap_cur = 0;
+static size_t g_heap_peak = 0;
+static size_t g_heap_allocs = 0;
+
+void* operator new(size_t size) {
+    size_t* p = (size_t*)malloc(size + sizeof(size_t));
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    *p = size;
+    g_heap_cur += size;
+    g_heap_allocs++;
+    if (g_heap_cur > g_heap_peak) {
+        g_heap_peak = g_heap_cur;
+    }
+    return p + 1;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    size_t* p = (size_t*)ptr - 1;
+    g_heap_cur -= *p;
+    free(p);
+}
+
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+
+static void heap_reset() {
+    g_heap_peak = g_heap_cur;
+    g_heap_allocs = 0;
+}
+
+// 原DOM实现(与json_sorting.hpp改动前的DeviceConfigInst一致)-------------
+static std::string dom_config(const uint8_t* data, size_t len, CfgCmd* out,
+                              size_t& out_num) {
+    out_num = 0;
+    if (!json::accept(data, data + len)) {
+        return "";
+    }
+    json j = json::parse(data, data + len, nullptr, false);
+    if (j.is_discarded() || !j.contains("inst") || j["inst"] != DEV_CONF) {
+        return "";
+    }
+    if (j.contains("params")) {
+        auto params = j["params"];
+        uint16_t total = 0;
+        for (const auto& item : params) {
+            uint16_t num = item["cond"];
+            total += num;
+        }
+        size_t slave_num = params.size();
+        uint16_t start = 0;
+        for (const auto& item : params) {
+            CfgCmd& cfg = out[out_num];
+            memset(&cfg, 0, sizeof(cfg));
+            cfg.totalHarnessNum = total;
+            cfg.startHarnessNum = start;
+            cfg.slave_dev_num = slave_num;
+            cfg.is_last_dev = (out_num == slave_num - 1);
+            if (item.contains("id")) {
+                std::string id = item["id"];
+                JsonCmdSax::parseIdString(id.c_str(), cfg.id);
+            }
+            if (item.contains("cond")) {
+                cfg.cond = item["cond"];
+            }
+            if (item.contains("Z")) {
+                cfg.Z = item["Z"];
+            }
+            if (item.contains("clip")) {
+                auto& clip = item["clip"];
+                cfg.clip_exist = true;
+                if (clip.contains("mode")) {
+                    cfg.clip_mode = clip["mode"];
+                }
+                if (clip.contains("pin") && clip["pin"].is_string()) {
+                    std::string pin = clip["pin"];
+                    cfg.clip_pin = JsonCmdSax::hexStringToUint16(pin.c_str());
+                }
+            }
+            start += cfg.cond;
+            out_num++;
+        }
+    }
+    // 全部从机配置失败时的回复，失败id列表最长
+    json rsp;
+    rsp["status"] = STATUS_ERROR;
+    rsp["result"]["inst"] = DEV_CONF;
+    for (size_t i = 0; i < out_num; i++) {
+        char id[12];
+        snprintf(id, sizeof(id), "%02X-%02X-%02X-%02X", out[i].id[0],
+                 out[i].id[1], out[i].id[2], out[i].id[3]);
+        rsp["result"]["id"].push_back(std::string(id));
+    }
+    return rsp.dump();
+}
+
+// SAX实现-------------------------------------------------------------
+static uint8_t g_false_dev[PCinterface_JSON_MAX_SLAVES][4];
+
+static bool sax_config(JsonCmdSax& sax, JsonRsp& rsp, const uint8_t* data,
+                       size_t len) {
+    if (!sax.parse(data, len) || sax.inst != DEV_CONF) {
+        return false;
+    }
+    for (uint8_t i = 0; i < sax.slave_num; i++) {
+        memcpy(g_false_dev[i], sax.cfg[i].id, 4);
+    }
+    rsp.begin();
+    rsp.id_list(g_false_dev, sax.slave_num);
+    rsp.number("inst", DEV_CONF);
+    rsp.end(STATUS_ERROR);
+    return true;
+}
+
+static std::string make_config(int slaves) {
+    std::string s = "{\"inst\":0,\"params\":[";
+    char item[160];
+    for (int i = 0; i < slaves; i++) {
+        snprintf(item, sizeof(item),
+                 "%s{\"id\":\"%02X-%02X-%02X-%02X\",\"cond\":%d,\"Z\":%d,"
+                 "\"clip\":{\"mode\":%d,\"pin\":\"%04X\"}}",
+                 i ? "," : "", 0x10 + i, 0x20, 0x30, i, 64 + i, i % 8, i % 3,
+                 0x1000 + i);
+        s += item;
+    }
+    s += "]}";
+    return s;
+}
+
+int main(int argc, char** argv) {
+    int iters = argc > 1 ? atoi(argv[1]) : 2000;
+    static JsonCmdSax sax;
+    static JsonRsp rsp;
+    static CfgCmd dom_cfg[PCinterface_JSON_MAX_SLAVES];
+    bool all_ok = true;
+
+    printf("%6s %6s | %10s %9s %7s | %10s %9s %7s | %7s %s\n", "slaves",
+           "bytes", "dom us", "dom peak", "allocs", "sax us", "sax peak",
+           "allocs", "speedup", "match");
+    for (int slaves = 1; slaves <= PCinterface_JSON_MAX_SLAVES; slaves *= 2) {
+        std::string text = make_config(slaves);
+        const uint8_t* data = (const uint8_t*)text.data();
+        size_t len = text.size();
+
+        // 校验: 两种实现得到相同的指令和回复
+        size_t dom_num = 0;
+        std::string dom_rsp = dom_config(data, len, dom_cfg, dom_num);
+        bool ok = sax_config(sax, rsp, data, len) && dom_num == sax.slave_num;
+        for (size_t i = 0; ok && i < dom_num; i++) {
+            ok = memcmp(&dom_cfg[i], &sax.cfg[i], sizeof(CfgCmd)) == 0;
+        }
+        ok = ok && dom_rsp.size() == rsp.size() &&
+             memcmp(dom_rsp.data(), rsp.data(), rsp.size()) == 0;
+        all_ok = all_ok && ok;
+
+        heap_reset();
+        size_t base = g_heap_cur;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; i++) {
+            dom_config(data, len, dom_cfg, dom_num);
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        size_t dom_peak = g_heap_peak - base;
+        size_t dom_allocs = g_heap_allocs / iters;
+
+        heap_reset();
+        base = g_heap_cur;
+        auto t2 = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; i++) {
+            sax_config(sax, rsp, data, len);
+        }
+        auto t3 = std::chrono::steady_clock::now();
+        size_t sax_peak = g_heap_peak - base;
+        size_t sax_allocs = g_heap_allocs / iters;
+
+        double dom_us =
+            std::chrono::duration<double, std::micro>(t1 - t0).count() / iters;
+        double sax_us =
+            std::chrono::duration<double, std::micro>(t3 - t2).count() / iters;
+        printf("%6d %6zu | %10.2f %9zu %7zu | %10.2f %9zu %7zu | %6.2fx %s\n",
+               slaves, len, dom_us, dom_peak, dom_allocs, sax_us, sax_peak,
+               sax_allocs, dom_us / sax_us, ok ? "yes" : "NO");
+    }
+    return all_ok ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+"""延迟日志二进制流解码
+
+固件以CMake选项 -DLOG_DEFERRED=ON -DLOG_DEFERRED_BINARY=ON 编译后，日志串口
+输出原始记录(格式字符串和tag只有指针)，由本脚本按固件ELF文件还原为与文本
+模式相同的日志行。记录格式见Source/BSP/inc/bsp_log_deferred.hpp。
+
+用法:
+  # 解码抓取的串口数据
+  log_decode.py build/wht.elf capture.bin
+
+  # 直接读取串口(需要pyserial)
+  log_decode.py build/wht.elf --port /dev/ttyUSB0 --baud 115200
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+MAGIC = 0xA5
+HDR_WORDS = 5
+MAX_WORDS = 1024
+TICK_RATE_HZ = 1000
+LEVELS = "VDIWER"
+
+KIND_FMT, KIND_RAW, KIND_DROP = 0, 1, 2
+ARG_U32, ARG_U64, ARG_DOUBLE, ARG_STR = 0, 1, 2, 3
+
+SHT_NOBITS = 8
+SHF_ALLOC = 0x2
+
+
+class Elf32:
+    """按地址读取ELF中已初始化段的字符串常量"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("%s: not a little-endian ELF32 file" % path)
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, flags, addr, offset,
+             size) = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size:
+                self.sections.append((addr, data[offset:offset + size]))
+        self.cache = {}
+
+    def string(self, addr):
+        if addr in self.cache:
+            return self.cache[addr]
+        s = None
+        for base, body in self.sections:
+            if base <= addr < base + len(body):
+                end = body.find(b"\0", addr - base)
+                end = len(body) if end < 0 else end
+                s = body[addr - base:end].decode("utf-8", "replace")
+                break
+        self.cache[addr] = s
+        return s
+
+
+# 与固件LogFormatter一致: 标志、宽度和精度保留，长度修饰按参数实际类型
+SPEC = re.compile(r"%(%|[-+ #0-9.]*)(?:[hlLqjzt]*)([a-zA-Z]?)")
+
+
+def take_args(words, types, num):
+    args = []
+    pos = 0
+    for i in range(num):
+        t = (types >> (2 * i)) & 0x3
+        if t == ARG_STR:
+            if pos >= len(words):
+                break
+            length = words[pos]
+            raw = struct.pack("<%dI" % ((length + 3) // 4),
+                              *words[pos + 1:pos + 1 + (length + 3) // 4])
+            args.append((t, raw[:length].decode("utf-8", "replace")))
+            pos += 1 + (length + 3) // 4
+        elif t == ARG_U32:
+            if pos >= len(words):
+                break
+            args.append((t, words[pos]))
+            pos += 1
+        else:
+            if pos + 1 >= len(words):
+                break
+            value = words[pos] | words[pos + 1] << 32
+            if t == ARG_DOUBLE:
+                value = struct.unpack("<d", struct.pack("<Q", value))[0]
+            args.append((t, value))
+            pos += 2
+    return args
+
+
+def signed(t, value):
+    bits = 32 if t == ARG_U32 else 64
+    return value - (1 << bits) if value >> (bits - 1) else value
+
+
+def format_record(fmt, args):
+    it = iter(args)
+
+    def conv(m):
+        flags, c = m.group(1), m.group(2)
+        if flags == "%":
+            return "%"
+        if not c:
+            return m.group(0)
+        try:
+            t, value = next(it)
+        except StopIteration:
+            return "<?>"
+        try:
+            if c == "s":
+                return ("%" + flags + "s") % value if t == ARG_STR else "<?>"
+            if t == ARG_STR:
+                return "<?>"
+            if c in "fFeEgG":
+                v = value if t == ARG_DOUBLE else float(signed(t, value))
+                return ("%" + flags + c) % v
+            if t == ARG_DOUBLE:
+                return "<?>"
+            if c in "di":
+                return ("%" + flags + "d") % signed(t, value)
+            if c in "uoxX":
+                return ("%" + flags + ("d" if c == "u" else c)) % value
+            if c == "c":
+                return ("%" + flags + "c") % (value & 0xFF)
+            if c == "p":
+                return "0x%08x" % value
+        except (TypeError, ValueError):
+            pass
+        return "<?>"
+
+    return SPEC.sub(conv, fmt)
+
+
+def decode(elf, words):
+    hdr = words[0]
+    kind = (hdr >> 20) & 0xF
+    level = (hdr >> 16) & 0xF
+    tick = words[1]
+    lvl = LEVELS[level] if level < 5 else "?"
+    tag = ""
+    if kind == KIND_FMT:
+        tag = elf.string(words[2]) or "0x%08x" % words[2]
+        fmt = elf.string(words[3])
+        types = words[4]
+        if fmt is None:
+            text = "<unknown format 0x%08x>" % words[3]
+        else:
+            text = format_record(fmt,
+                                 take_args(words[HDR_WORDS:], types, types >> 28))
+        lines = [text]
+    elif kind == KIND_RAW:
+        raw = struct.pack("<%dI" % (len(words) - HDR_WORDS), *words[HDR_WORDS:])
+        raw = raw[:words[4]]
+        lines = [" ".join("%02X" % b for b in raw[i:i + 85])
+                 for i in range(0, len(raw), 85)] or [""]
+    elif kind == KIND_DROP:
+        tag = "Log"
+        lines = ["%d log records dropped" % words[4]]
+    else:
+        return []
+    return ["[%03d.%03d] [%s] [%-6s] %s" %
+            (tick // TICK_RATE_HZ, tick % TICK_RATE_HZ * 1000 // TICK_RATE_HZ,
+             lvl, tag, text) for text in lines]
+
+
+class StreamDecoder:
+    """按同步字节和记录头分帧，记录头不合法时丢弃一个字节重新同步"""
+
+    def __init__(self, elf):
+        self.elf = elf
+        self.buf = bytearray()
+        self.resyncs = 0
+
+    def feed(self, data):
+        self.buf += data
+        out = []
+        pos = 0
+        while True:
+            start = self.buf.find(SYNC, pos)
+            if start < 0:
+                keep = 1 if self.buf.endswith(SYNC[:1]) else 0
+                pos = max(pos, len(self.buf) - keep)
+                break
+            if start > pos:
+                self.resyncs += 1
+            if len(self.buf) - start < 2 + 4:
+                pos = start
+                break
+            hdr, = struct.unpack_from("<I", self.buf, start + 2)
+            n = hdr & 0xFFFF
+            if hdr >> 24 != MAGIC or not HDR_WORDS <= n <= MAX_WORDS:
+                pos = start + 1
+                continue
+            if len(self.buf) - start < 2 + n * 4:
+                pos = start
+                break
+            words = struct.unpack_from("<%dI" % n, self.buf, start + 2)
+            out += decode(self.elf, words)
+            pos = start + 2 + n * 4
+        del self.buf[:pos]
+        return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.
+                                     RawDescriptionHelpFormatter)
+    parser.add_argument("elf", help="固件ELF文件")
+    parser.add_argument("capture", nargs="?", help="抓取的串口数据文件")
+    parser.add_argument("--port", help="串口设备")
+    parser.add_argument("--baud", type=int, default=115200)
+    args = parser.parse_args()
+
+    decoder = StreamDecoder(Elf32(args.elf))
+    if args.port:
+        import serial
+        source = serial.Serial(args.port, args.baud, timeout=0.1)
+    elif args.capture:
+        source = open(args.capture, "rb")
+    else:
+        source = sys.stdin.buffer
+    try:
+        while True:
+            data = source.read(4096)
+            if not data:
+                if args.port:
+                    continue
+                break
+            for line in decoder.feed(data):
+                print(line, flush=True)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        source.close()
+    if decoder.resyncs:
+        print("resyncs %d" % decoder.resyncs, file=sys.stderr)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -0,0 +1,273 @@
+#!/usr/bin/env python3
+"""事件跟踪导出为Chrome trace时间线
+
+固件以CMake选项 -DEVENT_TRACE=ON 编译后，在同步定时器、UWB发送、从机扫描、
+导通数据读取和上位机收发等位置记录事件(格式见Source/BSP/inc/bsp_trace.hpp)。
+主机经上位机UDP分段导出；从机每TRACE_LOG_INTERVAL秒以十六进制行输出到日志。
+本脚本把导出数据转换为chrome://tracing或ui.perfetto.dev可打开的JSON，
+每个来源一个进程，每个任务或中断一行，成对事件显示为时间段。
+
+各设备的周期计数器互不同步，每个来源的时间从其第一条记录开始计。
+输出的每事件时长统计可用于对比不同构建，例如分别以-DTCM_PLACEMENT=ON/OFF
+编译，比较scan_sample(扫描读取一行)和uci_parse(UWB接收解析)的平均和最大值。
+
+用法:
+  # 从主机导出，导出后清空并重新开始记录
+  trace_export.py udp:192.168.0.10 -o master.json --resume
+
+  # 从抓取的从机日志中取最后一次导出
+  trace_export.py slave1.log -o slave1.json
+
+  # 主机原始导出另存，之后与从机日志合并到一个时间线
+  trace_export.py udp:192.168.0.10 --save master.bin
+  trace_export.py master.bin slave1.log slave2.log -o cycle.json
+"""
+
+import argparse
+import collections
+import json
+import re
+import socket
+import struct
+import sys
+
+from backend_stream import (B2M_TRACE, BACKEND2MASTER, M2B_TRACE,
+                            MASTER2BACKEND, make_socket, pack_frame,
+                            parse_frame)
+
+MAGIC = 0x5254
+HEADER = struct.Struct("<HBBIIHHHB")
+TASK = struct.Struct("<I12s")
+RECORD = struct.Struct("<IIIH")
+FLAG_COMPILED = 0x01
+
+# 主机每段导出的记录数由固件TRACE_DUMP_CHUNK决定
+TRACE_READ, TRACE_RESUME = 0, 1
+MARK, BEGIN, END = 0, 1, 2
+
+# 与bsp_trace.hpp中TraceEvent一致
+EVENTS = [None, "sync_timer", "sync_send", "read_cycle", "read_cond",
+          "uwb_send", "scan", "scan_row", "cond_reply", "backend_send",
+          "backend_recv", "scan_sample", "uci_parse"]
+
+LOG_TRACE = re.compile(r"\[TRACE\s*\]\s+(\S.*?)\s*$")
+
+
+class Dump:
+    """一次完整导出，由一段或多段合并"""
+
+    def __init__(self):
+        self.compiled = False
+        self.core_hz = 0
+        self.lost = 0
+        self.tasks = {}
+        self.records = []
+
+
+def parse_chunks(data, dump=None):
+    """解析连续的导出段，返回(Dump, 最后一段的(next, total))"""
+    dump = dump or Dump()
+    pos = 0
+    last = (0, 0)
+    while pos + HEADER.size <= len(data):
+        (magic, version, flags, core_hz, lost, total, start, nxt,
+         task_num) = HEADER.unpack_from(data, pos)
+        if magic != MAGIC:
+            raise ValueError("bad trace magic at offset %d" % pos)
+        if version != 1:
+            raise ValueError("unsupported trace version %d" % version)
+        pos += HEADER.size
+        for _ in range(task_num):
+            handle, name = TASK.unpack_from(data, pos)
+            pos += TASK.size
+            dump.tasks[handle] = name.split(b"\0", 1)[0].decode(
+                "ascii", "replace")
+        num, = struct.unpack_from("<H", data, pos)
+        pos += 2
+        for _ in range(num):
+            dump.records.append(RECORD.unpack_from(data, pos))
+            pos += RECORD.size
+        dump.compiled = bool(flags & FLAG_COMPILED)
+        dump.core_hz = core_hz
+        if start == 0:
+            dump.lost = lost
+        last = (nxt, total)
+    return dump, last
+
+
+def fetch_master(host, port, timeout, resume):
+    """分段读取主机跟踪，返回拼接的原始导出数据"""
+    sock = make_socket()
+    sock.settimeout(timeout)
+
+    def request(cmd, start):
+        payload = struct.pack("<BBH", B2M_TRACE, cmd, start)
+        sock.sendto(pack_frame(BACKEND2MASTER, payload), (host, port))
+        while True:
+            data, _ = sock.recvfrom(4096)
+            frame = parse_frame(data)
+            # 跳过结果流等其他帧
+            if (frame is not None and frame[0] == MASTER2BACKEND and
+                    frame[1] and frame[1][0] == M2B_TRACE):
+                return frame[1][1:]
+
+    raw = b""
+    start = 0
+    while True:
+        body = request(TRACE_READ, start)
+        raw += body
+        _, (nxt, total) = parse_chunks(body)
+        if nxt >= total or nxt <= start:
+            break
+        start = nxt
+    if resume:
+        request(TRACE_RESUME, 0)
+    return raw
+
+
+def dumps_from_log(path):
+    """日志中每对dump begin/dump end之间的十六进制行为一次导出"""
+    dumps = []
+    hexdata = None
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            m = LOG_TRACE.search(line)
+            if m is None:
+                continue
+            text = m.group(1)
+            if text == "dump begin":
+                hexdata = []
+            elif text == "dump end":
+                if hexdata is not None:
+                    dumps.append(bytes.fromhex("".join(hexdata)))
+                hexdata = None
+            elif hexdata is not None:
+                hexdata.append(text)
+    return dumps
+
+
+def load_source(src, args):
+    if src.startswith("udp:"):
+        host, _, port = src[4:].partition(":")
+        raw = fetch_master(host, int(port or args.port), args.timeout,
+                           args.resume)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(raw)
+        return [parse_chunks(raw)[0]]
+    with open(src, "rb") as f:
+        head = f.read(2)
+    if len(head) == 2 and struct.unpack("<H", head)[0] == MAGIC:
+        with open(src, "rb") as f:
+            return [parse_chunks(f.read())[0]]
+    dumps = []
+    for raw in dumps_from_log(src):
+        try:
+            dumps.append(parse_chunks(raw)[0])
+        except (ValueError, struct.error) as e:
+            print("%s: skip broken dump: %s" % (src, e), file=sys.stderr)
+    return dumps if args.all else dumps[-1:]
+
+
+def ctx_name(dump, ctx):
+    if ctx < 256:
+        return "isr %d" % ctx
+    return dump.tasks.get(ctx, "task 0x%08X" % ctx)
+
+
+def to_events(dump, pid, label):
+    """转换为Chrome trace事件，返回(events, 每个事件的时长统计, 未配对数)"""
+    events = [dict(ph="M", pid=pid, name="process_name",
+                   args=dict(name=label))]
+    hz = dump.core_hz or 1
+    tids = {}
+    spans = collections.defaultdict(list)
+    opened = collections.defaultdict(list)
+    unmatched = 0
+    acc = 0
+    prev = None
+    for cycle, ctx, arg, ident in dump.records:
+        # 记录按序号排列，周期在取序号前读取，相邻记录可能略有倒序
+        if prev is not None:
+            acc += ((cycle - prev + 0x80000000) & 0xFFFFFFFF) - 0x80000000
+        prev = cycle
+        ts = acc * 1e6 / hz
+        if ctx not in tids:
+            tids[ctx] = len(tids) + 1
+            events.append(dict(ph="M", pid=pid, tid=tids[ctx],
+                               name="thread_name",
+                               args=dict(name=ctx_name(dump, ctx))))
+        tid = tids[ctx]
+        phase, event = ident >> 14, ident & 0x3FFF
+        name = EVENTS[event] if event < len(EVENTS) else "event_%d" % event
+        if phase == BEGIN:
+            opened[event].append((ts, tid, arg))
+        elif phase == END:
+            stack = opened[event]
+            if not stack:
+                unmatched += 1
+                continue
+            # 优先与同一任务的开始配对；扫描等由其他任务结束的事件取最近
+            # 的开始，时间段画在开始的任务上
+            i = next((i for i in range(len(stack) - 1, -1, -1)
+                      if stack[i][1] == tid), len(stack) - 1)
+            bts, btid, barg = stack.pop(i)
+            spans[name].append(ts - bts)
+            events.append(dict(ph="X", pid=pid, tid=btid, name=name,
+                               ts=bts, dur=ts - bts,
+                               args=dict(begin=barg, end=arg)))
+        else:
+            events.append(dict(ph="i", s="t", pid=pid, tid=tid, name=name,
+                               ts=ts, args=dict(arg=arg)))
+    unmatched += sum(len(v) for v in opened.values())
+    return events, spans, unmatched
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.
+                                     RawDescriptionHelpFormatter)
+    parser.add_argument("sources", nargs="+",
+                        help="udp:主机IP[:端口]、原始导出文件或日志文件")
+    parser.add_argument("-o", "--output", default="trace.json")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--timeout", type=float, default=1.0)
+    parser.add_argument("--resume", action="store_true",
+                        help="主机导出后清空并重新开始记录")
+    parser.add_argument("--save", help="主机原始导出另存的文件")
+    parser.add_argument("--all", action="store_true",
+                        help="日志中的每次导出都转换，缺省只取最后一次")
+    args = parser.parse_args()
+
+    events = []
+    pid = 0
+    for src in args.sources:
+        try:
+            dumps = load_source(src, args)
+        except socket.timeout:
+            print("%s: no response" % src, file=sys.stderr)
+            return 1
+        if not dumps:
+            print("%s: no trace dump found" % src, file=sys.stderr)
+        for i, dump in enumerate(dumps):
+            pid += 1
+            label = src if len(dumps) == 1 else "%s #%d" % (src, i + 1)
+            if not dump.compiled:
+                print("%s: firmware built without EVENT_TRACE" % label)
+                continue
+            evs, spans, unmatched = to_events(dump, pid, label)
+            events += evs
+            print("%s: %d records, %d lost, %d unmatched" %
+                  (label, len(dump.records), dump.lost, unmatched))
+            for name, durs in sorted(spans.items()):
+                print("  %-13s %5d x  mean %9.1fus  max %9.1fus" %
+                      (name, len(durs), sum(durs) / len(durs), max(durs)))
+
+    with open(args.output, "w") as f:
+        json.dump(dict(traceEvents=events, displayTimeUnit="ms"), f)
+    print("wrote %s" % args.output)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -2,12 +2,114 @@
 #ifndef BSP_ALLOCATE_HPP
 #define BSP_ALLOCATE_HPP
 #include <cstddef>
-#include <utility>    
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+extern "C" {
+#include "FreeRTOS.h"
+}
 
 // Assuming pvPortMalloc and vPortFree are defined in FreeRTOS
 extern "C" void* pvPortMalloc(size_t xWantedSize);
 extern "C" void vPortFree(void* pv);
 
+// 定长内存池: 块大小(需为8的倍数且递增)和块数
+// 块数按单从机导通循环中实测峰值的约两倍设置(主机/从机峰值:
+// 32B 45/22，128B 2/2，512B 14/7，2048B 2/2)，2048B留给多引脚的大帧
+#define MEMPOOL_32_NUM   96
+#define MEMPOOL_128_NUM  16
+#define MEMPOOL_512_NUM  32
+#define MEMPOOL_2048_NUM 4
+#define MEMPOOL_NUM      4
+
+/**
+ * @brief 定长块内存池，分配和释放均为O(1)，中断中可用
+ * @note 空闲块链表由屏蔽中断(BASEPRI)保护，优先级高于
+ *       configMAX_SYSCALL_INTERRUPT_PRIORITY的中断中不可使用。
+ *       未使用过的块按顺序切分，不需要初始化，静态构造期间即可使用
+ */
+class FixedPool {
+   public:
+    struct Stats {
+        uint16_t block_size;
+        uint16_t block_num;
+        uint16_t used;
+        uint16_t peak;    // 最大同时占用块数
+        uint32_t fail;    // 池满分配失败次数
+    };
+
+    constexpr FixedPool(uint8_t* buf, uint16_t block_size, uint16_t block_num)
+        : __buf(buf), __block_size(block_size), __block_num(block_num) {}
+
+    void* alloc() {
+        UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+        void* p = __free;
+        if (p != nullptr) {
+            __free = *static_cast<void**>(p);
+        } else if (__carved < __block_num) {
+            p = __buf + (size_t)__carved++ * __block_size;
+        }
+        if (p != nullptr) {
+            if (++__used > __peak) {
+                __peak = __used;
+            }
+        } else {
+            __fail++;
+        }
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+        return p;
+    }
+
+    void free(void* p) {
+        UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+        *static_cast<void**>(p) = __free;
+        __free = p;
+        __used--;
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    }
+
+    bool contains(const void* p) const {
+        return p >= __buf && p < __buf + (size_t)__block_num * __block_size;
+    }
+
+    uint16_t block_size() const { return __block_size; }
+
+    Stats stats() const {
+        return {__block_size, __block_num, __used, __peak, __fail};
+    }
+
+   private:
+    uint8_t* __buf;
+    uint16_t __block_size;
+    uint16_t __block_num;
+    uint16_t __carved = 0;
+    uint16_t __used = 0;
+    uint16_t __peak = 0;
+    uint32_t __fail = 0;
+    void* __free = nullptr;
+};
+
+/**
+ * @brief 按大小选择内存池，池满或超过最大块时从FreeRTOS堆分配
+ * @note 只服务OSallocator(PoolVector)，全局new/delete仍使用堆，
+ *       常驻对象不占用池块。只能在任务中调用，回退的pvPortMalloc
+ *       不能在中断中使用，中断中直接使用FixedPool
+ */
+class MemPool {
+   public:
+    static void* alloc(size_t size);
+    static void free(void* p);
+
+    static const FixedPool& pool(uint8_t index) { return pools[index]; }
+    // 因池满或超过最大块转到堆上的分配次数
+    static uint32_t heap_fallback() { return fallback; }
+
+   private:
+    static FixedPool pools[MEMPOOL_NUM];
+    static volatile uint32_t fallback;
+};
+
 template <class _TypeT>
 class OSallocator
 {
@@ -47,13 +149,14 @@ public:
 
     pointer allocate(size_type __n, const void* = 0) {
         if (__n == 0) return nullptr;
-        pointer __p = static_cast<pointer>(pvPortMalloc(__n * sizeof(value_type)));
+        pointer __p =
+            static_cast<pointer>(MemPool::alloc(__n * sizeof(value_type)));
         // if (!__p) throw std::bad_alloc();
-        // return __p;
+        return __p;
     }
 
     void deallocate(pointer __p, size_type) {
-        vPortFree(__p);
+        MemPool::free(__p);
     }
 
     size_type max_size() const noexcept {
@@ -71,6 +174,17 @@ public:
     }
 };
 
+// 无状态分配器，任意两个实例可互相释放
+template <class _TypeT, class _TypeU>
+bool operator==(const OSallocator<_TypeT>&, const OSallocator<_TypeU>&) {
+    return true;
+}
+
+template <class _TypeT, class _TypeU>
+bool operator!=(const OSallocator<_TypeT>&, const OSallocator<_TypeU>&) {
+    return false;
+}
+
 // Specialization for void
 template <>
 class OSallocator<void>
@@ -100,4 +214,12 @@ public:
         typedef OSallocator<_Up> other;
     };
 };
-#endif
\ No newline at end of file
+
+/**
+ * @brief 从内存池分配的vector，用于协议帧、UCI包和收发队列中反复
+ *        分配释放的缓冲区
+ */
+template <class _TypeT>
+using PoolVector = std::vector<_TypeT, OSallocator<_TypeT>>;
+
+#endif
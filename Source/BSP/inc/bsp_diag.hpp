@@ -0,0 +1,213 @@
+#ifndef BSP_DIAG_HPP
+#define BSP_DIAG_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "QueueCPP.h"
+#include "bsp_allocate.hpp"
+#include "bsp_runtime_stats.h"
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "task.h"
+}
+
+// 登记的队列数，队列编号1..DIAG_QUEUE_MAX
+#define DIAG_QUEUE_MAX 8
+// 快照中最多上报的任务数，不能少于系统任务总数
+#define DIAG_TASK_MAX 16
+// 任务线程局部存储中保存当前子系统的下标
+#define DIAG_TLS_INDEX 0
+// 快照中名称字段的定长
+#define DIAG_QUEUE_NAME_LEN 8
+#define DIAG_TASK_NAME_LEN  12
+
+#if configNUM_THREAD_LOCAL_STORAGE_POINTERS <= DIAG_TLS_INDEX
+#error "Diag needs configNUM_THREAD_LOCAL_STORAGE_POINTERS > DIAG_TLS_INDEX"
+#endif
+
+/**
+ * @brief 运行诊断: 堆和内存池水位、按子系统的分配计数、任务栈水位、
+ *        登记队列的最大深度，序列化为快照上报上位机
+ * @note 分配按调用任务当前的子系统计数，子系统保存在任务线程局部存储中，
+ *       任务入口用set_subsystem设置默认值，局部代码用Scope临时切换。
+ *       队列最大深度由FreeRTOS的traceQUEUE_SEND钩子按队列编号记录，
+ *       未登记的队列编号为0，钩子只做一次比较。
+ *
+ * 快照格式(小端):
+ *   version u8, sections u8, uptime_ms u32, 之后按sections位依次为
+ *   HEAP:   free u32, min_free u32, total u32, pool_fallback u32
+ *   POOL:   num u8, {block_size u16, block_num u16, used u16, peak u16,
+ *           fail u32}
+ *   SUBSYS: num u8, {allocs u32, bytes u32}，按Subsystem顺序
+ *   NET:    valid u8, 有效时 mem_used u32, mem_max u32, mem_err u16,
+ *           pbuf_used u16, pbuf_max u16, pbuf_err u16
+ *   QUEUE:  num u8, {name char[8], length u16, waiting u16, peak u16}
+ *   TASK:   num u8, {name char[12], prio u8, state u8, stack_free u16}，
+ *           stack_free为历史最小剩余栈(字)
+ *   CPU:    valid u8, 有效时 window_us u32, isr_permille u16,
+ *           isr_num u8, {name char[8], permille u16, count u32},
+ *           task_num u8, {name char[12], permille u16}
+ *           自上次CPU采样以来的占用千分比，任务时间包含其间被打断的中断时间，
+ *           只在RUN_TIME_STATS构建中有效
+ */
+class Diag {
+   public:
+    enum class Subsystem : uint8_t {
+        OTHER = 0,
+        PROTOCOL,
+        UWB,
+        LWIP,
+        JSON,
+        NUM
+    };
+
+    enum Section : uint8_t {
+        HEAP = 0x01,
+        POOL = 0x02,
+        SUBSYS = 0x04,
+        NET = 0x08,
+        QUEUE = 0x10,
+        TASK = 0x20,
+        CPU = 0x40,
+        ALL = 0x7F
+    };
+
+    static constexpr uint8_t VERSION = 1;
+
+    struct NetStats {
+        uint32_t mem_used;
+        uint32_t mem_max;
+        uint16_t mem_err;
+        uint16_t pbuf_used;
+        uint16_t pbuf_max;
+        uint16_t pbuf_err;
+    };
+
+    struct CpuLoad {
+        const char* name;
+        uint16_t permille;
+        uint32_t count;    // 中断分组在窗口内的进入次数
+    };
+
+    struct CpuSample {
+        uint32_t window_us;
+        uint16_t isr_permille;
+        uint8_t task_num;
+        CpuLoad task[DIAG_TASK_MAX];
+        CpuLoad isr[ISR_STAT_NUM];
+    };
+
+    // 网络协议栈统计由使用网络的固件提供
+    using NetProbe = bool (*)(NetStats& stats);
+
+    /**
+     * @brief 在作用域内把当前任务的分配计入指定子系统
+     */
+    class Scope {
+       public:
+        explicit Scope(Subsystem sub) : prev(current()) { set_subsystem(sub); }
+        ~Scope() { set_subsystem(prev); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+       private:
+        Subsystem prev;
+    };
+
+    static void set_subsystem(Subsystem sub) {
+        vTaskSetThreadLocalStoragePointer(
+            nullptr, DIAG_TLS_INDEX,
+            reinterpret_cast<void*>(static_cast<uintptr_t>(sub)));
+    }
+
+    // 中断中的分配计入OTHER，主机仿真构建没有中断
+    static Subsystem current() {
+#ifndef HOST_SIM
+        if (xPortIsInsideInterrupt()) {
+            return Subsystem::OTHER;
+        }
+#endif
+        return static_cast<Subsystem>(reinterpret_cast<uintptr_t>(
+            pvTaskGetThreadLocalStoragePointer(nullptr, DIAG_TLS_INDEX)));
+    }
+
+    // 由MemPool在调度器启动后调用
+    static void count_alloc(size_t size) {
+        uint8_t sub = static_cast<uint8_t>(current());
+        if (sub >= static_cast<uint8_t>(Subsystem::NUM)) {
+            sub = 0;
+        }
+        allocs[sub].fetch_add(1, std::memory_order_relaxed);
+        bytes[sub].fetch_add(size, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 登记队列，之后入队时记录最大深度
+     * @param name 快照中的名称，超过DIAG_QUEUE_NAME_LEN截断
+     * @return 登记数已满返回false
+     */
+    static bool watch_queue(FreeRTOScpp::QueueBase& queue, const char* name);
+
+    static void set_net_probe(NetProbe probe) { net_probe = probe; }
+
+    /**
+     * @brief 追加诊断快照
+     * @param sections Section位组合
+     */
+    static void serialize(PoolVector<uint8_t>& out, uint8_t sections = ALL);
+
+    /**
+     * @brief 计算自上次采样以来各任务和中断分组的CPU占用
+     * @note 采样窗口由所有调用者共用；任务名指向任务控制块，
+     *       任务删除后失效，应立即使用
+     * @return 未开启RUN_TIME_STATS时返回false
+     */
+    static bool cpu_sample(CpuSample& sample);
+
+    // traceQUEUE_SEND钩子，在队列临界区内调用
+    // 未登记的队列编号为0，减1后回绕，同样被范围检查排除
+    static void queue_send(UBaseType_t number, UBaseType_t depth) {
+        if (number - 1 < DIAG_QUEUE_MAX && depth > queues[number - 1].peak) {
+            queues[number - 1].peak = depth;
+        }
+    }
+
+   private:
+    struct WatchedQueue {
+        QueueHandle_t handle;
+        const char* name;
+        UBaseType_t peak;
+    };
+
+    // 通过派生类取得QueueBase的保护成员queueHandle
+    struct QueueHandleOf : FreeRTOScpp::QueueBase {
+        static QueueHandle_t get(const FreeRTOScpp::QueueBase& queue) {
+            return queue.*(&QueueHandleOf::queueHandle);
+        }
+    };
+
+    static std::atomic<uint32_t> allocs[(size_t)Subsystem::NUM];
+    static std::atomic<uint32_t> bytes[(size_t)Subsystem::NUM];
+    static WatchedQueue queues[DIAG_QUEUE_MAX];
+    static uint8_t queue_num;
+    static NetProbe net_probe;
+    // 任务表缓冲区，在挂起调度器时使用
+    static TaskStatus_t task_status[DIAG_TASK_MAX];
+#ifdef RUN_TIME_STATS
+    struct CpuPrev {
+        UBaseType_t number;    // xTaskNumber，任务创建时递增分配
+        uint64_t runtime;
+    };
+    static CpuPrev cpu_prev[DIAG_TASK_MAX];
+    static uint64_t cpu_prev_total;
+    static uint64_t cpu_prev_isr_total;
+    static uint64_t cpu_prev_isr[ISR_STAT_NUM];
+    static uint32_t cpu_prev_isr_count[ISR_STAT_NUM];
+#endif
+};
+
+#endif
@@ -3,6 +3,7 @@
 #include <cstdint>
 #include <functional>
 
+#include "bsp_runtime_stats.h"
 #include "gd32f4xx.h"
 
 typedef struct {
@@ -70,10 +71,12 @@ class ExtiBase {
 
    public:
     void irq_handler() {
+        ISR_STAT_ENTER();
         if (exti_interrupt_flag_get(exti_line) != RESET) {
             exti_interrupt_flag_clear(exti_line);
             callback();
         }
+        ISR_STAT_EXIT(ISR_STAT_EXTI);
     }
     virtual void callback() = 0;
 
@@ -1,4 +1,8 @@
 #pragma once
+#ifdef HOST_SIM
+// 主机仿真构建的GPIO见Source/Host
+#include "host_gpio.hpp"
+#else
 #include <cstdint>
 extern "C" {
 #include "gd32f4xx.h"
@@ -142,3 +146,4 @@ class GPIO {
     constexpr uint32_t port_base() const { return static_cast<uint32_t>(port); }
     constexpr uint32_t pin_mask() const { return static_cast<uint32_t>(pin); }
 };
+#endif
@@ -3,23 +3,111 @@
 #define _LOG_H_
 
 #include <stdarg.h>
+#include <string.h>
 
 #include <array>
+#include <atomic>
 
 #include "QueueCPP.h"
 #include "TaskCPP.h"
+#include "bsp_diag.hpp"
 #include "bsp_uart.hpp"
 #include "queue.h"
 #include "task.h"
 
+#ifdef LOG_DEFERRED
+#include "bsp_log_deferred.hpp"
+#endif
+
 #define LOG_TASK_DEPTH_SIZE 512
-#define LOG_TASK_PRIO       TaskPrio_Highest
+// 日志串口由DMA发送，LogTask只做格式化和拷贝，不抢占数据通路
+#define LOG_TASK_PRIO       TaskPrio_Low
+
+// 日志串口DMA发送环形缓冲区大小
+#define LOG_UART_TX_RING_SIZE 2048
 
 // 定义日志消息的最大长度
 #define LOG_QUEUE_SIZE 256
 // 定义日志队列的长度
 #define LOG_QUEUE_LENGTH 20
 
+// 延迟日志模式下LogTask轮询环形缓冲区的间隔(ms)
+#define LOG_DEFERRED_POLL_MS 5
+
+// 运行时可单独设置级别的tag数
+#define LOG_TAG_LEVEL_NUM 8
+
+/**
+ * @brief 编译期日志级别，低于此级别的LOG_x调用点不生成代码，参数也不求值
+ * @note 0 VERBOSE，1 DEBUG，2 INFO，3 WARN，4 ERROR。可由CMake的
+ *       LOG_COMPILE_LEVEL指定，默认debug版本全部保留，release版本保留INFO及以上
+ */
+#ifndef LOG_COMPILE_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILE_LEVEL 2
+#else
+#define LOG_COMPILE_LEVEL 0
+#endif
+#endif
+
+struct LogTagLevel {
+    const char* tag;
+    int level;
+};
+
+/**
+ * @brief 按tag提高编译期日志级别，未列出的tag使用LOG_COMPILE_LEVEL
+ * @note release版本去掉每个导通周期都会输出的日志
+ */
+inline constexpr LogTagLevel LOG_TAG_LEVELS[] = {
+#ifdef NDEBUG
+    {"SlaveManager", 3},
+    {"ReadCondProcessor", 3},
+#endif
+    {nullptr, 0},
+};
+
+constexpr bool log_tag_equal(const char* a, const char* b) {
+    while (*a != '\0' && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+constexpr int log_compile_level(const char* TAG) {
+    for (const LogTagLevel& item : LOG_TAG_LEVELS) {
+        if (item.tag != nullptr && log_tag_equal(item.tag, TAG)) {
+            return item.level > LOG_COMPILE_LEVEL ? item.level
+                                                  : LOG_COMPILE_LEVEL;
+        }
+    }
+    return LOG_COMPILE_LEVEL;
+}
+
+/**
+ * @brief 日志调用点，TAG须为常量表达式
+ * @note 低于编译期级别时整条语句被丢弃，其余的再按运行时级别过滤
+ */
+#define LOG_AT(level, fn, TAG, ...)                                   \
+    do {                                                              \
+        if constexpr (Logger::compiled(Logger::Level::level, TAG)) {  \
+            Log.fn(TAG, __VA_ARGS__);                                 \
+        }                                                             \
+    } while (0)
+
+#define LOG_V(TAG, ...) LOG_AT(VERBOSE, v, TAG, __VA_ARGS__)
+#define LOG_D(TAG, ...) LOG_AT(DEBUGL, d, TAG, __VA_ARGS__)
+#define LOG_I(TAG, ...) LOG_AT(INFO, i, TAG, __VA_ARGS__)
+#define LOG_W(TAG, ...) LOG_AT(WARN, w, TAG, __VA_ARGS__)
+#define LOG_E(TAG, ...) LOG_AT(ERROR, e, TAG, __VA_ARGS__)
+#define LOG_R(data, size)                                             \
+    do {                                                              \
+        if constexpr (Logger::compiled(Logger::Level::RAW, "")) {     \
+            Log.r(data, size);                                        \
+        }                                                             \
+    } while (0)
+
 // 日志消息结构体
 struct LogMessage {
     std::array<char, LOG_QUEUE_SIZE> message;
@@ -31,15 +119,106 @@ class Logger {
    public:
     enum class Level { VERBOSE, DEBUGL, INFO, WARN, ERROR, RAW = VERBOSE };
 
-    Logger(Uart& uart) : uart(uart), logQueue("LogQueue") {}
+#ifdef LOG_DEFERRED
+    Logger(Uart& uart) : uart(uart) {
+        uart.tx_ring_init(txRing, sizeof(txRing));
+    }
+
+    Uart& uart;    // 串口对象的引用
+#else
+    Logger(Uart& uart) : uart(uart), logQueue("LogQueue") {
+        uart.tx_ring_init(txRing, sizeof(txRing));
+        Diag::watch_queue(logQueue, "log");
+    }
 
     Uart& uart;    // 串口对象的引用
     FreeRTOScpp::Queue<LogMessage, LOG_QUEUE_LENGTH> logQueue;
+#endif
 
     Level currentLevel = Level::VERBOSE;
 
     void setLogLevel(Level level) { currentLevel = level; }
 
+    /**
+     * @brief 编译期是否保留该级别和tag的日志
+     */
+    static constexpr bool compiled(Level level, const char* TAG) {
+        return static_cast<int>(level) >= log_compile_level(TAG);
+    }
+
+    /**
+     * @brief 运行时设置单个tag的日志级别，优先于全局级别
+     * @return 表已满返回false
+     */
+    bool setTagLevel(const char* TAG, Level level) {
+        for (size_t i = 0; i < tagLevelNum; i++) {
+            if (strcmp(tagLevels[i].tag, TAG) == 0) {
+                tagLevels[i].level = level;
+                return true;
+            }
+        }
+        if (tagLevelNum >= LOG_TAG_LEVEL_NUM) {
+            return false;
+        }
+        tagLevels[tagLevelNum].tag = TAG;
+        tagLevels[tagLevelNum].level = level;
+        tagLevelNum++;
+        return true;
+    }
+
+    bool enabled(Level level, const char* TAG) const {
+        for (size_t i = 0; i < tagLevelNum; i++) {
+            if (strcmp(tagLevels[i].tag, TAG) == 0) {
+                return level >= tagLevels[i].level;
+            }
+        }
+        return level >= currentLevel;
+    }
+
+#ifdef LOG_DEFERRED
+    /**
+     * @brief 延迟日志：调用者只将格式字符串指针、tag指针、tick和参数原始值
+     *        写入无锁环形缓冲区，格式化在LogTask或上位机中完成
+     * @note format和TAG须为字符串常量；运行时生成的文本用"%s"作为参数传入
+     */
+    LogRing ring;
+
+    template <typename... Args>
+    void v(const char* TAG, const char* format, const Args&... args) {
+        if (!enabled(Level::VERBOSE, TAG)) return;
+        ring.put((uint8_t)Level::VERBOSE, TAG, format, args...);
+    }
+
+    template <typename... Args>
+    void d(const char* TAG, const char* format, const Args&... args) {
+        if (!enabled(Level::DEBUGL, TAG)) return;
+        ring.put((uint8_t)Level::DEBUGL, TAG, format, args...);
+    }
+
+    template <typename... Args>
+    void i(const char* TAG, const char* format, const Args&... args) {
+        if (!enabled(Level::INFO, TAG)) return;
+        ring.put((uint8_t)Level::INFO, TAG, format, args...);
+    }
+
+    template <typename... Args>
+    void w(const char* TAG, const char* format, const Args&... args) {
+        if (!enabled(Level::WARN, TAG)) return;
+        ring.put((uint8_t)Level::WARN, TAG, format, args...);
+    }
+
+    template <typename... Args>
+    void e(const char* TAG, const char* format, const Args&... args) {
+        if (!enabled(Level::ERROR, TAG)) return;
+        ring.put((uint8_t)Level::ERROR, TAG, format, args...);
+    }
+
+    void r(uint8_t* data, size_t size) {
+        if (!enabled(Level::RAW, "")) return;
+        ring.put_raw((uint8_t)Level::RAW, data, size);
+    }
+#else
+
     void log(Level level, const char* TAG, const char* format, va_list args) {
         // if (level < currentLevel) return;
         // 定义日志级别的字符串表示
@@ -63,20 +242,21 @@ class Logger {
         // 添加时间戳和级别前缀
         char finalMessage[bufferSize + 32];
         snprintf(finalMessage, sizeof(finalMessage),
-                 "[%03lu.%03lu] [%s] [%-6s] %s\n", seconds, milliseconds,
+                 "[%03lu.%03lu] [%s] [%-6s] %s\n", (unsigned long)seconds,
+                 (unsigned long)milliseconds,
                  levelStr[static_cast<int>(level)], TAG, buffer);
         // 输出日志
         output(level, finalMessage);
     }
     void v(const char* TAG, const char* format, ...) {
-        if (Level::VERBOSE < currentLevel) return;
+        if (!enabled(Level::VERBOSE, TAG)) return;
         va_list args;
         va_start(args, format);
         log(Level::VERBOSE, TAG, format, args);
         va_end(args);
     }
     void d(const char* TAG, const char* format, ...) {
-        if (Level::DEBUGL < currentLevel) return;
+        if (!enabled(Level::DEBUGL, TAG)) return;
         va_list args;
         va_start(args, format);
         log(Level::DEBUGL, TAG, format, args);
@@ -84,7 +264,7 @@ class Logger {
     }
 
     void i(const char* TAG, const char* format, ...) {
-        if (Level::INFO < currentLevel) return;
+        if (!enabled(Level::INFO, TAG)) return;
         va_list args;
         va_start(args, format);
         log(Level::INFO, TAG, format, args);
@@ -92,7 +272,7 @@ class Logger {
     }
 
     void w(const char* TAG, const char* format, ...) {
-        if (Level::WARN < currentLevel) return;
+        if (!enabled(Level::WARN, TAG)) return;
         va_list args;
         va_start(args, format);
         log(Level::WARN, TAG, format, args);
@@ -100,7 +280,7 @@ class Logger {
     }
 
     void e(const char* TAG, const char* format, ...) {
-        if (Level::ERROR < currentLevel) return;
+        if (!enabled(Level::ERROR, TAG)) return;
         va_list args;
         va_start(args, format);
         log(Level::ERROR, TAG, format, args);
@@ -108,7 +288,7 @@ class Logger {
     }
 
     void r(uint8_t* data, size_t size) {
-        if (Level::RAW < currentLevel) return;
+        if (!enabled(Level::RAW, "")) return;
         // 每个字节需要两个字符+一个空格，最后一个字节不需要空格
         char buffer[size * 3];
         for (size_t i = 0; i < size; i++) {
@@ -131,11 +311,34 @@ class Logger {
         std::strncpy(logMsg.message.data(), message, LOG_QUEUE_SIZE - 1);
         logMsg.message[LOG_QUEUE_SIZE - 1] = '\0';
 
-        // 将日志消息放入队列
-        if (!logQueue.add(logMsg, portMAX_DELAY)) {
-            printf("Failed to add log message to queue!\n");
+        // 将日志消息放入队列，队列满时丢弃并计数，不阻塞调用者
+        if (!logQueue.add(logMsg, 0)) {
+            queueDropped.fetch_add(1, std::memory_order_relaxed);
         }
     }
+#endif
+
+#ifndef LOG_DEFERRED
+   public:
+    /**
+     * @brief 取出并清零日志队列满丢弃的条数
+     */
+    uint32_t take_dropped() {
+        return queueDropped.exchange(0, std::memory_order_relaxed);
+    }
+#endif
+
+   private:
+    struct {
+        const char* tag;
+        Level level;
+    } tagLevels[LOG_TAG_LEVEL_NUM] = {};
+    volatile size_t tagLevelNum = 0;
+    // DMA发送源，定义在bsp_log.cpp，固定在主SRAM
+    static uint8_t txRing[LOG_UART_TX_RING_SIZE];
+#ifndef LOG_DEFERRED
+    std::atomic<uint32_t> queueDropped{0};
+#endif
 };
 
 class LogTask : public TaskClassS<LOG_TASK_DEPTH_SIZE> {
@@ -146,18 +349,144 @@ class LogTask : public TaskClassS<LOG_TASK_DEPTH_SIZE> {
     LogTask(Logger& Log)
         : TaskClassS<LOG_TASK_DEPTH_SIZE>("LogTask", LOG_TASK_PRIO), Log(Log) {}
 
+#ifdef LOG_DEFERRED
+    void task() override {
+        for (;;) {
+            uint32_t n = Log.ring.get(record, LogRing::MAX_RECORD);
+            if (n == 0) {
+                uint32_t dropped = Log.ring.take_dropped();
+                if (dropped == 0) {
+                    TaskBase::delay(pdMS_TO_TICKS(LOG_DEFERRED_POLL_MS));
+                    continue;
+                }
+                // 缓冲区满丢弃的记录数，作为一条记录输出
+                record[0] = LogRecord::header(
+                    LogRecord::KIND_DROP, (uint8_t)Logger::Level::WARN,
+                    LogRecord::HDR_WORDS);
+                record[1] = xTaskGetTickCount();
+                record[2] = 0;
+                record[3] = 0;
+                record[4] = dropped;
+                n = LogRecord::HDR_WORDS;
+            }
+            output(n);
+        }
+    }
+
+   private:
+    // 单条记录缓冲区，较大不放在任务栈上
+    uint32_t record[LogRing::MAX_RECORD];
+
+#ifdef LOG_DEFERRED_BINARY
+    /**
+     * @brief 原样输出记录，由上位机Scripts/log_decode.py按固件ELF还原
+     * @note 每条记录前加同步字节0xA5 0x5A
+     */
+    void output(uint32_t n) {
+        static const uint8_t sync[2] = {0xA5, 0x5A};
+        send(sync, sizeof(sync));
+        send(reinterpret_cast<const uint8_t*>(record), n * 4);
+    }
+#else
+    void output(uint32_t n) {
+        static const char* levelStr[] = {"V", "D", "I", "W", "E", "R"};
+        uint32_t hdr = record[0];
+        uint8_t level = LogRecord::level(hdr);
+        const char* lvl = level < 5 ? levelStr[level] : "?";
+        const char* TAG = reinterpret_cast<const char*>((uintptr_t)record[2]);
+        const char* fmt = reinterpret_cast<const char*>((uintptr_t)record[3]);
+        char text[LOG_QUEUE_SIZE];
+
+        switch (LogRecord::kind(hdr)) {
+            case LogRecord::KIND_FMT:
+                LogFormatter::format(text, sizeof(text), fmt, record, n);
+                line(lvl, TAG, text);
+                break;
+            case LogRecord::KIND_RAW: {
+                // 十六进制输出，过长时分多行
+                const uint8_t* data = reinterpret_cast<const uint8_t*>(
+                    &record[LogRecord::HDR_WORDS]);
+                uint32_t size = record[4];
+                if (size > (n - LogRecord::HDR_WORDS) * 4) {
+                    size = (n - LogRecord::HDR_WORDS) * 4;
+                }
+                for (uint32_t i = 0; i < size;) {
+                    size_t len = 0;
+                    for (; i < size && len + 4 <= sizeof(text); i++) {
+                        len += snprintf(text + len, 4, "%02X ", data[i]);
+                    }
+                    text[len > 0 ? len - 1 : 0] = '\0';
+                    line(lvl, "", text);
+                }
+                break;
+            }
+            case LogRecord::KIND_DROP:
+                snprintf(text, sizeof(text), "%lu log records dropped",
+                         (unsigned long)record[4]);
+                line(lvl, "Log", text);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void line(const char* level, const char* TAG, const char* text) {
+        uint32_t tick = record[1];
+        uint32_t seconds = tick / configTICK_RATE_HZ;
+        uint32_t milliseconds =
+            (tick % configTICK_RATE_HZ) * 1000 / configTICK_RATE_HZ;
+        char buffer[LOG_QUEUE_SIZE + 32];
+        int len = snprintf(buffer, sizeof(buffer),
+                           "[%03lu.%03lu] [%s] [%-6s] %s\n", seconds,
+                           milliseconds, level, TAG, text);
+        if (len >= (int)sizeof(buffer)) {
+            len = sizeof(buffer) - 1;
+            buffer[len - 1] = '\n';
+        }
+        if (len > 0) {
+            send(reinterpret_cast<const uint8_t*>(buffer), len);
+        }
+    }
+#endif
+#else
     void task() override {
         char buffer[LOG_QUEUE_SIZE + 8];
         for (;;) {
             LogMessage logMsg;
             // 从队列中获取日志消息
             if (Log.logQueue.pop(logMsg, portMAX_DELAY)) {
-                Log.uart.data_send(
-                    reinterpret_cast<const uint8_t*>(logMsg.message.data()),
-                    strlen(logMsg.message.data()));
+                uint32_t dropped = Log.take_dropped();
+                if (dropped != 0) {
+                    uint32_t tick = xTaskGetTickCount();
+                    int len = snprintf(
+                        buffer, sizeof(buffer),
+                        "[%03lu.%03lu] [W] [Log   ] %lu log messages "
+                        "dropped\n",
+                        (unsigned long)(tick / configTICK_RATE_HZ),
+                        (unsigned long)((tick % configTICK_RATE_HZ) * 1000 /
+                                        configTICK_RATE_HZ),
+                        (unsigned long)dropped);
+                    send(reinterpret_cast<const uint8_t*>(buffer), len);
+                }
+                send(reinterpret_cast<const uint8_t*>(logMsg.message.data()),
+                     strlen(logMsg.message.data()));
             }
         }
     }
+#endif
+
+   private:
+    /**
+     * @brief 整条写入串口发送缓冲区，空间不足时等待DMA发出
+     * @note LogTask优先级低，等待不影响其他任务
+     */
+    void send(const uint8_t* data, uint16_t len) {
+        while (Log.uart.tx_free() < len &&
+               Log.uart.tx_free() < LOG_UART_TX_RING_SIZE) {
+            TaskBase::delay(1);
+        }
+        Log.uart.data_send(data, len);
+    }
 };
 
 #endif
@@ -0,0 +1,410 @@
+#pragma once
+#ifndef _LOG_DEFERRED_H_
+#define _LOG_DEFERRED_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+// 延迟日志环形缓冲区大小(32位字)，需为2的幂
+#ifndef LOG_DEFERRED_RING_WORDS
+#define LOG_DEFERRED_RING_WORDS 1024
+#endif
+
+// 字符串参数最多拷贝的字节数，超出部分截断
+#define LOG_DEFERRED_STR_MAX 64
+
+// 单条记录最多的参数个数
+#define LOG_DEFERRED_MAX_ARGS 14
+
+/**
+ * @brief 延迟日志记录格式(32位字，小端)
+ * @note  [0] 记录头: 0xA5 << 24 | 类型 << 20 | 级别 << 16 | 总字数
+ *        [1] 系统tick
+ *        [2] tag指针
+ *        [3] 格式字符串指针
+ *        [4] 参数类型: 个数 << 28 | 每个参数2位类型
+ *        [5...] 参数: 32位整数1字，64位整数和double 2字(低字在前)，
+ *               字符串为1字长度 + 按字补齐的内容
+ *        RAW记录的[3]为0，[4]为字节数，其后为数据；DROP记录的[4]为丢弃条数。
+ *        tag和格式字符串只记录指针，须为静态存储的字符串常量，
+ *        上位机按固件ELF文件还原
+ */
+namespace LogRecord {
+constexpr uint32_t MAGIC = 0xA5;
+constexpr uint32_t HDR_WORDS = 5;
+
+enum Kind : uint8_t {
+    KIND_FMT = 0,     // 格式化日志
+    KIND_RAW = 1,     // 十六进制数据
+    KIND_DROP = 2,    // 缓冲区满丢弃的记录数
+};
+
+enum ArgType : uint8_t {
+    ARG_U32 = 0,
+    ARG_U64 = 1,
+    ARG_DOUBLE = 2,
+    ARG_STR = 3,
+};
+
+inline uint32_t header(Kind kind, uint8_t level, uint32_t words) {
+    return MAGIC << 24 | (uint32_t)kind << 20 | (uint32_t)(level & 0xF) << 16 |
+           (words & 0xFFFF);
+}
+inline Kind kind(uint32_t hdr) { return (Kind)((hdr >> 20) & 0xF); }
+inline uint8_t level(uint32_t hdr) { return (hdr >> 16) & 0xF; }
+inline uint32_t words(uint32_t hdr) { return hdr & 0xFFFF; }
+
+// 参数按C++类型归为四类，与格式说明无关，格式化时按类型取参数
+template <typename T>
+constexpr ArgType arg_type() {
+    using U = std::decay_t<T>;
+    if constexpr (std::is_same_v<U, const char*> || std::is_same_v<U, char*>) {
+        return ARG_STR;
+    } else if constexpr (std::is_floating_point_v<U>) {
+        return ARG_DOUBLE;
+    } else if constexpr (std::is_pointer_v<U>) {
+        return sizeof(U) > 4 ? ARG_U64 : ARG_U32;
+    } else {
+        static_assert(std::is_integral_v<U> || std::is_enum_v<U>,
+                      "unsupported log argument type");
+        return sizeof(U) > 4 ? ARG_U64 : ARG_U32;
+    }
+}
+
+inline size_t str_len(const char* s) {
+    return s == nullptr ? 0 : strnlen(s, LOG_DEFERRED_STR_MAX);
+}
+
+template <typename T>
+inline uint32_t arg_words(const T& v) {
+    if constexpr (arg_type<T>() == ARG_STR) {
+        return 1 + (str_len(v) + 3) / 4;
+    } else {
+        return arg_type<T>() == ARG_U32 ? 1 : 2;
+    }
+}
+}    // namespace LogRecord
+
+/**
+ * @brief 延迟日志的无锁环形缓冲区，多生产者单消费者
+ * @note 调用者只保留格式字符串和tag的指针、tick及参数原始值，不做格式化。
+ *       生产者以CAS预留连续的字(位置取模，不需要回绕处理)，写完数据后最后
+ *       写记录头提交；消费者见到非0记录头才读取，读完清零后释放。
+ *       缓冲区满时丢弃并计数，调用者从不阻塞，中断中也可调用
+ */
+class LogRing {
+   public:
+    static_assert((LOG_DEFERRED_RING_WORDS & (LOG_DEFERRED_RING_WORDS - 1)) ==
+                      0,
+                  "LOG_DEFERRED_RING_WORDS must be a power of 2");
+    static constexpr uint32_t SIZE = LOG_DEFERRED_RING_WORDS;
+    static constexpr uint32_t MASK = SIZE - 1;
+    // 单条记录的最大字数
+    static constexpr uint32_t MAX_RECORD =
+        LogRecord::HDR_WORDS +
+        LOG_DEFERRED_MAX_ARGS * (1 + (LOG_DEFERRED_STR_MAX + 3) / 4);
+    static_assert(MAX_RECORD <= SIZE, "LOG_DEFERRED_RING_WORDS too small");
+
+    template <typename... Args>
+    void put(uint8_t level, const char* tag, const char* fmt,
+             const Args&... args) {
+        static_assert(sizeof...(Args) <= LOG_DEFERRED_MAX_ARGS,
+                      "too many log arguments");
+        uint32_t n = LogRecord::HDR_WORDS;
+        ((n += LogRecord::arg_words(args)), ...);
+        uint32_t pos;
+        if (!__reserve(n, pos)) {
+            return;
+        }
+        uint32_t types = (uint32_t)sizeof...(Args) << 28;
+        uint32_t i = 0;
+        ((types |= (uint32_t)LogRecord::arg_type<Args>() << (2 * i++)), ...);
+
+        __set(pos + 1, xTaskGetTickCount());
+        __set(pos + 2, (uint32_t)(uintptr_t)tag);
+        __set(pos + 3, (uint32_t)(uintptr_t)fmt);
+        __set(pos + 4, types);
+        uint32_t w = pos + LogRecord::HDR_WORDS;
+        (__put_arg(w, args), ...);
+        __commit(pos, LogRecord::header(LogRecord::KIND_FMT, level, n));
+    }
+
+    void put_raw(uint8_t level, const uint8_t* data, size_t size) {
+        constexpr size_t max_size = (MAX_RECORD - LogRecord::HDR_WORDS) * 4;
+        size = size > max_size ? max_size : size;
+        uint32_t n = LogRecord::HDR_WORDS + (size + 3) / 4;
+        uint32_t pos;
+        if (!__reserve(n, pos)) {
+            return;
+        }
+        __set(pos + 1, xTaskGetTickCount());
+        __set(pos + 2, 0);
+        __set(pos + 3, 0);
+        __set(pos + 4, size);
+        __put_bytes(pos + LogRecord::HDR_WORDS, data, size);
+        __commit(pos, LogRecord::header(LogRecord::KIND_RAW, level, n));
+    }
+
+    /**
+     * @brief 消费者：取出一条已提交的记录
+     * @param out 输出缓冲区
+     * @param max 输出缓冲区字数，不小于MAX_RECORD
+     * @return 记录字数，没有已提交的记录返回0
+     */
+    uint32_t get(uint32_t* out, uint32_t max) {
+        uint32_t tail = __tail.load(std::memory_order_relaxed);
+        if (tail == __head.load(std::memory_order_acquire)) {
+            return 0;
+        }
+        uint32_t hdr = __ring[tail & MASK].load(std::memory_order_acquire);
+        if (hdr == 0) {
+            // 生产者已预留但尚未提交
+            return 0;
+        }
+        uint32_t n = LogRecord::words(hdr);
+        for (uint32_t i = 0; i < n; i++) {
+            std::atomic<uint32_t>& word = __ring[(tail + i) & MASK];
+            if (i < max) {
+                out[i] = word.load(std::memory_order_relaxed);
+            }
+            // 清零，后续记录头可能落在此处
+            word.store(0, std::memory_order_relaxed);
+        }
+        __tail.store(tail + n, std::memory_order_release);
+        return n < max ? n : max;
+    }
+
+    /**
+     * @brief 取出并清零丢弃计数
+     */
+    uint32_t take_dropped() {
+        return __dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+   private:
+    // 只有一个Logger，存储定义在bsp_log.cpp，CPU专用，放在TCM
+    static std::atomic<uint32_t> __ring[SIZE];
+    std::atomic<uint32_t> __head{0};
+    std::atomic<uint32_t> __tail{0};
+    std::atomic<uint32_t> __dropped{0};
+
+    bool __reserve(uint32_t n, uint32_t& pos) {
+        pos = __head.load(std::memory_order_relaxed);
+        do {
+            if (pos + n - __tail.load(std::memory_order_acquire) > SIZE) {
+                __dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!__head.compare_exchange_weak(pos, pos + n,
+                                               std::memory_order_relaxed));
+        return true;
+    }
+
+    void __set(uint32_t pos, uint32_t value) {
+        __ring[pos & MASK].store(value, std::memory_order_relaxed);
+    }
+
+    void __commit(uint32_t pos, uint32_t hdr) {
+        __ring[pos & MASK].store(hdr, std::memory_order_release);
+    }
+
+    void __put_bytes(uint32_t pos, const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; i += 4) {
+            uint32_t word = 0;
+            memcpy(&word, data + i, size - i < 4 ? size - i : 4);
+            __set(pos++, word);
+        }
+    }
+
+    template <typename T>
+    void __put_arg(uint32_t& pos, const T& v) {
+        constexpr LogRecord::ArgType type = LogRecord::arg_type<T>();
+        if constexpr (type == LogRecord::ARG_STR) {
+            size_t len = LogRecord::str_len(v);
+            __set(pos++, len);
+            __put_bytes(pos, (const uint8_t*)v, len);
+            pos += (len + 3) / 4;
+        } else if constexpr (type == LogRecord::ARG_DOUBLE) {
+            double d = v;
+            uint64_t bits;
+            memcpy(&bits, &d, sizeof(bits));
+            __set(pos++, (uint32_t)bits);
+            __set(pos++, (uint32_t)(bits >> 32));
+        } else if constexpr (type == LogRecord::ARG_U64) {
+            uint64_t bits = (uint64_t)v;
+            __set(pos++, (uint32_t)bits);
+            __set(pos++, (uint32_t)(bits >> 32));
+        } else {
+            // 有符号数按32位补码保存
+            __set(pos++, (uint32_t)v);
+        }
+    }
+};
+
+/**
+ * @brief 在LogTask中按记录还原日志文本
+ * @note 逐个转换说明调用snprintf，参数按记录中的类型取出再转换为格式说明
+ *       需要的类型，格式与参数不匹配时不会错位
+ */
+class LogFormatter {
+   public:
+    /**
+     * @return 输出长度，不含结尾的'\0'
+     */
+    static size_t format(char* out, size_t size, const char* fmt,
+                         const uint32_t* rec, uint32_t words) {
+        Args args{rec + LogRecord::HDR_WORDS, rec + words,
+                  rec[4] >> 28 > LOG_DEFERRED_MAX_ARGS ? 0 : rec[4] >> 28,
+                  rec[4], 0};
+        size_t len = 0;
+        while (*fmt != '\0' && len + 1 < size) {
+            if (*fmt != '%') {
+                out[len++] = *fmt++;
+                continue;
+            }
+            if (fmt[1] == '%') {
+                out[len++] = '%';
+                fmt += 2;
+                continue;
+            }
+            // 标志、宽度和精度原样保留，长度修饰按参数实际宽度重新生成
+            char spec[16];
+            size_t n = 0;
+            spec[n++] = *fmt++;
+            while (*fmt != '\0' && strchr("-+ #0123456789.", *fmt) &&
+                   n < sizeof(spec) - 4) {
+                spec[n++] = *fmt++;
+            }
+            while (*fmt != '\0' && strchr("hlLqjzt", *fmt)) {
+                fmt++;
+            }
+            char conv = *fmt;
+            if (conv == '\0') {
+                break;
+            }
+            fmt++;
+            len += __convert(out + len, size - len, spec, n, conv, args);
+            if (len >= size) {
+                len = size - 1;
+            }
+        }
+        out[len] = '\0';
+        return len;
+    }
+
+   private:
+    struct Args {
+        const uint32_t* pos;
+        const uint32_t* end;
+        uint32_t num;
+        uint32_t types;
+        uint32_t index;
+    };
+
+    static size_t __emit(int n) { return n < 0 ? 0 : (size_t)n; }
+
+    static size_t __convert(char* out, size_t size, char* spec, size_t n,
+                            char conv, Args& a) {
+        if (a.index >= a.num) {
+            return __emit(snprintf(out, size, "<?>"));
+        }
+        LogRecord::ArgType type =
+            (LogRecord::ArgType)((a.types >> (2 * a.index++)) & 0x3);
+        uint64_t value = 0;
+        const char* str = "";
+        char strbuf[LOG_DEFERRED_STR_MAX + 1];
+        uint32_t need = type == LogRecord::ARG_U32 ? 1 : 2;
+        if (type == LogRecord::ARG_STR) {
+            uint32_t len = a.pos < a.end ? *a.pos : 0;
+            need = 1 + (len + 3) / 4;
+            if (len > LOG_DEFERRED_STR_MAX || a.pos + need > a.end) {
+                a.num = 0;
+                return __emit(snprintf(out, size, "<?>"));
+            }
+            memcpy(strbuf, a.pos + 1, len);
+            strbuf[len] = '\0';
+            str = strbuf;
+        } else if (a.pos + need > a.end) {
+            a.num = 0;
+            return __emit(snprintf(out, size, "<?>"));
+        } else {
+            value = a.pos[0];
+            if (need == 2) {
+                value |= (uint64_t)a.pos[1] << 32;
+            }
+        }
+        a.pos += need;
+
+        switch (conv) {
+            case 's':
+                if (type != LogRecord::ARG_STR) {
+                    return __emit(snprintf(out, size, "<?>"));
+                }
+                spec[n++] = 's';
+                spec[n] = '\0';
+                return __emit(snprintf(out, size, spec, str));
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G': {
+                double d;
+                if (type == LogRecord::ARG_DOUBLE) {
+                    memcpy(&d, &value, sizeof(d));
+                } else {
+                    d = (double)(int64_t)__sign(value, type);
+                }
+                spec[n++] = conv;
+                spec[n] = '\0';
+                return __emit(snprintf(out, size, spec, d));
+            }
+            case 'p':
+                return __emit(snprintf(out, size, "0x%08lx", (long)value));
+            case 'c':
+                spec[n++] = 'c';
+                spec[n] = '\0';
+                return __emit(snprintf(out, size, spec, (int)value));
+            case 'd':
+            case 'i':
+                value = __sign(value, type);
+                // fallthrough
+            default:
+                if (!strchr("diuoxX", conv)) {
+                    return __emit(snprintf(out, size, "<?>"));
+                }
+                // 32位参数用long(ARM上为32位)，newlib-nano不支持long long
+                if (type == LogRecord::ARG_U64) {
+                    spec[n++] = 'l';
+                    spec[n++] = 'l';
+                    spec[n++] = conv;
+                    spec[n] = '\0';
+                    return __emit(
+                        snprintf(out, size, spec, (unsigned long long)value));
+                }
+                spec[n++] = 'l';
+                spec[n++] = conv;
+                spec[n] = '\0';
+                if (conv == 'd' || conv == 'i') {
+                    return __emit(
+                        snprintf(out, size, spec, (long)(int32_t)value));
+                }
+                return __emit(
+                    snprintf(out, size, spec, (unsigned long)(uint32_t)value));
+        }
+    }
+
+    // 32位参数按补码扩展为64位
+    static uint64_t __sign(uint64_t value, LogRecord::ArgType type) {
+        if (type == LogRecord::ARG_U32) {
+            return (uint64_t)(int64_t)(int32_t)value;
+        }
+        return value;
+    }
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef BSP_RUNTIME_STATS_H
+#define BSP_RUNTIME_STATS_H
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* 中断按来源分组统计占用时间 */
+typedef enum {
+    ISR_STAT_ENET = 0,
+    ISR_STAT_UART,
+    ISR_STAT_DMA,
+    ISR_STAT_EXTI,
+    ISR_STAT_SPI,
+    ISR_STAT_NUM
+} IsrStatId;
+
+#ifdef RUN_TIME_STATS
+/* FreeRTOS运行时间统计时钟: DWT周期计数器，软件扩展为64位 */
+void vConfigureTimerForRunTimeStats(void);
+uint64_t ulGetRunTimeCounterValue(void);
+
+uint32_t isr_stat_enter(void);
+void isr_stat_exit(IsrStatId id, uint32_t start);
+
+/* 分组累计的周期数和进入次数，嵌套的中断同时计入外层分组 */
+uint64_t isr_stat_cycles(IsrStatId id);
+uint32_t isr_stat_count(IsrStatId id);
+/* 处于中断中的总周期数，嵌套部分只计一次 */
+uint64_t isr_stat_total(void);
+
+/* 在中断服务函数开头和结尾成对使用，中间提前return的路径不计入 */
+#define ISR_STAT_ENTER()  uint32_t isr_stat_start = isr_stat_enter()
+#define ISR_STAT_EXIT(id) isr_stat_exit((id), isr_stat_start)
+#else
+#define ISR_STAT_ENTER()  do {} while (0)
+#define ISR_STAT_EXIT(id) do {} while (0)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
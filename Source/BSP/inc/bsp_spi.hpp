@@ -1,5 +1,7 @@
 #ifndef BSP_SPI_H
 #define BSP_SPI_H
+// 主机仿真构建没有SPI外设，应用层未使用
+#ifndef HOST_SIM
 #include <cstdint>
 #include <type_traits>
 #include <vector>
@@ -190,12 +192,17 @@ class SpiMaster : private SpiDevBase {
 
     bool send(std::vector<uint8_t> tx_data, uint16_t timeout_ms = 1000,
               uint8_t nss_index = 0) {
+        return send(tx_data.data(), tx_data.size(), timeout_ms, nss_index);
+    }
+
+    bool send(const uint8_t* tx_data, uint32_t tx_len,
+              uint16_t timeout_ms = 1000, uint8_t nss_index = 0) {
         uint32_t timeout_tick = pdMS_TO_TICKS(timeout_ms);
         uint32_t txcount = 0;
         // nss_low(nss_index);
 
         uint32_t tickstart = xTaskGetTickCount();
-        while (txcount < tx_data.size()) {
+        while (txcount < tx_len) {
             if (SET == spi_i2s_flag_get(__cfg.spi_periph, SPI_FLAG_TBE)) {
                 spi_i2s_data_transmit(__cfg.spi_periph, tx_data[txcount++]);
             }
@@ -521,4 +528,5 @@ class SpiDev : public std::conditional<mode == SpiMode::Master, SpiMaster,
     Spi_IOConfig __cfg;
 };
 
+#endif
 #endif
\ No newline at end of file
@@ -0,0 +1,129 @@
+#ifndef BSP_TCM_HPP
+#define BSP_TCM_HPP
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "bsp_allocate.hpp"
+
+// TCM SRAM(0x10000000，64KB)只连接CPU数据总线，DMA和ENET不能访问
+#define TCM_BASE 0x10000000U
+#define TCM_SIZE (64U * 1024U)
+
+// TCM中任务栈和热点容器共用的堆大小，其余留给TCM_BSS/TCM_DATA变量
+#ifndef TCM_HEAP_SIZE
+#define TCM_HEAP_SIZE (48U * 1024U)
+#endif
+
+/**
+ * @brief 变量放置属性
+ * @note TCM_BSS: 零初始化的CPU专用热点数据，放在TCM，启动时清零；
+ *       TCM_DATA: 带初值的CPU专用数据，启动时从Flash复制到TCM；
+ *       DMA_BSS: DMA访问的缓冲区，链接脚本把它放在主SRAM的.bss中。
+ *       同一变量同时使用DMA_BSS和TCM_*时编译报section冲突。
+ *       未开启TCM_PLACEMENT时TCM_*为空，变量留在主SRAM，便于对比测试
+ */
+#ifdef TCM_PLACEMENT
+#define TCM_BSS  __attribute__((section(".tcmbss")))
+#define TCM_DATA __attribute__((section(".tcmram")))
+#else
+#define TCM_BSS
+#define TCM_DATA
+#endif
+#ifdef HOST_SIM
+#define DMA_BSS
+#else
+#define DMA_BSS __attribute__((section(".dmabss")))
+#endif
+
+// 地址可被DMA访问(不在TCM中)
+#define DMA_ACCESSIBLE(addr) \
+    ((((uint32_t)(uintptr_t)(addr)) - TCM_BASE) >= TCM_SIZE)
+
+/**
+ * @brief TCM中的首次适配堆，供任务栈和扫描矩阵等CPU专用的数据使用
+ * @note 空闲块按地址排序，释放时与相邻块合并；由挂起调度器保护，
+ *       不能在中断中调用。空间不足返回nullptr，由调用者退回主SRAM。
+ *       未开启TCM_PLACEMENT时总是返回nullptr
+ */
+class TcmHeap {
+   public:
+    struct Stats {
+        uint32_t size;
+        uint32_t free;
+        uint32_t min_free;    // 历史最小剩余
+        uint32_t fail;        // 空间不足退回主SRAM的次数
+        uint32_t dma_fallback;    // TCM中的数据不能交给DMA、改为逐字节
+                                  // 或拷贝发送的次数
+    };
+
+    static void* alloc(size_t size);
+    static void free(void* p);
+    static bool contains(const void* p);
+    static Stats stats();
+
+    // 发送路径遇到TCM中的数据时调用，任务和中断中均可
+    static void count_dma_fallback() {
+        __dma_fallback.fetch_add(1, std::memory_order_relaxed);
+    }
+
+   private:
+    static std::atomic<uint32_t> __dma_fallback;
+#ifdef TCM_PLACEMENT
+    struct Block {
+        Block* next;    // 仅空闲块使用
+        size_t size;    // 含块头的字节数
+    };
+    static constexpr size_t HEADER = (sizeof(Block) + 7) & ~(size_t)7;
+
+    static void __init();
+
+    static uint8_t __heap[TCM_HEAP_SIZE];
+    static Block* __free;
+    static uint32_t __free_bytes;
+    static uint32_t __min_free;
+    static uint32_t __fail;
+    static bool __ready;
+#endif
+};
+
+/**
+ * @brief 优先从TCM分配的STL分配器，TCM不足时退回MemPool
+ * @note 元素只能由CPU访问，不能交给DMA或协议栈零拷贝发送
+ */
+template <class T>
+class TcmAllocator {
+   public:
+    using value_type = T;
+
+    TcmAllocator() noexcept = default;
+
+    template <class U>
+    TcmAllocator(const TcmAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        size_t size = n * sizeof(T);
+        void* p = TcmHeap::alloc(size);
+        return static_cast<T*>(p != nullptr ? p : MemPool::alloc(size));
+    }
+
+    void deallocate(T* p, size_t) {
+        if (TcmHeap::contains(p)) {
+            TcmHeap::free(p);
+        } else {
+            MemPool::free(p);
+        }
+    }
+};
+
+template <class T, class U>
+bool operator==(const TcmAllocator<T>&, const TcmAllocator<U>&) {
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const TcmAllocator<T>&, const TcmAllocator<U>&) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,158 @@
+#ifndef BSP_TRACE_HPP
+#define BSP_TRACE_HPP
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "bsp_allocate.hpp"
+#include "gd32f4xx.h"
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "task.h"
+}
+
+// 事件环形缓冲区的记录数，需为2的幂
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 256
+#endif
+// 导出时附带的任务名表最多任务数
+#define TRACE_TASK_MAX      16
+#define TRACE_TASK_NAME_LEN 12
+
+/**
+ * @brief 跟踪事件编号，与Scripts/trace_export.py中的EVENTS一致
+ * @note 成对事件用TRACE_BEGIN/TRACE_END，单点事件用TRACE_MARK
+ */
+enum class TraceEvent : uint16_t {
+    SYNC_TIMER = 1,    // 主机同步定时器到期
+    SYNC_SEND,         // 主机发出同步帧
+    READ_CYCLE,        // 主机一轮读取所有从机，参数为从机数/成功数
+    READ_COND,         // 主机读取一台从机导通数据，参数为从机ID/结果
+    UWB_SEND,          // UWB::__send_packet，结束参数为结果
+    SCAN,              // 从机一次导通扫描，参数为行数
+    SCAN_ROW,          // 从机扫描一行，参数为行号
+    COND_REPLY,        // 从机回复导通数据，参数为数据字节数
+    BACKEND_SEND,      // 主机向上位机发送，参数为字节数或帧数
+    BACKEND_RECV,      // 主机收到上位机数据报，参数为字节数
+    SCAN_SAMPLE,       // 从机读取一行各列的输入，参数为列数/行号
+    UCI_PARSE,         // UWB解析一段接收数据，参数为字节数/已解析字节数
+};
+
+#ifdef EVENT_TRACE
+#define TRACE_BEGIN(ev, arg) \
+    Trace::record(TraceEvent::ev, Trace::BEGIN, (uint32_t)(arg))
+#define TRACE_END(ev, arg) \
+    Trace::record(TraceEvent::ev, Trace::END, (uint32_t)(arg))
+#define TRACE_MARK(ev, arg) \
+    Trace::record(TraceEvent::ev, Trace::MARK, (uint32_t)(arg))
+#else
+// 参数不求值，只在sizeof中引用，避免仅用于跟踪的变量产生未使用告警
+#define TRACE_BEGIN(ev, arg) do { (void)sizeof(arg); } while (0)
+#define TRACE_END(ev, arg)   do { (void)sizeof(arg); } while (0)
+#define TRACE_MARK(ev, arg)  do { (void)sizeof(arg); } while (0)
+#endif
+
+/**
+ * @brief 热点路径事件跟踪：定长记录(事件、DWT周期计数、一个参数)写入RAM
+ *        环形缓冲区，满后覆盖最旧的记录
+ * @note 生产者以fetch_add取得序号，不加锁，任务和中断中都可调用。
+ *       每条记录的标记字含序号低16位，写入前清零、写完最后提交，读取时
+ *       前后两次读到相同的标记且序号匹配才有效，被覆盖或未写完的记录跳过。
+ *       导出前先freeze停止记录，resume后从空缓冲区重新开始。
+ *       未开启EVENT_TRACE时记录宏为空，导出只有头部且flags为0。
+ *
+ * 导出格式(小端)，可分多段导出，每段独立可解析:
+ *   magic u16 (0x5254), version u8, flags u8 (bit0 已编译, bit1 记录中),
+ *   core_hz u32, lost u32 (被覆盖的记录数), total u16, start u16, next u16,
+ *   task_num u8, {handle u32, name char[12]}   (仅start为0的段带任务表)
+ *   num u16, {cycle u32, ctx u32, arg u32, id u16}
+ *   total为冻结时可导出的记录数，本段覆盖[start, next)，next >= total时结束；
+ *   ctx小于256时为中断号(IPSR)，否则为任务句柄；
+ *   id高2位为Phase，低14位为TraceEvent
+ */
+class Trace {
+   public:
+    enum Phase : uint8_t { MARK = 0, BEGIN = 1, END = 2 };
+
+    static constexpr uint16_t MAGIC = 0x5254;
+    static constexpr uint8_t VERSION = 1;
+    static constexpr uint8_t FLAG_COMPILED = 0x01;
+    static constexpr uint8_t FLAG_RECORDING = 0x02;
+    // 导出格式中每条记录的字节数
+    static constexpr size_t RECORD_SIZE = 14;
+
+    /**
+     * @brief 开启DWT周期计数器并开始记录，在main中调用
+     */
+    static void start();
+
+    // 停止记录，保留缓冲区内容供导出
+    static void freeze();
+
+    // 清空缓冲区并重新开始记录
+    static void resume();
+
+    /**
+     * @brief 追加一段导出数据
+     * @param start 起始记录，从冻结时最旧的记录开始计
+     * @param max 本段最多的记录数
+     * @return 下一段的起始记录，已全部导出时返回0
+     */
+    static uint16_t serialize(PoolVector<uint8_t>& out, uint16_t start,
+                              uint16_t max);
+
+#ifdef EVENT_TRACE
+    static void record(TraceEvent event, Phase phase, uint32_t arg) {
+        if (!recording.load(std::memory_order_relaxed)) {
+            return;
+        }
+        uint32_t cycle = DWT->CYCCNT;
+        uint32_t index = next.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = ring[index & MASK];
+        slot.tag.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.cycle.store(cycle, std::memory_order_relaxed);
+        slot.ctx.store(context(), std::memory_order_relaxed);
+        slot.arg.store(arg, std::memory_order_relaxed);
+        slot.tag.store(tag_of(index, (uint32_t)phase << 14 |
+                                         (uint32_t)event),
+                       std::memory_order_release);
+    }
+
+   private:
+    static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0,
+                  "TRACE_RING_SIZE must be a power of 2");
+    static_assert(TRACE_RING_SIZE <= 0x8000, "TRACE_RING_SIZE too large");
+    static constexpr uint32_t MASK = TRACE_RING_SIZE - 1;
+
+    struct Slot {
+        std::atomic<uint32_t> tag;    // id << 16 | (序号 + 1)低16位，0为无效
+        std::atomic<uint32_t> cycle;
+        std::atomic<uint32_t> ctx;
+        std::atomic<uint32_t> arg;
+    };
+
+    static uint32_t tag_of(uint32_t index, uint32_t id) {
+        return id << 16 | ((index + 1) & 0xFFFF);
+    }
+
+    static uint32_t context() {
+        uint32_t ipsr = __get_IPSR();
+        if (ipsr != 0) {
+            return ipsr;
+        }
+        return (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle();
+    }
+
+    static Slot ring[TRACE_RING_SIZE];
+    static std::atomic<uint32_t> next;
+    static std::atomic<bool> recording;
+    // 有效记录的起点(resume时的序号)和冻结时的终点
+    static uint32_t base;
+    static uint32_t end;
+    static TaskStatus_t task_status[TRACE_TASK_MAX];
+#endif
+};
+
+#endif
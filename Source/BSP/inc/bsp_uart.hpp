@@ -1,6 +1,10 @@
 // #include "cstdio.h"
 #ifndef BSP_UART_HPP
 #define BSP_UART_HPP
+#ifdef HOST_SIM
+// 主机仿真构建的串口见Source/Host
+#include "host_uart.hpp"
+#else
 
 #include <cstdint>
 #include <cstring>
@@ -9,6 +13,8 @@
 
 #include "QueueCPP.h"
 #include "bsp_gpio.hpp"
+#include "bsp_runtime_stats.h"
+#include "bsp_tcm.hpp"
 
 
 extern "C" {
@@ -43,6 +49,7 @@ typedef struct {
     uint16_t rx_count;
     SemaphoreHandle_t dmaRxDoneSema;
     bool use_dma;
+    bool rx_ring;    // 环形DMA接收模式
 } UasrtInfo;
 
 class UartConfig {
@@ -66,9 +73,10 @@ class UartConfig {
     uint16_t *rx_count;                    // 接收计数
     bool use_dma;                          // 是否使用DMA
     uint16_t rxQueueSize;                  // 接收队列大小
+    bool rx_ring;                          // 环形DMA接收(IDLE/HT/FT中断)
 
     UartConfig(UasrtInfo &info, bool enable_dma = true,
-               uint16_t _rxQueueSize = 1)
+               uint16_t _rxQueueSize = 1, bool enable_rx_ring = false)
         : baudrate(info.baudrate),
           gpio_port(info.gpio_port),
           tx_pin(info.tx_pin),
@@ -86,9 +94,11 @@ class UartConfig {
           nvic_irq_pre_priority(info.nvic_irq_pre_priority),
           nvic_irq_sub_priority(info.nvic_irq_sub_priority),
           rx_count(&info.rx_count),    // 传递 rx_count 指针
-          use_dma(enable_dma),
-          rxQueueSize(_rxQueueSize) {
-        info.use_dma = enable_dma;
+          use_dma(enable_dma || enable_rx_ring),
+          rxQueueSize(_rxQueueSize),
+          rx_ring(enable_rx_ring) {
+        info.use_dma = use_dma;
+        info.rx_ring = rx_ring;
     }
 };
 
@@ -109,6 +119,14 @@ void UART3_IRQHandler(void);
 void USART5_IRQHandler(void);
 void UART6_IRQHandler(void);
 void UART7_IRQHandler(void);
+void DMA0_Channel0_IRQHandler(void);
+void DMA0_Channel1_IRQHandler(void);
+void DMA0_Channel2_IRQHandler(void);
+void DMA0_Channel3_IRQHandler(void);
+void DMA0_Channel4_IRQHandler(void);
+void DMA0_Channel5_IRQHandler(void);
+void DMA0_Channel6_IRQHandler(void);
+void DMA1_Channel2_IRQHandler(void);
 }
 
 class Uart {
@@ -120,6 +138,14 @@ class Uart {
     friend void USART5_IRQHandler(void);
     friend void UART6_IRQHandler(void);
     friend void UART7_IRQHandler(void);
+    friend void DMA0_Channel0_IRQHandler(void);
+    friend void DMA0_Channel1_IRQHandler(void);
+    friend void DMA0_Channel2_IRQHandler(void);
+    friend void DMA0_Channel3_IRQHandler(void);
+    friend void DMA0_Channel4_IRQHandler(void);
+    friend void DMA0_Channel5_IRQHandler(void);
+    friend void DMA0_Channel6_IRQHandler(void);
+    friend void DMA1_Channel2_IRQHandler(void);
 
     Uart(UartConfig &config) : config(config), rxQueue(config.rxQueueSize) {
         initBSP();
@@ -132,7 +158,14 @@ class Uart {
         }
     }
 
+    /**
+     * @brief 发送数据，启用发送环形缓冲区时写入缓冲区后立即返回
+     */
     void data_send(const uint8_t *data, uint16_t len) {
+        if (tx_buf != nullptr) {
+            tx_write(data, len);
+            return;
+        }
         for (uint16_t i = 0; i < len; i++) {
             usart_data_transmit(config.usart_periph, data[i]);
             while (RESET == usart_flag_get(config.usart_periph, USART_FLAG_TC));
@@ -148,7 +181,8 @@ class Uart {
     }
 
     void send(const uint8_t *data, uint16_t len) {
-        if (config.use_dma) {
+        // 任务栈等在TCM中的数据DMA不能访问，改为逐字节发送
+        if (config.use_dma && DMA_ACCESSIBLE(data)) {
             dma_channel_disable(config.dma_periph, config.dma_tx_channel);
             dma_flag_clear(config.dma_periph, config.dma_tx_channel,
                            DMA_FLAG_FTF);
@@ -156,9 +190,14 @@ class Uart {
                                       DMA_MEMORY_0, (uintptr_t)data);
             dma_transfer_number_config(config.dma_periph, config.dma_tx_channel,
                                        len);
+            // 清除上一次发送遗留的TC标志，避免DMA未发完就返回
+            usart_flag_clear(config.usart_periph, USART_FLAG_TC);
             dma_channel_enable(config.dma_periph, config.dma_tx_channel);
             while (RESET == usart_flag_get(config.usart_periph, USART_FLAG_TC));
         } else {
+            if (config.use_dma) {
+                TcmHeap::count_dma_fallback();
+            }
             for (uint16_t i = 0; i < len; i++) {
                 usart_data_transmit(config.usart_periph, *(data + i));
                 while (RESET ==
@@ -167,17 +206,128 @@ class Uart {
         }
     }
 
+    /**
+     * @brief 启用DMA发送环形缓冲区，之后data_send不再等待发送完成
+     * @param buf 缓冲区，由调用者提供并一直有效
+     * @note 只初始化发送DMA通道，不影响接收方式
+     */
+    void tx_ring_init(uint8_t *buf, uint16_t size) {
+        configASSERT(DMA_ACCESSIBLE(buf));
+        tx_size = size;
+        initDmaTx();
+        dma_interrupt_enable(config.dma_periph, config.dma_tx_channel,
+                             DMA_INT_FTF);
+        nvic_irq_enable(dma_irqn(config.dma_tx_channel),
+                        config.nvic_irq_pre_priority,
+                        config.nvic_irq_sub_priority);
+        tx_buf = buf;
+    }
+
+    /**
+     * @brief 写入发送环形缓冲区，DMA在后台发出，不等待
+     * @return 写入的字节数，缓冲区满时丢弃剩余部分并计入tx_drop_count
+     * @note 任务中调用，多个任务可同时写入
+     */
+    uint16_t tx_write(const uint8_t *data, uint16_t len) {
+        taskENTER_CRITICAL();
+        uint32_t space = tx_size - (tx_head - tx_tail);
+        uint16_t n = len < space ? len : space;
+        uint16_t pos = tx_head % tx_size;
+        uint16_t first = n < tx_size - pos ? n : tx_size - pos;
+        memcpy(tx_buf + pos, data, first);
+        memcpy(tx_buf, data + first, n - first);
+        tx_head += n;
+        tx_dropped += len - n;
+        if (tx_busy == 0) {
+            tx_kick();
+        }
+        taskEXIT_CRITICAL();
+        return n;
+    }
+
+    /* 发送环形缓冲区剩余空间 */
+    uint16_t tx_free() const { return tx_size - (tx_head - tx_tail); }
+
+    /* 发送环形缓冲区满丢弃的字节数 */
+    uint32_t tx_drop_count() const { return tx_dropped; }
+
+    /**
+     * @brief 按外设写入已启用的发送环形缓冲区，供_write等系统调用使用
+     * @return 该外设未启用发送环形缓冲区，或在中断中/中断被屏蔽时返回false，
+     *         由调用者直接发送
+     */
+    static bool tx_ring_write(uint32_t usart_periph, const uint8_t *data,
+                              uint16_t len) {
+        if (__get_IPSR() != 0 || __get_PRIMASK() != 0 ||
+            __get_BASEPRI() != 0) {
+            return false;
+        }
+        for (uint8_t i = 0; i < _UART_NUM; i++) {
+            if (dev[i] != nullptr && dev[i]->tx_buf != nullptr &&
+                dev[i]->config.usart_periph == usart_periph) {
+                dev[i]->tx_write(data, len);
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool recv_1byte(uint8_t &data, TickType_t time = portMAX_DELAY) {
         if (!config.use_dma) {
             return rxQueue.pop(data, time);
         }
+        if (config.rx_ring) {
+            const uint8_t *span;
+            if (rx_peek(span) > 0) {
+                data = *span;
+                rx_consume(1);
+                return true;
+            }
+        }
         return false;
     }
 
+    /**
+     * @brief 环形接收模式下获取一段连续的已接收数据，不拷贝
+     * @param data 连续数据的起始地址
+     * @return 连续数据长度，无数据返回0
+     * @note 单生产者(中断)/单消费者(任务)，无锁。数据用完后调用rx_consume
+     */
+    uint16_t rx_peek(const uint8_t *&data) {
+        uint32_t written = rx_written;
+        uint32_t avail = written - rx_read;
+        if (avail > DMA_RX_BUFFER_SIZE) {
+            // 消费过慢，未读数据已被DMA覆盖，丢弃被覆盖的部分
+            rx_overrun += avail - DMA_RX_BUFFER_SIZE;
+            rx_read = written - DMA_RX_BUFFER_SIZE;
+            avail = DMA_RX_BUFFER_SIZE;
+        }
+        uint16_t pos = rx_read % DMA_RX_BUFFER_SIZE;
+        uint16_t contiguous = DMA_RX_BUFFER_SIZE - pos;
+        data = dmaRxBuffer + pos;
+        return avail < contiguous ? avail : contiguous;
+    }
+
+    /**
+     * @brief 释放rx_peek取得的数据
+     * @param len 已处理的字节数
+     */
+    void rx_consume(uint16_t len) { rx_read += len; }
+
+    /* 环形接收溢出丢弃的字节数 */
+    uint32_t rx_overrun_count() const { return rx_overrun; }
+
     std::vector<uint8_t> getReceivedData() {
         std::vector<uint8_t> buffer;
         // Resize the buffer to ensure it has enough space
-        if (config.use_dma) {
+        if (config.rx_ring) {
+            const uint8_t *span;
+            uint16_t len;
+            while ((len = rx_peek(span)) > 0) {
+                buffer.insert(buffer.end(), span, span + len);
+                rx_consume(len);
+            }
+        } else if (config.use_dma) {
             buffer.resize(*config.rx_count);
             memcpy(buffer.data(), dmaRxBuffer, *config.rx_count);
             // clear
@@ -214,7 +364,131 @@ class Uart {
     Queue<uint8_t> rxQueue;
     long waswoken = pdFALSE;
 
+    // 环形接收: rx_written只由中断推进，rx_read只由任务推进
+    volatile uint32_t rx_written = 0;
+    uint32_t rx_read = 0;
+    uint16_t rx_dma_pos = 0;
+    uint32_t rx_overrun = 0;
+
+    // 发送环形缓冲区: tx_head由任务推进，tx_tail由DMA完成中断推进
+    uint8_t *tx_buf = nullptr;
+    uint16_t tx_size = 0;
+    volatile uint32_t tx_head = 0;
+    volatile uint32_t tx_tail = 0;
+    volatile uint16_t tx_busy = 0;    // DMA正在发送的字节数
+    volatile uint32_t tx_dropped = 0;
+
+    /**
+     * @brief DMA空闲时发送缓冲区中下一段连续数据
+     * @note 在临界区或DMA发送完成中断中调用
+     */
+    void tx_kick() {
+        uint32_t pending = tx_head - tx_tail;
+        if (pending == 0) {
+            return;
+        }
+        uint16_t pos = tx_tail % tx_size;
+        uint16_t len = pending < (uint32_t)(tx_size - pos)
+                           ? pending
+                           : tx_size - pos;
+        tx_busy = len;
+        dma_channel_disable(config.dma_periph, config.dma_tx_channel);
+        dma_flag_clear(config.dma_periph, config.dma_tx_channel, DMA_FLAG_FTF);
+        dma_memory_address_config(config.dma_periph, config.dma_tx_channel,
+                                  DMA_MEMORY_0, (uintptr_t)(tx_buf + pos));
+        dma_transfer_number_config(config.dma_periph, config.dma_tx_channel,
+                                   len);
+        dma_channel_enable(config.dma_periph, config.dma_tx_channel);
+    }
+
+    void dma_tx_irq_handler() {
+        if (RESET != dma_interrupt_flag_get(config.dma_periph,
+                                            config.dma_tx_channel,
+                                            DMA_INT_FLAG_FTF)) {
+            dma_interrupt_flag_clear(config.dma_periph, config.dma_tx_channel,
+                                     DMA_INT_FLAG_FTF);
+            tx_tail += tx_busy;
+            tx_busy = 0;
+            tx_kick();
+        }
+    }
+
+    /**
+     * @brief 按DMA当前写位置推进rx_written，在IDLE/HT/FT中断中调用
+     */
+    void rx_ring_advance() {
+        uint16_t pos = DMA_RX_BUFFER_SIZE -
+                       dma_transfer_number_get(config.dma_periph,
+                                               config.dma_rx_channel);
+        if (pos >= DMA_RX_BUFFER_SIZE) {
+            pos = 0;
+        }
+        rx_written +=
+            (uint16_t)(pos + DMA_RX_BUFFER_SIZE - rx_dma_pos) %
+            DMA_RX_BUFFER_SIZE;
+        rx_dma_pos = pos;
+    }
+
+    void dma_rx_irq_handler() {
+        if (RESET != dma_interrupt_flag_get(config.dma_periph,
+                                            config.dma_rx_channel,
+                                            DMA_INT_FLAG_HTF)) {
+            dma_interrupt_flag_clear(config.dma_periph, config.dma_rx_channel,
+                                     DMA_INT_FLAG_HTF);
+        }
+        if (RESET != dma_interrupt_flag_get(config.dma_periph,
+                                            config.dma_rx_channel,
+                                            DMA_INT_FLAG_FTF)) {
+            dma_interrupt_flag_clear(config.dma_periph, config.dma_rx_channel,
+                                     DMA_INT_FLAG_FTF);
+        }
+        rx_ring_advance();
+    }
+
+    static void dma_tx_irq(uint32_t dma_periph, dma_channel_enum channel) {
+        ISR_STAT_ENTER();
+        for (uint8_t i = 0; i < _UART_NUM; i++) {
+            if (dev[i] != nullptr && dev[i]->tx_buf != nullptr &&
+                dev[i]->config.dma_periph == dma_periph &&
+                dev[i]->config.dma_tx_channel == channel) {
+                dev[i]->dma_tx_irq_handler();
+                break;
+            }
+        }
+        ISR_STAT_EXIT(ISR_STAT_DMA);
+    }
+
+    static void dma_rx_irq(uint32_t dma_periph, dma_channel_enum channel) {
+        ISR_STAT_ENTER();
+        for (uint8_t i = 0; i < _UART_NUM; i++) {
+            if (dev[i] != nullptr && dev[i]->config.rx_ring &&
+                dev[i]->config.dma_periph == dma_periph &&
+                dev[i]->config.dma_rx_channel == channel) {
+                dev[i]->dma_rx_irq_handler();
+                break;
+            }
+        }
+        ISR_STAT_EXIT(ISR_STAT_DMA);
+    }
+
+    uint8_t dma_irqn(dma_channel_enum channel) {
+        uint8_t ch = channel;
+        if (config.dma_periph == DMA0) {
+            return ch < 7 ? DMA0_Channel0_IRQn + ch : DMA0_Channel7_IRQn;
+        }
+        return ch < 5 ? DMA1_Channel0_IRQn + ch : DMA1_Channel5_IRQn + ch - 5;
+    }
+
     void irq_handler() {
+        if (config.rx_ring) {
+            if (RESET != usart_interrupt_flag_get(config.usart_periph,
+                                                  USART_INT_FLAG_IDLE)) {
+                /* clear IDLE flag */
+                usart_data_receive(config.usart_periph);
+                rx_ring_advance();
+            }
+            return;
+        }
         if (!config.use_dma) {
             if (RESET != usart_interrupt_flag_get(config.usart_periph,
                                                   USART_INT_FLAG_RBNE)) {
@@ -331,6 +605,8 @@ class Uart {
                         config.nvic_irq_sub_priority);
         rcu_periph_clock_enable(config.rcu_dma_periph);
         dma_deinit(config.dma_periph, config.dma_rx_channel);
+        // 接收缓冲区在对象内，Uart对象不能放在TCM
+        configASSERT(DMA_ACCESSIBLE(dmaRxBuffer));
         dmaInitStruct.direction = DMA_PERIPH_TO_MEMORY;
         dmaInitStruct.memory0_addr = (uintptr_t)dmaRxBuffer;
         dmaInitStruct.memory_inc = DMA_MEMORY_INCREASE_ENABLE;
@@ -339,9 +615,23 @@ class Uart {
         dmaInitStruct.periph_inc = DMA_PERIPH_INCREASE_DISABLE;
         dmaInitStruct.periph_memory_width = DMA_PERIPH_WIDTH_8BIT;
         dmaInitStruct.priority = DMA_PRIORITY_ULTRA_HIGH;
+        dmaInitStruct.circular_mode = config.rx_ring
+                                          ? DMA_CIRCULAR_MODE_ENABLE
+                                          : DMA_CIRCULAR_MODE_DISABLE;
         dma_single_data_mode_init(config.dma_periph, config.dma_rx_channel,
                                   &dmaInitStruct);
-        dma_circulation_disable(config.dma_periph, config.dma_rx_channel);
+        if (config.rx_ring) {
+            // 环形接收: 半满/全满中断保证两次推进之间不超过半个缓冲区
+            dma_circulation_enable(config.dma_periph, config.dma_rx_channel);
+            dma_interrupt_enable(config.dma_periph, config.dma_rx_channel,
+                                 DMA_INT_HTF | DMA_INT_FTF);
+            // 与USART中断同优先级，避免推进rx_written时互相抢占
+            nvic_irq_enable(dma_irqn(config.dma_rx_channel),
+                            config.nvic_irq_pre_priority,
+                            config.nvic_irq_sub_priority);
+        } else {
+            dma_circulation_disable(config.dma_periph, config.dma_rx_channel);
+        }
         dma_channel_subperipheral_select(
             config.dma_periph, config.dma_rx_channel, config.dma_sub_per);
         dma_channel_enable(config.dma_periph, config.dma_rx_channel);
@@ -368,3 +658,4 @@ class Rs485 {
     GPIO ctrl;
 };
 #endif
+#endif
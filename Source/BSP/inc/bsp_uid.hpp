@@ -1,15 +1,23 @@
 #include <array>
 #include <cstdint>
 
+#ifdef HOST_SIM
+#include "host_sim.hpp"
+#endif
+
 class UIDReader {
     public:
      // 获取UID值（静态方法）
      static uint32_t get() {
+#ifdef HOST_SIM
+         return HostSim::uid();
+#else
          static uint32_t value = []{
              uint32_t* uid_address = reinterpret_cast<uint32_t*>(0x1FFF7A10);
              return *uid_address;
          }();
          return value;
+#endif
      }
  
     private:
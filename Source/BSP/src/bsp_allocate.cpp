@@ -1,13 +1,85 @@
 #include "bsp_allocate.hpp"
 #include <new>
-void *operator new(size_t size) 
+
+#include "bsp_diag.hpp"
+
+extern "C" {
+#include "task.h"
+}
+
+// FreeRTOS堆(configAPPLICATION_ALLOCATED_HEAP)，链接脚本把.heap段放在.bss
+// 之后并检查RAM余量；NOLOAD段不清零，heap_4首次分配时建立空闲链表。
+// 主机仿真构建没有该链接脚本，堆留在.bss
+extern "C" {
+#ifdef HOST_SIM
+alignas(8) uint8_t ucHeap[configTOTAL_HEAP_SIZE];
+#else
+alignas(8) __attribute__((section(".heap"))) uint8_t
+    ucHeap[configTOTAL_HEAP_SIZE];
+#endif
+}
+
+alignas(8) static uint8_t pool32[32 * MEMPOOL_32_NUM];
+alignas(8) static uint8_t pool128[128 * MEMPOOL_128_NUM];
+alignas(8) static uint8_t pool512[512 * MEMPOOL_512_NUM];
+alignas(8) static uint8_t pool2048[2048 * MEMPOOL_2048_NUM];
+
+// 常量初始化，先于任何静态构造函数可用
+FixedPool MemPool::pools[MEMPOOL_NUM] = {
+    {pool32, 32, MEMPOOL_32_NUM},
+    {pool128, 128, MEMPOOL_128_NUM},
+    {pool512, 512, MEMPOOL_512_NUM},
+    {pool2048, 2048, MEMPOOL_2048_NUM},
+};
+volatile uint32_t MemPool::fallback = 0;
+
+void* MemPool::alloc(size_t size) {
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        Diag::count_alloc(size);
+    }
+    for (FixedPool& pool : pools) {
+        if (size <= pool.block_size()) {
+            // 本级池满时不占用更大的块，避免挤占大帧
+            void* p = pool.alloc();
+            if (p != nullptr) {
+                return p;
+            }
+            break;
+        }
+    }
+    fallback++;
+    return pvPortMalloc(size);
+}
+
+void MemPool::free(void* p) {
+    if (p == nullptr) {
+        return;
+    }
+    for (FixedPool& pool : pools) {
+        if (pool.contains(p)) {
+            pool.free(p);
+            return;
+        }
+    }
+    vPortFree(p);
+}
+
+// 全局new/delete使用FreeRTOS堆，内存池只经由OSallocator使用
+static void* heap_alloc(size_t size) {
+    if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED) {
+        Diag::count_alloc(size);
+    }
+    return pvPortMalloc(size);
+}
+
+void *operator new(size_t size)
  {
-     return pvPortMalloc(size);
+     return heap_alloc(size);
  }
 
- void *operator new[](size_t size) 
+ void *operator new[](size_t size)
  {
-     return pvPortMalloc(size);
+     return heap_alloc(size);
  }
 
  void operator delete(void *pointer) throw()
@@ -18,4 +90,4 @@ void *operator new(size_t size)
  void operator delete[](void *pointer) throw()
  {
      vPortFree(pointer);
- }
\ No newline at end of file
+ }
@@ -0,0 +1,218 @@
+#include "bsp_diag.hpp"
+
+#include <cstring>
+
+#include "bsp_allocate.hpp"
+#include "gd32f4xx.h"
+
+std::atomic<uint32_t> Diag::allocs[(size_t)Subsystem::NUM];
+std::atomic<uint32_t> Diag::bytes[(size_t)Subsystem::NUM];
+Diag::WatchedQueue Diag::queues[DIAG_QUEUE_MAX];
+uint8_t Diag::queue_num = 0;
+Diag::NetProbe Diag::net_probe = nullptr;
+TaskStatus_t Diag::task_status[DIAG_TASK_MAX];
+#ifdef RUN_TIME_STATS
+Diag::CpuPrev Diag::cpu_prev[DIAG_TASK_MAX];
+uint64_t Diag::cpu_prev_total = 0;
+uint64_t Diag::cpu_prev_isr_total = 0;
+uint64_t Diag::cpu_prev_isr[ISR_STAT_NUM];
+uint32_t Diag::cpu_prev_isr_count[ISR_STAT_NUM];
+
+static const char* const isr_stat_names[ISR_STAT_NUM] = {
+    "enet", "uart", "dma", "exti", "spi",
+};
+#endif
+
+// FreeRTOSConfig.h中traceQUEUE_SEND/traceQUEUE_SEND_FROM_ISR调用
+extern "C" void vDiagQueueSend(unsigned long number, unsigned long depth) {
+    Diag::queue_send(number, depth);
+}
+
+static void put_u16(PoolVector<uint8_t>& out, uint16_t v) {
+    out.push_back(v & 0xFF);
+    out.push_back(v >> 8);
+}
+
+static void put_u32(PoolVector<uint8_t>& out, uint32_t v) {
+    put_u16(out, v & 0xFFFF);
+    put_u16(out, v >> 16);
+}
+
+static void put_name(PoolVector<uint8_t>& out, const char* name,
+                     size_t len) {
+    size_t n = name == nullptr ? 0 : strnlen(name, len);
+    out.insert(out.end(), name, name + n);
+    out.insert(out.end(), len - n, 0);
+}
+
+static uint16_t sat_u16(uint32_t v) { return v > 0xFFFF ? 0xFFFF : v; }
+
+// 静态构造期间(调度器启动前)也会调用，不使用taskENTER_CRITICAL
+bool Diag::watch_queue(FreeRTOScpp::QueueBase& queue, const char* name) {
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    if (queue_num >= DIAG_QUEUE_MAX) {
+        portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+        return false;
+    }
+    WatchedQueue& q = queues[queue_num++];
+    q.handle = QueueHandleOf::get(queue);
+    q.name = name;
+    q.peak = 0;
+    vQueueSetQueueNumber(q.handle, queue_num);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    return true;
+}
+
+void Diag::serialize(PoolVector<uint8_t>& out, uint8_t sections) {
+    out.push_back(VERSION);
+    out.push_back(sections);
+    put_u32(out, xTaskGetTickCount() * portTICK_PERIOD_MS);
+
+    if (sections & HEAP) {
+        put_u32(out, xPortGetFreeHeapSize());
+        put_u32(out, xPortGetMinimumEverFreeHeapSize());
+        put_u32(out, configTOTAL_HEAP_SIZE);
+        put_u32(out, MemPool::heap_fallback());
+    }
+
+    if (sections & POOL) {
+        out.push_back(MEMPOOL_NUM);
+        for (uint8_t i = 0; i < MEMPOOL_NUM; i++) {
+            FixedPool::Stats s = MemPool::pool(i).stats();
+            put_u16(out, s.block_size);
+            put_u16(out, s.block_num);
+            put_u16(out, s.used);
+            put_u16(out, s.peak);
+            put_u32(out, s.fail);
+        }
+    }
+
+    if (sections & SUBSYS) {
+        out.push_back((uint8_t)Subsystem::NUM);
+        for (size_t i = 0; i < (size_t)Subsystem::NUM; i++) {
+            put_u32(out, allocs[i].load(std::memory_order_relaxed));
+            put_u32(out, bytes[i].load(std::memory_order_relaxed));
+        }
+    }
+
+    if (sections & NET) {
+        NetStats s;
+        bool valid = net_probe != nullptr && net_probe(s);
+        out.push_back(valid);
+        if (valid) {
+            put_u32(out, s.mem_used);
+            put_u32(out, s.mem_max);
+            put_u16(out, s.mem_err);
+            put_u16(out, s.pbuf_used);
+            put_u16(out, s.pbuf_max);
+            put_u16(out, s.pbuf_err);
+        }
+    }
+
+    if (sections & QUEUE) {
+        uint8_t num = queue_num;
+        out.push_back(num);
+        for (uint8_t i = 0; i < num; i++) {
+            const WatchedQueue& q = queues[i];
+            put_name(out, q.name, DIAG_QUEUE_NAME_LEN);
+            put_u16(out, sat_u16(uxQueueGetQueueLength(q.handle)));
+            put_u16(out, sat_u16(uxQueueMessagesWaiting(q.handle)));
+            put_u16(out, sat_u16(q.peak));
+        }
+    }
+
+    if (sections & TASK) {
+        // 任务数超过缓冲区时uxTaskGetSystemState返回0，只上报任务数为0
+        vTaskSuspendAll();
+        UBaseType_t num =
+            uxTaskGetSystemState(task_status, DIAG_TASK_MAX, nullptr);
+        out.push_back(num);
+        for (UBaseType_t i = 0; i < num; i++) {
+            const TaskStatus_t& t = task_status[i];
+            put_name(out, t.pcTaskName, DIAG_TASK_NAME_LEN);
+            out.push_back(t.uxCurrentPriority);
+            out.push_back(t.eCurrentState);
+            put_u16(out, sat_u16(t.usStackHighWaterMark));
+        }
+        xTaskResumeAll();
+    }
+
+    if (sections & CPU) {
+        // 采样结果较大，不放在调用者栈上，由挂起调度器保护
+        static CpuSample cpu;
+        vTaskSuspendAll();
+        bool valid = cpu_sample(cpu);
+        out.push_back(valid);
+        if (valid) {
+            put_u32(out, cpu.window_us);
+            put_u16(out, cpu.isr_permille);
+            out.push_back(ISR_STAT_NUM);
+            for (const CpuLoad& isr : cpu.isr) {
+                put_name(out, isr.name, DIAG_QUEUE_NAME_LEN);
+                put_u16(out, isr.permille);
+                put_u32(out, isr.count);
+            }
+            out.push_back(cpu.task_num);
+            for (uint8_t i = 0; i < cpu.task_num; i++) {
+                put_name(out, cpu.task[i].name, DIAG_TASK_NAME_LEN);
+                put_u16(out, cpu.task[i].permille);
+            }
+        }
+        xTaskResumeAll();
+    }
+}
+
+#ifdef RUN_TIME_STATS
+static uint16_t permille(uint64_t part, uint64_t whole) {
+    return whole == 0 ? 0 : (uint16_t)(part * 1000 / whole);
+}
+#endif
+
+bool Diag::cpu_sample(CpuSample& sample) {
+#ifdef RUN_TIME_STATS
+    vTaskSuspendAll();
+    uint64_t total = 0;
+    UBaseType_t num =
+        uxTaskGetSystemState(task_status, DIAG_TASK_MAX, &total);
+    uint64_t window = total - cpu_prev_total;
+    sample.window_us = window / (SystemCoreClock / 1000000);
+    sample.task_num = num;
+    for (UBaseType_t i = 0; i < num; i++) {
+        const TaskStatus_t& t = task_status[i];
+        uint64_t last = 0;
+        for (const CpuPrev& prev : cpu_prev) {
+            if (prev.number == t.xTaskNumber) {
+                last = prev.runtime;
+                break;
+            }
+        }
+        sample.task[i].name = t.pcTaskName;
+        sample.task[i].permille =
+            permille(t.ulRunTimeCounter - last, window);
+        sample.task[i].count = 0;
+    }
+    for (UBaseType_t i = 0; i < DIAG_TASK_MAX; i++) {
+        cpu_prev[i].number = i < num ? task_status[i].xTaskNumber : 0;
+        cpu_prev[i].runtime = i < num ? task_status[i].ulRunTimeCounter : 0;
+    }
+    cpu_prev_total = total;
+
+    uint64_t isr_total = isr_stat_total();
+    sample.isr_permille = permille(isr_total - cpu_prev_isr_total, window);
+    cpu_prev_isr_total = isr_total;
+    for (uint8_t i = 0; i < ISR_STAT_NUM; i++) {
+        uint64_t cycles = isr_stat_cycles((IsrStatId)i);
+        uint32_t count = isr_stat_count((IsrStatId)i);
+        sample.isr[i].name = isr_stat_names[i];
+        sample.isr[i].permille = permille(cycles - cpu_prev_isr[i], window);
+        sample.isr[i].count = count - cpu_prev_isr_count[i];
+        cpu_prev_isr[i] = cycles;
+        cpu_prev_isr_count[i] = count;
+    }
+    xTaskResumeAll();
+    return true;
+#else
+    (void)sample;
+    return false;
+#endif
+}
@@ -1,9 +1,22 @@
 #include "bsp_log.hpp"
 
+#include <cstdlib>
+
+DMA_BSS uint8_t Logger::txRing[LOG_UART_TX_RING_SIZE];
+#ifdef LOG_DEFERRED
+TCM_BSS std::atomic<uint32_t> LogRing::__ring[LogRing::SIZE];
+#endif
+
 void vAssertCalled(const char *file, int line) {
     taskDISABLE_INTERRUPTS();
     printf("Assert failed in file %s at line %d\n", file, line);
+#ifdef HOST_SIM
+    // 主机仿真中退出进程，测试脚本据此判断失败
+    fflush(stdout);
+    abort();
+#else
     for (;;);
+#endif
 }
 
 #ifdef ARM
@@ -20,6 +33,11 @@ int fputc(int ch, FILE *f) {
 #ifdef GCC
 extern "C" {
 int _write(int fd, char *pBuffer, int size) {
+    // 串口启用了DMA发送环形缓冲区时不等待发送完成；断言等中断被屏蔽的
+    // 场景DMA完成中断无法推进，仍直接发送
+    if (Uart::tx_ring_write(UART3, (const uint8_t *)pBuffer, size)) {
+        return size;
+    }
     for (int i = 0; i < size; i++) {
         while (RESET == usart_flag_get(UART3, USART_FLAG_TBE));
         usart_data_transmit(UART3, (uint8_t)pBuffer[i]);
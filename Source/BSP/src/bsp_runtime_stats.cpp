@@ -0,0 +1,84 @@
+#include "bsp_runtime_stats.h"
+
+#ifdef RUN_TIME_STATS
+#include "gd32f4xx.h"
+
+extern "C" {
+#include "FreeRTOS.h"
+}
+
+static uint32_t cyccnt_last = 0;
+static uint32_t cyccnt_high = 0;
+
+static uint32_t isr_depth = 0;
+static uint32_t isr_outer_start = 0;
+static uint64_t isr_total = 0;
+static uint64_t isr_cycles[ISR_STAT_NUM];
+static uint32_t isr_count[ISR_STAT_NUM];
+
+extern "C" {
+// vTaskStartScheduler中调用
+void vConfigureTimerForRunTimeStats(void) {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    cyccnt_last = 0;
+    cyccnt_high = 0;
+}
+
+// 240MHz下CYCCNT约17.9s回绕一次，任务切换时都会调用，回绕不会漏计
+uint64_t ulGetRunTimeCounterValue(void) {
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    uint32_t now = DWT->CYCCNT;
+    if (now < cyccnt_last) {
+        cyccnt_high++;
+    }
+    cyccnt_last = now;
+    uint64_t value = ((uint64_t)cyccnt_high << 32) | now;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    return value;
+}
+
+// 嵌套深度和外层起点需要与嵌套中断互斥，关中断只有几条指令
+uint32_t isr_stat_enter(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t now = DWT->CYCCNT;
+    if (isr_depth++ == 0) {
+        isr_outer_start = now;
+    }
+    __set_PRIMASK(primask);
+    return now;
+}
+
+void isr_stat_exit(IsrStatId id, uint32_t start) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint32_t now = DWT->CYCCNT;
+    isr_cycles[id] += now - start;
+    isr_count[id]++;
+    if (--isr_depth == 0) {
+        isr_total += now - isr_outer_start;
+    }
+    __set_PRIMASK(primask);
+}
+
+uint64_t isr_stat_cycles(IsrStatId id) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t v = isr_cycles[id];
+    __set_PRIMASK(primask);
+    return v;
+}
+
+uint32_t isr_stat_count(IsrStatId id) { return isr_count[id]; }
+
+uint64_t isr_stat_total(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    uint64_t v = isr_total;
+    __set_PRIMASK(primask);
+    return v;
+}
+}
+#endif
@@ -1,4 +1,5 @@
 #include "bsp_spi.hpp"
+#include "bsp_runtime_stats.h"
 
 #include <cstdint>
 uint8_t SpiDevBase::__bsp_is_init = 0;
@@ -94,21 +95,27 @@ const Spi_PeriphConfig SPI_CFG1 = {
 };
 extern "C" {
 void SPI1_IRQHandler(void) {
+    ISR_STAT_ENTER();
     if (RESET != spi_i2s_flag_get(SPI1, SPI_FLAG_RBNE)) {
         SpiDevBase::__dev[(uint8_t)SpiDevBase::SpiEnum::Spi1]
             ->__rx_isr_callback(spi_i2s_data_receive(SPI1));
     }
+    ISR_STAT_EXIT(ISR_STAT_SPI);
 }
 void SPI2_IRQHandler(void) {
+    ISR_STAT_ENTER();
     if (RESET != spi_i2s_flag_get(SPI2, SPI_FLAG_RBNE)) {
         SpiDevBase::__dev[(uint8_t)SpiDevBase::SpiEnum::Spi2]
             ->__rx_isr_callback(spi_i2s_data_receive(SPI2));
     }
+    ISR_STAT_EXIT(ISR_STAT_SPI);
 }
 void SPI3_IRQHandler(void) {
+    ISR_STAT_ENTER();
     if (RESET != spi_i2s_flag_get(SPI3, SPI_FLAG_RBNE)) {
         SpiDevBase::__dev[(uint8_t)SpiDevBase::SpiEnum::Spi3]
             ->__rx_isr_callback(spi_i2s_data_receive(SPI3));
     }
+    ISR_STAT_EXIT(ISR_STAT_SPI);
 }
 }
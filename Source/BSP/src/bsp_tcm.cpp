@@ -0,0 +1,145 @@
+#include "bsp_tcm.hpp"
+
+extern "C" {
+#include "task.h"
+}
+
+std::atomic<uint32_t> TcmHeap::__dma_fallback{0};
+
+#ifdef TCM_PLACEMENT
+alignas(8) TCM_BSS uint8_t TcmHeap::__heap[TCM_HEAP_SIZE];
+TcmHeap::Block* TcmHeap::__free = nullptr;
+uint32_t TcmHeap::__free_bytes = 0;
+uint32_t TcmHeap::__min_free = 0;
+uint32_t TcmHeap::__fail = 0;
+bool TcmHeap::__ready = false;
+
+// 第一次分配时建立覆盖整个堆的空闲块；静态构造中创建任务时就会分配，
+// 以上状态均为常量初始化
+void TcmHeap::__init() {
+    __free = reinterpret_cast<Block*>(__heap);
+    __free->next = nullptr;
+    __free->size = TCM_HEAP_SIZE;
+    __free_bytes = TCM_HEAP_SIZE;
+    __min_free = TCM_HEAP_SIZE;
+    __ready = true;
+}
+
+void* TcmHeap::alloc(size_t size) {
+    if (size == 0 || size > TCM_HEAP_SIZE) {
+        return nullptr;
+    }
+    size_t need = (size + HEADER + 7) & ~(size_t)7;
+    void* p = nullptr;
+    vTaskSuspendAll();
+    if (!__ready) {
+        __init();
+    }
+    Block** link = &__free;
+    for (Block* b = __free; b != nullptr; link = &b->next, b = b->next) {
+        if (b->size < need) {
+            continue;
+        }
+        // 剩余部分不够一个块头时整块分出
+        if (b->size - need > HEADER) {
+            Block* rest = reinterpret_cast<Block*>(
+                reinterpret_cast<uint8_t*>(b) + need);
+            rest->next = b->next;
+            rest->size = b->size - need;
+            b->size = need;
+            *link = rest;
+        } else {
+            *link = b->next;
+        }
+        __free_bytes -= b->size;
+        if (__free_bytes < __min_free) {
+            __min_free = __free_bytes;
+        }
+        p = reinterpret_cast<uint8_t*>(b) + HEADER;
+        break;
+    }
+    if (p == nullptr) {
+        __fail++;
+    }
+    xTaskResumeAll();
+    return p;
+}
+
+void TcmHeap::free(void* p) {
+    if (p == nullptr) {
+        return;
+    }
+    Block* blk = reinterpret_cast<Block*>(static_cast<uint8_t*>(p) - HEADER);
+    vTaskSuspendAll();
+    __free_bytes += blk->size;
+    // 按地址插入，与前后相邻的空闲块合并
+    Block* prev = nullptr;
+    Block* next = __free;
+    while (next != nullptr && next < blk) {
+        prev = next;
+        next = next->next;
+    }
+    if (next != nullptr &&
+        reinterpret_cast<uint8_t*>(blk) + blk->size ==
+            reinterpret_cast<uint8_t*>(next)) {
+        blk->size += next->size;
+        next = next->next;
+    }
+    blk->next = next;
+    if (prev != nullptr && reinterpret_cast<uint8_t*>(prev) + prev->size ==
+                               reinterpret_cast<uint8_t*>(blk)) {
+        prev->size += blk->size;
+        prev->next = blk->next;
+    } else if (prev != nullptr) {
+        prev->next = blk;
+    } else {
+        __free = blk;
+    }
+    xTaskResumeAll();
+}
+
+bool TcmHeap::contains(const void* p) {
+    return p >= __heap && p < __heap + TCM_HEAP_SIZE;
+}
+
+TcmHeap::Stats TcmHeap::stats() {
+    uint32_t fallback = __dma_fallback.load(std::memory_order_relaxed);
+    if (!__ready) {
+        return {TCM_HEAP_SIZE, TCM_HEAP_SIZE, TCM_HEAP_SIZE, __fail, fallback};
+    }
+    return {TCM_HEAP_SIZE, __free_bytes, __min_free, __fail, fallback};
+}
+
+extern "C" {
+// configSTACK_ALLOCATION_FROM_SEPARATE_HEAP: 任务栈优先放在TCM，
+// TCB仍由内核从FreeRTOS堆分配
+void* pvPortMallocStack(size_t xSize) {
+    void* p = TcmHeap::alloc(xSize);
+    return p != nullptr ? p : pvPortMalloc(xSize);
+}
+
+void vPortFreeStack(void* pv) {
+    if (TcmHeap::contains(pv)) {
+        TcmHeap::free(pv);
+    } else {
+        vPortFree(pv);
+    }
+}
+}
+#else
+void* TcmHeap::alloc(size_t size) {
+    (void)size;
+    return nullptr;
+}
+
+void TcmHeap::free(void* p) { (void)p; }
+
+bool TcmHeap::contains(const void* p) {
+    (void)p;
+    return false;
+}
+
+TcmHeap::Stats TcmHeap::stats() {
+    return {0, 0, 0, 0, __dma_fallback.load(std::memory_order_relaxed)};
+}
+#endif
@@ -0,0 +1,129 @@
+#include "bsp_trace.hpp"
+
+#include <cstring>
+
+#include "bsp_tcm.hpp"
+
+static void put_u16(PoolVector<uint8_t>& out, uint16_t v) {
+    out.push_back(v & 0xFF);
+    out.push_back(v >> 8);
+}
+
+static void put_u32(PoolVector<uint8_t>& out, uint32_t v) {
+    put_u16(out, v & 0xFFFF);
+    put_u16(out, v >> 16);
+}
+
+#ifdef EVENT_TRACE
+TCM_BSS Trace::Slot Trace::ring[TRACE_RING_SIZE];
+std::atomic<uint32_t> Trace::next{0};
+std::atomic<bool> Trace::recording{false};
+uint32_t Trace::base = 0;
+uint32_t Trace::end = 0;
+TaskStatus_t Trace::task_status[TRACE_TASK_MAX];
+
+static void set_u16(PoolVector<uint8_t>& out, size_t pos, uint16_t v) {
+    out[pos] = v & 0xFF;
+    out[pos + 1] = v >> 8;
+}
+#endif
+
+void Trace::start() {
+#ifdef EVENT_TRACE
+    // RUN_TIME_STATS构建中调度器启动时还会清零计数器，之前没有跟踪点
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    recording.store(true, std::memory_order_relaxed);
+#endif
+}
+
+void Trace::freeze() {
+#ifdef EVENT_TRACE
+    recording.store(false, std::memory_order_relaxed);
+    end = next.load(std::memory_order_relaxed);
+#endif
+}
+
+void Trace::resume() {
+#ifdef EVENT_TRACE
+    base = next.load(std::memory_order_relaxed);
+    recording.store(true, std::memory_order_relaxed);
+#endif
+}
+
+uint16_t Trace::serialize(PoolVector<uint8_t>& out, uint16_t start,
+                          uint16_t max) {
+    put_u16(out, MAGIC);
+    out.push_back(VERSION);
+#ifdef EVENT_TRACE
+    bool live = recording.load(std::memory_order_relaxed);
+    out.push_back(FLAG_COMPILED | (live ? FLAG_RECORDING : 0));
+    put_u32(out, SystemCoreClock);
+
+    uint32_t stop = live ? next.load(std::memory_order_relaxed) : end;
+    uint32_t first = stop - base > TRACE_RING_SIZE ? stop - TRACE_RING_SIZE
+                                                   : base;
+    uint16_t total = stop - first;
+    put_u32(out, first - base);
+    put_u16(out, total);
+    put_u16(out, start);
+    size_t next_pos = out.size();
+    put_u16(out, start);
+
+    if (start == 0) {
+        // 任务名只在导出时取一次，记录中只保存句柄
+        vTaskSuspendAll();
+        UBaseType_t num =
+            uxTaskGetSystemState(task_status, TRACE_TASK_MAX, nullptr);
+        out.push_back(num);
+        for (UBaseType_t i = 0; i < num; i++) {
+            const TaskStatus_t& t = task_status[i];
+            put_u32(out, (uint32_t)(uintptr_t)t.xHandle);
+            size_t n = strnlen(t.pcTaskName, TRACE_TASK_NAME_LEN);
+            out.insert(out.end(), t.pcTaskName, t.pcTaskName + n);
+            out.insert(out.end(), TRACE_TASK_NAME_LEN - n, 0);
+        }
+        xTaskResumeAll();
+    } else {
+        out.push_back(0);
+    }
+
+    size_t num_pos = out.size();
+    put_u16(out, 0);
+    uint16_t num = 0;
+    uint16_t i = start;
+    for (; i < total && i - start < max; i++) {
+        uint32_t index = first + i;
+        const Slot& slot = ring[index & MASK];
+        uint32_t tag = slot.tag.load(std::memory_order_acquire);
+        uint32_t cycle = slot.cycle.load(std::memory_order_relaxed);
+        uint32_t ctx = slot.ctx.load(std::memory_order_relaxed);
+        uint32_t arg = slot.arg.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // 读取期间被覆盖或尚未提交的记录跳过
+        if (tag == 0 || tag != slot.tag.load(std::memory_order_relaxed) ||
+            (tag & 0xFFFF) != ((index + 1) & 0xFFFF)) {
+            continue;
+        }
+        put_u32(out, cycle);
+        put_u32(out, ctx);
+        put_u32(out, arg);
+        put_u16(out, tag >> 16);
+        num++;
+    }
+    set_u16(out, next_pos, i);
+    set_u16(out, num_pos, num);
+    return i < total ? i : 0;
+#else
+    (void)max;
+    out.push_back(0);
+    put_u32(out, SystemCoreClock);
+    put_u32(out, 0);
+    put_u16(out, 0);
+    put_u16(out, start);
+    put_u16(out, start);
+    out.push_back(0);
+    put_u16(out, 0);
+    return 0;
+#endif
+}
@@ -167,7 +167,8 @@ UasrtInfo uart7_info = {.baudrate = 115200,
 
 // 全局信号量
 void handle_usart_interrupt(UasrtInfo* config) {
-    if (config->use_dma) {
+    // 环形接收模式由Uart::irq_handler处理IDLE，DMA不停止
+    if (config->use_dma && !config->rx_ring) {
         if (RESET != usart_interrupt_flag_get(config->usart_periph,
                                               USART_INT_FLAG_IDLE)) {
             /* clear IDLE flag */
@@ -193,31 +194,57 @@ void handle_usart_interrupt(UasrtInfo* config) {
 
 extern "C" {
 void USART0_IRQHandler(void) {
+    ISR_STAT_ENTER();
     handle_usart_interrupt(&usart0_info);
     Uart::dev[Uart::_UART0]->irq_handler();
+    ISR_STAT_EXIT(ISR_STAT_UART);
 }
 void USART1_IRQHandler(void) {
+    ISR_STAT_ENTER();
     handle_usart_interrupt(&usart1_info);
     Uart::dev[Uart::_UART1]->irq_handler();
+    ISR_STAT_EXIT(ISR_STAT_UART);
 }
 void USART2_IRQHandler(void) {
+    ISR_STAT_ENTER();
     handle_usart_interrupt(&usart2_info);
     Uart::dev[Uart::_UART2]->irq_handler();
+    ISR_STAT_EXIT(ISR_STAT_UART);
 }
 void UART3_IRQHandler(void) {
+    ISR_STAT_ENTER();
     handle_usart_interrupt(&uart3_info);
     Uart::dev[Uart::_UART3]->irq_handler();
+    ISR_STAT_EXIT(ISR_STAT_UART);
 }
 void USART5_IRQHandler(void) {
+    ISR_STAT_ENTER();
     handle_usart_interrupt(&usart5_info);
     Uart::dev[Uart::_UART5]->irq_handler();
+    ISR_STAT_EXIT(ISR_STAT_UART);
 }
 void UART6_IRQHandler(void) {
+    ISR_STAT_ENTER();
     handle_usart_interrupt(&uart6_info);
     Uart::dev[Uart::_UART6]->irq_handler();
+    ISR_STAT_EXIT(ISR_STAT_UART);
 }
 void UART7_IRQHandler(void) {
+    ISR_STAT_ENTER();
     handle_usart_interrupt(&uart7_info);
     Uart::dev[Uart::_UART7]->irq_handler();
+    ISR_STAT_EXIT(ISR_STAT_UART);
 }
+
+// 环形接收模式的DMA半满/全满中断
+void DMA0_Channel1_IRQHandler(void) { Uart::dma_rx_irq(DMA0, DMA_CH1); }
+void DMA0_Channel2_IRQHandler(void) { Uart::dma_rx_irq(DMA0, DMA_CH2); }
+void DMA0_Channel3_IRQHandler(void) { Uart::dma_rx_irq(DMA0, DMA_CH3); }
+
+// 发送环形缓冲区的DMA发送完成中断(UART7、UART3)
+void DMA0_Channel0_IRQHandler(void) { Uart::dma_tx_irq(DMA0, DMA_CH0); }
+void DMA0_Channel4_IRQHandler(void) { Uart::dma_tx_irq(DMA0, DMA_CH4); }
+void DMA0_Channel5_IRQHandler(void) { Uart::dma_rx_irq(DMA0, DMA_CH5); }
+void DMA0_Channel6_IRQHandler(void) { Uart::dma_rx_irq(DMA0, DMA_CH6); }
+void DMA1_Channel2_IRQHandler(void) { Uart::dma_rx_irq(DMA1, DMA_CH2); }
 }
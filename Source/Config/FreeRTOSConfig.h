@@ -100,7 +100,12 @@ extern void vAssertCalled(const char *file, int line);
  * 0 to select the next task to run using a generic C algorithm that works for
  * all FreeRTOS ports.  Not all FreeRTOS ports have this option.  Defaults to 0
  * if left undefined. */
+/* 主机仿真构建(HOST_SIM)的POSIX移植使用通用算法 */
+#ifdef HOST_SIM
+#define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
+#else
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 1
+#endif
 
 /* Set configUSE_TICKLESS_IDLE to 1 to use the low power tickless mode.  Set to
  * 0 to keep the tick interrupt running at all times.  Not all FreeRTOS ports
@@ -168,7 +173,8 @@ extern void vAssertCalled(const char *file, int line);
  * in the array.  See
  * https://www.freertos.org/thread-local-storage-pointers.html Defaults to 0 if
  * left undefined. */
-#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 0
+/* 下标0保存运行诊断的当前子系统，见bsp_diag.hpp */
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 1
 
 /* When configUSE_MINI_LIST_ITEM is set to 0, MiniListItem_t and ListItem_t are
  * both the same. When configUSE_MINI_LIST_ITEM is set to 1, MiniListItem_t
@@ -276,7 +282,15 @@ extern void vAssertCalled(const char *file, int line);
  * memory in the build.  Set to 0 to exclude the ability to create statically
  * allocated objects from the build.  Defaults to 0 if left undefined.  See
  * https://www.freertos.org/Static_Vs_Dynamic_Memory_Allocation.html. */
+/* CMake选项STATIC_ALLOCATION打开，FreeRTOScpp中定长的任务、队列、信号量、
+ * 事件组和定时器改为对象内的静态存储，随对象放在.bss；空闲和定时器任务由
+ * 内核提供静态内存(configKERNEL_PROVIDED_STATIC_MEMORY)。lwIP线程、邮箱和
+ * 运行时指定长度的队列仍从FreeRTOS堆分配 */
+#ifdef STATIC_ALLOCATION
+#define configSUPPORT_STATIC_ALLOCATION 1
+#else
 #define configSUPPORT_STATIC_ALLOCATION 0
+#endif
 
 /* Set configSUPPORT_DYNAMIC_ALLOCATION to 1 to include FreeRTOS API functions
  * that create FreeRTOS objects (tasks, queues, etc.) using dynamically
@@ -290,19 +304,35 @@ extern void vAssertCalled(const char *file, int line);
  * or heap_4.c are included in the build.  This value is defaulted to 4096 bytes
  * but it must be tailored to each application.  Note the heap will appear in
  * the .bss section.  See https://www.freertos.org/a00111.html. */
-#define configTOTAL_HEAP_SIZE ((size_t)(100 * 1024))
+/* 堆放在链接脚本的.heap段，紧跟.bss，链接时检查.bss、堆和主栈不超出RAM，
+ * 剩余空间见map文件中的_ram_free。调整大小时以map中.bss的实际占用为准 */
+/* 主机仿真构建(HOST_SIM)中StackType_t为8字节，任务栈占用的堆加倍 */
+#ifndef configTOTAL_HEAP_SIZE
+#ifdef HOST_SIM
+#define configTOTAL_HEAP_SIZE ((size_t)(8 * 1024 * 1024))
+#else
+#define configTOTAL_HEAP_SIZE ((size_t)(256 * 1024))
+#endif
+#endif
 
 /* Set configAPPLICATION_ALLOCATED_HEAP to 1 to have the application allocate
  * the array used as the FreeRTOS heap.  Set to 0 to have the linker allocate
  * the array used as the FreeRTOS heap.  Defaults to 0 if left undefined. */
-#define configAPPLICATION_ALLOCATED_HEAP 0
+/* ucHeap由bsp_allocate.cpp定义在.heap段，启动时不清零 */
+#define configAPPLICATION_ALLOCATED_HEAP 1
 
 /* 将 configSTACK_ALLOCATION_FROM_SEPARATE_HEAP 设置为 1，以便从除 FreeRTOS
  * 堆之外的其他地方分配任务栈。 这在您希望确保栈存储在快速内存中时很有用。
  * 设置为 0 则让任务栈来自标准的 FreeRTOS 堆。 如果设置为
  * 1，应用程序开发者必须提供 pvPortMallocStack() 和 vPortFreeStack() 的实现。
  * 如果未定义，默认值为 0。 */
+/* CMake选项TCM_PLACEMENT打开，任务栈从TCM分配(bsp_tcm.cpp)，不足时退回
+ * FreeRTOS堆 */
+#ifdef TCM_PLACEMENT
+#define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP 1
+#else
 #define configSTACK_ALLOCATION_FROM_SEPARATE_HEAP 0
+#endif
 
 /* Set configENABLE_HEAP_PROTECTOR to 1 to enable bounds checking and
  * obfuscation to internal heap block pointers in heap_4.c and heap_5.c to help
@@ -388,12 +418,26 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
  * application writer needs to provide a clock source if set to 1.  Defaults to
  * 0 if left undefined.  See https://www.freertos.org/rtos-run-time-stats.html.
  */
+/* CMake选项RUN_TIME_STATS打开，时钟为DWT周期计数器(bsp_runtime_stats.h)，
+ * 扩展为64位，按CPU周期计时 */
+#ifdef RUN_TIME_STATS
+#define configGENERATE_RUN_TIME_STATS 1
+#define configRUN_TIME_COUNTER_TYPE   uint64_t
+/* lwipopts.h会在C++文件的extern "C"之外包含本文件，声明需指定C链接 */
+#ifdef __cplusplus
+extern "C" {
+#endif
+extern void vConfigureTimerForRunTimeStats(void);
+extern uint64_t ulGetRunTimeCounterValue(void);
+#ifdef __cplusplus
+}
+#endif
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS() \
+    vConfigureTimerForRunTimeStats()
+#define portGET_RUN_TIME_COUNTER_VALUE() ulGetRunTimeCounterValue()
+#else
 #define configGENERATE_RUN_TIME_STATS 0
-
-// extern void configureTimerForRunTimeStats(void);
-// extern unsigned long getRunTimeCounterValue(void);
-// #define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS 0
-// #define portGET_RUN_TIME_COUNTER_VALUE 0
+#endif
 
 /* Set configUSE_TRACE_FACILITY to include additional task structure members
  * are used by trace and visualisation functions and tools.  Set to 0 to exclude
@@ -401,6 +445,18 @@ See http://www.FreeRTOS.org/RTOS-Cortex-M3-M4.html. */
  * undefined. */
 #define configUSE_TRACE_FACILITY 1
 
+/* 运行诊断: 登记过的队列(队列编号非0)入队时记录最大深度，见bsp_diag.hpp。
+ * 钩子在队列临界区内、数据复制之前调用，入队后的深度为当前深度加1 */
+extern void vDiagQueueSend(unsigned long number, unsigned long depth);
+#define traceQUEUE_SEND(pxQueue)                                 \
+    do {                                                         \
+        if ((pxQueue)->uxQueueNumber != 0) {                     \
+            vDiagQueueSend((pxQueue)->uxQueueNumber,             \
+                           (pxQueue)->uxMessagesWaiting + 1);    \
+        }                                                        \
+    } while (0)
+#define traceQUEUE_SEND_FROM_ISR(pxQueue) traceQUEUE_SEND(pxQueue)
+
 /* Set to 1 to include the vTaskList() and vTaskGetRunTimeStats() functions in
  * the build.  Set to 0 to exclude these functions from the build.  These two
  * functions introduce a dependency on string formatting functions that would
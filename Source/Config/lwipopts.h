@@ -73,8 +73,13 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define MEMP_NUM_TCP_PCB_LISTEN 5 /* the number of listening TCP connections \
                                    */
 
+#ifdef LWIP_BACKEND_TCP_PROFILE
+#define MEMP_NUM_TCP_SEG \
+    40 /* must cover TCP_SND_QUEUELEN of the TCP backend profile */
+#else
 #define MEMP_NUM_TCP_SEG \
     20 /* the number of simultaneously queued TCP segments */
+#endif
 
 #define MEMP_NUM_SYS_TIMEOUT \
     10 /* the number of simulateously active timeouts */
@@ -84,6 +89,8 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 /* Pbuf options */
 #define PBUF_POOL_SIZE    40   /* the number of buffers in the pbuf pool */
 #define PBUF_POOL_BUFSIZE 1514 /* the size of each pbuf in the pbuf pool */
+#define LWIP_SUPPORT_CUSTOM_PBUF \
+    1 /* ethernetif passes ENET DMA receive buffers to lwIP as custom pbufs */
 #define IP_REASS_MAX_PBUFS \
     20 /* total maximum amount of pbufs waiting to be reassembled */
 
@@ -100,14 +107,36 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
      40) /* TCP Maximum segment size, \
             TCP_MSS = (Ethernet MTU - IP header size - TCP header size) */
 
+/* TCP backend profile (CMake option BACKEND_TCP): the backend link streams
+   results with netconn_write(NETCONN_NOCOPY), so the send buffer only holds
+   references into the application TX ring and can be raised well beyond the
+   default two segments without costing heap. Segment pool and tcpip mailbox
+   are raised to match. */
+#ifdef LWIP_BACKEND_TCP_PROFILE
+#define TCP_SND_BUF (8 * TCP_MSS) /* TCP sender buffer space (bytes) */
+#else
 #define TCP_SND_BUF (2 * TCP_MSS) /* TCP sender buffer space (bytes) */
+#endif
 
 #define TCP_SND_QUEUELEN                                                \
     ((4 * TCP_SND_BUF) /                                                \
      TCP_MSS) /* TCP sender buffer space (pbufs), this must be at least \
              as much as (2 * TCP_SND_BUF/TCP_MSS) for things to work */
 
+#ifdef LWIP_BACKEND_TCP_PROFILE
+#define TCP_WND (4 * TCP_MSS) /* TCP receive window */
+
+/* drop a dead backend connection within ~8 s so a new one can be accepted */
+#define LWIP_TCP_KEEPALIVE    1
+#define TCP_KEEPIDLE_DEFAULT  5000UL
+#define TCP_KEEPINTVL_DEFAULT 1000UL
+#define TCP_KEEPCNT_DEFAULT   3U
+
+/* linger 0 aborts a closed connection that still references the TX ring */
+#define LWIP_SO_LINGER 1
+#else
 #define TCP_WND (2 * TCP_MSS) /* TCP receive window */
+#endif
 
 /* ICMP options */
 #define LWIP_ICMP 1
@@ -123,7 +152,19 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #define UDP_TTL  255
 
 /* statistics options */
-#define LWIP_STATS         0
+/* 只统计堆和内存池，供运行诊断上报(bsp_diag.hpp)，协议层计数关闭 */
+#define LWIP_STATS         1
+#define MEM_STATS          1
+#define MEMP_STATS         1
+#define LINK_STATS         0
+#define ETHARP_STATS       0
+#define IP_STATS           0
+#define IPFRAG_STATS       0
+#define ICMP_STATS         0
+#define IGMP_STATS         0
+#define UDP_STATS          0
+#define TCP_STATS          0
+#define SYS_STATS          0
 #define LWIP_PROVIDE_ERRNO 1
 
 /* checksum options */
@@ -194,7 +235,11 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #define TCPIP_THREAD_NAME         "TCP/IP"
 #define TCPIP_THREAD_STACKSIZE    1000
+#ifdef LWIP_BACKEND_TCP_PROFILE
+#define TCPIP_MBOX_SIZE           16
+#else
 #define TCPIP_MBOX_SIZE           5
+#endif
 #define DEFAULT_THREAD_STACKSIZE  1000
 #define TCPIP_THREAD_PRIO         (configMAX_PRIORITIES - 2)
 #define LWIP_COMPAT_MUTEX         1
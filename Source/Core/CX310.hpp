@@ -153,7 +153,7 @@ class CX310Class {
 
         // 检查最小长度和包头(0x63)
         if (rx_data.size() < 6 || rx_data[0] != 0x63) {
-            Log.e("UCI: Invalid packet header or length");
+            LOG_E("UCI: Invalid packet header or length");
             return payload;    // 返回空vector表示错误
         }
 
@@ -162,7 +162,7 @@ class CX310Class {
 
         // 检查数据长度是否匹配
         if (rx_data.size() != 6 + data_len) {
-            Log.e("UCI: Packet length mismatch");
+            LOG_E("UCI: Packet length mismatch");
             return payload;
         }
 
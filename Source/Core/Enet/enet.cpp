@@ -48,21 +48,22 @@ __IO uint32_t Enet::enet_init_status = 0;
 */
 int Enet::enet_system_setup(void) {
     nvic_configuration();
-    Log.v("ENET", "nvic_configuration done");
+    LOG_V("ENET", "nvic_configuration done");
 
     enet_gpio_config();
-    Log.v("ENET", "enet_gpio_config done");
+    LOG_V("ENET", "enet_gpio_config done");
 
     enet_mac_dma_config();
     if (0 == enet_init_status) {
-        Log.e("ENET", "enet_mac_dma_config failed, exiting enet_system_setup");
+        LOG_E("ENET", "enet_mac_dma_config failed, exiting enet_system_setup");
         return 1;
     }
-    Log.v("ENET", "enet_mac_dma_config done");
+    LOG_V("ENET", "enet_mac_dma_config done");
 
     enet_interrupt_enable(ENET_DMA_INT_NIE);
     enet_interrupt_enable(ENET_DMA_INT_RIE);
-    Log.v("ENET", "enet_interrupt_enable done");
+    enet_interrupt_enable(ENET_DMA_INT_TIE);
+    LOG_V("ENET", "enet_interrupt_enable done");
     return 0;
 }
 
@@ -82,12 +83,12 @@ void Enet::enet_mac_dma_config(void) {
 
     /* reset ethernet on AHB bus */
     enet_deinit();
-    Log.v("ENET", "enet_deinit done");
+    LOG_V("ENET", "enet_deinit done");
 
     reval_state = enet_software_reset();
-    Log.v("ENET", "enet_software_reset reval_state= %d\n", reval_state);
+    LOG_V("ENET", "enet_software_reset reval_state= %d\n", reval_state);
     if (ERROR == reval_state) {
-        Log.e("ENET", "enet_software_reset ERROR");
+        LOG_E("ENET", "enet_software_reset ERROR");
         enet_init_status = 0;    // 标记初始化失败
         return;                  // 退出 enet_mac_dma_config 函数
     }
@@ -101,7 +102,7 @@ void Enet::enet_mac_dma_config(void) {
     enet_init_status =
         enet_init(ENET_AUTO_NEGOTIATION, ENET_AUTOCHECKSUM_DROP_FAILFRAMES,
                   ENET_BROADCAST_FRAMES_PASS);
-    Log.v("ENET", "enet_init reval_state= %d\n", enet_init_status);
+    LOG_V("ENET", "enet_init reval_state= %d\n", enet_init_status);
 }
 
 /*!
@@ -189,5 +190,5 @@ void Enet::enet_gpio_config(void) {
     gpio_af_set(GPIOC, GPIO_AF_11, GPIO_PIN_1);
     gpio_af_set(GPIOC, GPIO_AF_11, GPIO_PIN_4);
     gpio_af_set(GPIOC, GPIO_AF_11, GPIO_PIN_5);
-    Log.d("ENET", "enet_gpio_config ok");
+    LOG_D("ENET", "enet_gpio_config ok");
 }
@@ -47,13 +47,15 @@
 
 #include "netcfg.h"
 #include "gd32f4xx_enet.h"
+#include "bsp_tcm.hpp"
 #include <string.h>
 #include "semphr.h"
 
 
 #define ETHERNETIF_INPUT_TASK_STACK_SIZE          (350)
 #define ETHERNETIF_INPUT_TASK_PRIO                (configMAX_PRIORITIES - 1)
-#define LOWLEVEL_OUTPUT_WAITING_TIME              (250)
+/* The time to block waiting for a free TX descriptor before dropping the frame */
+#define LOWLEVEL_OUTPUT_WAITING_TIME              ((portTickType )20)
 /* The time to block waiting for input */
 #define LOWLEVEL_INPUT_WAITING_TIME               ((portTickType )100)
 
@@ -78,9 +80,108 @@ extern enet_descriptors_struct  *dma_current_rxdesc;
 enet_descriptors_struct  ptp_txstructure[ENET_TXBUF_NUM];
 enet_descriptors_struct  ptp_rxstructure[ENET_RXBUF_NUM];
 
+#ifdef ETH_ZERO_COPY
+/* number of spare receive buffers. a received frame stays in its DMA buffer
+   and is handed to lwIP as a custom pbuf, the descriptor is refilled with a
+   spare buffer. when all spares are held by lwIP, frames are copied into
+   PBUF_POOL as before */
+#define ETH_RX_SPARE_BUF_NUM                      (8)
+
+/* frames shorter than this are copied into the descriptor's own buffer,
+   longer ones are transmitted directly from the pbuf payloads */
+#define ETH_TX_COPY_BREAK                         (128)
+#else
+/* without ETH_ZERO_COPY every frame is copied, received ones into
+   PBUF_POOL and transmitted ones into the descriptor's own buffer */
+#define ETH_TX_COPY_BREAK                         (ENET_TXBUF_SIZE + 1)
+#endif /* ETH_ZERO_COPY */
+
+/* required alignment of a pbuf payload for transmitting it in place,
+   the ENET TxDMA reads buffers at any byte address */
+#define ETH_TX_BUF_ALIGN                          (1U)
+
+/* the ENET DMA is not connected to TCMSRAM */
+#define ETH_DMA_ACCESSIBLE(addr)                  DMA_ACCESSIBLE(addr)
+
+#ifdef ETH_ZERO_COPY
+/* a receive buffer wrapped as custom pbuf, one per DMA and spare buffer */
+typedef struct {
+    struct pbuf_custom pc;
+    uint8_t *buff;
+} rx_pbuf_t;
+
+DMA_BSS static uint8_t rx_spare_buff[ETH_RX_SPARE_BUF_NUM][ENET_RXBUF_SIZE] __attribute__((aligned(4)));
+static rx_pbuf_t rx_pbuf[ENET_RXBUF_NUM + ETH_RX_SPARE_BUF_NUM];
+
+/* receive buffers neither owned by a descriptor nor held by lwIP */
+static uint8_t *rx_free_buff[ETH_RX_SPARE_BUF_NUM];
+static uint32_t rx_free_num = 0;
+#endif /* ETH_ZERO_COPY */
+
+/* pbuf chain referenced by an in-flight TX descriptor, stored on the last
+   descriptor of the frame and released once DMA has sent it */
+static struct pbuf *tx_pbuf[ENET_TXBUF_NUM];
+static volatile uint32_t tx_pbuf_num = 0;
+
 
 static struct netif *low_netif = NULL;
 xSemaphoreHandle g_rx_semaphore = NULL;
+/* given by the ENET interrupt when a TX descriptor has been sent */
+xSemaphoreHandle g_tx_semaphore = NULL;
+
+#ifdef ETH_ZERO_COPY
+/**
+* Return a receive buffer held by lwIP to the free list.
+*
+* @param p the custom pbuf wrapping the buffer
+*/
+static void rx_pbuf_free(struct pbuf *p)
+{
+    rx_pbuf_t *rp = (rx_pbuf_t *)p;
+    SYS_ARCH_DECL_PROTECT(sr);
+
+    SYS_ARCH_PROTECT(sr);
+    rx_free_buff[rx_free_num++] = rp->buff;
+    SYS_ARCH_UNPROTECT(sr);
+}
+
+/**
+* Find the custom pbuf bound to a receive buffer.
+*
+* @param buff a DMA or spare receive buffer
+* @return the custom pbuf, NULL if buff is not a receive buffer
+*/
+static rx_pbuf_t *rx_pbuf_of(uint8_t *buff)
+{
+    uint32_t i;
+
+    for(i = 0; i < ENET_RXBUF_NUM + ETH_RX_SPARE_BUF_NUM; i++){
+        if(rx_pbuf[i].buff == buff){
+            return &rx_pbuf[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+* Set up the custom pbufs and the spare receive buffer list.
+*/
+static void rx_pbuf_init(void)
+{
+    uint32_t i;
+
+    for(i = 0; i < ENET_RXBUF_NUM; i++){
+        rx_pbuf[i].pc.custom_free_function = rx_pbuf_free;
+        rx_pbuf[i].buff = rx_buff[i];
+    }
+    for(i = 0; i < ETH_RX_SPARE_BUF_NUM; i++){
+        rx_pbuf[ENET_RXBUF_NUM + i].pc.custom_free_function = rx_pbuf_free;
+        rx_pbuf[ENET_RXBUF_NUM + i].buff = rx_spare_buff[i];
+        rx_free_buff[i] = rx_spare_buff[i];
+    }
+    rx_free_num = ETH_RX_SPARE_BUF_NUM;
+}
+#endif /* ETH_ZERO_COPY */
 
 /**
 * In this function, the hardware should be initialized.
@@ -117,6 +218,10 @@ static void low_level_init(struct netif *netif)
         vSemaphoreCreateBinary(g_rx_semaphore);
         xSemaphoreTake( g_rx_semaphore, 0);
     }
+    if (g_tx_semaphore == NULL){
+        vSemaphoreCreateBinary(g_tx_semaphore);
+        xSemaphoreTake( g_tx_semaphore, 0);
+    }
 
     /* initialize MAC address in ethernet MAC */ 
     enet_mac_address_set(ENET_MAC_ADDRESS0, netif->hwaddr);
@@ -136,6 +241,10 @@ static void low_level_init(struct netif *netif)
     
 #endif /* SELECT_DESCRIPTORS_ENHANCED_MODE */  
 
+#ifdef ETH_ZERO_COPY
+    rx_pbuf_init();
+#endif /* ETH_ZERO_COPY */
+
     /* enable ethernet Rx interrrupt */
     {   int i;
         for(i=0; i<ENET_RXBUF_NUM; i++){ 
@@ -144,6 +253,11 @@ static void low_level_init(struct netif *netif)
     }
 
 
+    /* interrupt on completion of every Tx descriptor, frees the TX ring */
+    for(i=0; i < ENET_TXBUF_NUM; i++){
+        txdesc_tab[i].status |= ENET_TDES0_INTC;
+    }
+
 #ifdef CHECKSUM_BY_HARDWARE
     /* enable the TCP, UDP and ICMP checksum insertion for the Tx frames */
     for(i=0; i < ENET_TXBUF_NUM; i++){
@@ -160,74 +274,254 @@ static void low_level_init(struct netif *netif)
 }
 
 
+/**
+* Release the pbuf held on a TX descriptor once the TxDMA has sent it.
+*
+* @param i index of the descriptor in txdesc_tab
+*/
+static void low_level_tx_release(uint32_t i)
+{
+    struct pbuf *p;
+    SYS_ARCH_DECL_PROTECT(sr);
+
+    SYS_ARCH_PROTECT(sr);
+    p = tx_pbuf[i];
+    if((NULL != p) && ((uint32_t)RESET == (txdesc_tab[i].status & ENET_TDES0_DAV))){
+        tx_pbuf[i] = NULL;
+        tx_pbuf_num--;
+    }else{
+        p = NULL;
+    }
+    SYS_ARCH_UNPROTECT(sr);
+
+    /* pbuf_free() may take the heap mutex, keep it out of the critical section */
+    if(NULL != p){
+        pbuf_free(p);
+    }
+}
+
+/**
+* Release the pbufs of frames the TxDMA has finished sending.
+* Called from the output path and from the input task on TX completion.
+*/
+static void low_level_tx_reclaim(void)
+{
+    uint32_t i;
+
+    for(i = 0; (i < ENET_TXBUF_NUM) && (tx_pbuf_num > 0); i++){
+        low_level_tx_release(i);
+    }
+}
+
+/**
+* Check that the next descriptors of the TX ring are released by DMA.
+* A pbuf still held on a released descriptor is freed here, the DMA may
+* have finished it after the last reclaim and the descriptor is reused next.
+*
+* @param segs number of descriptors needed
+* @return 1 if all are free
+*/
+static int low_level_tx_free(uint32_t segs)
+{
+    enet_descriptors_struct *desc = dma_current_txdesc;
+    uint32_t i;
+
+    for(i = 0; i < segs; i++){
+        if((uint32_t)RESET != (desc->status & ENET_TDES0_DAV)){
+            return 0;
+        }
+        low_level_tx_release(desc - txdesc_tab);
+        desc = (enet_descriptors_struct *)(desc->buffer2_next_desc_addr);
+    }
+    return 1;
+}
+
+#ifndef SELECT_DESCRIPTORS_ENHANCED_MODE
+/**
+* Count the TX descriptors needed to send a pbuf chain in place.
+*
+* @param p the MAC packet to send
+* @return number of descriptors, 0 if the packet has to be copied
+*/
+static uint32_t low_level_tx_segments(struct pbuf *p)
+{
+    struct pbuf *q;
+    uint32_t segs = 0;
+
+    if(p->tot_len < ETH_TX_COPY_BREAK){
+        return 0;
+    }
+    for(q = p; q != NULL; q = q->next){
+        if(0 == q->len){
+            continue;
+        }
+        /* the payload must stay valid until the DMA is done with it */
+        if(PBUF_NEEDS_COPY(q) ||
+           (0U != ((uint32_t)q->payload & (ETH_TX_BUF_ALIGN - 1U)))){
+            return 0;
+        }
+        /* stack-held payloads in TCM are counted, see TcmHeap::stats() */
+        if(!ETH_DMA_ACCESSIBLE(q->payload)){
+            TcmHeap::count_dma_fallback();
+            return 0;
+        }
+        if(++segs > ENET_TXBUF_NUM){
+            return 0;
+        }
+    }
+    return segs;
+}
+
+/**
+* Chain free TX descriptors directly onto the pbuf payloads and start the DMA.
+* The pbuf is referenced until the last descriptor has been sent.
+*
+* @param p the MAC packet to send
+* @param segs number of descriptors returned by low_level_tx_segments()
+*/
+static void low_level_tx_chain(struct pbuf *p, uint32_t segs)
+{
+    enet_descriptors_struct *first = dma_current_txdesc;
+    enet_descriptors_struct *desc = first;
+    struct pbuf *q;
+    uint32_t i = 0, status;
+    SYS_ARCH_DECL_PROTECT(sr);
+
+    pbuf_ref(p);
+    for(q = p; q != NULL; q = q->next){
+        if(0 == q->len){
+            continue;
+        }
+        desc->buffer1_addr = (uint32_t)q->payload;
+        desc->control_buffer_size = q->len & ENET_TDES1_TB1S;
+        status = desc->status & ~(ENET_TDES0_FSG | ENET_TDES0_LSG | ENET_TDES0_DAV);
+        if(0 == i){
+            status |= ENET_TDES0_FSG;
+        }
+        if(segs - 1 == i){
+            status |= ENET_TDES0_LSG;
+        }
+        /* the first descriptor is given to DMA last */
+        if(0 != i){
+            status |= ENET_TDES0_DAV;
+        }
+        desc->status = status;
+        if(++i < segs){
+            desc = (enet_descriptors_struct *)(desc->buffer2_next_desc_addr);
+        }
+    }
+
+    /* hold the pbuf on the last descriptor, it is released once DAV is cleared.
+       for a single descriptor frame DAV must be set before the reclaim can run */
+    __DMB();
+    SYS_ARCH_PROTECT(sr);
+    tx_pbuf[desc - txdesc_tab] = p;
+    tx_pbuf_num++;
+    first->status |= ENET_TDES0_DAV;
+    SYS_ARCH_UNPROTECT(sr);
+
+    /* resume DMA transmission if it was suspended */
+    if(RESET != (ENET_DMA_STAT & (ENET_DMA_STAT_TBU | ENET_DMA_STAT_TU))){
+        ENET_DMA_STAT = ENET_DMA_STAT & (ENET_DMA_STAT_TBU | ENET_DMA_STAT_TU);
+        ENET_DMA_TPEN = 0U;
+    }
+
+    dma_current_txdesc = (enet_descriptors_struct *)(desc->buffer2_next_desc_addr);
+}
+#endif /* SELECT_DESCRIPTORS_ENHANCED_MODE */
+
+/**
+* Copy a frame into the current TX descriptor's own buffer and start the DMA.
+*
+* @param p the MAC packet to send
+* @return SUCCESS if the frame was given to DMA
+*/
+static ErrStatus low_level_tx_copy(struct pbuf *p)
+{
+    uint8_t *buffer;
+
+#ifndef SELECT_DESCRIPTORS_ENHANCED_MODE
+    /* the descriptor may still point into a pbuf sent in place before */
+    dma_current_txdesc->buffer1_addr = (uint32_t)tx_buff[dma_current_txdesc - txdesc_tab];
+#endif /* SELECT_DESCRIPTORS_ENHANCED_MODE */
+    buffer = (uint8_t *)(enet_desc_information_get(dma_current_txdesc, TXDESC_BUFFER_1_ADDR));
+    pbuf_copy_partial(p, buffer, p->tot_len, 0);
+
+   /* transmit descriptors to give to DMA */ 
+#ifdef SELECT_DESCRIPTORS_ENHANCED_MODE
+    return ENET_NOCOPY_PTPFRAME_TRANSMIT_ENHANCED_MODE(p->tot_len, NULL);
+#else
+    return ENET_NOCOPY_FRAME_TRANSMIT(p->tot_len);
+#endif /* SELECT_DESCRIPTORS_ENHANCED_MODE */
+}
+
 /**
 * This function should do the actual transmission of the packet. The packet is
 * contained in the pbuf that is passed to the function. This pbuf
 * might be chained.
 *
+* With ETH_ZERO_COPY long frames made of DMA accessible pbufs are sent in
+* place, one descriptor per pbuf, others are copied into the current
+* descriptor's buffer. Frames are queued on the TX descriptor ring without
+* waiting for the previous one; when the ring is full the caller blocks on
+* the TX completion interrupt for at most LOWLEVEL_OUTPUT_WAITING_TIME and
+* then gets ERR_MEM.
+*
+* Calls are serialized by the tcpip thread (LWIP_TCPIP_CORE_LOCKING is 0).
+*
 * @param netif the lwip network interface structure for this ethernetif
 * @param p the MAC packet to send (e.g. IP packet including MAC addresses and type)
 * @return ERR_OK if the packet could be sent
-*         an err_t value if the packet couldn't be sent
-*
-* @note Returning ERR_MEM here if a DMA queue of your MAC is full can lead to
-*       strange results. You might consider waiting for space in the DMA queue
-*       to become availale since the stack doesn't retry to send a packet
-*       dropped because of memory failure (except for the TCP timers).
+*         ERR_MEM if the TX ring stayed full
+*         ERR_BUF if the packet is larger than a TX buffer
 */
 
 static err_t low_level_output(struct netif *netif, struct pbuf *p)
 {
-    static xSemaphoreHandle s_tx_semaphore = NULL;
-    struct pbuf *q;
-    uint8_t *buffer ;
-    uint16_t framelength = 0;
-    ErrStatus reval = ERROR;
-  
-    SYS_ARCH_DECL_PROTECT(sr);
-    
-    if (s_tx_semaphore == NULL){
-        vSemaphoreCreateBinary (s_tx_semaphore);
+    uint32_t segs = 0;
+    TickType_t start, elapsed;
+
+    if(p->tot_len > ENET_TXBUF_SIZE){
+        return ERR_BUF;
     }
 
-    if (xSemaphoreTake(s_tx_semaphore, LOWLEVEL_OUTPUT_WAITING_TIME)){    
-        SYS_ARCH_PROTECT(sr);
-      
-        while((uint32_t)RESET != (dma_current_txdesc->status & ENET_TDES0_DAV)){
-        }    
-        buffer = (uint8_t *)(enet_desc_information_get(dma_current_txdesc, TXDESC_BUFFER_1_ADDR));
+    low_level_tx_reclaim();
+#ifndef SELECT_DESCRIPTORS_ENHANCED_MODE
+    segs = low_level_tx_segments(p);
+#endif /* SELECT_DESCRIPTORS_ENHANCED_MODE */
 
-        for(q = p; q != NULL; q = q->next){ 
-            memcpy((uint8_t *)&buffer[framelength], q->payload, q->len);
-            framelength = framelength + q->len;
+    /* wait for the DMA to release enough descriptors */
+    start = xTaskGetTickCount();
+    while(!low_level_tx_free(segs > 0 ? segs : 1)){
+        elapsed = xTaskGetTickCount() - start;
+        if(elapsed >= LOWLEVEL_OUTPUT_WAITING_TIME){
+            return ERR_MEM;
         }
+        xSemaphoreTake(g_tx_semaphore, LOWLEVEL_OUTPUT_WAITING_TIME - elapsed);
+        low_level_tx_reclaim();
+    }
 
-       /* transmit descriptors to give to DMA */ 
-#ifdef SELECT_DESCRIPTORS_ENHANCED_MODE
-        reval = ENET_NOCOPY_PTPFRAME_TRANSMIT_ENHANCED_MODE(framelength, NULL);
-#else
-        reval = ENET_NOCOPY_FRAME_TRANSMIT(framelength);
+#ifndef SELECT_DESCRIPTORS_ENHANCED_MODE
+    if(segs > 0){
+        low_level_tx_chain(p, segs);
+        return ERR_OK;
+    }
 #endif /* SELECT_DESCRIPTORS_ENHANCED_MODE */
 
-        SYS_ARCH_UNPROTECT(sr);
-        
-        /* give semaphore and exit */
-        xSemaphoreGive(s_tx_semaphore);
+    if(SUCCESS != low_level_tx_copy(p)){
+        return ERR_IF;
     }
-    
-    if(SUCCESS == reval){
-        return ERR_OK;
-    }else{
-        while(1){
-        }
-    }
-    
+    return ERR_OK;
 }
 
 /**
 * Should allocate a pbuf and transfer the bytes of the incoming
 * packet from the interface into the pbuf.
 *
+* With ETH_ZERO_COPY the frame is not copied while a spare receive buffer
+* is left: the DMA buffer itself is returned as custom pbuf and comes back
+* to the spare list when lwIP frees it.
+*
 * @param netif the lwip network interface structure for this ethernetif
 * @return a pbuf filled with the received packet (including MAC header)
 *         NULL on memory error
@@ -238,21 +532,49 @@ static struct pbuf * low_level_input(struct netif *netif)
     uint32_t l =0;
     u16_t len;
     uint8_t *buffer;
+#ifdef ETH_ZERO_COPY
+    uint8_t *spare = NULL;
+    rx_pbuf_t *rp;
+#endif /* ETH_ZERO_COPY */
 
     /* obtain the size of the packet and put it into the "len" variable. */
     len = enet_desc_information_get(dma_current_rxdesc, RXDESC_FRAME_LENGTH);
     buffer = (uint8_t *)(enet_desc_information_get(dma_current_rxdesc, RXDESC_BUFFER_1_ADDR));
-  
-    if (len > 0){
-        /* We allocate a pbuf chain of pbufs from the Lwip buffer pool */
-        p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+
+    /* the descriptor is still owned by DMA */
+    if ((uint32_t)RESET != (dma_current_rxdesc->status & ENET_RDES0_DAV)){
+        return NULL;
+    }
+    if ((uint32_t)RESET != (dma_current_rxdesc->status & ENET_RDES0_ERRS)){
+        len = 0;
     }
   
-    if (p != NULL){
-        for(q = p; q != NULL; q = q->next){
-            memcpy((uint8_t *)q->payload, (u8_t*)&buffer[l], q->len);
-            l = l + q->len;
+    if (len > 0){
+#ifdef ETH_ZERO_COPY
+        if (rx_free_num > 0){
+            spare = rx_free_buff[--rx_free_num];
+        }
+        rp = rx_pbuf_of(buffer);
+        if ((spare != NULL) && (rp != NULL)){
+            /* pass the DMA buffer to lwIP and refill the descriptor with a spare one */
+            p = pbuf_alloced_custom(PBUF_RAW, len, PBUF_REF, &rp->pc, buffer, ENET_RXBUF_SIZE);
+            dma_current_rxdesc->buffer1_addr = (uint32_t)spare;
+        }else{
+            if (spare != NULL){
+                rx_free_buff[rx_free_num++] = spare;
+            }
+#endif /* ETH_ZERO_COPY */
+            /* no spare buffer left, we allocate a pbuf chain of pbufs from the Lwip buffer pool */
+            p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
+            if (p != NULL){
+                for(q = p; q != NULL; q = q->next){
+                    memcpy((uint8_t *)q->payload, (u8_t*)&buffer[l], q->len);
+                    l = l + q->len;
+                }
+            }
+#ifdef ETH_ZERO_COPY
         }
+#endif /* ETH_ZERO_COPY */
     }
 #ifdef SELECT_DESCRIPTORS_ENHANCED_MODE
     ENET_NOCOPY_PTPFRAME_RECEIVE_ENHANCED_MODE(NULL);
@@ -282,6 +604,9 @@ void ethernetif_input( void * pvParameters )
   
     for( ;; ){   
         if(pdTRUE == xSemaphoreTake(g_rx_semaphore, LOWLEVEL_INPUT_WAITING_TIME)){ 
+            /* the interrupt also wakes us on TX completion, release sent pbufs
+               so that TCP can retransmit them */
+            low_level_tx_reclaim();
 TRY_GET_NEXT_FRAME:
             SYS_ARCH_PROTECT(sr);
             p = low_level_input( low_netif );
@@ -39,10 +39,12 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "bsp_log.hpp"
 #include "enet.h"
 #include "ethernetif.h"
+#include "lwip/apps/lwiperf.h"
 #include "lwip/dhcp.h"
 #include "lwip/errno.h"
 #include "lwip/mem.h"
 #include "lwip/memp.h"
+#include "lwip/stats.h"
 #include "netcfg.h"
 #include "queue.h"
 #include "tcpip.h"
@@ -56,32 +58,65 @@ int EthDevice::init() {
         /* configure ethernet (GPIOs, clocks, MAC, DMA) */
         ret = Enet::enet_system_setup();
         if (0 != ret) {
-            Log.e("ETH", "enet_system_setup failed, exiting eth_device_init");
+            LOG_E("ETH", "enet_system_setup failed, exiting eth_device_init");
             return 1;
         }
-        Log.v("ETH", "ethernet initialized");
+        LOG_V("ETH", "ethernet initialized");
 
         /* initilaize the LwIP stack */
         lwip_stack_init();
-        Log.v("ETH", "lwip stack initialized");
+        LOG_V("ETH", "lwip stack initialized");
         initialized = true;
     }
     return 0;
 }
 
+#ifdef LWIPERF_ENABLE
+static void lwiperf_report(void *arg, enum lwiperf_report_type report_type,
+                           const ip_addr_t *local_addr, u16_t local_port,
+                           const ip_addr_t *remote_addr, u16_t remote_port,
+                           u32_t bytes_transferred, u32_t ms_duration,
+                           u32_t bandwidth_kbitpsec) {
+    LOG_I("LWIPERF", "%lu bytes in %lu ms, %lu kbit/s",
+          (unsigned long)bytes_transferred, (unsigned long)ms_duration,
+          (unsigned long)bandwidth_kbitpsec);
+}
+
+/* raw API must run in the tcpip thread (core locking is disabled) */
+static void lwiperf_start(void *arg) {
+    lwiperf_start_tcp_server_default(lwiperf_report, NULL);
+}
+#endif
+
 void EthDevice::lwip_netif_status_callback(struct netif *netif) {
-    // Log.v("LWIP", "netif status changed: %d", netif->flags);
+    // LOG_V("LWIP", "netif status changed: %d", netif->flags);
     // // logd addr
-    // Log.v("LWIP", "netif addr: %d.%d.%d.%d", ip4_addr1_16(&netif->ip_addr),
+    // LOG_V("LWIP", "netif addr: %d.%d.%d.%d", ip4_addr1_16(&netif->ip_addr),
     //       ip4_addr2_16(&netif->ip_addr), ip4_addr3_16(&netif->ip_addr),
     //       ip4_addr4_16(&netif->ip_addr));
     // if (((netif->flags & NETIF_FLAG_UP) != 0) && (0 != netif->ip_addr.addr))
     // {
     //     /* initilaize the udp: echo 1025 */
-    //     Log.v("LWIP", "udp echo initialized");
+    //     LOG_V("LWIP", "udp echo initialized");
     // }
 }
 
+// 运行诊断快照中的lwIP堆和PBUF_POOL统计
+bool EthDevice::diag_net_stats(Diag::NetStats &stats) {
+#if MEM_STATS && MEMP_STATS
+    const struct stats_mem *pbuf = lwip_stats.memp[MEMP_PBUF_POOL];
+    stats.mem_used = lwip_stats.mem.used;
+    stats.mem_max = lwip_stats.mem.max;
+    stats.mem_err = lwip_stats.mem.err;
+    stats.pbuf_used = pbuf->used;
+    stats.pbuf_max = pbuf->max;
+    stats.pbuf_err = pbuf->err;
+    return true;
+#else
+    return false;
+#endif
+}
+
 /*!
     \brief      initializes the LwIP stack
     \param[in]  none
@@ -95,32 +130,42 @@ void EthDevice::lwip_stack_init(void) {
 
     /* create tcp_ip stack thread */
     tcpip_init(NULL, NULL);
-    Log.v("LWIP", "tcpip_init initialized");
+    LOG_V("LWIP", "tcpip_init initialized");
+    Diag::set_net_probe(diag_net_stats);
 
     /* IP address setting */
     IP4_ADDR(&ipaddr, IP_ADDR0, IP_ADDR1, IP_ADDR2, IP_ADDR3);
-    Log.v("LWIP", "static ip address set to %d.%d.%d.%d", ip4_addr1_16(&ipaddr),
+    LOG_V("LWIP", "static ip address set to %d.%d.%d.%d", ip4_addr1_16(&ipaddr),
           ip4_addr2_16(&ipaddr), ip4_addr3_16(&ipaddr), ip4_addr4_16(&ipaddr));
     IP4_ADDR(&netmask, NETMASK_ADDR0, NETMASK_ADDR1, NETMASK_ADDR2,
              NETMASK_ADDR3);
-    Log.v("LWIP", "netmask set to %d.%d.%d.%d", ip4_addr1_16(&netmask),
+    LOG_V("LWIP", "netmask set to %d.%d.%d.%d", ip4_addr1_16(&netmask),
           ip4_addr2_16(&netmask), ip4_addr3_16(&netmask),
           ip4_addr4_16(&netmask));
     IP4_ADDR(&gw, GW_ADDR0, GW_ADDR1, GW_ADDR2, GW_ADDR3);
-    Log.v("LWIP", "gateway set to %d.%d.%d.%d", ip4_addr1_16(&gw),
+    LOG_V("LWIP", "gateway set to %d.%d.%d.%d", ip4_addr1_16(&gw),
           ip4_addr2_16(&gw), ip4_addr3_16(&gw), ip4_addr4_16(&gw));
 
     netif_add(&g_mynetif, &ipaddr, &netmask, &gw, NULL, &ethernetif_init,
               &tcpip_input);
-    Log.v("LWIP", "ethernet interface added");
+    LOG_V("LWIP", "ethernet interface added");
 
     /* registers the default network interface */
     netif_set_default(&g_mynetif);
-    Log.v("LWIP", "default network interface set");
+    LOG_V("LWIP", "default network interface set");
     netif_set_status_callback(&g_mynetif, lwip_netif_status_callback);
-    Log.v("LWIP", "network interface status callback set");
+    LOG_V("LWIP", "network interface status callback set");
 
     /* when the netif is fully configured this function must be called */
     netif_set_up(&g_mynetif);
-    Log.v("LWIP", "network interface set up");
+    LOG_V("LWIP", "network interface set up");
+
+#ifdef LWIPERF_ENABLE
+    /* iperf2 server for throughput test: iperf -c <ip> -i 1 */
+    if (tcpip_callback(lwiperf_start, NULL) == ERR_OK) {
+        LOG_V("LWIP", "lwiperf server started");
+    } else {
+        LOG_E("LWIP", "lwiperf server start failed");
+    }
+#endif
 }
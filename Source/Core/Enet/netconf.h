@@ -3,6 +3,7 @@
 #define NETCONF_H
 #include "SemaphoreCPP.h"
 #include "TaskCPP.h"
+#include "bsp_diag.hpp"
 #include "enet.h"
 #include "netcfg.h"
 
@@ -16,6 +17,7 @@ class EthDevice {
    public:
     int init();
     static void lwip_netif_status_callback(struct netif* netif);
+    static bool diag_net_stats(Diag::NetStats& stats);
     void lwip_stack_init(void);
 };
 
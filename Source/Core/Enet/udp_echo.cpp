@@ -56,7 +56,7 @@ extern Logger Log;
 UdpTask::UdpTask() : TaskClassS<UDP_TASK_DEPTH>("UdpTask", TaskPrio_Mid) {}
 
 void UdpTask::task() {
-    Log.v("UDP", "UDP task start");
+    LOG_V("UDP", "UDP task start");
     int ret, recvnum, sockfd = -1;
     int rmt_port = 8080;
     int bod_port = 8080;
@@ -76,7 +76,7 @@ void UdpTask::task() {
     bod_addr.sin_port = htons(bod_port);
     bod_addr.sin_addr.s_addr = htons(INADDR_ANY);
 
-    Log.v("UDP", "UDP server start");
+    LOG_V("UDP", "UDP server start");
 
     send_buf.resize(100);
     for (int i = 0; i < 100; i++) {
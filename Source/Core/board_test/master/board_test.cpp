@@ -68,8 +68,8 @@ class UdpEchoTask : public TaskClassS<UDP_ECHO_TASK_DEPTH> {
         }
         fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
 
-        Log.v("UDP", "rmt_port: %d", rmt_port);
-        Log.v("UDP", "bod_port: %d", bod_port);
+        LOG_V("UDP", "rmt_port: %d", rmt_port);
+        LOG_V("UDP", "bod_port: %d", bod_port);
 
         if (sockfd < 0) {
             vTaskDelete(nullptr);
@@ -86,7 +86,7 @@ class UdpEchoTask : public TaskClassS<UDP_ECHO_TASK_DEPTH> {
             recvnum = recvfrom(sockfd, buf, MAX_BUF_SIZE, 0,
                                (struct sockaddr*)&rmt_addr, &len);
             if (recvnum > 0) {
-                Log.v("UDP", "recvfrom: %d", recvnum);
+                LOG_V("UDP", "recvfrom: %d", recvnum);
                 sendto(sockfd, buf, recvnum, 0, (struct sockaddr*)&rmt_addr,
                        sizeof(rmt_addr));
                 recvnum = 0;
@@ -115,30 +115,30 @@ static void BootTask(void* pvParameters) {
 
     LogTask logTask(Log);
     logTask.give();
-    Log.d(TAG, "LogTask initialized");
+    LOG_D(TAG, "LogTask initialized");
 
     uint32_t myUid = UIDReader::get();
-    Log.d(TAG, "Master Board Test Firmware %s, Build: %s %s", FIRMWARE_VERSION,
+    LOG_D(TAG, "Master Board Test Firmware %s, Build: %s %s", FIRMWARE_VERSION,
           __DATE__, __TIME__);
-    Log.d(TAG, "UID: %08X", myUid);
+    LOG_D(TAG, "UID: %08X", myUid);
 
     EthDevice ethDevice;
     ret = ethDevice.init();
     if (ret != 0) {
-        Log.e(TAG, "ethDevice init failed");
+        LOG_E(TAG, "ethDevice init failed");
     } else {
-        Log.d(TAG, "ethDevice init success");
+        LOG_D(TAG, "ethDevice init success");
         UdpEchoTask udpEchoTask;
         udpEchoTask.give();
-        Log.d(TAG, "UDP Echo Task Start");
+        LOG_D(TAG, "UDP Echo Task Start");
     }
 
     UwbDevice uwbDevice;
     uwbDevice.give();
-    Log.d(TAG, "UWB Device Task Start");
+    LOG_D(TAG, "UWB Device Task Start");
 
     while (1) {
-        // Log.d("heap minimum: %d", xPortGetMinimumEverFreeHeapSize());
+        // LOG_D("heap minimum: %d", xPortGetMinimumEverFreeHeapSize());
         sysLed.toggle();
         vTaskDelay(pdMS_TO_TICKS(500));
     }
@@ -18,7 +18,7 @@ extern Logger Log;
 class UwbUartInterface : public CxUwbInterface {
    public:
     UwbUartInterface()
-        : uwb_com_info(usart0_info), uwb_com_cfg(uwb_com_info, false, 1024) {}
+        : uwb_com_info(usart0_info), uwb_com_cfg(uwb_com_info, true, 1, true) {}
     ~UwbUartInterface() {
         delete uwb_com;
         delete en_pin;
@@ -37,7 +37,7 @@ class UwbUartInterface : public CxUwbInterface {
     }
     void generate_reset_signal() override { rst_pin->bit_reset(); }
     void turn_of_reset_signal() override { rst_pin->bit_set(); }
-    bool send(std::vector<uint8_t>& tx_data) override {
+    bool send(PoolVector<uint8_t>& tx_data) override {
         uwb_com->send(tx_data.data(), tx_data.size());
         return true;
     }
@@ -54,31 +54,29 @@ class UwbUartInterface : public CxUwbInterface {
     uint32_t get_system_1ms_ticks() override {
         return xTaskGetTickCount() * portTICK_PERIOD_MS;
     }
-    bool get_recv_data(std::queue<uint8_t>& rx_data) override {
-        bool ret = false;
-        uint8_t data;
-        while (uwb_com->recv_1byte(data, 0)) {
-            rx_data.push(data);
-        }
-        return ret;
+    uint16_t get_recv_span(const uint8_t*& rx_data) override {
+        return uwb_com->rx_peek(rx_data);
     }
+    void release_recv_span(uint16_t len) override { uwb_com->rx_consume(len); }
 
     void delay_ms(uint32_t ms) override { TaskBase::delay(ms); }
 
     void log(const char* format, ...) override {
-        va_list args;
-        va_start(args, format);
-        char buffer[256];
-        vsnprintf(buffer, sizeof(buffer), format, args);
-        va_end(args);
-        Log.d("uwb", buffer);
+        if constexpr (Logger::compiled(Logger::Level::DEBUGL, "uwb")) {
+            va_list args;
+            va_start(args, format);
+            char buffer[256];
+            vsnprintf(buffer, sizeof(buffer), format, args);
+            va_end(args);
+            LOG_D("uwb", "%s", buffer);
+        }
     }
 };
 
 class BoardUwbUartInterface : public CxUwbInterface {
    public:
     BoardUwbUartInterface()
-        : uwb_com_info(usart0_info), uwb_com_cfg(uwb_com_info, false, 1024) {}
+        : uwb_com_info(usart0_info), uwb_com_cfg(uwb_com_info, true, 1, true) {}
     ~BoardUwbUartInterface() {
         delete uwb_com;
         delete en_pin;
@@ -101,19 +99,15 @@ class BoardUwbUartInterface : public CxUwbInterface {
 
     void generate_reset_signal() override { rst_pin->bit_reset(); }
     void turn_of_reset_signal() override { rst_pin->bit_set(); }
-    bool send(std::vector<uint8_t>& tx_data) override {
+    bool send(PoolVector<uint8_t>& tx_data) override {
         uwb_com->send(tx_data.data(), tx_data.size());
         return true;
     }
 
-    bool get_recv_data(std::queue<uint8_t>& rx_data) override {
-        bool ret = false;
-        uint8_t data;
-        while (uwb_com->recv_1byte(data, 0)) {
-            rx_data.push(data);
-        }
-        return ret;
+    uint16_t get_recv_span(const uint8_t*& rx_data) override {
+        return uwb_com->rx_peek(rx_data);
     }
+    void release_recv_span(uint16_t len) override { uwb_com->rx_consume(len); }
 
     void commuication_peripheral_init() override {
         uwb_com = new Uart(uwb_com_cfg);
@@ -129,12 +123,14 @@ class BoardUwbUartInterface : public CxUwbInterface {
     void delay_ms(uint32_t ms) override { TaskBase::delay(ms); }
 
     void log(const char* format, ...) override {
-        va_list args;
-        va_start(args, format);
-        char buffer[256];
-        vsnprintf(buffer, sizeof(buffer), format, args);
-        va_end(args);
-        Log.d("uwb", buffer);
+        if constexpr (Logger::compiled(Logger::Level::DEBUGL, "uwb")) {
+            va_list args;
+            va_start(args, format);
+            char buffer[256];
+            vsnprintf(buffer, sizeof(buffer), format, args);
+            va_end(args);
+            LOG_D("uwb", "%s", buffer);
+        }
     }
 };
 
@@ -175,6 +171,8 @@ class SlaveUwbSpiInterface : public CxUwbInterface {
         this, &SlaveUwbSpiInterface::int_pin_irq_handler, exit_cfg};
     uint8_t rx_buffer[1024];
     uint16_t revc_len;
+    uint16_t rx_span_offset = 0;    // 已被解析的字节数
+    uint16_t rx_span_len = 0;       // 剩余未解析的字节数
     BinarySemaphore rx_semaphore = {"rx_semaphore"};
     long waswoken = 0;
     bool irq_enable = false;
@@ -210,7 +208,7 @@ class SlaveUwbSpiInterface : public CxUwbInterface {
     }
     void generate_reset_signal() override { rst_pin->bit_reset(); }
     void turn_of_reset_signal() override { rst_pin->bit_set(); }
-    bool send(std::vector<uint8_t>& tx_data) override {
+    bool send(PoolVector<uint8_t>& tx_data) override {
         bool ret = false;
 
         spi_dev->nss_low();
@@ -224,20 +222,25 @@ class SlaveUwbSpiInterface : public CxUwbInterface {
                 return false;
             }
         }
-        ret = spi_dev->send(tx_data);
+        ret = spi_dev->send(tx_data.data(), tx_data.size());
         spi_dev->nss_high();
         return ret;
     }
 
-    bool get_recv_data(std::queue<uint8_t>& rx_data) override {
-        if (rx_semaphore.take(0)) {
-            for (int i = 0; i < revc_len + 4; i++) {
-                rx_data.push(rx_buffer[i]);
+    uint16_t get_recv_span(const uint8_t*& rx_data) override {
+        if (rx_span_len == 0) {
+            if (!rx_semaphore.take(0)) {
+                return 0;
             }
-            memset(rx_buffer, 0, sizeof(rx_buffer));
-            return true;
+            rx_span_offset = 0;
+            rx_span_len = revc_len + 4;
         }
-        return false;
+        rx_data = rx_buffer + rx_span_offset;
+        return rx_span_len;
+    }
+    void release_recv_span(uint16_t len) override {
+        rx_span_offset += len;
+        rx_span_len -= len;
     }
 
     void commuication_peripheral_init() override {
@@ -261,12 +264,14 @@ class SlaveUwbSpiInterface : public CxUwbInterface {
     void delay_ms(uint32_t ms) override { TaskBase::delay(ms); }
 
     void log(const char* format, ...) override {
-        va_list args;
-        va_start(args, format);
-        char buffer[256];
-        vsnprintf(buffer, sizeof(buffer), format, args);
-        va_end(args);
-        Log.d("uwb", buffer);
+        if constexpr (Logger::compiled(Logger::Level::DEBUGL, "uwb")) {
+            va_list args;
+            va_start(args, format);
+            char buffer[256];
+            vsnprintf(buffer, sizeof(buffer), format, args);
+            va_end(args);
+            LOG_D("uwb", "%s", buffer);
+        }
     }
 };
 
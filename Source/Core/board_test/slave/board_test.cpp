@@ -112,7 +112,7 @@ class KeyTestTask : public TaskClassS<1024> {
         for (;;) {
             for (auto key : keys) {
                 if (key->isPressed()) {
-                    Log.d(TAG,"[%s] pressed", key->getName());
+                    LOG_D(TAG,"[%s] pressed", key->getName());
                 }
             }
             TaskBase::delay(1000);
@@ -147,7 +147,7 @@ class DipSwithTestTask : public TaskClassS<1024> {
 
         for (;;) {
             uint8_t switchVal = dip.value();    // 获取当前拨码值
-            Log.d(TAG,"%02X", switchVal);
+            LOG_D(TAG,"%02X", switchVal);
             TaskBase::delay(1000);
         }
     }
@@ -162,7 +162,7 @@ class DW1000Task : public TaskClassS<1024> {
         for (;;) {
             // dw1000.recv();
             // if (dw1000.frame_len != 0) {
-                // Log.d("[DW1000] recv: %d", dw1000.frame_len);
+                // LOG_D("[DW1000] recv: %d", dw1000.frame_len);
                 // dw1000.frame_len = 0;
             // }
             TaskBase::delay(1000);
@@ -173,39 +173,39 @@ class DW1000Task : public TaskClassS<1024> {
 static void BootTask(void* pvParameters) {
     static constexpr const char TAG[] = "BOOT";
     uint32_t myUid = UIDReader::get();
-    Log.d(TAG,"Slave Board Test Firmware %s, Build: %s %s", FIRMWARE_VERSION, __DATE__, __TIME__);
-    Log.d(TAG,"UID: %08X", myUid);
+    LOG_D(TAG,"Slave Board Test Firmware %s, Build: %s %s", FIRMWARE_VERSION, __DATE__, __TIME__);
+    LOG_D(TAG,"UID: %08X", myUid);
 
     LogTask logTask(Log);
     logTask.give();
-    Log.d(TAG,"LogTask started");
+    LOG_D(TAG,"LogTask started");
 
     ComEchoTask ComEchoTask;
     ComEchoTask.give();
-    Log.d(TAG,"ComEchoTask started");
+    LOG_D(TAG,"ComEchoTask started");
 
     GpioTestTask GpioTestTask;
     GpioTestTask.give();
-    Log.d(TAG,"GpioTestTask started");
+    LOG_D(TAG,"GpioTestTask started");
 
     LedElvTestTask LedElvTestTask;
     LedElvTestTask.give();
-    Log.d(TAG,"LedElvTestTask started");
+    LOG_D(TAG,"LedElvTestTask started");
 
     KeyTestTask KeyTestTask;
     KeyTestTask.give();
-    Log.d(TAG,"KeyTestTask started");
+    LOG_D(TAG,"KeyTestTask started");
 
     DipSwithTestTask DipSwithTestTask;
     DipSwithTestTask.give();
-    Log.d(TAG,"DipSwithTestTask started");
+    LOG_D(TAG,"DipSwithTestTask started");
 
     DW1000Task DW1000Task;
     DW1000Task.give();
-    Log.d(TAG,"DW1000Task started");
+    LOG_D(TAG,"DW1000Task started");
 
     while (1) {
-        // Log.d("heap minimum: %d", xPortGetMinimumEverFreeHeapSize());
+        // LOG_D("heap minimum: %d", xPortGetMinimumEverFreeHeapSize());
         sysLed.toggle();
         vTaskDelay(pdMS_TO_TICKS(500));
     }
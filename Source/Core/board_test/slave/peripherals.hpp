@@ -218,7 +218,7 @@ class DW1000 {
         reset();
 
         if (dwt_initialise(DWT_LOADUCODE) == DWT_ERROR) {
-            Log.e(TAG,"init FAIL");
+            LOG_E(TAG,"init FAIL");
             return 1;
         }
 
@@ -226,7 +226,7 @@ class DW1000 {
         dwt_configure(&dw1000_config);
 
         dwt_write32bitreg(TX_POWER_ID, 0x85858585);
-        Log.d(TAG,"init OK");
+        LOG_D(TAG,"init OK");
         return 0;
     }
 
@@ -275,14 +275,14 @@ class DW1000 {
             dwt_write32bitreg(SYS_STATUS_ID, SYS_STATUS_RXFCG);
         } else if (status_reg & SYS_STATUS_ALL_RX_TO) {
             dwt_write32bitreg(SYS_STATUS_ID, SYS_STATUS_ALL_RX_TO);
-            Log.e(TAG,"RX TIMEOUT!");
+            LOG_E(TAG,"RX TIMEOUT!");
             return 1;
         } else if (status_reg & SYS_STATUS_ALL_RX_ERR) {
             dwt_write32bitreg(SYS_STATUS_ID, SYS_STATUS_ALL_RX_ERR);
-            Log.e(TAG,"RX ERROR!");
+            LOG_E(TAG,"RX ERROR!");
             return 1;
         }
-        // Log.d("RX OK!");
+        // LOG_D("RX OK!");
         return 0;
     }
 
@@ -34,6 +34,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "gd32f4xx_it.h"
 
+#include "bsp_runtime_stats.h"
 #include "gd32f4xx.h"
 
 #ifdef MASTER
@@ -43,6 +44,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "semphr.h"
 
 extern xSemaphoreHandle g_rx_semaphore;
+extern xSemaphoreHandle g_tx_semaphore;
 #endif
 /*!
     \brief      this function handles NMI exception
@@ -140,6 +142,7 @@ void DebugMon_Handler(void) {
     \retval     none
 */
 void ENET_IRQHandler(void) {
+    ISR_STAT_ENTER();
     portBASE_TYPE xHigherPriorityTaskWoken = pdFALSE;
 
     /* frame received */
@@ -148,9 +151,19 @@ void ENET_IRQHandler(void) {
         xSemaphoreGiveFromISR(g_rx_semaphore, &xHigherPriorityTaskWoken);
     }
 
-    /* clear the enet DMA Rx interrupt pending bits */
+    /* frame transmitted */
+    if (SET == enet_interrupt_flag_get(ENET_DMA_INT_FLAG_TS)) {
+        /* wakeup the output waiting for a free descriptor, and the input task
+         * to release the sent pbufs */
+        xSemaphoreGiveFromISR(g_tx_semaphore, &xHigherPriorityTaskWoken);
+        xSemaphoreGiveFromISR(g_rx_semaphore, &xHigherPriorityTaskWoken);
+    }
+
+    /* clear the enet DMA Rx/Tx interrupt pending bits */
     enet_interrupt_flag_clear(ENET_DMA_INT_FLAG_RS_CLR);
+    enet_interrupt_flag_clear(ENET_DMA_INT_FLAG_TS_CLR);
     enet_interrupt_flag_clear(ENET_DMA_INT_FLAG_NI_CLR);
+    ISR_STAT_EXIT(ISR_STAT_ENET);
 
     /* switch tasks if necessary */
     if (pdFALSE != xHigherPriorityTaskWoken) {
@@ -5,9 +5,14 @@
 
 #include "FreeRTOS.h"
 #include "bsp_log.hpp"
+#include "bsp_trace.hpp"
 #include "bsp_uid.hpp"
 #include "mode_entry.h"
 
+#ifdef HOST_SIM
+#include "host_sim.hpp"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -21,8 +26,14 @@ extern "C" {
 }
 #endif
 
+#ifdef HOST_SIM
+int main(int argc, char** argv) {
+    HostSim::init(argc, argv);
+#else
 int main(void) {
     nvic_priority_group_set(NVIC_PRIGROUP_PRE4_SUB0);
+#endif
+    Trace::start();
 
 #ifdef MASTER
     // 主节点模式入口
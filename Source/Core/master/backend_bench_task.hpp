@@ -0,0 +1,71 @@
+#ifndef BACKEND_BENCH_TASK_HPP
+#define BACKEND_BENCH_TASK_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "TaskCPP.h"
+#include "bsp_allocate.hpp"
+#include "bsp_log.hpp"
+#include "master_cfg.hpp"
+#include "master_def.hpp"
+#include "protocol.hpp"
+
+extern Logger Log;
+
+/**
+ * @brief 上位机链路吞吐量测试，持续向发送环形缓冲区写入结果流帧
+ * @note 帧格式与正常上报相同(RESULT_STREAM_MSG，序号连续递增)，上位机用
+ *       Scripts/backend_tcp_bench.py接收并统计吞吐量和序号连续性
+ */
+class BackendBenchTask : public TaskClassS<BackendBenchTask_STACK_SIZE> {
+   public:
+    BackendBenchTask(TxSlotRing& ring)
+        : TaskClassS("BackendBenchTask", TaskPrio_Mid), ring(ring) {}
+
+   private:
+    static constexpr const char TAG[] = "BackendBench";
+    // 帧头 + 消息ID之后为4字节序号
+    static constexpr size_t SEQ_OFFSET = FrameHeader::HEADER_SIZE + 1;
+    TxSlotRing& ring;
+
+    void task() override {
+        LOG_I(TAG, "Boot");
+
+        // 只构造一次测试帧，之后原地改写序号
+        Master2Backend::ResultStreamMsg msg;
+        msg.seq = 0;
+        msg.flags = 0;
+        msg.frame.assign(BackendBenchTask_FRAME_SIZE - SEQ_OFFSET - 5, 0);
+        for (size_t i = 0; i < msg.frame.size(); i++) {
+            msg.frame[i] = (uint8_t)i;
+        }
+        auto packet = PacketPacker::master2BackendPack(msg);
+        PoolVector<uint8_t> frame = FramePacker::pack(packet);
+
+        uint32_t seq = 0;
+        uint32_t bytes = 0;
+        TickType_t last = xTaskGetTickCount();
+        for (;;) {
+            frame[SEQ_OFFSET] = (uint8_t)seq;
+            frame[SEQ_OFFSET + 1] = (uint8_t)(seq >> 8);
+            frame[SEQ_OFFSET + 2] = (uint8_t)(seq >> 16);
+            frame[SEQ_OFFSET + 3] = (uint8_t)(seq >> 24);
+            if (ring.push(frame.data(), frame.size())) {
+                seq++;
+                bytes += frame.size();
+            }
+
+            TickType_t elapsed = xTaskGetTickCount() - last;
+            if (elapsed >= pdMS_TO_TICKS(BackendBenchTask_REPORT_INTERVAL_MS)) {
+                LOG_I(TAG, "seq=%lu, queued %lu B/s", (unsigned long)seq,
+                      (unsigned long)((uint64_t)bytes * 1000 /
+                                      (elapsed * portTICK_PERIOD_MS)));
+                bytes = 0;
+                last = xTaskGetTickCount();
+            }
+        }
+    }
+};
+
+#endif
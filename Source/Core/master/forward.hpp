@@ -18,21 +18,20 @@ class DataForwardBase {
     DataForward data_forward;
     PCmanagerMsg& pc_manager_msg;
 
-    bool forward() {
-        if (pc_manager_msg.data_forward_queue.add(
-                data_forward, PCinterface_FORWARD_QUEUE_TIMEOUT)) {
-        } else {
-            Log.e("Forward","pc_manager_msg.data_forward_queue.add failed");
+    /**
+     * @brief 同步转发data_forward并等待从机管理任务执行完成
+     * @return 执行成功返回true，指令表已满、超时或执行失败返回false
+     */
+    bool forward(CmdTable::Priority prio = CmdTable::NORMAL) {
+        uint8_t slot = pc_manager_msg.cmd_table.submit(
+            std::vector<DataForward>{data_forward}, PoolVector<uint8_t>(), 0,
+            prio);
+        if (slot == CmdTable::NONE) {
+            LOG_E("Forward", "cmd_table full");
             return false;
         }
 
-        if (pc_manager_msg.event.wait(FORWARD_SUCCESS_EVENT, true, true,
-                                      PCinterface_FORWARD_TIMEOUT)) {
-        } else {
-            Log.e("Forward","pc_manager_msg.event.take failed");
-            return false;
-        }
-        return true;
+        return pc_manager_msg.cmd_table.wait(slot, PCinterface_FORWARD_TIMEOUT);
     }
 };
 
@@ -0,0 +1,452 @@
+#ifndef __JSON_CMD_HPP
+#define __JSON_CMD_HPP
+
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "json.hpp"
+#include "master_cfg.hpp"
+#include "master_cmd.hpp"
+
+/**
+ * @brief 上位机json指令的SAX解析器，单遍解析直接填充指令结构体，不构建DOM
+ * @note 字段顺序任意，"inst"可以出现在"params"之后，因此params数组中每个
+ *       元素同时填入cfg和rst，由inst决定使用哪一个。params数组结束时即算出
+ *       配置指令的总线数、起始线号和末设备标志。解析过程中仅词法分析器的
+ *       字符串缓冲可能申请堆内存(键和id均在短字符串优化范围内)
+ */
+class JsonCmdSax : public nlohmann::json_sax<nlohmann::json> {
+   public:
+    int16_t inst;    // 未携带inst时为-1
+
+    bool has_mode;
+    ModeCmd mode;
+    bool has_ctrl;
+    CtrlCmd ctrl;
+
+    // "params"数组: 配置/复位指令的从机列表
+    bool has_params;
+    uint8_t slave_num;
+    CfgCmd cfg[PCinterface_JSON_MAX_SLAVES];
+    ResetCmd rst[PCinterface_JSON_MAX_SLAVES];
+
+    // "id"数组 + "params"对象: 查询指令
+    bool has_query_id;
+    uint8_t query_num;
+    QueryCmd query[PCinterface_JSON_MAX_SLAVES];
+
+   public:
+    /**
+     * @brief 解析一条指令
+     * @return json格式错误、嵌套过深或从机数超限时返回false
+     */
+    bool parse(const uint8_t* data, size_t len) {
+        inst = -1;
+        has_mode = false;
+        has_ctrl = false;
+        has_params = false;
+        slave_num = 0;
+        has_query_id = false;
+        query_num = 0;
+        __query_clip = 0;
+        __depth = 0;
+        __key = KEY_NONE;
+        if (!nlohmann::json::sax_parse(data, data + len, this)) {
+            return false;
+        }
+        for (uint8_t i = 0; i < query_num; i++) {
+            query[i].clip = __query_clip;
+        }
+        return true;
+    }
+
+    static bool parseIdString(const char* ptr, uint8_t tar_id[4]) {
+        int index = 0;
+
+        while (*ptr && index < 4) {
+            uint8_t value = 0;
+            for (int i = 0; i < 2; ++i) {
+                if (*ptr >= '0' && *ptr <= '9') {
+                    value = (value << 4) + (*ptr - '0');
+                } else if (*ptr >= 'A' && *ptr <= 'F') {
+                    value = (value << 4) + (*ptr - 'A' + 10);
+                } else if (*ptr >= 'a' && *ptr <= 'f') {
+                    value = (value << 4) + (*ptr - 'a' + 10);
+                } else {
+                    return false;    // 解析出错
+                }
+                ptr++;
+            }
+            tar_id[index++] = value;
+            if (*ptr == '-') {
+                ptr++;
+            }
+        }
+        return index == 4;    // 确保解析了 4 个字节
+    }
+
+    static uint16_t hexStringToUint16(const char* hex_str) {
+        uint16_t result = 0;
+        for (const char* c = hex_str; *c; c++) {
+            if (*c >= '0' && *c <= '9') {
+                result = (result << 4) + (*c - '0');
+            } else if (*c >= 'A' && *c <= 'F') {
+                result = (result << 4) + (*c - 'A' + 10);
+            } else if (*c >= 'a' && *c <= 'f') {
+                result = (result << 4) + (*c - 'a' + 10);
+            } else {
+                // 遇到非十六进制字符，返回 0
+                return 0;
+            }
+        }
+        return result;
+    }
+
+   private:
+    // 当前所在容器
+    enum Scope : uint8_t {
+        SCOPE_ROOT = 0,
+        SCOPE_PARAMS_ARRAY,     // 配置/复位: "params": [...]
+        SCOPE_SLAVE,            // params数组元素
+        SCOPE_CLIP,             // 配置: "clip": {"mode", "pin"}
+        SCOPE_QUERY_PARAMS,     // 查询: "params": {"clip"}
+        SCOPE_QUERY_ID_ARRAY,   // 查询: "id": [...]
+        SCOPE_SKIP,             // 不关心的容器
+    };
+
+    enum Key : uint8_t {
+        KEY_NONE = 0,
+        KEY_INST,
+        KEY_MODE,
+        KEY_CTRL,
+        KEY_PARAMS,
+        KEY_ID,
+        KEY_COND,
+        KEY_Z,
+        KEY_CLIP,
+        KEY_PIN,
+        KEY_LOCK,
+    };
+
+    static constexpr uint8_t MAX_DEPTH = 8;
+
+    Scope __scope[MAX_DEPTH];
+    uint8_t __depth;
+    Key __key;
+    uint8_t __query_clip;
+
+    Scope __top() const {
+        return __depth ? __scope[__depth - 1] : SCOPE_SKIP;
+    }
+
+    bool __push(Scope scope) {
+        if (__depth >= MAX_DEPTH) {
+            return false;
+        }
+        __scope[__depth++] = scope;
+        __key = KEY_NONE;
+        return true;
+    }
+
+    static Key __to_key(const std::string& s) {
+        static const struct {
+            const char* name;
+            Key key;
+        } table[] = {
+            {"inst", KEY_INST}, {"mode", KEY_MODE},   {"ctrl", KEY_CTRL},
+            {"params", KEY_PARAMS}, {"id", KEY_ID}, {"cond", KEY_COND},
+            {"Z", KEY_Z},       {"clip", KEY_CLIP},   {"pin", KEY_PIN},
+            {"lock", KEY_LOCK},
+        };
+        for (const auto& item : table) {
+            if (s == item.name) {
+                return item.key;
+            }
+        }
+        return KEY_NONE;
+    }
+
+    // 数值字段，负数和浮点数按原DOM实现的隐式转换截断
+    bool __number(uint64_t val) {
+        switch (__top()) {
+            case SCOPE_ROOT:
+                if (__key == KEY_INST) {
+                    inst = (uint8_t)val;
+                } else if (__key == KEY_MODE) {
+                    has_mode = true;
+                    mode.mode = (SysMode)val;
+                } else if (__key == KEY_CTRL) {
+                    has_ctrl = true;
+                    ctrl.ctrl = (CtrlType)val;
+                }
+                break;
+            case SCOPE_SLAVE:
+                if (__key == KEY_COND) {
+                    cfg[slave_num - 1].cond = (uint16_t)val;
+                } else if (__key == KEY_Z) {
+                    cfg[slave_num - 1].Z = (uint16_t)val;
+                } else if (__key == KEY_LOCK) {
+                    rst[slave_num - 1].lock = (LockSta)val;
+                }
+                break;
+            case SCOPE_CLIP:
+                if (__key == KEY_MODE) {
+                    cfg[slave_num - 1].clip_mode = (uint8_t)val;
+                }
+                break;
+            case SCOPE_QUERY_PARAMS:
+                if (__key == KEY_CLIP) {
+                    __query_clip = (uint8_t)val;
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    // 配置指令的线号分配，与逐个转发时的累加顺序一致
+    void __finish_params() {
+        uint16_t total = 0;
+        for (uint8_t i = 0; i < slave_num; i++) {
+            total += cfg[i].cond;
+        }
+        uint16_t start = 0;
+        for (uint8_t i = 0; i < slave_num; i++) {
+            cfg[i].totalHarnessNum = total;
+            cfg[i].startHarnessNum = start;
+            cfg[i].slave_dev_num = slave_num;
+            cfg[i].is_last_dev = (i == slave_num - 1);
+            start += cfg[i].cond;
+        }
+    }
+
+   public:
+    bool null() override { return true; }
+
+    bool boolean(bool) override { return true; }
+
+    bool number_integer(number_integer_t val) override {
+        return __number((uint64_t)val);
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+        return __number(val);
+    }
+
+    bool number_float(number_float_t val, const string_t&) override {
+        return __number((uint64_t)(int64_t)val);
+    }
+
+    bool string(string_t& val) override {
+        switch (__top()) {
+            case SCOPE_SLAVE:
+                if (__key == KEY_ID) {
+                    parseIdString(val.c_str(), cfg[slave_num - 1].id);
+                    memcpy(rst[slave_num - 1].id, cfg[slave_num - 1].id, 4);
+                } else if (__key == KEY_CLIP) {
+                    rst[slave_num - 1].clip = hexStringToUint16(val.c_str());
+                }
+                break;
+            case SCOPE_CLIP:
+                if (__key == KEY_PIN) {
+                    cfg[slave_num - 1].clip_pin =
+                        hexStringToUint16(val.c_str());
+                }
+                break;
+            case SCOPE_QUERY_ID_ARRAY: {
+                if (query_num >= PCinterface_JSON_MAX_SLAVES) {
+                    return false;
+                }
+                QueryCmd& q = query[query_num++];
+                memset(&q, 0, sizeof(q));
+                if (val == "*") {
+                    memset(q.id, 0xFF, 4);
+                } else {
+                    parseIdString(val.c_str(), q.id);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool binary(binary_t&) override { return true; }
+
+    bool start_object(std::size_t) override {
+        Scope parent = __top();
+        if (__depth == 0) {
+            return __push(SCOPE_ROOT);
+        }
+        if (parent == SCOPE_ROOT && __key == KEY_PARAMS) {
+            return __push(SCOPE_QUERY_PARAMS);
+        }
+        if (parent == SCOPE_PARAMS_ARRAY) {
+            if (slave_num >= PCinterface_JSON_MAX_SLAVES) {
+                return false;
+            }
+            memset(&cfg[slave_num], 0, sizeof(cfg[slave_num]));
+            memset(&rst[slave_num], 0, sizeof(rst[slave_num]));
+            slave_num++;
+            return __push(SCOPE_SLAVE);
+        }
+        if (parent == SCOPE_SLAVE && __key == KEY_CLIP) {
+            cfg[slave_num - 1].clip_exist = true;
+            return __push(SCOPE_CLIP);
+        }
+        return __push(SCOPE_SKIP);
+    }
+
+    bool key(string_t& val) override {
+        __key = __to_key(val);
+        return true;
+    }
+
+    bool end_object() override {
+        __depth--;
+        return true;
+    }
+
+    bool start_array(std::size_t) override {
+        Scope parent = __top();
+        if (__depth == 0) {
+            // 指令必须是对象
+            return false;
+        }
+        if (parent == SCOPE_ROOT && __key == KEY_PARAMS) {
+            has_params = true;
+            return __push(SCOPE_PARAMS_ARRAY);
+        }
+        if (parent == SCOPE_ROOT && __key == KEY_ID) {
+            has_query_id = true;
+            return __push(SCOPE_QUERY_ID_ARRAY);
+        }
+        return __push(SCOPE_SKIP);
+    }
+
+    bool end_array() override {
+        if (__top() == SCOPE_PARAMS_ARRAY) {
+            __finish_params();
+        }
+        __depth--;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&,
+                     const nlohmann::detail::exception&) override {
+        return false;
+    }
+};
+
+/**
+ * @brief 定长缓冲区上的json回复，键按字母序输出，与nlohmann::json::dump()
+ *        的结果一致。缓冲区不足时size()返回0，不回复截断的json
+ */
+class JsonRsp {
+   public:
+    void clear() {
+        __len = 0;
+        __overflow = false;
+        __first = true;
+    }
+
+    // {"result":{
+    void begin() {
+        clear();
+        __append("{\"result\":{");
+    }
+
+    // "key":value
+    void number(const char* key, unsigned value) {
+        __sep();
+        __append("\"%s\":%u", key, value);
+    }
+
+    // "id":["XX-XX-XX-XX",...]，列表为空时不输出
+    void id_list(const uint8_t (*ids)[4], size_t num) {
+        if (num == 0) {
+            return;
+        }
+        __sep();
+        __append("\"id\":[");
+        for (size_t i = 0; i < num; i++) {
+            __append("%s\"%02X-%02X-%02X-%02X\"", i ? "," : "", ids[i][0],
+                     ids[i][1], ids[i][2], ids[i][3]);
+        }
+        __append("]");
+    }
+
+    // "key":"XX-XX-XX-XX"
+    void id(const char* key, const uint8_t id[4]) {
+        __sep();
+        __append("\"%s\":\"%02X-%02X-%02X-%02X\"", key, id[0], id[1], id[2],
+                 id[3]);
+    }
+
+    // "key":[，数组元素用object_begin()/object_end()输出
+    void array_begin(const char* key) {
+        __sep();
+        __append("\"%s\":[", key);
+        __first = true;
+    }
+
+    void array_end() {
+        __append("]");
+        __first = false;
+    }
+
+    // {，对象内的键同样按字母序输出
+    void object_begin() {
+        __sep();
+        __append("{");
+        __first = true;
+    }
+
+    void object_end() {
+        __append("}");
+        __first = false;
+    }
+
+    // },"status":N}
+    void end(uint8_t status) { __append("},\"status\":%u}", status); }
+
+    const uint8_t* data() const { return (const uint8_t*)__buf; }
+
+    size_t size() const { return __overflow ? 0 : __len; }
+
+    bool overflow() const { return __overflow; }
+
+   private:
+    char __buf[PCinterface_JSON_RSP_SIZE];
+    size_t __len = 0;
+    bool __overflow = false;
+    bool __first = true;
+
+    void __sep() {
+        if (!__first) {
+            __append(",");
+        }
+        __first = false;
+    }
+
+    void __append(const char* fmt, ...) {
+        if (__overflow) {
+            return;
+        }
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(__buf + __len, sizeof(__buf) - __len, fmt, args);
+        va_end(args);
+        if (n < 0 || (size_t)n >= sizeof(__buf) - __len) {
+            __overflow = true;
+            return;
+        }
+        __len += n;
+    }
+};
+
+#endif
@@ -7,16 +7,23 @@
 #define CONDUCTION_TEST_INTERVAL           20      // 导通检测时间间隔
 #define CLIP_TEST_INTERVAL                 20     // 卡钉检测时间间隔
 #define SYNC_TIMER_PERIOD_REDUNDANCY_TICKS 100    // 同步定时器冗余时间
-#define PC_TX_SHARE_MEM_ACCESS_TIMEOUT \
-    1000    // 获取上位机数据传输共享内存写权限超时
-#define PC_TX_TIMEOUT 1000    // 向上位机发送数据超时
+#define PC_TX_TIMEOUT 1000    // 上位机发送缓冲区满时数据入队超时
+// 主节点启动任务栈大小(字)：栈上有LOG格式化缓冲区(约0.6KB)和vsnprintf，
+// 并执行EthDevice初始化和各任务对象的构造，留出一倍余量；
+// 实际用量以诊断TASK段中MasterTask的stack_free核对
+#define MasterTask_STACK_SIZE 2 * 1024
 
 // < MSG 任务通信消息 >---------------------------------------------------
-// 上位机数据传输任务 <-> json解析任务：数据传输队列大小
-#define PCdataTransferMsg_DATA_QUEUE_SIZE 2048
+// 上位机数据传输任务 <-> json解析任务：接收数据报缓冲区个数
+#define PCdataTransferMsg_RX_DATAGRAM_NUM 4
 
-// json解析任务 <-> 从机管理任务：数据转发队列大小
-#define PCmanagerMsg_FORWARD_QUEUE_SIZE 10
+// 上位机数据传输任务 <-> json解析任务：接收数据报最大长度
+// 以太网MTU 1500 - IP头20 - UDP头8
+#define PCdataTransferMsg_RX_DATAGRAM_SIZE 1472
+
+// json解析任务 <-> 从机管理任务：同时在途的上位机指令数(指令表槽位数)，
+// 每个槽位占用一个事件位，不超过24
+#define PCmanagerMsg_CMD_SLOT_NUM 8
 
 // 从机数据传输任务 <-> 从机管理任务：接受数据传输队列大小
 #define ManagerDataTransferMsg_RXDATA_QUEUE_SIZE 2048
@@ -43,25 +50,96 @@
 // 上报数据超时
 #define SlaveManager_UPLOAD_TIMEOUT PC_TX_TIMEOUT    
 
+// 结果流历史环：保留最近的结果条数及总字节数，用于上位机NACK重传
+#define ResultStream_HISTORY_NUM   32
+#define ResultStream_HISTORY_BYTES 16 * 1024
+
+// 结果缓存：缓存最新结果的从机数，超出的从机不缓存
+#define ResultCache_SLAVE_NUM 32
+
+// 缓存查询应答的最大字节数，保证单个UDP数据报不分片
+#define ResultCache_RSP_MAX_SIZE 1400
+
+// 事件跟踪每段导出的最多记录数，应答不超过一个UDP数据报
+#define TRACE_DUMP_CHUNK 64
+
 // < ManagerDataTransfer 从机数据传输任务 >------------------------------
 // 从机数据转发任务 栈大小
 #define ManagerDataTransfer_STACK_SIZE 4 * 512
 
+// 以flush=false发送的帧的最长聚合等待时间，ms；
+// 同步帧和需要回复的帧都立即发送
+#define ManagerDataTransfer_TX_FLUSH_DEADLINE_MS 5
+
+// < UwbBenchTask UWB链路基准测试任务 >----------------------------------
+// 由CMake选项UWB_BENCHMARK打开，打开后不运行正常业务任务
+#define UwbBenchTask_STACK_SIZE 4 * 512
+
+// 扫描的负载长度(含12字节测试包头)
+#define UwbBenchTask_PAYLOAD_SIZES {16, 64, 256, 512, 1000}
+
+// 扫描的发包间隔，ms，0表示连续发送
+#define UwbBenchTask_GAPS_MS {0, 5, 20}
+
+// 每个测试点的发包数
+#define UwbBenchTask_PACKET_NUM 100
+
+// 两轮扫描之间的间隔，ms
+#define UwbBenchTask_SWEEP_INTERVAL_MS 10000
+
+// 测试结果上报端口，上位机地址见netcfg.h
+#define UwbBenchTask_REPORT_PORT 8081
+
+// < BackendBenchTask 上位机TCP吞吐量测试任务 >---------------------------
+// 由CMake选项BACKEND_TCP_BENCH打开，打开后不运行正常业务任务
+#define BackendBenchTask_STACK_SIZE 2 * 512
+
+// 测试帧长度(含帧头)
+#define BackendBenchTask_FRAME_SIZE 1024
+
+// 统计输出间隔，ms
+#define BackendBenchTask_REPORT_INTERVAL_MS 10000
+
 //==========================================================================================================
 
 // < PCdataTransfer 上位机数据传输任务 >-----------------------------------
 // 上位机数据传输任务 栈大小
 #define PCdataTransfer_STACK_SIZE 3 * 512
 
-// 上位机数据传输任务 发送缓冲区大小
-#define PCdataTransfer_TX_BUFFER_SIZE 1024
+// 上位机数据传输任务 发送环形缓冲区大小，单帧最长为其一半
+#define PCdataTransfer_TX_RING_SIZE 8 * 1024
+
+// 上位机数据发送任务 栈大小
+#define PCdataTransfer_SENDER_STACK_SIZE 2 * 512
+
+// 上位机UDP传输：本机端口，上位机地址见netcfg.h
+#define PCdataTransfer_UDP_PORT 8080
+
+// 上位机原始UDP传输(CMake选项BACKEND_RAW_UDP)：每次切换到tcpip线程发出的
+// 最多帧数
+#define PCdataTransfer_RAW_UDP_BATCH 8
+
+// 上位机原始UDP传输：接收缓冲池空导致丢包时的统计输出间隔，ms
+#define PCdataTransfer_RAW_UDP_STATS_MS 10000
+
+// 上位机TCP传输(CMake选项BACKEND_TCP)：监听端口
+#define PCdataTransfer_TCP_PORT 8080
+
+// 上位机TCP传输：已写入协议栈、等待确认后才释放的帧数上限
+#define PCdataTransfer_TCP_INFLIGHT_NUM 32
+
+// 上位机TCP传输：有帧等待确认时查询确认序号的间隔
+#define PCdataTransfer_TCP_ACK_POLL_TICKS 1
 
 // < PCinterface json解析任务 >------------------------------------------
 // json解析任务 栈大小
 #define PCinterface_STACK_SIZE 1500
 
-// 从机管理任务 <-> json解析任务：转发数据入队超时时间
-#define PCinterface_FORWARD_QUEUE_TIMEOUT 5000
+// json解析任务：单条配置/复位/查询指令最多携带的从机数
+#define PCinterface_JSON_MAX_SLAVES 64
+
+// json解析任务：回复缓冲区大小，需容纳PCinterface_JSON_MAX_SLAVES个失败id
+#define PCinterface_JSON_RSP_SIZE 1024
 
 // json解析任务 <-> 从机管理任务：数据转发超时时间
 #define PCinterface_FORWARD_TIMEOUT                             \
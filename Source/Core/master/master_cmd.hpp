@@ -0,0 +1,82 @@
+#ifndef __MASTER_CMD_HPP
+#define __MASTER_CMD_HPP
+
+#include <cstdint>
+
+// 配置指令-------------------------------------------------
+struct CfgCmd {
+    uint8_t id[4];
+    uint16_t cond;    // 导通检测线数
+    uint16_t Z;       // 阻抗检测线数
+
+    bool clip_exist;      // 是否存在卡丁信息
+    uint8_t clip_mode;    // 卡丁模式
+    uint16_t clip_pin;    // 卡丁初始化信息
+
+    uint16_t totalHarnessNum;
+    uint16_t startHarnessNum;
+    uint16_t slave_dev_num;
+    bool is_last_dev;
+};
+
+// 模式指令-------------------------------------------------
+enum SysMode : uint8_t {
+    CONDUCTION_TEST = 0,
+    IMPEDANCE_TEST,
+    CLIP_TEST
+
+};
+struct ModeCmd {
+    SysMode mode;
+};
+
+// 复位指令-------------------------------------------------
+enum LockSta : uint8_t {
+    UNLOCKED = 0,
+    LOCKED,
+};
+struct ResetCmd {
+    uint8_t id[4];
+    uint16_t clip;
+    LockSta lock;
+};
+
+// 控制指令-------------------------------------------------
+enum CtrlType : uint8_t {
+    DEV_DISABLE = 0,
+    DEV_ENABLE,
+};
+struct CtrlCmd {
+    CtrlType ctrl;
+};
+
+// 查询指令-------------------------------------------------
+struct QueryCmd {
+    uint8_t id[4];
+    uint8_t clip;
+};
+
+// 状态回复-------------------------------------------------
+enum StatusReply : uint8_t {
+    STATUS_OK = 0,
+    STATUS_ERROR,
+};
+
+// 转发数据-------------------------------------------------
+enum CmdType : uint8_t {
+    DEV_CONF = 0,
+    DEV_MODE,
+    DEV_RESET,
+    DEV_CTRL,
+    DEV_QUERY,
+};
+struct DataForward {
+    CmdType type;
+    CfgCmd cfg_cmd;
+    ModeCmd mode_cmd;
+    ResetCmd rst_cmd;
+    CtrlCmd ctrl_cmd;
+    QueryCmd query_cmd;
+};
+
+#endif
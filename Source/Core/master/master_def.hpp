@@ -1,7 +1,10 @@
 #ifndef __MASTER_DEF_HPP
 #define __MASTER_DEF_HPP
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iterator>
 #include <vector>
 
@@ -10,8 +13,13 @@
 #include "MutexCPP.h"
 #include "QueueCPP.h"
 #include "SemaphoreCPP.h"
+#include "bsp_allocate.hpp"
+#include "bsp_diag.hpp"
+#include "bsp_log.hpp"
+#include "master_cmd.hpp"
 #include "master_cfg.hpp"
 #include "portable.h"
+#include "protocol.hpp"
 
 // 迭代器-------------------------------------------------
 class Uint8ArrayIterator {
@@ -45,210 +53,838 @@ class Uint8ArrayIterator {
     uint8_t* ptr_;
 };
 
-// 共享内存-------------------------------------------------
-class ShareMem {
+// 发送环形缓冲区-------------------------------------------------
+/**
+ * @brief 变长发送槽环形缓冲区，多生产者单消费者
+ * @note 每个槽为[4字节长度][数据]，按4字节对齐，数据始终连续存放，
+ *       尾部放不下时写入回绕标记从头开始。生产者之间用互斥锁串行入队，
+ *       入队后立即返回；消费者无锁地按顺序取出槽并原地发送
+ */
+class TxSlotRing {
    public:
-    ShareMem()
-        : __mutex("mem"),
-          __lock(__mutex),
-          __write_mtx("write_mtx"),
-          __write_access(__write_mtx) {
-        __write_access.unlock();
-    }
-
-    ShareMem(size_t wantedSize) : ShareMem() {
-        __shared_mem = (uint8_t*)pvPortMalloc(wantedSize);
-        if (__shared_mem == nullptr) {
-            __init_success = false;
+    explicit TxSlotRing(size_t capacity)
+        : __mutex("tx_ring"),
+          __data_sem("tx_ring_data"),
+          __space_sem("tx_ring_space") {
+        __capacity = capacity & ~(size_t)(HDR_SIZE - 1);
+        __buf = (uint8_t*)pvPortMalloc(__capacity);
+        if (__buf == nullptr) {
             __capacity = 0;
-            return;
-        } else {
-            __init_success = true;
-            __capacity = wantedSize;
         }
     }
-
-    ShareMem(uint8_t* shared_mem, size_t wantedSize) : ShareMem() {
-        __shared_mem = shared_mem;
-        __init_success = true;
-        __capacity = wantedSize;
+    TxSlotRing(const TxSlotRing&) = delete;
+    ~TxSlotRing() { vPortFree(__buf); }
+
+    /**
+     * @brief 生产者：数据入队，单个槽最多占用一半容量，保证空队列总能放下
+     * @param data 数据
+     * @param len 数据长度
+     * @param wait 缓冲区满时等待时间
+     * @return 成功返回true，数据过长或超时返回false
+     */
+    bool push(const uint8_t* data, size_t len,
+              TickType_t wait = portMAX_DELAY) {
+        size_t need = HDR_SIZE + __align(len);
+        if (data == nullptr || len == 0 || need > __capacity / 2) {
+            return false;
+        }
+        TickType_t start = xTaskGetTickCount();
+        if (!__mutex.take(wait)) {
+            return false;
+        }
+        size_t head = __head.load(std::memory_order_relaxed);
+        size_t pos;
+        while (!__reserve(head, need, pos)) {
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            if (elapsed >= wait || !__space_sem.take(wait - elapsed)) {
+                __mutex.give();
+                return false;
+            }
+        }
+        if (pos != head) {
+            // 尾部空间不足，写回绕标记
+            if (__capacity - head >= HDR_SIZE) {
+                __write_hdr(head, WRAP);
+            }
+        }
+        __write_hdr(pos, (uint32_t)len);
+        memcpy(__buf + pos + HDR_SIZE, data, len);
+        __head.store((pos + need) % __capacity, std::memory_order_release);
+        __mutex.give();
+        __data_sem.give();
+        return true;
     }
 
-    ShareMem(const ShareMem&) = delete;
-    ~ShareMem() { vPortFree(__shared_mem); }
-
-    // 申请共享内存的写访问权限，防止数据在发送前被修改
-    bool get_write_access(TickType_t wait = portMAX_DELAY) {
-        return __write_access.lock(wait);
+    /**
+     * @brief 消费者：等待数据入队
+     * @return 有数据返回true，超时返回false
+     */
+    bool wait(TickType_t wait = portMAX_DELAY) {
+        if (!empty()) {
+            return true;
+        }
+        return __data_sem.take(wait) && !empty();
     }
 
-    // 释放共享内存的写访问权限，等待数据转发完成后在释放写访问权限
-    void release_write_access() { __write_access.unlock(); }
-
-    bool write(const uint8_t* data, size_t size,
-               TickType_t wait = portMAX_DELAY) {
-        __size = 0;
-        if (!__init_success) {
+    /**
+     * @brief 消费者：取队首的槽，数据在pop()之前有效
+     * @return 有数据返回true
+     */
+    bool peek(const uint8_t*& data, size_t& len) {
+        size_t tail = __tail.load(std::memory_order_relaxed);
+        if (tail == __head.load(std::memory_order_acquire)) {
             return false;
         }
-        if (data == nullptr) {
-            return false;
-        }
-        if (size > __capacity) {
-            return false;
+        uint32_t hdr = __read_hdr(tail);
+        if (hdr == WRAP) {
+            tail = 0;
+            __tail.store(0, std::memory_order_release);
+            if (tail == __head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            hdr = __read_hdr(0);
         }
+        data = __buf + tail + HDR_SIZE;
+        len = hdr;
+        return true;
+    }
 
-        // 当前无写访问权限
-        if (!__write_access.lock()) {
+    /**
+     * @brief 消费者：从游标处取下一个槽但不释放，用于发出后需等待对端确认
+     *        才能释放的场合。游标之前的槽仍按顺序用pop()释放
+     * @param cursor 游标，初始为begin()，返回后指向下一个槽
+     * @return 有数据返回true
+     */
+    bool peek_next(size_t& cursor, const uint8_t*& data, size_t& len) {
+        if (cursor == __head.load(std::memory_order_acquire)) {
             return false;
         }
-
-        // 资源上锁，避免资源竞争
-        __lock.lock(wait);
-        __size = size;
-        std::copy(data, data + size, __shared_mem);
-        __lock.unlock();
+        uint32_t hdr = __read_hdr(cursor);
+        if (hdr == WRAP) {
+            cursor = 0;
+            if (cursor == __head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            hdr = __read_hdr(0);
+        }
+        data = __buf + cursor + HDR_SIZE;
+        len = hdr;
+        cursor = (cursor + HDR_SIZE + __align(hdr)) % __capacity;
         return true;
     }
 
-    bool lock(TickType_t wait = portMAX_DELAY) {
-        if (!__init_success) {
-            return false;
+    /**
+     * @brief 消费者：队首位置，作为peek_next()的初始游标
+     */
+    size_t begin() { return __tail.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 消费者：释放队首的槽
+     */
+    void pop() {
+        size_t tail = __tail.load(std::memory_order_relaxed);
+        uint32_t hdr = __read_hdr(tail);
+        if (hdr == WRAP) {
+            // 未经peek()直接释放时，队首可能停在回绕标记上
+            tail = 0;
+            hdr = __read_hdr(0);
         }
-        return __lock.lock(wait);
+        __tail.store((tail + HDR_SIZE + __align(hdr)) % __capacity,
+                     std::memory_order_release);
+        __space_sem.give();
+    }
+
+    bool empty() {
+        return __tail.load(std::memory_order_relaxed) ==
+               __head.load(std::memory_order_acquire);
     }
-    void unlock() { __lock.unlock(); }
-    uint8_t* get() { return __shared_mem; }
-    size_t size() { return __size; }
     size_t capacity() { return __capacity; }
 
    private:
+    static constexpr size_t HDR_SIZE = 4;
+    static constexpr uint32_t WRAP = 0xFFFFFFFF;
+
     Mutex __mutex;
-    Lock __lock;
-    Mutex __write_mtx;
-    Lock __write_access;
-    // BinarySemaphore __write_access;
-    size_t __size;
+    BinarySemaphore __data_sem;
+    BinarySemaphore __space_sem;
+    uint8_t* __buf;
     size_t __capacity;
-    bool __init_success;
-    uint8_t* __shared_mem;
+    // head只由持有互斥锁的生产者推进，tail只由消费者推进
+    std::atomic<size_t> __head{0};
+    std::atomic<size_t> __tail{0};
 
-   public:
-};
+    static size_t __align(size_t len) {
+        return (len + HDR_SIZE - 1) & ~(HDR_SIZE - 1);
+    }
 
-// 配置指令-------------------------------------------------
-struct CfgCmd {
-    uint8_t id[4];
-    uint16_t cond;    // 导通检测线数
-    uint16_t Z;       // 阻抗检测线数
+    // 尾部剩余不足一个长度字段时消费者直接回绕，等同于回绕标记
+    uint32_t __read_hdr(size_t pos) {
+        if (__capacity - pos < HDR_SIZE) {
+            return WRAP;
+        }
+        uint32_t hdr;
+        memcpy(&hdr, __buf + pos, HDR_SIZE);
+        return hdr;
+    }
 
-    bool clip_exist;      // 是否存在卡丁信息
-    uint8_t clip_mode;    // 卡丁模式
-    uint16_t clip_pin;    // 卡丁初始化信息
+    void __write_hdr(size_t pos, uint32_t hdr) {
+        memcpy(__buf + pos, &hdr, HDR_SIZE);
+    }
 
-    uint16_t totalHarnessNum;
-    uint16_t startHarnessNum;
-    uint16_t slave_dev_num;
-    bool is_last_dev;
+    /**
+     * @brief 查找能连续放下need字节的位置，始终保留至少一个字节的空隙以区分空和满
+     * @return 空间足够返回true，pos为写入位置
+     */
+    bool __reserve(size_t head, size_t need, size_t& pos) {
+        size_t tail = __tail.load(std::memory_order_acquire);
+        if (head >= tail) {
+            if (__capacity - head > need ||
+                (__capacity - head == need && tail != 0)) {
+                pos = head;
+                return true;
+            }
+            // 回绕到开头
+            if (tail > need) {
+                pos = 0;
+                return true;
+            }
+            return false;
+        }
+        if (tail - head > need) {
+            pos = head;
+            return true;
+        }
+        return false;
+    }
 };
 
-// 模式指令-------------------------------------------------
-enum SysMode : uint8_t {
-    CONDUCTION_TEST = 0,
-    IMPEDANCE_TEST,
-    CLIP_TEST
-
-};
-struct ModeCmd {
-    SysMode mode;
+// 数据报缓冲池-------------------------------------------------
+struct PCdatagram {
+    uint16_t len;
+    uint8_t data[PCdataTransferMsg_RX_DATAGRAM_SIZE];
 };
 
-// 复位指令-------------------------------------------------
-enum LockSta : uint8_t {
-    UNLOCKED = 0,
-    LOCKED,
-};
-struct ResetCmd {
-    uint8_t id[4];
-    uint16_t clip;
-    LockSta lock;
-};
+/**
+ * @brief 固定大小的数据报缓冲池
+ * @note 接收方申请空闲缓冲区，收满一个数据报后按指针投递给处理方，
+ *       处理方用完后归还，整个过程不拷贝数据
+ */
+template <size_t N>
+class DatagramPool {
+   public:
+    DatagramPool() : free_queue("dgram_free"), ready_queue("dgram_ready") {
+        for (auto& dgram : pool) {
+            free_queue.add(&dgram, 0);
+        }
+        Diag::watch_queue(ready_queue, "pc_rx");
+    }
+    DatagramPool(const DatagramPool&) = delete;
 
-// 控制指令-------------------------------------------------
-enum CtrlType : uint8_t {
-    DEV_DISABLE = 0,
-    DEV_ENABLE,
-};
-struct CtrlCmd {
-    CtrlType ctrl;
-};
+    // 申请空闲缓冲区，超时返回nullptr
+    PCdatagram* alloc(TickType_t wait = portMAX_DELAY) {
+        PCdatagram* dgram = nullptr;
+        return free_queue.pop(dgram, wait) ? dgram : nullptr;
+    }
 
-// 查询指令-------------------------------------------------
-struct QueryCmd {
-    uint8_t id[4];
-    uint8_t clip;
-};
+    // 归还缓冲区
+    void free(PCdatagram* dgram) { free_queue.add(dgram, 0); }
 
-// 状态回复-------------------------------------------------
-enum StatusReply : uint8_t {
-    STATUS_OK = 0,
-    STATUS_ERROR,
+    // 投递收到的数据报
+    void post(PCdatagram* dgram) { ready_queue.add(dgram, 0); }
+
+    // 取出收到的数据报，超时返回nullptr
+    PCdatagram* take(TickType_t wait = portMAX_DELAY) {
+        PCdatagram* dgram = nullptr;
+        return ready_queue.pop(dgram, wait) ? dgram : nullptr;
+    }
+
+   private:
+    PCdatagram pool[N];
+    Queue<PCdatagram*, N> free_queue;
+    Queue<PCdatagram*, N> ready_queue;
 };
 
-// 转发数据-------------------------------------------------
-enum CmdType : uint8_t {
-    DEV_CONF = 0,
-    DEV_MODE,
-    DEV_RESET,
-    DEV_CTRL,
-    DEV_QUERY,
+// 结果流-------------------------------------------------
+/**
+ * @brief 带序号的结果流，在UDP上提供选择性重传
+ * @note 每个结果分配递增序号并包装为RESULT_STREAM_MSG送入发送环形缓冲区，
+ *       同时保留在历史环中。上位机按序号发现缺口后发送NACK，历史中仍保留
+ *       的结果以重传标志再次发出，已淘汰的序号在应答中列出。历史环同时受
+ *       条数和总字节数限制，超出时淘汰最旧的结果
+ */
+class ResultStream {
+   public:
+    explicit ResultStream(TxSlotRing& ring)
+        : __mutex("result_stream"), __ring(ring) {}
+    ResultStream(const ResultStream&) = delete;
+
+    /**
+     * @brief 发布一个结果，分配序号、保存到历史并入队发送
+     * @param frame Slave2Backend完整帧
+     * @param wait 发送缓冲区满时等待时间
+     * @return 入队成功返回true；失败时结果仍保留在历史中，可由NACK取回
+     */
+    bool publish(const PoolVector<uint8_t>& frame,
+                 TickType_t wait = portMAX_DELAY) {
+        __mutex.take();
+        uint32_t seq = __next_seq++;
+        __evict(frame.size());
+        if (frame.size() <= ResultStream_HISTORY_BYTES) {
+            Entry& e = __history[seq % ResultStream_HISTORY_NUM];
+            e.seq = seq;
+            e.frame = frame;
+            __bytes += frame.size();
+        } else {
+            // 超过历史容量的结果不保留，丢失后无法重传
+            __first_seq = __next_seq;
+        }
+        bool ret = __send(seq, frame, 0, wait);
+        __mutex.give();
+        return ret;
+    }
+
+    /**
+     * @brief 重传历史中保留的结果
+     * @param seqs 上位机缺失的序号
+     * @param lost 输出已淘汰、无法重传的序号
+     * @param wait 发送缓冲区满时等待时间
+     */
+    void retransmit(const std::vector<uint32_t>& seqs,
+                    std::vector<uint32_t>& lost,
+                    TickType_t wait = portMAX_DELAY) {
+        __mutex.take();
+        lost.clear();
+        for (const auto& seq : seqs) {
+            if (!__contains(seq)) {
+                lost.push_back(seq);
+                continue;
+            }
+            const Entry& e = __history[seq % ResultStream_HISTORY_NUM];
+            if (!__send(seq, e.frame,
+                        Master2Backend::ResultStreamMsg::FLAG_RETRANSMIT,
+                        wait)) {
+                // 发送缓冲区满，剩余序号留给上位机下次请求
+                break;
+            }
+            __retransmit_cnt++;
+        }
+        __mutex.give();
+    }
+
+    /**
+     * @brief 下一个将要分配的序号
+     */
+    uint32_t next_seq() {
+        __mutex.take();
+        uint32_t seq = __next_seq;
+        __mutex.give();
+        return seq;
+    }
+
+    /**
+     * @brief 累计重传次数
+     */
+    uint32_t retransmit_count() const { return __retransmit_cnt; }
+
+   private:
+    struct Entry {
+        uint32_t seq = 0;
+        PoolVector<uint8_t> frame;
+    };
+
+    Mutex __mutex;
+    TxSlotRing& __ring;
+    Entry __history[ResultStream_HISTORY_NUM];
+    uint32_t __next_seq = 0;
+    uint32_t __first_seq = 0;    // 历史中最旧的序号
+    size_t __bytes = 0;          // 历史占用字节数
+    uint32_t __retransmit_cnt = 0;
+
+    Master2Backend::ResultStreamMsg __msg;
+    PoolVector<uint8_t> __out;
+
+    bool __contains(uint32_t seq) const {
+        // 序号回绕时按差值比较
+        return (uint32_t)(seq - __first_seq) <
+               (uint32_t)(__next_seq - __first_seq);
+    }
+
+    /**
+     * @brief 为新结果腾出一个历史槽和len字节
+     * @note 调用前__next_seq已加1，新结果序号为__next_seq - 1
+     */
+    void __evict(size_t len) {
+        while (__first_seq != __next_seq - 1 &&
+               ((uint32_t)(__next_seq - __first_seq) >
+                    ResultStream_HISTORY_NUM ||
+                __bytes + len > ResultStream_HISTORY_BYTES)) {
+            Entry& e = __history[__first_seq % ResultStream_HISTORY_NUM];
+            __bytes -= e.frame.size();
+            PoolVector<uint8_t>().swap(e.frame);
+            __first_seq++;
+        }
+    }
+
+    bool __send(uint32_t seq, const PoolVector<uint8_t>& frame,
+                uint8_t flags, TickType_t wait) {
+        __msg.seq = seq;
+        __msg.flags = flags;
+        __msg.frame = frame;
+        auto packet = PacketPacker::master2BackendPack(__msg);
+        __out = FramePacker::pack(packet);
+        return __ring.push(__out.data(), __out.size(), wait);
+    }
 };
-struct DataForward {
-    CmdType type;
-    CfgCmd cfg_cmd;
-    ModeCmd mode_cmd;
-    ResetCmd rst_cmd;
-    CtrlCmd ctrl_cmd;
-    QueryCmd query_cmd;
+
+// 结果缓存-------------------------------------------------
+/**
+ * @brief 各从机最新结果缓存，上位机查询直接由缓存应答，不经过无线链路
+ * @note 从机管理任务配置时登记从机，每个检测周期读取后更新导通结果、设备
+ *       状态和链路统计；解析任务按从机ID和驱动引脚范围查询。导通结果按行
+ *       (驱动引脚)展开，每行为本从机的导通线数，取引脚范围即取一段连续的位
+ */
+class ResultCache {
+   public:
+    using SlaveResult = Master2Backend::QueryMsg::SlaveResult;
+
+    ResultCache() : __mutex("result_cache") {}
+    ResultCache(const ResultCache&) = delete;
+
+    /**
+     * @brief 重新配置时清空缓存
+     * @param total_num 总检测线数，即导通矩阵行数
+     */
+    void reset(uint16_t total_num) {
+        __mutex.take();
+        __num = 0;
+        __total_num = total_num;
+        __mutex.give();
+    }
+
+    /**
+     * @brief 登记从机，已登记的从机清空结果和统计
+     * @param cond_num 本从机导通线数，即导通矩阵列数
+     * @return 缓存已满返回false
+     */
+    bool add(uint32_t id, uint16_t cond_num) {
+        __mutex.take();
+        Entry* e = __find(id);
+        if (e == nullptr && __num < ResultCache_SLAVE_NUM) {
+            e = &__entry[__num++];
+        }
+        if (e != nullptr) {
+            e->id = id;
+            e->cond_num = cond_num;
+            e->cycle = 0;
+            e->status = 0;
+            e->ok_num = 0;
+            e->fail_num = 0;
+            e->retry_num = 0;
+            e->data.clear();
+        }
+        __mutex.give();
+        return e != nullptr;
+    }
+
+    /**
+     * @brief 开始新的检测周期
+     * @return 周期号，从1开始
+     */
+    uint32_t begin_cycle() {
+        __mutex.take();
+        uint32_t cycle = ++__cycle;
+        __mutex.give();
+        return cycle;
+    }
+
+    /**
+     * @brief 当前检测周期号，尚未开始检测时为0
+     */
+    uint32_t cycle() {
+        __mutex.take();
+        uint32_t cycle = __cycle;
+        __mutex.give();
+        return cycle;
+    }
+
+    /**
+     * @brief 读取成功，更新从机结果
+     * @param status 设备状态(DeviceStatus)
+     * @param data 导通结果
+     * @param retry 本次读取的重发次数
+     */
+    void update(uint32_t id, uint16_t status,
+                const PoolVector<uint8_t>& data, uint8_t retry) {
+        __mutex.take();
+        Entry* e = __find(id);
+        if (e != nullptr) {
+            e->cycle = __cycle;
+            e->tick = xTaskGetTickCount();
+            e->status = status;
+            e->data = data;    // 长度不变时复用已有内存
+            __inc(e->ok_num, 1);
+            __inc(e->retry_num, retry);
+        }
+        __mutex.give();
+    }
+
+    /**
+     * @brief 读取失败，保留上次结果，只更新链路统计
+     */
+    void fail(uint32_t id, uint8_t retry) {
+        __mutex.take();
+        Entry* e = __find(id);
+        if (e != nullptr) {
+            __inc(e->fail_num, 1);
+            __inc(e->retry_num, retry);
+        }
+        __mutex.give();
+    }
+
+    /**
+     * @brief 查询缓存的结果
+     * @param ids 从机ID，为空时查询全部从机
+     * @param pin_start 起始驱动引脚
+     * @param pin_num 驱动引脚数，0为全部
+     * @param max_size 输出记录的总字节数上限，超出的从机只计入匹配数
+     * @param out 输出，复用已有元素的内存
+     * @param with_data 是否输出导通结果
+     * @return 匹配的从机数
+     */
+    uint8_t query(const std::vector<uint32_t>& ids, uint16_t pin_start,
+                  uint16_t pin_num, size_t max_size,
+                  std::vector<SlaveResult>& out, bool with_data = true) {
+        __mutex.take();
+        TickType_t now = xTaskGetTickCount();
+        uint8_t match = 0;
+        size_t num = 0;
+        size_t size = 0;
+        for (uint8_t i = 0; i < __num; i++) {
+            const Entry& e = __entry[i];
+            if (!ids.empty() &&
+                std::find(ids.begin(), ids.end(), e.id) == ids.end()) {
+                continue;
+            }
+            match++;
+
+            // 驱动引脚范围截取到已有结果的行数内
+            uint16_t rows = 0;
+            if (e.cycle != 0 && e.cond_num != 0) {
+                rows = std::min<size_t>(__total_num,
+                                        e.data.size() * 8 / e.cond_num);
+            }
+            uint16_t first = std::min(pin_start, rows);
+            uint16_t last = rows;
+            if (pin_num != 0 && pin_num < rows - first) {
+                last = first + pin_num;
+            }
+            size_t bits = with_data ? (size_t)(last - first) * e.cond_num : 0;
+            size_t need =
+                Master2Backend::QueryMsg::RECORD_SIZE + (bits + 7) / 8;
+            if (size + need > max_size) {
+                continue;
+            }
+            size += need;
+
+            if (out.size() <= num) {
+                out.emplace_back();
+            }
+            SlaveResult& r = out[num++];
+            r.id = e.id;
+            r.cycle = e.cycle;
+            r.age = e.cycle ? (now - e.tick) * portTICK_PERIOD_MS : 0;
+            r.status = e.status;
+            r.okNum = e.ok_num;
+            r.failNum = e.fail_num;
+            r.retryNum = e.retry_num;
+            r.condNum = e.cond_num;
+            r.pinStart = first;
+            r.pinNum = with_data ? last - first : 0;
+            __copy_bits(e.data, (size_t)first * e.cond_num, bits, r.data);
+        }
+        __mutex.give();
+        out.resize(num);
+        return match;
+    }
+
+   private:
+    struct Entry {
+        uint32_t id = 0;
+        uint16_t cond_num = 0;
+        uint32_t cycle = 0;    // 结果所属检测周期，0为尚无结果
+        TickType_t tick = 0;
+        uint16_t status = 0;
+        uint16_t ok_num = 0;
+        uint16_t fail_num = 0;
+        uint16_t retry_num = 0;
+        PoolVector<uint8_t> data;
+    };
+
+    Mutex __mutex;
+    Entry __entry[ResultCache_SLAVE_NUM];
+    uint8_t __num = 0;
+    uint16_t __total_num = 0;
+    uint32_t __cycle = 0;
+
+    Entry* __find(uint32_t id) {
+        for (uint8_t i = 0; i < __num; i++) {
+            if (__entry[i].id == id) {
+                return &__entry[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // 统计计数饱和，不回绕
+    static void __inc(uint16_t& cnt, uint16_t n) {
+        cnt = (cnt > 0xFFFF - n) ? 0xFFFF : cnt + n;
+    }
+
+    // 取src中从start位开始的num位(高位在前)，重新从out的第0位开始存放
+    static void __copy_bits(const PoolVector<uint8_t>& src, size_t start,
+                            size_t num, PoolVector<uint8_t>& out) {
+        out.resize((num + 7) / 8);
+        if (num == 0) {
+            return;
+        }
+        const uint8_t* p = src.data() + start / 8;
+        size_t shift = start % 8;
+        if (shift == 0) {
+            memcpy(out.data(), p, out.size());
+        } else {
+            size_t remain = src.size() - start / 8;
+            for (size_t i = 0; i < out.size(); i++) {
+                uint8_t lo = (i + 1 < remain) ? p[i + 1] >> (8 - shift) : 0;
+                out[i] = (uint8_t)(p[i] << shift) | lo;
+            }
+        }
+        // 清除最后一个字节中不属于范围的位
+        if (num % 8) {
+            out.back() &= (uint8_t)(0xFF << (8 - num % 8));
+        }
+    }
 };
 
 // 上位机数据传输任务 <-> json解析任务
 // 消息结构---------------------------------------
 class PCdataTransferMsg {
    public:
-    PCdataTransferMsg()
-        : rx_done_sem("rx_done_sem"),
-          tx_request_sem("tx_request_sem"),
-          tx_done_sem("tx_done_sem"),
-          tx_share_mem(PCdataTransfer_TX_BUFFER_SIZE) {}
-    Queue<uint8_t, PCdataTransferMsg_DATA_QUEUE_SIZE> rx_data_queue;
-    BinarySemaphore rx_done_sem;
-    BinarySemaphore tx_request_sem;
-    BinarySemaphore tx_done_sem;
-    ShareMem tx_share_mem;
+    PCdataTransferMsg() : tx_ring(PCdataTransfer_TX_RING_SIZE) {}
+    DatagramPool<PCdataTransferMsg_RX_DATAGRAM_NUM> rx_pool;
+    TxSlotRing tx_ring;
+};
+
+// 指令表-------------------------------------------------
+/**
+ * @brief 在途的上位机指令表
+ * @note 每条上位机指令占用一个槽位，拆分为若干步(如每个从机一条配置)，槽位号
+ *       经队列交给从机管理任务逐步执行，解析任务提交后即可处理下一条指令。
+ *       应答帧在提交时预先打包，全部步骤完成后回填状态字节送入发送环形缓冲区；
+ *       不带应答帧的指令由提交者调用wait()同步等待结果。
+ *       紧急指令进入单独的队列，从机管理任务在两步之间优先执行；抢占指令
+ *       另外要求从机管理任务中止正在进行的检测周期
+ */
+class CmdTable {
+   public:
+    static constexpr uint8_t NONE = 0xFF;
+
+    enum Priority : uint8_t {
+        NORMAL = 0,    // 按提交顺序执行
+        URGENT,        // 越过排队中的普通指令，在两步之间执行
+        PREEMPT,       // 同URGENT，并中止正在进行的检测周期
+    };
+
+    explicit CmdTable(TxSlotRing& ring)
+        : __mutex("cmd_table"),
+          __ring(ring),
+          __queue("cmd_queue"),
+          __urgent_queue("cmd_urgent_queue") {
+        Diag::watch_queue(__queue, "cmd");
+        Diag::watch_queue(__urgent_queue, "cmd_urg");
+    }
+    CmdTable(const CmdTable&) = delete;
+
+    /**
+     * @brief 提交一条指令
+     * @param steps 执行步骤，至少一步
+     * @param rsp 预先打包的应答帧，为空时由提交者调用wait()取结果
+     * @param status_pos 应答帧中状态字节的偏移，0成功1失败
+     * @return 槽位号，指令表已满返回NONE
+     */
+    uint8_t submit(std::vector<DataForward>&& steps,
+                   PoolVector<uint8_t>&& rsp, size_t status_pos,
+                   Priority prio = NORMAL) {
+        if (steps.empty() || (!rsp.empty() && status_pos >= rsp.size())) {
+            return NONE;
+        }
+        __mutex.take();
+        uint8_t slot = NONE;
+        for (uint8_t i = 0; i < PCmanagerMsg_CMD_SLOT_NUM; i++) {
+            if (!__entry[i].used) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == NONE) {
+            __mutex.give();
+            return NONE;
+        }
+        Entry& e = __entry[slot];
+        e.used = true;
+        e.ok = true;
+        e.abandoned = false;
+        e.prio = prio;
+        e.pending = steps.size();
+        e.status_pos = status_pos;
+        e.steps = std::move(steps);
+        e.rsp = std::move(rsp);
+        __done.clear(__bit(slot));
+        __mutex.give();
+
+        // 队列长度等于槽位数，不会满
+        if (prio == NORMAL) {
+            __queue.add(slot, 0);
+        } else {
+            if (prio == PREEMPT) {
+                __preempt++;
+            }
+            __urgent_queue.add(slot, 0);
+        }
+        return slot;
+    }
+
+    /**
+     * @brief 同步等待不带应答帧的指令完成并释放槽位
+     * @return 全部步骤成功返回true，超时返回false
+     */
+    bool wait(uint8_t slot, TickType_t ticks) {
+        __done.wait(__bit(slot), true, true, ticks);
+        __mutex.take();
+        Entry& e = __entry[slot];
+        bool ok = false;
+        if (e.pending == 0) {
+            ok = e.ok;
+            __free(e);
+        } else {
+            // 超时，由最后一步完成时释放
+            e.abandoned = true;
+        }
+        __mutex.give();
+        return ok;
+    }
+
+    /**
+     * @brief 从机管理任务：取下一条紧急指令
+     */
+    bool pop_urgent(uint8_t& slot) {
+        if (!__urgent_queue.pop(slot, 0)) {
+            return false;
+        }
+        __mutex.take();
+        if (__entry[slot].prio == PREEMPT) {
+            __preempt--;
+        }
+        __mutex.give();
+        return true;
+    }
+
+    /**
+     * @brief 从机管理任务：取下一条普通指令
+     */
+    bool pop(uint8_t& slot) { return __queue.pop(slot, 0); }
+
+    /**
+     * @brief 是否有等待执行的抢占指令，检测周期中轮询
+     */
+    bool preempt_pending() const { return __preempt > 0; }
+
+    /**
+     * @brief 指令的步骤数，在最后一步done()之前有效
+     */
+    uint16_t step_num(uint8_t slot) const {
+        return __entry[slot].steps.size();
+    }
+
+    /**
+     * @brief 指令的第index步，在该步done()之前有效
+     */
+    const DataForward& step(uint8_t slot, uint16_t index) const {
+        return __entry[slot].steps[index];
+    }
+
+    /**
+     * @brief 从机管理任务：一步执行完成，最后一步完成时发出应答
+     */
+    void done(uint8_t slot, bool ok) {
+        __mutex.take();
+        Entry& e = __entry[slot];
+        e.ok = e.ok && ok;
+        if (--e.pending > 0) {
+            __mutex.give();
+            return;
+        }
+        if (e.rsp.empty()) {
+            if (e.abandoned) {
+                __free(e);
+            } else {
+                __done.set(__bit(slot));
+            }
+            __mutex.give();
+            return;
+        }
+        PoolVector<uint8_t> rsp;
+        rsp.swap(e.rsp);
+        rsp[e.status_pos] = e.ok ? 0 : 1;
+        __free(e);
+        __mutex.give();
+
+        if (!__ring.push(rsp.data(), rsp.size(), PCinterface_RSP_TIMEOUT)) {
+            LOG_E("CmdTable", "respond to PC failed: tx_ring.push failed");
+        }
+    }
+
+   private:
+    static_assert(PCmanagerMsg_CMD_SLOT_NUM <= 24,
+                  "one event bit per slot, at most 24");
+
+    struct Entry {
+        bool used = false;
+        bool ok = false;
+        bool abandoned = false;
+        Priority prio = NORMAL;
+        uint16_t pending = 0;
+        size_t status_pos = 0;
+        std::vector<DataForward> steps;
+        PoolVector<uint8_t> rsp;
+    };
+
+    Mutex __mutex;
+    TxSlotRing& __ring;
+    Entry __entry[PCmanagerMsg_CMD_SLOT_NUM];
+    Queue<uint8_t, PCmanagerMsg_CMD_SLOT_NUM> __queue;
+    Queue<uint8_t, PCmanagerMsg_CMD_SLOT_NUM> __urgent_queue;
+    EventGroup __done;
+    std::atomic<uint8_t> __preempt{0};
+
+    static EventBits_t __bit(uint8_t slot) { return (EventBits_t)1 << slot; }
+
+    // 释放内存，避免大指令长期占用堆
+    void __free(Entry& e) {
+        e.used = false;
+        std::vector<DataForward>().swap(e.steps);
+        PoolVector<uint8_t>().swap(e.rsp);
+    }
 };
 
 // json解析任务 <-> 从机管理任务
 // 消息结构---------------------------------------------
-#define FORWARD_SUCCESS_EVENT (EventBits_t)((EventBits_t)1 << 0)
-#define CONFIG_SUCCESS_EVENT  (EventBits_t)((EventBits_t)1 << 1)
-#define MODE_SUCCESS_EVENT    (EventBits_t)((EventBits_t)1 << 2)
-#define RESET_SUCCESS_EVENT   (EventBits_t)((EventBits_t)1 << 3)
-#define CTRL_SUCCESS_EVENT    (EventBits_t)((EventBits_t)1 << 4)
-#define QUERY_SUCCESS_EVENT   (EventBits_t)((EventBits_t)1 << 5)
 class PCmanagerMsg {
    public:
-    PCmanagerMsg(ShareMem& __upload_data, BinarySemaphore& __upload_request_sem,
-                 BinarySemaphore& __upload_done_sem)
-        : data_forward_queue("data_forward_queue"),
-          upload_data(__upload_data),
-          upload_request_sem(__upload_request_sem),
-          upload_done_sem(__upload_done_sem) {}
-    Queue<DataForward, PCmanagerMsg_FORWARD_QUEUE_SIZE> data_forward_queue;
-    EventGroup event;
-    ShareMem& upload_data;
-    BinarySemaphore& upload_request_sem;
-    BinarySemaphore& upload_done_sem;
+    PCmanagerMsg(TxSlotRing& __upload_ring)
+        : cmd_table(__upload_ring), result_stream(__upload_ring) {}
+    CmdTable cmd_table;
+    ResultStream result_stream;
+    ResultCache result_cache;
 };
 
 // 从机数据传输任务 <-> 从机管理任务
@@ -261,7 +897,10 @@ class ManagerDataTransferMsg {
           tx_done_sem("tx_done_sem"),
 
           tx_data_queue("manager_tx_data_queue"),
-          rx_data_queue("manager_rx_data_queue") {}
+          rx_data_queue("manager_rx_data_queue") {
+        Diag::watch_queue(tx_data_queue, "uwb_tx");
+        Diag::watch_queue(rx_data_queue, "uwb_rx");
+    }
 
    public:
     BinarySemaphore rx_done_sem;
@@ -270,5 +909,8 @@ class ManagerDataTransferMsg {
 
     Queue<uint8_t, ManagerDataTransferMsg_RXDATA_QUEUE_SIZE> tx_data_queue;
     Queue<uint8_t, ManagerDataTransferMsg_RXDATA_QUEUE_SIZE> rx_data_queue;
+
+    // 本帧需要立即发送，否则与后续帧聚合，到期后发送
+    volatile bool tx_flush = true;
 };
 #endif
\ No newline at end of file
@@ -3,12 +3,15 @@
 #include <cstdio>
 
 #include "FreeRTOS.h"
+#include "backend_bench_task.hpp"
 #include "bsp_led.hpp"
 #include "bsp_spi.hpp"
+#include "bsp_tcm.hpp"
 #include "pc_interface.hpp"
 #include "protocol.hpp"
 #include "slave_manager.hpp"
 #include "task.h"
+#include "uwb_bench_task.hpp"
 
 #ifdef MASTER
 
@@ -26,10 +29,12 @@ uint8_t __ProcessBase::expected_rsp_msg_id;    // 期望从机回复的消息ID
 
 static void Master_Task(void* pvParameters) {
     static constexpr const char TAG[] = "BOOT";
+    // 任务和消息对象在本任务中构造后一直存在，定义为静态对象放在.bss，
+    // STATIC_ALLOCATION构建中其任务栈和队列存储不占用本任务的栈
     LED led(GPIO::Port::A, GPIO::Pin::PIN_0);
-    LogTask logTask(Log);
+    static LogTask logTask(Log);
     logTask.give();
-    Log.d(TAG, "LogTask initialized");
+    LOG_D(TAG, "LogTask initialized");
 
     // Backend2Master::SlaveCfgMsg slave_cfg_msg;
     // Backend2Master::SlaveCfgMsg::SlaveConfig cfg;
@@ -49,64 +54,90 @@ static void Master_Task(void* pvParameters) {
     // slave_cfg_msg.slaveNum = 2;
     // auto msg = PacketPacker::backend2MasterPack(slave_cfg_msg);
     // std::vector<uint8_t> data = FramePacker::pack(msg);
-    // Log.r(data.data(), data.size());
+    // LOG_R(data.data(), data.size());
 
-    // Log.i("[Master_Task]: Mode packet:");
+    // LOG_I("[Master_Task]: Mode packet:");
     // Backend2Master::ModeCfgMsg mode_msg;
     // mode_msg.mode = 0x00;
     // msg = PacketPacker::backend2MasterPack(mode_msg);
     // data = FramePacker::pack(msg);
-    // Log.r(data.data(), data.size());
+    // LOG_R(data.data(), data.size());
 
-    // Log.i("[Master_Task]: Control start packet:");
+    // LOG_I("[Master_Task]: Control start packet:");
     // Backend2Master::CtrlMsg ctrl_msg;
     // ctrl_msg.runningStatus = 0x01;
     // msg = PacketPacker::backend2MasterPack(ctrl_msg);
     // data = FramePacker::pack(msg);
-    // Log.r(data.data(), data.size());
+    // LOG_R(data.data(), data.size());
 
-    // Log.i("[Master_Task]: Control stop packet:");
+    // LOG_I("[Master_Task]: Control stop packet:");
     // ctrl_msg.runningStatus = 0x00;
     // msg = PacketPacker::backend2MasterPack(ctrl_msg);
     // data = FramePacker::pack(msg);
-    // Log.r(data.data(), data.size());
+    // LOG_R(data.data(), data.size());
 
-    Log.d(TAG,"Slave Firmware %s, Build: %s %s", FIRMWARE_VERSION, __DATE__, __TIME__);
+    LOG_D(TAG,"Slave Firmware %s, Build: %s %s", FIRMWARE_VERSION, __DATE__, __TIME__);
 
-    EthDevice ethDevice;
+    static EthDevice ethDevice;
     ethDevice.init();
-    Log.d("BOOT", "ethDevice initialized");
+    LOG_D("BOOT", "ethDevice initialized");
 
     // 上位机数据传输任务 json解析任务 初始化
-    PCdataTransferMsg pc_data_transfer_msg;
-    PCmanagerMsg pc_manger_msg(pc_data_transfer_msg.tx_share_mem,
-                               pc_data_transfer_msg.tx_request_sem,
-                               pc_data_transfer_msg.tx_done_sem);
+    static PCdataTransferMsg pc_data_transfer_msg;
+    static PCmanagerMsg pc_manger_msg(pc_data_transfer_msg.tx_ring);
 
-    PCinterface pc_interface(pc_manger_msg, pc_data_transfer_msg);
-    PCdataTransfer pc_data_transfer(pc_data_transfer_msg);
+    static PCinterface pc_interface(pc_manger_msg, pc_data_transfer_msg);
+    static PCdataTransfer pc_data_transfer(pc_data_transfer_msg);
 
+#if defined(BACKEND_TCP_BENCH)
+    // 上位机TCP吞吐量测试，持续产生结果流帧，不运行从机管理任务
+    static BackendBenchTask backend_bench_task(pc_data_transfer_msg.tx_ring);
+
+    pc_interface.give();
+    pc_data_transfer.give();
+    backend_bench_task.give();
+#elif defined(UWB_BENCHMARK)
+    // UWB链路基准测试，独占UWB，不运行从机管理任务
+    static UwbBenchTask uwb_bench_task;
+
+    pc_interface.give();
+    pc_data_transfer.give();
+    uwb_bench_task.give();
+#else
     // 从机数据传输任务 从机管理任务 初始化
-    ManagerDataTransferMsg manager_transfer_msg;
-    SlaveManager slave_manager(pc_manger_msg, manager_transfer_msg);
-    ManagerDataTransfer manager_data_transfer(manager_transfer_msg);
+    static ManagerDataTransferMsg manager_transfer_msg;
+    static SlaveManager slave_manager(pc_manger_msg, manager_transfer_msg);
+    static ManagerDataTransfer manager_data_transfer(manager_transfer_msg);
 
     pc_interface.give();
     pc_data_transfer.give();
     slave_manager.give();
     manager_data_transfer.give();
+#endif
 
     DataForward tmp;
+#ifdef TCM_PLACEMENT
+    uint32_t dma_fallback = 0;
+#endif
     while (1) {
-        // Log.v("SYS", "heap minimum: %d", xPortGetMinimumEverFreeHeapSize());
+        // LOG_V("SYS", "heap minimum: %d", xPortGetMinimumEverFreeHeapSize());
         led.toggle();
         vTaskDelay(pdMS_TO_TICKS(2000));
+#ifdef TCM_PLACEMENT
+        // TCM中的缓冲区退回逐字节或拷贝发送时提示
+        uint32_t n = TcmHeap::stats().dma_fallback;
+        if (n != dma_fallback) {
+            LOG_W(TAG, "TCM buffers sent without DMA: %lu", (unsigned long)n);
+            dma_fallback = n;
+        }
+#endif
     }
 }
 
 int Master_Init(void) {
-    // 创建主节点任务
-    xTaskCreate(Master_Task, "MasterTask", 10 * 1024, NULL, 2, NULL);
+    // 创建主节点任务，STATIC_ALLOCATION构建中TCB和栈为静态存储
+    static TaskS<MasterTask_STACK_SIZE> master_task(
+        "MasterTask", Master_Task, static_cast<TaskPriority>(2));
     return 0;
 }
 namespace Master2Slave {
@@ -126,30 +157,30 @@ void CondCfgMsg::process() {
     __ProcessBase::rsp_parsed = true;
     if (__ProcessBase::expected_rsp_msg_id !=
         (uint8_t)(Slave2MasterMessageID::COND_CFG_MSG)) {
-        Log.e("CondCfgMsg", "msg_id not match");
+        LOG_E("CondCfgMsg", "msg_id not match");
         __ProcessBase::rsp_parsed = false;
         return;
     }
     if (CondCfgMsg::timeSlot != WriteCondInfoMsg::timeSlot) {
-        Log.e("CondCfgMsg", "timeSlot not match");
+        LOG_E("CondCfgMsg", "timeSlot not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (CondCfgMsg::interval != WriteCondInfoMsg::interval) {
-        Log.e("CondCfgMsg", "interval not match");
+        LOG_E("CondCfgMsg", "interval not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (CondCfgMsg::totalConductionNum !=
         WriteCondInfoMsg::totalConductionNum) {
-        Log.e("CondCfgMsg", "totalConductionNum not match");
+        LOG_E("CondCfgMsg", "totalConductionNum not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (CondCfgMsg::startConductionNum !=
         WriteCondInfoMsg::startConductionNum) {
-        Log.e("CondCfgMsg", "startConductionNum not match");
+        LOG_E("CondCfgMsg", "startConductionNum not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (CondCfgMsg::conductionNum != WriteCondInfoMsg::conductionNum) {
-        Log.e("CondCfgMsg", "conductionNum not match");
+        LOG_E("CondCfgMsg", "conductionNum not match");
         __ProcessBase::rsp_parsed = false;
     }
 }
@@ -157,20 +188,20 @@ void ClipCfgMsg::process() {
     __ProcessBase::rsp_parsed = true;
     if (__ProcessBase::expected_rsp_msg_id !=
         (uint8_t)(Slave2MasterMessageID::CLIP_CFG_MSG)) {
-        Log.e("ClipCfgMsg", " msg_id not match");
+        LOG_E("ClipCfgMsg", " msg_id not match");
         __ProcessBase::rsp_parsed = false;
         return;
     }
     if (ClipCfgMsg::mode != WriteClipInfoMsg::mode) {
-        Log.e("ClipCfgMsg", " mode not match");
+        LOG_E("ClipCfgMsg", " mode not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (ClipCfgMsg::clipPin != WriteClipInfoMsg::clipPin) {
-        Log.e("ClipCfgMsg", " clipPin not match");
+        LOG_E("ClipCfgMsg", " clipPin not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (ClipCfgMsg::interval != WriteClipInfoMsg::interval) {
-        Log.e("ClipCfgMsg", " clipNum not match");
+        LOG_E("ClipCfgMsg", " clipNum not match");
         __ProcessBase::rsp_parsed = false;
     }
 }
@@ -178,28 +209,36 @@ void ResCfgMsg::process() {
     __ProcessBase::rsp_parsed = true;
     if (__ProcessBase::expected_rsp_msg_id !=
         (uint8_t)(Slave2MasterMessageID::RES_CFG_MSG)) {
-        Log.e("ResCfgMsg", "msg_id not match");
+        LOG_E("ResCfgMsg", "msg_id not match");
         __ProcessBase::rsp_parsed = false;
         return;
     }
     if (ResCfgMsg::timeSlot != WriteResInfoMsg::timeSlot) {
-        Log.e("ResCfgMsg", "timeSlot not match");
+        LOG_E("ResCfgMsg", "timeSlot not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (ResCfgMsg::interval != WriteResInfoMsg::interval) {
-        Log.e("ResCfgMsg", "interval not match");
+        LOG_E("ResCfgMsg", "interval not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (ResCfgMsg::totalResistanceNum != WriteResInfoMsg::totalResistanceNum) {
-        Log.e("ResCfgMsg", "totalResistanceNum not match");
+        LOG_E("ResCfgMsg", "totalResistanceNum not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (ResCfgMsg::startResistanceNum != WriteResInfoMsg::startResistanceNum) {
-        Log.e("ResCfgMsg", "startResistanceNum not match");
+        LOG_E("ResCfgMsg", "startResistanceNum not match");
         __ProcessBase::rsp_parsed = false;
     }
     if (ResCfgMsg::resistanceNum != WriteResInfoMsg::resistanceNum) {
-        Log.e("ResCfgMsg", "resistanceNum not match");
+        LOG_E("ResCfgMsg", "resistanceNum not match");
+        __ProcessBase::rsp_parsed = false;
+    }
+}
+void RstMsg::process() {
+    __ProcessBase::rsp_parsed = true;
+    if (__ProcessBase::expected_rsp_msg_id !=
+        (uint8_t)(Slave2MasterMessageID::RST_MSG)) {
+        LOG_E("RstMsg", "msg_id not match");
         __ProcessBase::rsp_parsed = false;
     }
 }
@@ -211,11 +250,27 @@ void CondDataMsg::process() {
     __ProcessBase::rsp_parsed = true;
     if (__ProcessBase::expected_rsp_msg_id !=
         (uint8_t)(Slave2BackendMessageID::COND_DATA_MSG)) {
-        Log.e("CondDataMsg", "msg_id not match");
+        LOG_E("CondDataMsg", "msg_id not match");
         __ProcessBase::rsp_parsed = false;
         return;
     }
 }
+void ResDataMsg::process() {
+    __ProcessBase::rsp_parsed = true;
+    if (__ProcessBase::expected_rsp_msg_id !=
+        (uint8_t)(Slave2BackendMessageID::RES_DATA_MSG)) {
+        LOG_E("ResDataMsg", "msg_id not match");
+        __ProcessBase::rsp_parsed = false;
+    }
+}
+void ClipDataMsg::process() {
+    __ProcessBase::rsp_parsed = true;
+    if (__ProcessBase::expected_rsp_msg_id !=
+        (uint8_t)(Slave2BackendMessageID::CLIP_DATA_MSG)) {
+        LOG_E("ClipDataMsg", "msg_id not match");
+        __ProcessBase::rsp_parsed = false;
+    }
+}
 }    // namespace Slave2Backend
 
 #endif
\ No newline at end of file
@@ -9,24 +9,32 @@
 #include "QueueCPP.h"
 #include "TaskCPP.h"
 #include "bsp_log.hpp"
+#include "bsp_trace.hpp"
 #include "bsp_uart.hpp"
-#include "enet.h"
-#include "ethernetif.h"
 #include "json.hpp"
 #include "json_sorting.hpp"
+#include "master_cfg.hpp"
+#include "master_def.hpp"
+#include "netcfg.h"
+#include "pc_message.hpp"
+#ifdef HOST_SIM
+// 主机仿真构建以Linux套接字替代lwIP，只支持默认的UDP方式
+#include "host_net.hpp"
+#else
+#include "enet.h"
+#include "ethernetif.h"
 #include "lwip/api.h"
 #include "lwip/memp.h"
 #include "lwip/opt.h"
+#include "lwip/pbuf.h"
 #include "lwip/sockets.h"
 #include "lwip/sys.h"
 #include "lwip/tcp.h"
-#include "netcfg.h"
-#include "master_cfg.hpp"
-#include "master_def.hpp"
+#include "lwip/udp.h"
 #include "netconf.h"
-#include "pc_message.hpp"
 #include "tcpip.h"
 #include "udp_echo.h"
+#endif
 
 extern Logger Log;
 extern UasrtInfo& pc_com_info;
@@ -37,17 +45,30 @@ extern UasrtInfo& pc_com_info;
 #undef write
 
 // using json = nlohmann::json;
+// 上位机传输方式，默认UDP；CMake选项BACKEND_TCP定义BACKEND_TRANSFER_USE_TCP，
+// BACKEND_RAW_UDP定义BACKEND_TRANSFER_USE_RAW_UDP
+#if !defined(BACKEND_TRANSFER_USE_TCP) && !defined(BACKEND_TRANSFER_USE_COM) && \
+    !defined(BACKEND_TRANSFER_USE_RAW_UDP)
 #define BACKEND_TRANSFER_USE_UDP
-#define MAX_BUF_SIZE 100
+#endif
 
+/**
+ * @brief 上位机数据传输任务
+ * @note 接收：阻塞等待数据报，整包收入缓冲池后按指针交给json解析任务；
+ *       TCP方式下按帧分隔符从字节流中恢复帧后同样逐帧放入缓冲池；
+ *       原始UDP方式下在tcpip线程的udp_recv回调中直接放入缓冲池；
+ *       发送：由内部发送任务等待发送请求，收到后立即发出
+ */
 class PCdataTransfer : public TaskClassS<PCdataTransfer_STACK_SIZE> {
    public:
     PCdataTransfer(PCdataTransferMsg& msg)
         : TaskClassS<PCdataTransfer_STACK_SIZE>("PCdataTransfer",
                                                 TaskPrio_High),
-          __msg(msg) {}
+          __msg(msg),
+          __sender(*this) {}
     void task() override {
-        Log.i("PCdataTransfer_Task", "Boot");
+        LOG_I("PCdataTransfer_Task", "Boot");
+        Diag::set_subsystem(Diag::Subsystem::LWIP);
 
 #ifdef BACKEND_TRANSFER_USE_COM
         taskENTER_CRITICAL();
@@ -55,39 +76,42 @@ class PCdataTransfer : public TaskClassS<PCdataTransfer_STACK_SIZE> {
         Uart pc_com(pc_com_cfg);
         taskEXIT_CRITICAL();
 
-        uint8_t buffer[DMA_RX_BUFFER_SIZE];
-        std::vector<uint8_t> rx_data;
+        PoolVector<uint8_t> rx_data;
 
         for (;;) {
             // 等待 DMA 完成信号
             if (xSemaphoreTake(pc_com_info.dmaRxDoneSema, 0) == pdPASS) {
                 rx_data = pc_com.getReceivedData();
-                for (auto it : rx_data) {
-                    __msg.rx_data_queue.add(it);
+                PCdatagram* dgram = nullptr;
+                if (rx_data.size() > sizeof(dgram->data)) {
+                    // 截断的数据无法解析，整包丢弃
+                    LOG_E("COM", "rx data too long, drop %d bytes",
+                          rx_data.size());
+                } else if ((dgram = __msg.rx_pool.alloc(0)) == nullptr) {
+                    LOG_E("COM", "rx datagram pool empty, drop %d bytes",
+                          rx_data.size());
+                } else {
+                    dgram->len = rx_data.size();
+                    memcpy(dgram->data, rx_data.data(), dgram->len);
+                    __msg.rx_pool.post(dgram);
                 }
-                __msg.rx_done_sem.give();
             };
-            if (__msg.tx_request_sem.take(0)) {
-                __msg.tx_share_mem.lock();
-                const uint8_t* ptr = __msg.tx_share_mem.get();
-                size_t size = __msg.tx_share_mem.size();
-
+            const uint8_t* ptr;
+            size_t size;
+            while (__msg.tx_ring.peek(ptr, size)) {
                 pc_com.send(ptr, size);
-
-                __msg.tx_share_mem.unlock();
-                __msg.tx_done_sem.give();
+                __msg.tx_ring.pop();
             }
             TaskBase::delay(500);
         }
 #endif
 
 #ifdef BACKEND_TRANSFER_USE_UDP
-        int ret, recvnum, sockfd = -1;
+        int recvnum;
         int rmt_port = 8080;
         int bod_port = 8080;
-        struct sockaddr_in rmt_addr, bod_addr;
-        char buf[100];
-        u32_t len;
+        struct sockaddr_in bod_addr, from_addr;
+        socklen_t from_len;
         ip_addr_t ipaddr;
 
         IP4_ADDR(&ipaddr, IP_S_ADDR0, IP_S_ADDR1, IP_S_ADDR2, IP_S_ADDR3);
@@ -101,72 +125,446 @@ class PCdataTransfer : public TaskClassS<PCdataTransfer_STACK_SIZE> {
         bod_addr.sin_addr.s_addr = htons(INADDR_ANY);
 
         sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+        LOG_V("UDP", "rmt_port: %d", rmt_port);
+        LOG_V("UDP", "bod_port: %d", bod_port);
 
-        // 设置为非阻塞
-        int flags = fcntl(sockfd, F_GETFL, 0);
-        if (flags < 0) {
-            // 获取失败处理
+        if (sockfd < 0) {
+            vTaskDelete(nullptr);
+            return;
+        }
+
+        if (bind(sockfd, (struct sockaddr*)&bod_addr, sizeof(bod_addr)) < 0) {
             lwip_close(sockfd);
             vTaskDelete(nullptr);
             return;
         }
-        fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
-        // 打印所有UDP 信息
-        // Log.v("UDP", "UDP server start");
-        // Log.v("UDP", "rmt_addr: %d.%d.%d.%d",
-        // ip4_addr1_16(&rmt_addr.sin_addr),
-        //       ip4_addr2_16(&rmt_addr.sin_addr),
-        //       ip4_addr3_16(&rmt_addr.sin_addr),
-        //       ip4_addr4_16(&rmt_addr.sin_addr));
-        // Log.v("UDP", "bod_addr: %d.%d.%d.%d",
-        // ip4_addr1_16(&bod_addr.sin_addr),
-        //       ip4_addr2_16(&bod_addr.sin_addr),
-        //       ip4_addr3_16(&bod_addr.sin_addr),
-        //       ip4_addr4_16(&bod_addr.sin_addr));
-        Log.v("UDP", "rmt_port: %d", rmt_port);
-        Log.v("UDP", "bod_port: %d", bod_port);
+        __sender.give();
 
-        if (sockfd < 0) {
+        for (;;) {
+            // 缓冲池空说明解析任务处理不过来，等待归还后再收
+            PCdatagram* dgram = __msg.rx_pool.alloc();
+            from_len = sizeof(from_addr);
+            recvnum = recvfrom(sockfd, dgram->data, sizeof(dgram->data), 0,
+                               (struct sockaddr*)&from_addr, &from_len);
+            if (recvnum <= 0) {
+                __msg.rx_pool.free(dgram);
+                continue;
+            }
+            // 回复发往最近一次发来数据的地址
+            taskENTER_CRITICAL();
+            rmt_addr = from_addr;
+            taskEXIT_CRITICAL();
+
+            dgram->len = recvnum;
+            TRACE_MARK(BACKEND_RECV, recvnum);
+            __msg.rx_pool.post(dgram);
+            LOG_V("UDP", "recvnum: %d", recvnum);
+        }
+#endif
+
+#ifdef BACKEND_TRANSFER_USE_RAW_UDP
+        IP4_ADDR(&__rmt_ip, IP_S_ADDR0, IP_S_ADDR1, IP_S_ADDR2, IP_S_ADDR3);
+        __rmt_port = PCdataTransfer_UDP_PORT;
+
+        // 未开启LWIP_TCPIP_CORE_LOCKING，控制块只能在tcpip线程中创建和使用
+        if (tcpip_callback(raw_open, this) != ERR_OK) {
+            LOG_E("UDP", "tcpip_callback failed");
+            vTaskDelete(nullptr);
+            return;
+        }
+        __raw_done.take();
+        if (__pcb == nullptr) {
+            LOG_E("UDP", "bind port %d failed", PCdataTransfer_UDP_PORT);
             vTaskDelete(nullptr);
             return;
         }
+        LOG_V("UDP", "raw udp port: %d", PCdataTransfer_UDP_PORT);
+        __sender.give();
 
-        if (bind(sockfd, (struct sockaddr*)&bod_addr, sizeof(bod_addr)) < 0) {
-            lwip_close(sockfd);
+        // 接收在tcpip线程的回调中完成，本任务只输出丢包统计
+        uint32_t reported = 0;
+        uint32_t oversize_reported = 0;
+        for (;;) {
+            TaskBase::delay(pdMS_TO_TICKS(PCdataTransfer_RAW_UDP_STATS_MS));
+            uint32_t drop = __rx_drop;
+            if (drop != reported) {
+                LOG_W("UDP", "rx pool empty, %lu datagrams dropped",
+                      (unsigned long)(drop - reported));
+                reported = drop;
+            }
+            uint32_t oversize = __rx_oversize;
+            if (oversize != oversize_reported) {
+                LOG_W("UDP", "%lu datagrams longer than %u bytes dropped",
+                      (unsigned long)(oversize - oversize_reported),
+                      (unsigned)PCdataTransferMsg_RX_DATAGRAM_SIZE);
+                oversize_reported = oversize;
+            }
+        }
+#endif
+
+#ifdef BACKEND_TRANSFER_USE_TCP
+        struct netconn* listen_conn = netconn_new(NETCONN_TCP);
+        if (listen_conn == nullptr) {
+            LOG_E("TCP", "netconn_new failed");
             vTaskDelete(nullptr);
             return;
         }
+        // 对端断电或断线后由保活探测释放连接，才能接受新的连接；
+        // 接受的连接继承监听连接的保活选项
+        ip_set_option(listen_conn->pcb.tcp, SOF_KEEPALIVE);
+        if (netconn_bind(listen_conn, IP_ADDR_ANY, PCdataTransfer_TCP_PORT) !=
+                ERR_OK ||
+            netconn_listen(listen_conn) != ERR_OK) {
+            LOG_E("TCP", "listen on port %d failed", PCdataTransfer_TCP_PORT);
+            netconn_delete(listen_conn);
+            vTaskDelete(nullptr);
+            return;
+        }
+        LOG_V("TCP", "listen port: %d", PCdataTransfer_TCP_PORT);
+        __sender.give();
+
+        FrameDecoder decoder(sizeof(PCdatagram::data));
+        for (;;) {
+            struct netconn* conn;
+            if (netconn_accept(listen_conn, &conn) != ERR_OK) {
+                continue;
+            }
+            tcp_attach(conn);
+            decoder.reset();
+
+            struct netbuf* nbuf;
+            while (netconn_recv(conn, &nbuf) == ERR_OK) {
+                do {
+                    void* data;
+                    u16_t len;
+                    netbuf_data(nbuf, &data, &len);
+                    decoder.feed(
+                        (const uint8_t*)data, len,
+                        [this](const uint8_t* frame, size_t frame_len) {
+                            // 缓冲池空说明解析任务处理不过来，等待归还
+                            PCdatagram* dgram = __msg.rx_pool.alloc();
+                            memcpy(dgram->data, frame, frame_len);
+                            dgram->len = frame_len;
+                            TRACE_MARK(BACKEND_RECV, frame_len);
+                            __msg.rx_pool.post(dgram);
+                        });
+                } while (netbuf_next(nbuf) >= 0);
+                netbuf_delete(nbuf);
+            }
+            tcp_detach(conn);
+        }
+#endif
+    }
+
+   private:
+    PCdataTransferMsg& __msg;
+
+#ifdef BACKEND_TRANSFER_USE_UDP
+    int sockfd = -1;
+    struct sockaddr_in rmt_addr;
+
+    // 接收任务完成socket绑定后才启动发送任务
+    void send_loop() {
+        const uint8_t* ptr;
+        size_t size;
+        for (;;) {
+            __msg.tx_ring.wait();
+            taskENTER_CRITICAL();
+            struct sockaddr_in addr = rmt_addr;
+            taskEXIT_CRITICAL();
+
+            // 连续发出所有已入队的帧，数据直接从环形缓冲区发送
+            while (__msg.tx_ring.peek(ptr, size)) {
+                TRACE_BEGIN(BACKEND_SEND, size);
+                if (sendto(sockfd, ptr, size, 0, (struct sockaddr*)&addr,
+                           sizeof(addr)) < 0) {
+                    LOG_E("UDP", "sendto failed, size: %d", size);
+                }
+                TRACE_END(BACKEND_SEND, size);
+                __msg.tx_ring.pop();
+            }
+        }
+    }
+#endif
+
+#ifdef BACKEND_TRANSFER_USE_RAW_UDP
+    // 控制块和回复地址只在tcpip线程中访问
+    struct udp_pcb* __pcb = nullptr;
+    ip_addr_t __rmt_ip;
+    u16_t __rmt_port = 0;
+    volatile uint32_t __rx_drop = 0;
+    volatile uint32_t __rx_oversize = 0;
+
+    // tcpip线程回调完成
+    BinarySemaphore __raw_done{"raw_udp_done"};
+
+    // 待发出的一批pbuf，直接引用环形缓冲区中的帧
+    struct pbuf* __tx_batch[PCdataTransfer_RAW_UDP_BATCH];
+    uint8_t __tx_num = 0;
+
+    // tcpip线程：创建并绑定控制块
+    static void raw_open(void* arg) {
+        PCdataTransfer* self = (PCdataTransfer*)arg;
+        struct udp_pcb* pcb = udp_new();
+        if (pcb != nullptr &&
+            udp_bind(pcb, IP_ADDR_ANY, PCdataTransfer_UDP_PORT) != ERR_OK) {
+            udp_remove(pcb);
+            pcb = nullptr;
+        }
+        if (pcb != nullptr) {
+            udp_recv(pcb, raw_recv, self);
+        }
+        self->__pcb = pcb;
+        self->__raw_done.give();
+    }
+
+    // tcpip线程：收到数据报，拷入缓冲池后交给解析任务
+    static void raw_recv(void* arg, struct udp_pcb* pcb, struct pbuf* p,
+                         const ip_addr_t* addr, u16_t port) {
+        PCdataTransfer* self = (PCdataTransfer*)arg;
+        PCdatagram* dgram = nullptr;
+        if (p->tot_len > sizeof(dgram->data)) {
+            // 截断的数据报无法解析，整包丢弃并计数
+            self->__rx_oversize++;
+        } else if ((dgram = self->__msg.rx_pool.alloc(0)) == nullptr) {
+            // 不能阻塞tcpip线程，缓冲池空时丢弃，由上位机重发
+            self->__rx_drop++;
+        } else {
+            dgram->len = pbuf_copy_partial(p, dgram->data, p->tot_len, 0);
+            TRACE_MARK(BACKEND_RECV, dgram->len);
+            self->__msg.rx_pool.post(dgram);
+        }
+        // 回复发往最近一次发来数据的地址
+        ip_addr_copy(self->__rmt_ip, *addr);
+        self->__rmt_port = port;
+        pbuf_free(p);
+    }
+
+    // tcpip线程：发出一批pbuf
+    static void raw_send(void* arg) {
+        PCdataTransfer* self = (PCdataTransfer*)arg;
+        for (uint8_t i = 0; i < self->__tx_num; i++) {
+            struct pbuf* p = self->__tx_batch[i];
+            if (udp_sendto(self->__pcb, p, &self->__rmt_ip,
+                           self->__rmt_port) != ERR_OK) {
+                LOG_E("UDP", "udp_sendto failed, size: %d", p->tot_len);
+            }
+            pbuf_free(p);
+        }
+        self->__raw_done.give();
+    }
 
+    // 接收任务完成控制块绑定后才启动发送任务
+    void send_loop() {
+        const uint8_t* ptr;
+        size_t size;
         for (;;) {
-            recvnum = recvfrom(sockfd, buf, MAX_BUF_SIZE, 0,
-                               (struct sockaddr*)&rmt_addr, &len);
-            if (recvnum > 0) {
-                for (int i = 0; i < recvnum; i++) {
-                    __msg.rx_data_queue.add(buf[i]);
+            __msg.tx_ring.wait();
+
+            // 在本任务中预先构造pbuf，一批帧只经过一次tcpip线程消息
+            size_t cursor = __msg.tx_ring.begin();
+            __tx_num = 0;
+            while (__tx_num < PCdataTransfer_RAW_UDP_BATCH &&
+                   __msg.tx_ring.peek_next(cursor, ptr, size)) {
+                struct pbuf* p = pbuf_alloc(PBUF_TRANSPORT, size, PBUF_REF);
+                if (p == nullptr) {
+                    break;
                 }
-                __msg.rx_done_sem.give();
-                recvnum = 0;
-                Log.v("UDP", "recvnum: %d", recvnum);
+                p->payload = (void*)ptr;
+                __tx_batch[__tx_num++] = p;
+            }
+            if (__tx_num == 0) {
+                // pbuf耗尽，等协议栈释放
+                TaskBase::delay(1);
+                continue;
             }
 
-            if (__msg.tx_request_sem.take(0)) {
-                __msg.tx_share_mem.lock();
-                const uint8_t* ptr = __msg.tx_share_mem.get();
-                size_t size = __msg.tx_share_mem.size();
-                sendto(sockfd, ptr, size, 0, (struct sockaddr*)&rmt_addr,
-                       sizeof(rmt_addr));
-                __msg.tx_share_mem.unlock();
-                __msg.tx_done_sem.give();
-                Log.v("UDP", "sendto: %d", size);
+            uint8_t num = __tx_num;
+            TRACE_BEGIN(BACKEND_SEND, num);
+            if (tcpip_callback(raw_send, this) == ERR_OK) {
+                __raw_done.take();
+                TRACE_END(BACKEND_SEND, num);
+            } else {
+                TRACE_END(BACKEND_SEND, 0);
+                LOG_E("UDP", "tcpip_callback failed, drop %u frames", num);
+                for (uint8_t i = 0; i < num; i++) {
+                    pbuf_free(__tx_batch[i]);
+                }
+            }
+            // 引用的数据在发送时已由网卡驱动或ARP队列拷贝，可以释放
+            for (uint8_t i = 0; i < num; i++) {
+                __msg.tx_ring.pop();
             }
+        }
+    }
+#endif
 
-            TaskBase::delay(10);
+#ifdef BACKEND_TRANSFER_USE_TCP
+    // 当前连接，由接收任务建立和释放，发送任务持锁使用
+    Mutex __conn_mutex{"backend_conn"};
+    struct netconn* __conn = nullptr;
+    bool __conn_broken = false;
+
+    // 环形缓冲区中已写入协议栈的帧，对端确认前不能释放
+    size_t __cursor = 0;
+    uint32_t __snd_base = 0;    // 连接建立时的发送序号
+    uint32_t __written = 0;     // 本连接累计写入字节数
+    uint32_t __inflight_end[PCdataTransfer_TCP_INFLIGHT_NUM];
+    uint16_t __inflight_head = 0;
+    uint16_t __inflight_num = 0;
+    uint32_t __idle_dropped = 0;    // 无连接期间丢弃的帧数
+
+    // 控制块的发送序号，由tcpip线程读取
+    bool __seq_valid = false;
+    uint32_t __seq_lastack = 0;
+    uint32_t __seq_snd_lbb = 0;
+    BinarySemaphore __seq_done{"tcp_seq_done"};
+
+    void tcp_attach(struct netconn* conn) {
+        __conn_mutex.take();
+        __conn = conn;
+        __written = 0;
+        __conn_broken = !tcp_seq();
+        __snd_base = __seq_snd_lbb;
+        if (__idle_dropped > 0) {
+            LOG_W("TCP", "%lu frames dropped while disconnected",
+                  (unsigned long)__idle_dropped);
+            __idle_dropped = 0;
         }
+        __conn_mutex.give();
+        LOG_I("TCP", "backend connected");
+    }
+
+    void tcp_detach(struct netconn* conn) {
+        __conn_mutex.take();
+        __conn = nullptr;
+#if LWIP_SO_LINGER
+        // 仍有未确认数据时直接复位连接，避免协议栈继续引用环形缓冲区
+        conn->linger = 0;
 #endif
+        netconn_delete(conn);
+        // 未确认和未写入的帧随连接丢弃，结果由结果流序号经NACK重传恢复
+        uint16_t unacked = __inflight_num;
+        uint32_t dropped = tcp_drop();
+        __conn_mutex.give();
+        if (dropped > 0) {
+            LOG_W("TCP", "backend disconnected, %u unacked and %lu unsent "
+                  "frames dropped",
+                  unacked, (unsigned long)(dropped - unacked));
+        } else {
+            LOG_I("TCP", "backend disconnected");
+        }
     }
 
-   private:
-    PCdataTransferMsg& __msg;
+    // 持__conn_mutex调用：丢弃环形缓冲区中的全部帧，返回丢弃的帧数
+    uint32_t tcp_drop() {
+        uint32_t num = 0;
+        while (!__msg.tx_ring.empty()) {
+            __msg.tx_ring.pop();
+            num++;
+        }
+        __cursor = __msg.tx_ring.begin();
+        __inflight_head = 0;
+        __inflight_num = 0;
+        return num;
+    }
+
+    // tcpip线程：读取当前连接控制块的发送序号
+    static void tcp_seq_read(void* arg) {
+        PCdataTransfer* self = (PCdataTransfer*)arg;
+        // 连接出错时控制块由tcpip线程释放并清空
+        struct tcp_pcb* pcb = self->__conn->pcb.tcp;
+        self->__seq_valid = pcb != nullptr;
+        if (pcb != nullptr) {
+            self->__seq_lastack = pcb->lastack;
+            self->__seq_snd_lbb = pcb->snd_lbb;
+        }
+        self->__seq_done.give();
+    }
+
+    // 持__conn_mutex调用：读取当前连接的发送序号，连接已失效返回false
+    bool tcp_seq() {
+        // 未开启LWIP_TCPIP_CORE_LOCKING，控制块只能在tcpip线程中访问
+        if (tcpip_callback(tcp_seq_read, this) != ERR_OK) {
+            LOG_E("TCP", "tcpip_callback failed");
+            return false;
+        }
+        __seq_done.take();
+        return __seq_valid;
+    }
+
+    // 持__conn_mutex调用：将新入队的帧零拷贝写入协议栈，释放已确认的帧
+    void tcp_flush() {
+        const uint8_t* ptr;
+        size_t size;
+        while (__inflight_num < PCdataTransfer_TCP_INFLIGHT_NUM &&
+               __msg.tx_ring.peek_next(__cursor, ptr, size)) {
+            // 协议栈只引用环形缓冲区中的数据，发送缓冲区满时阻塞
+            TRACE_BEGIN(BACKEND_SEND, size);
+            err_t err = netconn_write(__conn, ptr, size, NETCONN_NOCOPY);
+            TRACE_END(BACKEND_SEND, size);
+            if (err != ERR_OK) {
+                LOG_E("TCP", "netconn_write failed, size: %d", size);
+                __conn_broken = true;
+                return;
+            }
+            __written += size;
+            __inflight_end[(__inflight_head + __inflight_num) %
+                           PCdataTransfer_TCP_INFLIGHT_NUM] = __written;
+            __inflight_num++;
+        }
+
+        if (__inflight_num == 0 || !tcp_seq()) {
+            return;
+        }
+        uint32_t acked = __seq_lastack - __snd_base;
+        while (__inflight_num > 0 &&
+               (int32_t)(acked - __inflight_end[__inflight_head]) >= 0) {
+            __msg.tx_ring.pop();
+            __inflight_head =
+                (__inflight_head + 1) % PCdataTransfer_TCP_INFLIGHT_NUM;
+            __inflight_num--;
+        }
+    }
+
+    void send_loop() {
+        for (;;) {
+            // 有帧等待确认或连接失效等待释放时定时查询，否则等待新帧入队
+            if (__inflight_num > 0 || __conn_broken) {
+                TaskBase::delay(PCdataTransfer_TCP_ACK_POLL_TICKS);
+            } else {
+                __msg.tx_ring.wait();
+            }
+            __conn_mutex.take();
+            if (__conn == nullptr) {
+                // 没有连接时不积压，避免阻塞上报，建立连接时报告丢弃数
+                __idle_dropped += tcp_drop();
+            } else if (!__conn_broken) {
+                tcp_flush();
+            }
+            __conn_mutex.give();
+        }
+    }
+#endif
+
+    class Sender : public TaskClassS<PCdataTransfer_SENDER_STACK_SIZE> {
+       public:
+        Sender(PCdataTransfer& owner)
+            : TaskClassS<PCdataTransfer_SENDER_STACK_SIZE>("PCdataSender",
+                                                           TaskPrio_High),
+              owner(owner) {}
+        void task() override {
+            Diag::set_subsystem(Diag::Subsystem::LWIP);
+#if defined(BACKEND_TRANSFER_USE_UDP) ||     \
+    defined(BACKEND_TRANSFER_USE_RAW_UDP) || \
+    defined(BACKEND_TRANSFER_USE_TCP)
+            owner.send_loop();
+#endif
+        }
+
+       private:
+        PCdataTransfer& owner;
+    } __sender;
 };
 
 class PCinterface : public TaskClassS<PCinterface_STACK_SIZE> {
@@ -185,21 +583,17 @@ class PCinterface : public TaskClassS<PCinterface_STACK_SIZE> {
           pmf(pc_manager_msg) {}
 
     void task() override {
-        Log.i("PCinterface_Task", "Boot");
+        LOG_I("PCinterface_Task", "Boot");
+        Diag::set_subsystem(Diag::Subsystem::PROTOCOL);
 
-        std::vector<uint8_t> buffer;
-        std::vector<uint8_t> rsp_data;
-        buffer.reserve(PCdataTransferMsg_DATA_QUEUE_SIZE);
-        uint8_t recv_data;
+        PoolVector<uint8_t> rsp_data;
         while (1) {
-            transfer_msg.rx_done_sem.take();
-            while (transfer_msg.rx_data_queue.pop(recv_data, 0) == pdPASS) {
-                buffer.push_back(recv_data);
-            }
-            rsp_data = pmf.forward(buffer);
+            // 整个数据报按指针交给协议解析，用完立即归还缓冲池
+            PCdatagram* dgram = transfer_msg.rx_pool.take();
+            rsp_data = pmf.forward(dgram->data, dgram->len);
+            // jsonSorting(dgram->data, dgram->len);
+            transfer_msg.rx_pool.free(dgram);
             rsp(rsp_data.data(), rsp_data.size());
-            // jsonSorting(buffer.data(), buffer.size());
-            buffer.clear();
         }
     }
 
@@ -209,6 +603,8 @@ class PCinterface : public TaskClassS<PCinterface_STACK_SIZE> {
     DeviceResetInst reset_inst;
     DeviceCtrlInst ctrl_inst;
     DeviceQueryInst query_inst;
+    JsonCmdSax json_cmd;
+    JsonRsp json_rsp;
     PCdataTransferMsg& transfer_msg;
 
     ProtocolMessageForward pmf;
@@ -217,85 +613,58 @@ class PCinterface : public TaskClassS<PCinterface_STACK_SIZE> {
     // 直接序列化到数组的函数
     void pc_message() {}
 
+    // SAX单遍解析直接得到指令结构体，回复写入定长缓冲区，不构建DOM
     void jsonSorting(uint8_t* ch, uint16_t len) {
-        // 先检查JSON字符串是否有效
-        if (!json::accept(ch, ch + len)) {
-            Log.e("PCinterface", "Invalid JSON format");
+        Diag::Scope diag_scope(Diag::Subsystem::JSON);
+        if (!json_cmd.parse(ch, len)) {
+            LOG_E("PCinterface", "json parse failed");
             return;
         }
 
-        json j = json::parse((uint8_t*)ch, ch + len, nullptr, false);
-        if (j.is_discarded()) {
-            Log.e("PCinterface", "json parse failed");
-            return;
-        }
-
-        if (j.contains("inst")) {
-            uint8_t inst = j["inst"];
-            std::string rsp;
-            switch (inst) {
+        if (json_cmd.inst >= 0) {
+            json_rsp.clear();
+            switch (json_cmd.inst) {
                 case DEV_CONF: {
                     // 设备配置解析
-                    rsp = cfg_inst.forward(j);
+                    cfg_inst.forward(json_cmd, json_rsp);
                     break;
                 }
 
                 case DEV_MODE: {
                     // 设备模式解析
-                    rsp = mode_inst.forward(j);
+                    mode_inst.forward(json_cmd, json_rsp);
                     break;
                 }
                 case DEV_RESET:
                     // 设备复位解析
-                    rsp = reset_inst.forward(j);
+                    reset_inst.forward(json_cmd, json_rsp);
                     break;
                 case DEV_CTRL:
                     // 设备控制解析
-                    rsp = ctrl_inst.forward(j);
+                    ctrl_inst.forward(json_cmd, json_rsp);
                     break;
                 case DEV_QUERY:
                     // 设备查询解析
-                    query_inst.forward(j);
+                    query_inst.forward(json_cmd, json_rsp);
                     break;
                 default:
                     break;
             }
 
-            // 获取共享内存写访问权限，避免在数据发送前共享内存内的数据被复写
-            if (transfer_msg.tx_share_mem.get_write_access(
-                    PC_TX_SHARE_MEM_ACCESS_TIMEOUT)) {
-                transfer_msg.tx_share_mem.write((uint8_t*)rsp.c_str(),
-                                                rsp.size());
-                transfer_msg.tx_request_sem.give();
-                if (!transfer_msg.tx_done_sem.take(PCinterface_RSP_TIMEOUT)) {
-                    Log.e("PCinterface",
-                          " json respond failed. tx_done_sem.take "
-                          "failed");
-                }
-                // 释放写访问权限
-                transfer_msg.tx_share_mem.release_write_access();
-            } else {
-                Log.e("PCinterface", " tx_share_mem.get_write_access failed");
+            if (json_rsp.overflow()) {
+                LOG_E("PCinterface", "json response overflow");
             }
+            this->rsp(json_rsp.data(), json_rsp.size());
         }
     }
 
-    void rsp(uint8_t* ch, uint16_t len) {
-        if (transfer_msg.tx_share_mem.get_write_access(
-                PC_TX_SHARE_MEM_ACCESS_TIMEOUT)) {
-            transfer_msg.tx_share_mem.write(ch, len);
-            transfer_msg.tx_request_sem.give();
-            if (!transfer_msg.tx_done_sem.take(PCinterface_RSP_TIMEOUT)) {
-                Log.e("PCinterface",
-                      " respond to PC failed: tx_done_sem.take "
-                      "failed");
-            }
-            // 释放写访问权限
-            transfer_msg.tx_share_mem.release_write_access();
-        } else {
-            Log.e("PCinterface",
-                  " respond to PC failed: "
-                  "tx_share_mem.get_write_access failed");
+    // 回复入队后即返回，不等待发送完成
+    void rsp(const uint8_t* ch, size_t len) {
+        if (len == 0) {
+            return;
+        }
+        if (!transfer_msg.tx_ring.push(ch, len, PCinterface_RSP_TIMEOUT)) {
+            LOG_E("PCinterface", " respond to PC failed: tx_ring.push failed");
         }
     }
 };
@@ -11,6 +11,19 @@ void ModeCfgMsg::process() {
 }
 void RstMsg::process() { ProtocolMessageForward::rx_msg_id = MSGID::RST_MSG; }
 void CtrlMsg::process() { ProtocolMessageForward::rx_msg_id = MSGID::CTRL_MSG; }
+void NackMsg::process() { ProtocolMessageForward::rx_msg_id = MSGID::NACK_MSG; }
+void RequestMsg::process() {
+    ProtocolMessageForward::rx_msg_id = MSGID::REQUEST_MSG;
+}
+void QueryMsg::process() {
+    ProtocolMessageForward::rx_msg_id = MSGID::QUERY_MSG;
+}
+void DiagMsg::process() {
+    ProtocolMessageForward::rx_msg_id = MSGID::DIAG_MSG;
+}
+void TraceMsg::process() {
+    ProtocolMessageForward::rx_msg_id = MSGID::TRACE_MSG;
+}
 }    // namespace Backend2Master
 
 namespace Master2Backend {
@@ -18,5 +31,11 @@ void SlaveCfgMsg::process() {}
 void ModeCfgMsg::process() {}
 void RstMsg::process() {}
 void CtrlMsg::process() {}
+void NackMsg::process() {}
+void ResultStreamMsg::process() {}
+void ResponseMsg::process() {}
+void QueryMsg::process() {}
+void DiagMsg::process() {}
+void TraceMsg::process() {}
 
 }    // namespace Master2Backend
\ No newline at end of file
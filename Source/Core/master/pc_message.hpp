@@ -7,7 +7,9 @@
 #include <cstring>
 #include <vector>
 
+#include "bsp_diag.hpp"
 #include "bsp_log.hpp"
+#include "bsp_trace.hpp"
 #include "forward.hpp"
 #include "master_cfg.hpp"
 #include "master_def.hpp"
@@ -16,6 +18,55 @@
 class __PcMessageBase : public DataForwardBase {
    public:
     __PcMessageBase(PCmanagerMsg& msg) : DataForwardBase(msg) {};
+
+    // 指令的请求号，旧格式(不带请求号)的指令tagged为false
+    struct RequestTag {
+        bool tagged;
+        uint16_t id;
+    };
+
+   protected:
+    /**
+     * @brief 打包应答帧，带请求号的指令包装为RESPONSE_MSG
+     * @param status_pos 输出应答状态字节在帧中的偏移
+     */
+    static PoolVector<uint8_t> pack_rsp(const Message& msg,
+                                         const RequestTag& tag,
+                                         size_t& status_pos) {
+        auto packet = PacketPacker::master2BackendPack(msg);
+        status_pos = FrameHeader::HEADER_SIZE + 1;
+        if (!tag.tagged) {
+            return FramePacker::pack(packet);
+        }
+        Master2Backend::ResponseMsg rsp_msg;
+        rsp_msg.reqId = tag.id;
+        rsp_msg.packet = packet.serialize();
+        status_pos += 3;    // 请求号2字节 + 内层消息ID
+        return FramePacker::pack(PacketPacker::master2BackendPack(rsp_msg));
+    }
+
+    /**
+     * @brief 提交到指令表，全部步骤完成后由指令表发出应答
+     * @return 需要立即回复的应答帧，已提交时为空
+     */
+    PoolVector<uint8_t> submit(std::vector<DataForward>&& steps,
+                                PoolVector<uint8_t>&& rsp, size_t status_pos,
+                                CmdTable::Priority prio = CmdTable::NORMAL) {
+        if (steps.empty()) {
+            // 没有需要从机管理任务执行的步骤
+            rsp[status_pos] = 0;
+            return std::move(rsp);
+        }
+        uint8_t slot = pc_manager_msg.cmd_table.submit(
+            std::move(steps), std::move(rsp), status_pos, prio);
+        if (slot == CmdTable::NONE) {
+            // 提交失败时rsp未被取走
+            LOG_E("PcMessage", "cmd_table full, reject");
+            rsp[status_pos] = 1;
+            return std::move(rsp);
+        }
+        return PoolVector<uint8_t>();
+    }
 };
 class SlaveConfig : private __PcMessageBase {
    public:
@@ -23,21 +74,20 @@ class SlaveConfig : private __PcMessageBase {
 
    private:
     CfgCmd cfg_cmd;
-    bool is_success;
     Master2Backend::SlaveCfgMsg::SlaveConfig slave_cfg;
     Master2Backend::SlaveCfgMsg rsp_msg;
     uint16_t index = 0;
     uint16_t slave_num = 0;
-    // std::vector<Master2Backend::SlaveCfgMsg::SlaveConfig> slaves_dev;
 
    public:
-    std::vector<uint8_t> forward() {
-        is_success = true;
+    PoolVector<uint8_t> forward(const RequestTag& tag) {
         index = 0;
         data_forward.type = DEV_CONF;
         slave_num = Backend2Master::SlaveCfgMsg::slaves.size();
         rsp_msg.slaves.reserve(slave_num);
         rsp_msg.slaves.clear();
+        std::vector<DataForward> steps;
+        steps.reserve(slave_num);
         memset(&cfg_cmd, 0, sizeof(cfg_cmd));
         for (auto dev : Backend2Master::SlaveCfgMsg::slaves) {
             cfg_cmd.totalHarnessNum += dev.conductionNum;
@@ -59,6 +109,7 @@ class SlaveConfig : private __PcMessageBase {
             cfg_cmd.clip_mode = dev.clipMode;
 
             data_forward.cfg_cmd = cfg_cmd;
+            steps.push_back(data_forward);
 
             slave_cfg.id = dev.id;
             slave_cfg.clipMode = dev.clipMode;
@@ -66,33 +117,16 @@ class SlaveConfig : private __PcMessageBase {
             slave_cfg.conductionNum = dev.conductionNum;
             slave_cfg.resistanceNum = dev.resistanceNum;
             rsp_msg.slaves.push_back(slave_cfg);
-            Log.i("SlaveConfig","0x%.8X  configing... ", slave_cfg.id);
-            // Log.i("SlaveConfig","conductionNum = %u", cfg_cmd.cond);
-            // Log.i("SlaveConfig","resistanceNum = %u", cfg_cmd.Z);
-            // Log.i("SlaveConfig","clipMode = %u", cfg_cmd.clip_mode);
-            // Log.i("SlaveConfig","clipStatus = %u", cfg_cmd.clip_pin);
-            Log.i("SlaveConfig","startHarnessNum = %u",
+            LOG_I("SlaveConfig", "0x%.8X  configing... ", slave_cfg.id);
+            LOG_I("SlaveConfig", "startHarnessNum = %u",
                   cfg_cmd.startHarnessNum);
-
-            if (__PcMessageBase::forward()) {
-                if ((pc_manager_msg.event.get() & CONFIG_SUCCESS_EVENT)) {
-                    Log.i("SlaveConfig","%.2X-%.2X-%.2X-%.2X config success\n",
-                          cfg_cmd.id[0], cfg_cmd.id[1], cfg_cmd.id[2],
-                          cfg_cmd.id[3]);
-
-                } else {
-                    Log.e("SlaveConfig","%.2X-%.2X-%.2X-%.2X config failed\n",
-                          cfg_cmd.id[0], cfg_cmd.id[1], cfg_cmd.id[2],
-                          cfg_cmd.id[3]);
-                    is_success = false;
-                }
-            }
         }
 
         rsp_msg.slaveNum = slave_num;
-        rsp_msg.status = !is_success;
-        auto rsp_packet = PacketPacker::master2BackendPack(rsp_msg);
-        return FramePacker::pack(rsp_packet);
+        rsp_msg.status = 0;
+        size_t status_pos;
+        auto rsp = pack_rsp(rsp_msg, tag, status_pos);
+        return submit(std::move(steps), std::move(rsp), status_pos);
     }
 };
 
@@ -102,28 +136,20 @@ class ModeConfig : private __PcMessageBase {
 
    private:
     ModeCmd mode_cmd;
-    bool is_success;
     Master2Backend::ModeCfgMsg rsp_msg;
 
    public:
-    std::vector<uint8_t> forward() {
-        is_success = true;
+    PoolVector<uint8_t> forward(const RequestTag& tag) {
         data_forward.type = DEV_MODE;
         mode_cmd.mode = (SysMode)Backend2Master::ModeCfgMsg::mode;
         data_forward.mode_cmd = mode_cmd;
-        Log.i("ModeConfig","mode = %u", mode_cmd.mode);
-        if (__PcMessageBase::forward()) {
-            if ((pc_manager_msg.event.get() & MODE_SUCCESS_EVENT)) {
-                Log.i("ModeConfig","config success");
-            } else {
-                Log.e("ModeConfig","config failed");
-                is_success = false;
-            }
-        }
-        rsp_msg.status = !is_success;
+        LOG_I("ModeConfig","mode = %u", mode_cmd.mode);
+        rsp_msg.status = 0;
         rsp_msg.mode = mode_cmd.mode;
-        auto rsp_packet = PacketPacker::master2BackendPack(rsp_msg);
-        return FramePacker::pack(rsp_packet);
+        size_t status_pos;
+        auto rsp = pack_rsp(rsp_msg, tag, status_pos);
+        return submit(std::vector<DataForward>{data_forward}, std::move(rsp),
+                      status_pos);
     }
 };
 
@@ -133,45 +159,38 @@ class ResetConfig : private __PcMessageBase {
 
    private:
     ResetCmd rst_cmd;
-    bool is_success;
     Master2Backend::RstMsg rsp_msg;
     Master2Backend::RstMsg::SlaveResetConfig rst_cfg;
     uint16_t slave_num;
-    // std::vector<Master2Backend::RstMsg::SlaveResetConfig> slaves_dev;
 
    public:
-    std::vector<uint8_t> forward() {
-        is_success = true;
+    PoolVector<uint8_t> forward(const RequestTag& tag) {
         data_forward.type = DEV_RESET;
         slave_num = Backend2Master::RstMsg::slaves.size();
         rsp_msg.slaves.reserve(slave_num);
         rsp_msg.slaves.clear();
+        std::vector<DataForward> steps;
+        steps.reserve(slave_num);
         memset(&rst_cmd, 0, sizeof(rst_cmd));
         for (auto dev : Backend2Master::RstMsg::slaves) {
             memcpy(rst_cmd.id, &dev.id, sizeof(dev.id));
             rst_cmd.clip = dev.clipStatus;
             rst_cmd.lock = (LockSta)dev.lock;
             data_forward.rst_cmd = rst_cmd;
+            steps.push_back(data_forward);
 
             rst_cfg.id = dev.id;
             rst_cfg.clipStatus = dev.clipStatus;
             rst_cfg.lock = dev.lock;
             rsp_msg.slaves.push_back(rst_cfg);
 
-            Log.i("ResetConfig","0x%.8X  reseting... ", rst_cmd.id);
-            if (__PcMessageBase::forward()) {
-                if ((pc_manager_msg.event.get() & RESET_SUCCESS_EVENT)) {
-                    Log.i("ResetConfig"," 0x%.8X reset success\n", rst_cmd.id);
-                } else {
-                    Log.e("ResetConfig"," 0x%.8X reset failed\n", rst_cmd.id);
-                    is_success = false;
-                }
-            }
+            LOG_I("ResetConfig", "0x%.8X  reseting... ", dev.id);
         }
         rsp_msg.slaveNum = slave_num;
-        rsp_msg.status = !is_success;
-        auto rsp_packet = PacketPacker::master2BackendPack(rsp_msg);
-        return FramePacker::pack(rsp_packet);
+        rsp_msg.status = 0;
+        size_t status_pos;
+        auto rsp = pack_rsp(rsp_msg, tag, status_pos);
+        return submit(std::move(steps), std::move(rsp), status_pos);
     }
 };
 
@@ -181,38 +200,145 @@ class ControlConfig : private __PcMessageBase {
 
    private:
     CtrlCmd ctrl_cmd;
-    bool is_success;
     Master2Backend::CtrlMsg rsp_msg;
 
    public:
-    std::vector<uint8_t> forward() {
-        is_success = true;
+    PoolVector<uint8_t> forward(const RequestTag& tag) {
         data_forward.type = DEV_CTRL;
         ctrl_cmd.ctrl = (CtrlType)Backend2Master::CtrlMsg::runningStatus;
         data_forward.ctrl_cmd = ctrl_cmd;
-        Log.i("ControlConfig","runningStatus = %u", ctrl_cmd.ctrl);
-        if (__PcMessageBase::forward()) {
-            if ((pc_manager_msg.event.get() & CTRL_SUCCESS_EVENT)) {
-                Log.i("ControlConfig","config success\n");
-            } else {
-                Log.e("ControlConfig","config failed\n");
-                is_success = false;
-            }
-        }
+        LOG_I("ControlConfig","runningStatus = %u", ctrl_cmd.ctrl);
         rsp_msg.runningStatus = ctrl_cmd.ctrl;
-        rsp_msg.status = !is_success;
-        auto rsp_packet = PacketPacker::master2BackendPack(rsp_msg);
-        return FramePacker::pack(rsp_packet);
+        rsp_msg.status = 0;
+        size_t status_pos;
+        auto rsp = pack_rsp(rsp_msg, tag, status_pos);
+        // 停止检测越过排队中的指令，并中止正在进行的检测周期
+        return submit(std::vector<DataForward>{data_forward}, std::move(rsp),
+                      status_pos,
+                      ctrl_cmd.ctrl == DEV_DISABLE ? CmdTable::PREEMPT
+                                                   : CmdTable::NORMAL);
+    }
+};
+
+class ResultNack : private __PcMessageBase {
+   public:
+    ResultNack(PCmanagerMsg& msg) : __PcMessageBase(msg) {};
+
+   private:
+    Master2Backend::NackMsg rsp_msg;
+
+   public:
+    PoolVector<uint8_t> forward(const RequestTag& tag) {
+        // 重传的结果先入队，应答随后发出
+        pc_manager_msg.result_stream.retransmit(
+            Backend2Master::NackMsg::seqs, rsp_msg.lostSeqs,
+            PCinterface_RSP_TIMEOUT);
+        rsp_msg.nextSeq = pc_manager_msg.result_stream.next_seq();
+        if (!rsp_msg.lostSeqs.empty()) {
+            LOG_W("ResultNack", "%u results no longer in history",
+                  (unsigned)rsp_msg.lostSeqs.size());
+        }
+        size_t status_pos;
+        return pack_rsp(rsp_msg, tag, status_pos);
+    }
+};
+
+/**
+ * @brief 由结果缓存直接应答查询，不经过指令表和无线链路
+ */
+class ResultQuery : private __PcMessageBase {
+   public:
+    ResultQuery(PCmanagerMsg& msg) : __PcMessageBase(msg) {};
+
+   private:
+    Master2Backend::QueryMsg rsp_msg;
+
+   public:
+    PoolVector<uint8_t> forward(const RequestTag& tag) {
+        // 帧头、RESPONSE_MSG消息ID + 请求号 + 内层消息ID、查询应答头
+        constexpr size_t overhead = FrameHeader::HEADER_SIZE + 4 + 6;
+        static_assert(ResultCache_RSP_MAX_SIZE > overhead,
+                      "ResultCache_RSP_MAX_SIZE too small");
+        ResultCache& cache = pc_manager_msg.result_cache;
+        rsp_msg.cycle = cache.cycle();
+        rsp_msg.matchNum = cache.query(
+            Backend2Master::QueryMsg::ids, Backend2Master::QueryMsg::pinStart,
+            Backend2Master::QueryMsg::pinNum,
+            ResultCache_RSP_MAX_SIZE - overhead, rsp_msg.slaves);
+        if (rsp_msg.slaves.size() < rsp_msg.matchNum) {
+            LOG_W("ResultQuery", "%u of %u slaves fit in response",
+                  (unsigned)rsp_msg.slaves.size(), rsp_msg.matchNum);
+        }
+        size_t status_pos;
+        return pack_rsp(rsp_msg, tag, status_pos);
+    }
+};
+
+/**
+ * @brief 运行诊断查询，在解析任务中直接应答，不经过从机
+ */
+class DiagQuery : private __PcMessageBase {
+   public:
+    DiagQuery(PCmanagerMsg& msg) : __PcMessageBase(msg) {};
+
+   private:
+    Master2Backend::DiagMsg rsp_msg;
+
+   public:
+    PoolVector<uint8_t> forward(const RequestTag& tag) {
+        rsp_msg.snapshot.clear();
+        Diag::serialize(rsp_msg.snapshot,
+                        Backend2Master::DiagMsg::sections & Diag::ALL);
+        size_t status_pos;
+        return pack_rsp(rsp_msg, tag, status_pos);
     }
 };
 
+/**
+ * @brief 事件跟踪导出，在解析任务中直接应答，一次一段
+ */
+class TraceQuery : private __PcMessageBase {
+   public:
+    TraceQuery(PCmanagerMsg& msg) : __PcMessageBase(msg) {};
+
+   private:
+    Master2Backend::TraceMsg rsp_msg;
+
+   public:
+    PoolVector<uint8_t> forward(const RequestTag& tag) {
+        rsp_msg.dump.clear();
+        using Req = Backend2Master::TraceMsg;
+        uint16_t start = Req::start;
+        if (Req::cmd == Req::RESUME) {
+            Trace::resume();
+        } else if (start == 0) {
+            Trace::freeze();
+        }
+        Trace::serialize(rsp_msg.dump, start, TRACE_DUMP_CHUNK);
+        size_t status_pos;
+        return pack_rsp(rsp_msg, tag, status_pos);
+    }
+};
+
+/**
+ * @brief 上位机指令分发
+ * @note 需要从机执行的指令提交到指令表后立即返回，应答在完成时发出，
+ *       解析任务不再阻塞等待，后续指令(如停止检测)可以越过耗时的配置。
+ *       REQUEST_MSG包装的指令以同一请求号的RESPONSE_MSG应答
+ */
 class ProtocolMessageForward {
    public:
+    using RequestTag = __PcMessageBase::RequestTag;
+
     ProtocolMessageForward(PCmanagerMsg& _msg)
         : slave_config(_msg),
           mode_config(_msg),
           reset_config(_msg),
-          control_config(_msg) {};
+          control_config(_msg),
+          result_nack(_msg),
+          result_query(_msg),
+          diag_query(_msg),
+          trace_query(_msg) {};
     ~ProtocolMessageForward() {};
 
    public:
@@ -223,41 +349,90 @@ class ProtocolMessageForward {
     ModeConfig mode_config;
     ResetConfig reset_config;
     ControlConfig control_config;
+    ResultNack result_nack;
+    ResultQuery result_query;
+    DiagQuery diag_query;
+    TraceQuery trace_query;
     FrameParser frame_parser;
-    std::vector<uint8_t> rsp_packet;
-
-   public:
-    const std::vector<uint8_t> forward(std::vector<uint8_t> raw_data) {
-        auto msg = frame_parser.parse(raw_data);
+    PoolVector<uint8_t> rsp_packet;
+    PoolVector<uint8_t> raw_frame;
+
+    // 解析REQUEST_MSG携带的内层指令
+    std::unique_ptr<Message> __unwrap() {
+        Backend2MasterPacket packet;
+        if (!packet.deserialize(Backend2Master::RequestMsg::packet) ||
+            packet.message_id ==
+                static_cast<uint8_t>(Backend2MasterMessageID::REQUEST_MSG)) {
+            return nullptr;
+        }
+        raw_frame = FramePacker::pack(packet);
+        auto msg = frame_parser.parse(raw_frame);
         if (msg != nullptr) {
-            // 处理解析后的数据
             msg->process();
+        }
+        return msg;
+    }
 
-            switch (rx_msg_id) {
-                case Backend2MasterMessageID::SLAVE_CFG_MSG: {
-                    rsp_packet = slave_config.forward();
-
-                    break;
-                }
-                case Backend2MasterMessageID::MODE_CFG_MSG: {
-                    rsp_packet = mode_config.forward();
-                    break;
-                }
-                case Backend2MasterMessageID::RST_MSG: {
-                    rsp_packet = reset_config.forward();
-                    break;
-                }
-                case Backend2MasterMessageID::CTRL_MSG: {
-                    rsp_packet = control_config.forward();
-                    break;
-                }
+   public:
+    const PoolVector<uint8_t> forward(const uint8_t* data, uint16_t len) {
+        rsp_packet.clear();
+        raw_frame.assign(data, data + len);
+        auto msg = frame_parser.parse(raw_frame);
+        if (msg == nullptr) {
+            LOG_E("SlaveManager","parse failed");
+            return rsp_packet;
+        }
+
+        // 处理解析后的数据
+        msg->process();
+        RequestTag tag = {false, 0};
+        if (rx_msg_id == Backend2MasterMessageID::REQUEST_MSG) {
+            tag = {true, Backend2Master::RequestMsg::reqId};
+            msg = __unwrap();
+            if (msg == nullptr) {
+                LOG_E("PcMessage", "request %u parse failed", tag.id);
+                return rsp_packet;
+            }
+        }
+
+        switch (rx_msg_id) {
+            case Backend2MasterMessageID::SLAVE_CFG_MSG: {
+                rsp_packet = slave_config.forward(tag);
+                break;
+            }
+            case Backend2MasterMessageID::MODE_CFG_MSG: {
+                rsp_packet = mode_config.forward(tag);
+                break;
+            }
+            case Backend2MasterMessageID::RST_MSG: {
+                rsp_packet = reset_config.forward(tag);
+                break;
+            }
+            case Backend2MasterMessageID::CTRL_MSG: {
+                rsp_packet = control_config.forward(tag);
+                break;
+            }
+            case Backend2MasterMessageID::NACK_MSG: {
+                rsp_packet = result_nack.forward(tag);
+                break;
+            }
+            case Backend2MasterMessageID::QUERY_MSG: {
+                rsp_packet = result_query.forward(tag);
+                break;
+            }
+            case Backend2MasterMessageID::DIAG_MSG: {
+                rsp_packet = diag_query.forward(tag);
+                break;
+            }
+            case Backend2MasterMessageID::TRACE_MSG: {
+                rsp_packet = trace_query.forward(tag);
+                break;
             }
-        } else {
-            Log.e("SlaveManager","parse failed");
-            rsp_packet.clear();
+            default:
+                break;
         }
         return rsp_packet;
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -7,12 +7,15 @@
 
 #include "TaskCPP.h"
 #include "TimerCPP.h"
+#include "bsp_allocate.hpp"
 #include "bsp_log.hpp"
+#include "bsp_trace.hpp"
 #include "bsp_uart.hpp"
 #include "master_cfg.hpp"
 #include "master_def.hpp"
 #include "protocol.hpp"
 #include "uwb.hpp"
+#include "uwb_aggregator.hpp"
 #include "uwb_interface.hpp"
 
 extern Logger Log;
@@ -26,10 +29,12 @@ class __ProcessBase {
     ManagerDataTransferMsg& transfer_msg;
     static bool rsp_parsed;
     static uint8_t expected_rsp_msg_id;
+    // 非空时，有抢占指令等待执行则不再重试
+    const CmdTable* preempt_src = nullptr;
 
    private:
     uint8_t send_cnd = 0;
-    std::vector<uint8_t> rsp_data;
+    PoolVector<uint8_t> rsp_data;
     FrameParser frame_parser;
 
    public:
@@ -43,10 +48,27 @@ class __ProcessBase {
 
     virtual void process_rsp_data() {};
 
-    bool send_frame(std::vector<uint8_t>& frame, bool rsp = true) {
+    /**
+     * @brief 最近一次send_frame()中未得到有效回复的发送次数
+     */
+    uint8_t lost_num() const { return send_cnd; }
+
+   protected:
+    // 最近一次从机回复的原始帧，在process_rsp_data()中有效
+    const PoolVector<uint8_t>& rsp_frame() const { return rsp_data; }
+
+   public:
+
+    /**
+     * @brief 发送帧，需要回复时等待并处理从机回复
+     * @param flush 立即发送；为false时可与后续帧聚合，最长等待
+     *        ManagerDataTransfer_TX_FLUSH_DEADLINE_MS，返回前仍等待发出
+     */
+    bool send_frame(PoolVector<uint8_t>& frame, bool rsp = true,
+                    bool flush = true) {
         send_cnd = 0;
         while (send_cnd < SlaveManager_TX_RETRY_TIMES + 1) {
-            if (__send(frame)) {
+            if (__send(frame, flush)) {
                 if (!rsp) {
                     return true;    // 直接返回，不等待从机回复
                 }
@@ -54,18 +76,22 @@ class __ProcessBase {
                 // 发送成功，等待从机回复
                 if (transfer_msg.rx_done_sem.take(SlaveManager_RSP_TIMEOUT) ==
                     false) {
-                    Log.i("SlaveManager",
+                    LOG_I("SlaveManager",
                           "rx_done_sem.take failed, slave no "
                           "response");
 
                 } else if (__rsp_process()) {
-                    Log.i("SlaveManager", "slave response process success");
+                    LOG_I("SlaveManager", "slave response process success");
                     return true;
                 }
 
                 send_cnd++;
+                if (preempt_src && preempt_src->preempt_pending()) {
+                    LOG_W("SlaveManager", "preempted, stop retry");
+                    break;
+                }
                 if (send_cnd < SlaveManager_TX_RETRY_TIMES + 1) {
-                    Log.i("SlaveManager", "send retry %d", send_cnd);
+                    LOG_I("SlaveManager", "send retry %d", send_cnd);
                 }
 
             } else {
@@ -78,22 +104,23 @@ class __ProcessBase {
     }
 
    private:
-    bool __send(std::vector<uint8_t>& frame) {
+    bool __send(PoolVector<uint8_t>& frame, bool flush) {
         // 将发送数据写入队列
         for (auto it = frame.begin(); it != frame.end(); it++) {
             if (transfer_msg.tx_data_queue.add(
                     *it, SlaveManager_TX_QUEUE_TIMEOUT) == false) {
-                Log.e("SlaveManager", "tx_data_queue.add failed");
+                LOG_E("SlaveManager", "tx_data_queue.add failed");
                 return false;
             }
         }
 
         // 请求数据发送
+        transfer_msg.tx_flush = flush;
         transfer_msg.tx_request_sem.give();
 
-        // 等待数据发送完成
+        // 等待帧所在的批次发出
         if (transfer_msg.tx_done_sem.take(SlaveManager_TX_TIMEOUT) == false) {
-            Log.e("SlaveManager", "tx_done_sem.take failed, timeout");
+            LOG_E("SlaveManager", "tx_done_sem.take failed, timeout");
             return false;
         }
         return true;
@@ -113,7 +140,7 @@ class __ProcessBase {
             rsp_data.push_back(data);
         }
         // for (auto it : rsp_data) {
-        //     Log.d("SlaveManager","rx_data: 0x%02X", it);
+        //     LOG_D("SlaveManager","rx_data: 0x%02X", it);
         // }
         // 解析数据
         auto msg = frame_parser.parse(rsp_data);
@@ -122,7 +149,7 @@ class __ProcessBase {
             msg->process();
             process_rsp_data();
         } else {
-            Log.e("SlaveManager", "parse failed");
+            LOG_E("SlaveManager", "parse failed");
         }
         return rsp_parsed;
     }
@@ -149,26 +176,26 @@ class DeviceConfigProcessor : private __ProcessBase {
     bool process(CfgCmd& cfg_cmd, uint8_t timeSlot) {
         bool ret = true;
         if (!__cond_config(cfg_cmd, timeSlot)) {
-            Log.e("SlaveManager", "cond config failed");
+            LOG_E("SlaveManager", "cond config failed");
             ret = false;
         } else {
-            Log.i("SlaveManager", "cond config success");
+            LOG_I("SlaveManager", "cond config success");
         }
 
         // if (cfg_cmd.clip_exist) {
         //     if (!__clip_config(cfg_cmd)) {
-        //         Log.e("SlaveManager","clip config failed");
+        //         LOG_E("SlaveManager","clip config failed");
         //         ret = false;
         //     }
         // } else {
-        //     Log.i("SlaveManager","clip config success");
+        //     LOG_I("SlaveManager","clip config success");
         // }
         return ret;
     }
 
    private:
     bool __cond_config(CfgCmd& cfg_cmd, uint8_t timeSlot) {
-        Log.i("SlaveManager", "cond config start");
+        LOG_I("SlaveManager", "cond config start");
         wirte_cond_info_msg.timeSlot = timeSlot;
 
         // 配置设备检测线数
@@ -198,7 +225,7 @@ class DeviceConfigProcessor : private __ProcessBase {
     }
 
     bool __clip_config(CfgCmd& cfg_cmd) {
-        Log.i("SlaveManager", "clip config start");
+        LOG_I("SlaveManager", "clip config start");
 
         write_clip_info_msg.clipPin = cfg_cmd.clip_pin;
         write_clip_info_msg.mode = cfg_cmd.clip_mode;
@@ -231,7 +258,7 @@ class DeviceModeProcessor : private __ProcessBase {
    public:
     bool process(ModeCmd mode_cmd) {
         mode = mode_cmd.mode;
-        Log.i("SlaveManager", "mode config : %u", mode);
+        LOG_I("SlaveManager", "mode config : %u", mode);
         return true;
     }
 };
@@ -249,11 +276,11 @@ class DeviceCtrlProcessor : private __ProcessBase {
    private:
     Master2Slave::SyncMsg sync_msg;
     CtrlType ctrl = DEV_DISABLE;
-    std::vector<uint8_t> sync_frame;
+    PoolVector<uint8_t> sync_frame;
 
    public:
     bool process(CtrlCmd& ctrl_cmd, SysMode mode) {
-        Log.i("SlaveManager", "ctrl config start");
+        LOG_I("SlaveManager", "ctrl config start");
         sync_msg.mode = mode;
         sync_msg.timestamp = 0;
         ctrl = ctrl_cmd.ctrl;
@@ -282,30 +309,52 @@ class ReadCondProcessor : private __ProcessBase {
     ReadCondProcessor(ManagerDataTransferMsg& __transfer_msg)
         : __ProcessBase(__transfer_msg) {}
     uint32_t deviceID;
+    uint16_t device_status = 0;    // 最近一次回复中的设备状态
+    uint8_t retry_num = 0;         // 最近一次读取的重发次数
+    using __ProcessBase::preempt_src;
    private:
     Master2Slave::ReadCondDataMsg read_cond_data_msg;
     Slave2Backend::CondDataMsg upload_cond_data_msg;
-    std::vector<uint8_t> upload_frame;
+    PoolVector<uint8_t> upload_frame;
 
    public:
-    const std::vector<uint8_t>& get_upload_frame() { return upload_frame; }
+    const PoolVector<uint8_t>& get_upload_frame() { return upload_frame; }
+    // 最近一次成功读取的导通数据
+    const PoolVector<uint8_t>& cond_data() const {
+        return upload_cond_data_msg.conductionData;
+    }
     void process_rsp_data() override {
-        Log.v("ReadCondProcessor 3", "slaveID: %08X", deviceID);
+        LOG_V("ReadCondProcessor 3", "slaveID: %08X", deviceID);
+        // 设备状态在从机回复帧的包头中，重新打包时带上
+        const auto& frame = rsp_frame();
+        size_t pos = FrameHeader::HEADER_SIZE + 5;
+        device_status = 0;
+        if (frame.size() >= pos + 2) {
+            device_status = frame[pos] | (frame[pos + 1] << 8);
+        }
         auto upload_msg =
             PacketPacker::slave2BackendPack(upload_cond_data_msg, deviceID);
+        memcpy(&upload_msg.device_status, &device_status,
+               sizeof(device_status));
         upload_frame = FramePacker::pack(upload_msg);
     }
     bool process(uint32_t id) {
-        Log.i("ReadCondProcessor", "read cond data start");
-        Log.v("ReadCondProcessor 1", "slaveID: %08X", id);
+        LOG_I("ReadCondProcessor", "read cond data start");
+        LOG_V("ReadCondProcessor 1", "slaveID: %08X", id);
         deviceID = id;
-        Log.v("ReadCondProcessor 2", "slaveID: %08X", deviceID);
+        LOG_V("ReadCondProcessor 2", "slaveID: %08X", deviceID);
         // 打包数据
         auto cond_packet =
             PacketPacker::master2SlavePack(read_cond_data_msg, id);
         auto cond_frame = FramePacker::pack(cond_packet);
         expected_rsp_msg_id = (uint8_t)(Slave2BackendMessageID::COND_DATA_MSG);
-        return send_frame(cond_frame);
+        TRACE_BEGIN(READ_COND, id);
+        bool ok = send_frame(cond_frame);
+        TRACE_END(READ_COND, ok);
+        // 失败时最后一次发送不算重发
+        uint8_t lost = lost_num();
+        retry_num = (ok || lost == 0) ? lost : lost - 1;
+        return ok;
     }
 };
 
@@ -320,27 +369,41 @@ class ManagerDataTransfer : public TaskClassS<ManagerDataTransfer_STACK_SIZE> {
 
    private:
     void task() override {
-        Log.i("SlaveDataTransfer_Task", "Boot");
+        LOG_I("SlaveDataTransfer_Task", "Boot");
+        Diag::set_subsystem(Diag::Subsystem::UWB);
 
 #ifdef SLAVE_USE_UWB
         UWB<UwbUartInterface> uwb;
-        std::vector<uint8_t> buffer = {1, 2, 3, 4, 5};
+        UwbAggregator<UWB<UwbUartInterface>> aggregator(
+            uwb, ManagerDataTransfer_TX_FLUSH_DEADLINE_MS);
+        PoolVector<uint8_t> buffer = {1, 2, 3, 4, 5};
         uint8_t data = 0;
-        std::vector<uint8_t> rx;
-        uwb.set_recv_mode();
+        PoolVector<uint8_t> rx;
+        // 已入队、所在批次尚未发出的帧，发出后才通知发送完成
+        bool tx_pending = false;
+        // 接收模式由UWB层维护，发送后在update中重新进入
+        uwb.keep_recv_mode();
         for (;;) {
-            if (transfer_msg.tx_request_sem.take(0)) {
+            // 有发送请求时立即处理，否则每5ms轮询一次接收
+            if (transfer_msg.tx_request_sem.take(5)) {
                 buffer.reserve(transfer_msg.tx_data_queue.waiting());
                 buffer.clear();
                 while (transfer_msg.tx_data_queue.pop(data, 0)) {
                     buffer.push_back(data);
                 }
-                uwb.data_transmit(buffer);
+                if (!aggregator.push(buffer.data(), buffer.size(),
+                                     transfer_msg.tx_flush)) {
+                    LOG_E("SlaveDataTransfer_Task", "uwb transmit failed");
+                }
+                tx_pending = true;
+            }
+            aggregator.update();
+            if (tx_pending && !aggregator.pending()) {
+                tx_pending = false;
                 transfer_msg.tx_done_sem.give();
-                uwb.set_recv_mode();
             }
 
-            if (uwb.get_recv_data(buffer)) {
+            while (aggregator.pop(buffer)) {
                 for (auto it = buffer.begin(); it != buffer.end(); it++) {
                     transfer_msg.rx_data_queue.add(*it);
                 }
@@ -348,7 +411,6 @@ class ManagerDataTransfer : public TaskClassS<ManagerDataTransfer_STACK_SIZE> {
             }
 
             uwb.update();
-            TaskBase::delay(5);
         }
 
 #else
@@ -358,7 +420,7 @@ class ManagerDataTransfer : public TaskClassS<ManagerDataTransfer_STACK_SIZE> {
         UartConfig slave_com_cfg(slave_com_info, true);
         Uart slave_com(slave_com_cfg);
         taskEXIT_CRITICAL();
-        std::vector<uint8_t> rx_data;
+        PoolVector<uint8_t> rx_data;
         uint8_t data;
         for (;;) {
             if (transfer_msg.tx_request_sem.take(0)) {
@@ -402,7 +464,9 @@ class SlaveManager : public TaskClassS<SlaveManager_STACK_SIZE> {
           ctrl_processor(__manager_transfer_msg),
           read_cond_processor(__manager_transfer_msg),
           sync_timer("sync_timer", this, &SlaveManager::sync_timer_callback,
-                     pdMS_TO_TICKS(500), pdTRUE) {}
+                     pdMS_TO_TICKS(500), pdTRUE) {
+        read_cond_processor.preempt_src = &pc_manager_msg.cmd_table;
+    }
 
    private:
     enum CfgState : uint8_t {
@@ -426,6 +490,11 @@ class SlaveManager : public TaskClassS<SlaveManager_STACK_SIZE> {
     CfgState cfg_state = CONGIG_START;
     bool wait_for_data = false;
 
+    // 正在逐步执行的普通指令
+    uint8_t active_slot = CmdTable::NONE;
+    uint16_t active_step = 0;
+    uint16_t active_step_num = 0;
+
     FreeRTOScpp::TimerMember<SlaveManager> sync_timer;
     BinarySemaphore sync_sem;
 
@@ -438,18 +507,23 @@ class SlaveManager : public TaskClassS<SlaveManager_STACK_SIZE> {
         }
         return 1000;
     }
-    void sync_timer_callback() { sync_sem.give(); }
-    void config_process() {
+    void sync_timer_callback() {
+        TRACE_MARK(SYNC_TIMER, 0);
+        sync_sem.give();
+    }
+    bool config_process() {
         bool ret = true;
         SlaveDev dev;
         switch (cfg_state) {
             case CONGIG_START: {
-                Log.i("SlaveManager", "config process start");
+                LOG_I("SlaveManager", "config process start");
                 timeSlot = 0;
                 slave_dev_index = 0;
                 slave_num = forward_data.cfg_cmd.slave_dev_num;
                 slave_dev.clear();
                 slave_dev.reserve(forward_data.cfg_cmd.slave_dev_num);
+                pc_manager_msg.result_cache.reset(
+                    forward_data.cfg_cmd.totalHarnessNum);
                 ret = cfg_processor.process(forward_data.cfg_cmd, timeSlot);
                 break;
             }
@@ -463,50 +537,45 @@ class SlaveManager : public TaskClassS<SlaveManager_STACK_SIZE> {
         memcpy(dev._ID.id, forward_data.cfg_cmd.id, 4);
         dev.timeSlot = timeSlot;
         slave_dev.push_back(dev);
+        if (!pc_manager_msg.result_cache.add(dev._ID.id32,
+                                             forward_data.cfg_cmd.cond)) {
+            LOG_W("SlaveManager", "result cache full, 0x%08X not cached",
+                  dev._ID.id32);
+        }
         timeSlot++;
         slave_dev_index++;
         if (slave_dev_index >= forward_data.cfg_cmd.slave_dev_num) {
             // 所有从机配置完成
             cfg_state = CONGIG_START;
-            Log.i("SlaveManager", "config process done, device num: %u",
+            LOG_I("SlaveManager", "config process done, device num: %u",
                   forward_data.cfg_cmd.slave_dev_num);
         } else {
             cfg_state = CONFIG_PROCESSING;
         }
 
-        if (ret) {
-            // 配置成功
-            pc_manager_msg.event.set(CONFIG_SUCCESS_EVENT);
-        } else {
-            // 配置失败
-            pc_manager_msg.event.clear(CONFIG_SUCCESS_EVENT);
-        }
+        return ret;
     }
-    void ctrl_process() {
-        if (ctrl_processor.process(forward_data.ctrl_cmd,
-                                   mode_processor.mode)) {
-            pc_manager_msg.event.set(CTRL_SUCCESS_EVENT);
-        } else {
-            pc_manager_msg.event.clear(CTRL_SUCCESS_EVENT);
-        }
+    bool ctrl_process() {
+        bool ret = ctrl_processor.process(forward_data.ctrl_cmd,
+                                          mode_processor.mode);
         if (ctrl_processor.state() == DEV_ENABLE) {
             // 启动检测
             if (slave_num > 0) {
                 if (running == false) {
                     running = true;
                     TickType_t period = get_timer_period();
-                    Log.i("SlaveManager", "total cond num: %u",
+                    LOG_I("SlaveManager", "total cond num: %u",
                           cfg_processor.totalConductionNum());
-                    Log.i("SlaveManager", "interval: %u",
+                    LOG_I("SlaveManager", "interval: %u",
                           CONDUCTION_TEST_INTERVAL);
-                    Log.i("SlaveManager", "sync timer period: %u", period);
+                    LOG_I("SlaveManager", "sync timer period: %u", period);
                     slave_dev_index = 0;
                     wait_for_data = false;
                     sync_sem.give();
                     sync_timer.period(period);
                 }
             } else {
-                Log.e("SlaveManager",
+                LOG_E("SlaveManager",
                       "have not config. slave "
                       "num is 0, discard "
                       "ctrl data");
@@ -517,101 +586,120 @@ class SlaveManager : public TaskClassS<SlaveManager_STACK_SIZE> {
             running = false;
             sync_timer.stop();
         }
+        return ret;
     }
     void read_cond_data_process() {
+        ResultCache& cache = pc_manager_msg.result_cache;
+        cache.begin_cycle();
+        TRACE_BEGIN(READ_CYCLE, slave_dev.size());
+        uint32_t ok_num = 0;
         for (auto it = slave_dev.begin(); it != slave_dev.end(); it++) {
-            if (read_cond_processor.process(it->_ID.id32)) {
-                Log.i("SlaveManager", "read cond data success");
-                if (pc_manager_msg.upload_data.get_write_access(
-                        PC_TX_SHARE_MEM_ACCESS_TIMEOUT)) {
-                    // 共享资源上锁，禁止外部读写
-                    // pc_manager_msg.upload_data.lock();
-                    /* ---------------------<上报数据>---------------------*/
-                    // upload_cond_data_frame.pack(
-                    //     pc_manager_msg.upload_data.get(),
-                    //     read_cond_processor.get_data_msg(),
-                    //     it->id);
-                    pc_manager_msg.upload_data.write(
-                        read_cond_processor.get_upload_frame().data(),
-                        read_cond_processor.get_upload_frame().size(),
-                        PC_TX_TIMEOUT);
-                    // 共享资源解锁，允许读取数据
-                    // pc_manager_msg.upload_data.unlock();
-
-                    // 发送数据给上位机，释放发送请求信号量
-                    pc_manager_msg.upload_request_sem.give();
-
-                    // 等待发送完成
-                    if (!pc_manager_msg.upload_done_sem.take(
-                            SlaveManager_UPLOAD_TIMEOUT)) {
-                        Log.e("SlaveManager",
-                              ""
-                              "upload_done_sem.take "
-                              "failed");
-                    }
-                    // 释放写访问权限
-                    pc_manager_msg.upload_data.release_write_access();
+            if (pc_manager_msg.cmd_table.preempt_pending()) {
+                LOG_W("SlaveManager", "read cycle preempted");
+                break;
+            }
+            if (!read_cond_processor.process(it->_ID.id32)) {
+                cache.fail(it->_ID.id32, read_cond_processor.retry_num);
+            } else {
+                LOG_I("SlaveManager", "read cond data success");
+                ok_num++;
+                cache.update(it->_ID.id32, read_cond_processor.device_status,
+                             read_cond_processor.cond_data(),
+                             read_cond_processor.retry_num);
+                /* ---------------------<上报数据>---------------------*/
+                // 分配序号后入队即返回，由上位机数据发送任务发出
+                if (!pc_manager_msg.result_stream.publish(
+                        read_cond_processor.get_upload_frame(),
+                        SlaveManager_UPLOAD_TIMEOUT)) {
+                    LOG_E("SlaveManager", "result_stream.publish failed");
                 }
             }
         }
+        TRACE_END(READ_CYCLE, ok_num);
     }
-    void task() override {
-        Log.i("SlaveManager_Task", "Boot");
+    // 执行指令的一步，返回是否成功
+    bool execute() {
+        bool ok = false;
+        switch ((uint8_t)forward_data.type) {
+            case CmdType::DEV_CONF: {
+                // LOG_I("SlaveManager","Config data received");
+                if (!running) {
+                    ok = config_process();
+                } else {
+                    LOG_E("SlaveManager",
+                          "Device is running, discard "
+                          "config data");
+                }
 
-        // sync_timer.period()
-        for (;;) {
-            // 从pc_manager_msg中获取数据
-            while (pc_manager_msg.data_forward_queue.pop(forward_data, 0) ==
-                   pdPASS) {
-                switch ((uint8_t)forward_data.type) {
-                    case CmdType::DEV_CONF: {
-                        // Log.i("SlaveManager","Config data received");
-                        if (!running) {
-                            config_process();
-                        } else {
-                            Log.e("SlaveManager",
-                                  "Device is running, discard "
-                                  "config data");
-                        }
+                break;
+            }
+            case (uint8_t)CmdType::DEV_MODE: {
+                // LOG_I("SlaveManager","Mode data received");
+                if (!running) {
+                    ok = mode_processor.process(forward_data.mode_cmd);
+                } else {
+                    LOG_E("SlaveManager",
+                          "Device is running, discard "
+                          "mode "
+                          "data");
+                }
 
-                        break;
-                    }
-                    case (uint8_t)CmdType::DEV_MODE: {
-                        // Log.i("SlaveManager","Mode data received");
-                        if (!running) {
-                            if (mode_processor.process(forward_data.mode_cmd)) {
-                                pc_manager_msg.event.set(MODE_SUCCESS_EVENT);
-                            } else {
-                                pc_manager_msg.event.clear(MODE_SUCCESS_EVENT);
-                            }
-                        } else {
-                            Log.e("SlaveManager",
-                                  "Device is running, discard "
-                                  "mode "
-                                  "data");
-                        }
+                break;
+            }
+            case (uint8_t)CmdType::DEV_RESET: {
+                // LOG_I("SlaveManager","Reset data received");
+                break;
+            }
+            case (uint8_t)CmdType::DEV_CTRL: {
+                ok = ctrl_process();
+                // LOG_I("SlaveManager","Ctrl data received");
 
-                        break;
-                    }
-                    case (uint8_t)CmdType::DEV_RESET: {
-                        // Log.i("SlaveManager","Reset data received");
-                        break;
-                    }
-                    case (uint8_t)CmdType::DEV_CTRL: {
-                        ctrl_process();
-                        // Log.i("SlaveManager","Ctrl data received");
+                break;
+            }
+            case (uint8_t)CmdType::DEV_QUERY: {
+                // 查询由解析任务直接从结果缓存应答，不再转发到这里
+                break;
+            }
+            default:
+                break;
+        }
+        return ok;
+    }
 
-                        break;
-                    }
-                    case (uint8_t)CmdType::DEV_QUERY: {
-                        // Log.i("SlaveManager","Query data received");
-                        break;
-                    }
-                    default:
-                        break;
-                }
-                pc_manager_msg.event.set(FORWARD_SUCCESS_EVENT);
+    // 从指令表取指令执行：紧急指令全部执行，普通指令每轮执行一步，
+    // 使紧急指令可以插在多从机配置的两步之间
+    void cmd_process() {
+        CmdTable& table = pc_manager_msg.cmd_table;
+        uint8_t slot;
+        while (table.pop_urgent(slot)) {
+            uint16_t step_num = table.step_num(slot);
+            for (uint16_t i = 0; i < step_num; i++) {
+                forward_data = table.step(slot, i);
+                table.done(slot, execute());
+            }
+        }
+
+        if (active_slot == CmdTable::NONE && table.pop(active_slot)) {
+            active_step = 0;
+            active_step_num = table.step_num(active_slot);
+        }
+        if (active_slot != CmdTable::NONE) {
+            forward_data = table.step(active_slot, active_step++);
+            uint8_t slot = active_slot;
+            if (active_step >= active_step_num) {
+                active_slot = CmdTable::NONE;
             }
+            table.done(slot, execute());
+        }
+    }
+
+    void task() override {
+        LOG_I("SlaveManager_Task", "Boot");
+        Diag::set_subsystem(Diag::Subsystem::PROTOCOL);
+
+        // sync_timer.period()
+        for (;;) {
+            cmd_process();
 
             if (ctrl_processor.state() == DEV_ENABLE) {
                 if (sync_sem.take(0)) {
@@ -619,16 +707,16 @@ class SlaveManager : public TaskClassS<SlaveManager_STACK_SIZE> {
                         sync_timer.stop();
                         switch (mode_processor.mode) {
                             case CONDUCTION_TEST: {
-                                Log.i("SlaveManager", "cond data read start");
+                                LOG_I("SlaveManager", "cond data read start");
                                 read_cond_data_process();
                                 break;
                             }
                             case CLIP_TEST: {
-                                Log.i("SlaveManager", "clip data read start");
+                                LOG_I("SlaveManager", "clip data read start");
                                 break;
                             }
                             case IMPEDANCE_TEST: {
-                                Log.i("SlaveManager",
+                                LOG_I("SlaveManager",
                                       "impedance data read "
                                       "start");
                             }
@@ -639,12 +727,17 @@ class SlaveManager : public TaskClassS<SlaveManager_STACK_SIZE> {
                     }
                     if (wait_for_data == false) {
                         wait_for_data = true;
-                        ctrl_processor.send_sync_frame();
+                        TRACE_BEGIN(SYNC_SEND, 0);
+                        bool sent = ctrl_processor.send_sync_frame();
+                        TRACE_END(SYNC_SEND, sent);
                         sync_timer.start();
                     }
                 }
             }
-            TaskBase::delay(5);
+            // 多步指令未执行完时不休眠
+            if (active_slot == CmdTable::NONE) {
+                TaskBase::delay(5);
+            }
         }
     }
 };
@@ -0,0 +1,88 @@
+#ifndef UWB_BENCH_TASK_HPP
+#define UWB_BENCH_TASK_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+#include "TaskCPP.h"
+#include "bsp_log.hpp"
+#ifdef HOST_SIM
+#include "host_net.hpp"
+#else
+#include "lwip/sockets.h"
+#endif
+#include "master_cfg.hpp"
+#include "netcfg.h"
+#include "uwb.hpp"
+#include "uwb_bench.hpp"
+#include "uwb_interface.hpp"
+
+extern Logger Log;
+
+/**
+ * @brief UWB链路基准测试发起端，按负载长度和发包间隔扫描，
+ *        每个测试点的结果以一行CSV通过UDP上报给上位机
+ */
+class UwbBenchTask : public TaskClassS<UwbBenchTask_STACK_SIZE> {
+   public:
+    UwbBenchTask() : TaskClassS("UwbBenchTask", TaskPrio_High) {}
+
+   private:
+    static constexpr const char TAG[] = "UwbBench";
+    int sockfd = -1;
+    struct sockaddr_in rmt_addr;
+
+    void report_init() {
+        ip_addr_t ipaddr;
+        IP4_ADDR(&ipaddr, IP_S_ADDR0, IP_S_ADDR1, IP_S_ADDR2, IP_S_ADDR3);
+        rmt_addr.sin_family = AF_INET;
+        rmt_addr.sin_port = htons(UwbBenchTask_REPORT_PORT);
+        rmt_addr.sin_addr.s_addr = ipaddr.addr;
+        sockfd = lwip_socket(AF_INET, SOCK_DGRAM, 0);
+        if (sockfd < 0) {
+            LOG_E(TAG, "report socket create failed");
+        }
+    }
+
+    void report(const UwbBenchResult& r) {
+        char line[160];
+        int len = snprintf(
+            line, sizeof(line),
+            "uwb_bench,%u,%u,%u,%u,%u,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+            r.payload_size, r.gap_ms, r.sent, r.received, r.lost, r.reordered,
+            (unsigned long)r.rtt_p50, (unsigned long)r.rtt_p99,
+            (unsigned long)r.rtt_max, (unsigned long)r.oneway_p50,
+            (unsigned long)r.oneway_p99, (unsigned long)r.oneway_max,
+            (unsigned long)r.goodput_Bps, (unsigned long)r.elapsed_ms);
+        LOG_I(TAG,
+              "size=%u gap=%ums sent=%u recv=%u lost=%u reorder=%u "
+              "rtt p50/p99/max=%lu/%lu/%lums goodput=%luB/s",
+              r.payload_size, r.gap_ms, r.sent, r.received, r.lost,
+              r.reordered, (unsigned long)r.rtt_p50, (unsigned long)r.rtt_p99,
+              (unsigned long)r.rtt_max, (unsigned long)r.goodput_Bps);
+        if (sockfd >= 0 && len > 0) {
+            lwip_sendto(sockfd, line, len, 0, (struct sockaddr*)&rmt_addr,
+                        sizeof(rmt_addr));
+        }
+    }
+
+    void task() override {
+        LOG_I(TAG, "Boot");
+        static const uint16_t sizes[] = UwbBenchTask_PAYLOAD_SIZES;
+        static const uint16_t gaps[] = UwbBenchTask_GAPS_MS;
+
+        report_init();
+        UWB<UwbUartInterface> uwb;
+        uwb.keep_recv_mode();
+        UwbBench<UWB<UwbUartInterface>> bench(uwb);
+        for (;;) {
+            bench.sweep(sizes, sizeof(sizes) / sizeof(sizes[0]), gaps,
+                        sizeof(gaps) / sizeof(gaps[0]),
+                        UwbBenchTask_PACKET_NUM,
+                        [this](const UwbBenchResult& r) { report(r); });
+            TaskBase::delay(UwbBenchTask_SWEEP_INTERVAL_MS);
+        }
+    }
+};
+
+#endif
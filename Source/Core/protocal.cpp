@@ -60,6 +60,18 @@ std::vector<Backend2Master::RstMsg::SlaveResetConfig>
 
 uint8_t Backend2Master::CtrlMsg::runningStatus = 0;
 
+std::vector<uint32_t> Backend2Master::NackMsg::seqs;
+
+uint16_t Backend2Master::RequestMsg::reqId = 0;
+PoolVector<uint8_t> Backend2Master::RequestMsg::packet;
+
+std::vector<uint32_t> Backend2Master::QueryMsg::ids;
+uint16_t Backend2Master::QueryMsg::pinStart = 0;
+uint16_t Backend2Master::QueryMsg::pinNum = 0;
+uint8_t Backend2Master::DiagMsg::sections = 0xFF;
+uint8_t Backend2Master::TraceMsg::cmd = 0;
+uint16_t Backend2Master::TraceMsg::start = 0;
+
 // Master2Backend 命名空间静态变量初始化
 uint8_t Master2Backend::SlaveCfgMsg::status = 0;
 uint8_t Master2Backend::SlaveCfgMsg::slaveNum = 0;
@@ -77,11 +89,29 @@ std::vector<Master2Backend::RstMsg::SlaveResetConfig>
 uint8_t Master2Backend::CtrlMsg::status = 0;
 uint8_t Master2Backend::CtrlMsg::runningStatus = 0;
 
+uint32_t Master2Backend::NackMsg::nextSeq = 0;
+std::vector<uint32_t> Master2Backend::NackMsg::lostSeqs;
+
+uint32_t Master2Backend::ResultStreamMsg::seq = 0;
+uint8_t Master2Backend::ResultStreamMsg::flags = 0;
+PoolVector<uint8_t> Master2Backend::ResultStreamMsg::frame;
+
+uint16_t Master2Backend::ResponseMsg::reqId = 0;
+PoolVector<uint8_t> Master2Backend::ResponseMsg::packet;
+
+uint32_t Master2Backend::QueryMsg::cycle = 0;
+uint8_t Master2Backend::QueryMsg::matchNum = 0;
+std::vector<Master2Backend::QueryMsg::SlaveResult>
+    Master2Backend::QueryMsg::slaves;
+PoolVector<uint8_t> Master2Backend::DiagMsg::snapshot;
+PoolVector<uint8_t> Master2Backend::TraceMsg::dump;
+
 // Slave2Backend 命名空间静态变量初始化
 uint16_t Slave2Backend::CondDataMsg::conductionLength = 0;
-std::vector<uint8_t> Slave2Backend::CondDataMsg::conductionData;
+PoolVector<uint8_t> Slave2Backend::CondDataMsg::conductionData;
+PoolVector<uint8_t> Slave2Backend::CondDataMsg::diagData;
 
 uint16_t Slave2Backend::ResDataMsg::resistanceLength = 0;
-std::vector<uint8_t> Slave2Backend::ResDataMsg::resistanceData;
+PoolVector<uint8_t> Slave2Backend::ResDataMsg::resistanceData;
 
 uint16_t Slave2Backend::ClipDataMsg::clipData = 0;
\ No newline at end of file
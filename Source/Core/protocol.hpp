@@ -21,11 +21,13 @@
  */
 #ifndef __PROTOCOL_HPP
 #define __PROTOCOL_HPP
+#include <algorithm>
 #include <cstdint>
 #include <cstdio>
 #include <memory>
 #include <vector>
 
+#include "bsp_allocate.hpp"
 #include "bsp_log.hpp"
 #include "bsp_uid.hpp"
 
@@ -61,7 +63,12 @@ enum class Backend2MasterMessageID : uint8_t {
     SLAVE_CFG_MSG = 0x00,
     MODE_CFG_MSG = 0x01,
     RST_MSG = 0x02,
-    CTRL_MSG = 0x03
+    CTRL_MSG = 0x03,
+    NACK_MSG = 0x04,       // 结果流重传请求
+    REQUEST_MSG = 0x05,    // 带请求号的指令
+    QUERY_MSG = 0x06,      // 查询主机缓存的最新结果
+    DIAG_MSG = 0x07,       // 查询主机运行诊断
+    TRACE_MSG = 0x08       // 导出主机事件跟踪
 };
 
 enum class Master2BackendMessageID : uint8_t {
@@ -69,9 +76,15 @@ enum class Master2BackendMessageID : uint8_t {
     MODE_CFG_MSG = 0x01,
     RST_MSG = 0x02,
     CTRL_MSG = 0x03,
+    NACK_MSG = 0x04,               // 结果流重传应答
+    RESPONSE_MSG = 0x05,           // 带请求号的应答
+    QUERY_MSG = 0x06,              // 缓存结果查询应答
+    DIAG_MSG = 0x07,               // 运行诊断应答
+    TRACE_MSG = 0x08,              // 事件跟踪导出应答
     CONDUCTION_DATA_MSG = 0x10,    // 导通数据
     RESISTANCE_DATA_MSG = 0x11,    // 阻值数据
-    CLIPPING_DATA_MSG = 0x12       // 卡钉数据
+    CLIPPING_DATA_MSG = 0x12,      // 卡钉数据
+    RESULT_STREAM_MSG = 0x20       // 带序号的结果流
 };
 
 enum class Slave2BackendMessageID : uint8_t {
@@ -82,14 +95,24 @@ enum class Slave2BackendMessageID : uint8_t {
 
 namespace ProtocolUtils {
 
-inline void serializeUint32(std::vector<uint8_t>& data, uint32_t value) {
+inline void serializeUint16(PoolVector<uint8_t>& data, uint16_t value) {
+    data.push_back(static_cast<uint8_t>(value));
+    data.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+inline uint16_t deserializeUint16(const PoolVector<uint8_t>& data,
+                                  size_t offset = 0) {
+    return static_cast<uint16_t>(data[offset] | (data[offset + 1] << 8));
+}
+
+inline void serializeUint32(PoolVector<uint8_t>& data, uint32_t value) {
     data.push_back(static_cast<uint8_t>(value));
     data.push_back(static_cast<uint8_t>(value >> 8));
     data.push_back(static_cast<uint8_t>(value >> 16));
     data.push_back(static_cast<uint8_t>(value >> 24));
 }
 
-inline uint32_t deserializeUint32(const std::vector<uint8_t>& data,
+inline uint32_t deserializeUint32(const PoolVector<uint8_t>& data,
                                   size_t offset = 0) {
     return static_cast<uint32_t>(data[offset]) |
            (static_cast<uint32_t>(data[offset + 1]) << 8) |
@@ -101,8 +124,8 @@ inline uint32_t deserializeUint32(const std::vector<uint8_t>& data,
 class FrameBase {
    public:
     virtual ~FrameBase() = default;
-    virtual std::vector<uint8_t> serialize() const = 0;
-    virtual void deserialize(const std::vector<uint8_t>& data) = 0;
+    virtual PoolVector<uint8_t> serialize() const = 0;
+    virtual void deserialize(const PoolVector<uint8_t>& data) = 0;
     virtual bool validate() const { return true; }    // 可扩展校验逻辑
 };
 
@@ -118,8 +141,8 @@ struct FrameHeader {
     uint16_t data_length;           // 数据负载长度
 
     // 序列化为字节流
-    std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> data;
+    PoolVector<uint8_t> serialize() const {
+        PoolVector<uint8_t> data;
         data.reserve(HEADER_SIZE);
         data.push_back(FRAME_DELIMITER[0]);
         data.push_back(FRAME_DELIMITER[1]);
@@ -131,15 +154,15 @@ struct FrameHeader {
         return data;
     }
 
-    bool deserialize(const std::vector<uint8_t>& data) {
+    bool deserialize(const PoolVector<uint8_t>& data) {
         if (data.size() < HEADER_SIZE) {
-            Log.e(TAG, "Invalid frame header data size");
+            LOG_E(TAG, "Invalid frame header data size");
             return false;
         }
 
         // 验证帧分隔符
         if (data[0] != FRAME_DELIMITER[0] || data[1] != FRAME_DELIMITER[1]) {
-            Log.e(TAG, "Invalid frame delimiter");
+            LOG_E(TAG, "Invalid frame delimiter");
             return false;
         }
 
@@ -155,8 +178,8 @@ struct FrameHeader {
 class Message {
    public:
     virtual ~Message() = default;
-    virtual void serialize(std::vector<uint8_t>& data) const = 0;
-    virtual void deserialize(const std::vector<uint8_t>& data) = 0;
+    virtual void serialize(PoolVector<uint8_t>& data) const = 0;
+    virtual void deserialize(const PoolVector<uint8_t>& data) = 0;
     virtual void process() = 0;
     // 消息类型标识
     virtual uint8_t message_type() const = 0;
@@ -166,11 +189,11 @@ struct Master2SlavePacket {
     static constexpr const char TAG[] = "Master2SlavePacket";
     uint8_t message_id;              // 消息类型标识
     uint32_t destination_id;         // 目标设备 ID
-    std::vector<uint8_t> payload;    // 消息的序列化数据
+    PoolVector<uint8_t> payload;    // 消息的序列化数据
 
     // 序列化 Master2SlavePacket
-    std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> data;
+    PoolVector<uint8_t> serialize() const {
+        PoolVector<uint8_t> data;
         data.reserve(5 + payload.size());    // 1 + 4 + payload size
         data.push_back(message_id);
         ProtocolUtils::serializeUint32(data, destination_id);
@@ -179,9 +202,9 @@ struct Master2SlavePacket {
     }
 
     // 反序列化 Master2SlavePacket
-    bool deserialize(const std::vector<uint8_t>& data) {
+    bool deserialize(const PoolVector<uint8_t>& data) {
         if (data.size() < 5) {
-            Log.e(TAG, "data too short");
+            LOG_E(TAG, "data too short");
             return false;
         }
         message_id = data[0];
@@ -195,11 +218,11 @@ struct Slave2MasterPacket {
     static constexpr const char TAG[] = "Slave2MasterPacket";
     uint8_t message_id;              // 消息类型标识
     uint32_t source_id;              // 目标设备 ID
-    std::vector<uint8_t> payload;    // 消息的序列化数据
+    PoolVector<uint8_t> payload;    // 消息的序列化数据
 
     // 序列化 Master2SlavePacket
-    std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> data;
+    PoolVector<uint8_t> serialize() const {
+        PoolVector<uint8_t> data;
         data.reserve(5 + payload.size());    // 1 + 4 + payload size
         data.push_back(message_id);
         ProtocolUtils::serializeUint32(data, source_id);
@@ -208,9 +231,9 @@ struct Slave2MasterPacket {
     }
 
     // 反序列化 Master2SlavePacket
-    bool deserialize(const std::vector<uint8_t>& data) {
+    bool deserialize(const PoolVector<uint8_t>& data) {
         if (data.size() < 5) {
-            Log.e(TAG, "data too short");
+            LOG_E(TAG, "data too short");
             return false;
         }
         message_id = data[0];
@@ -223,11 +246,11 @@ struct Slave2MasterPacket {
 struct Backend2MasterPacket {
     static constexpr const char TAG[] = "Backend2MasterPacket";
     uint8_t message_id;              // 消息类型标识
-    std::vector<uint8_t> payload;    // 消息的序列化数据
+    PoolVector<uint8_t> payload;    // 消息的序列化数据
 
     // 序列化 Backend2MasterPacket
-    std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> data;
+    PoolVector<uint8_t> serialize() const {
+        PoolVector<uint8_t> data;
         data.reserve(1 + payload.size());    // 1 + payload size
         data.push_back(message_id);
         data.insert(data.end(), payload.begin(), payload.end());
@@ -235,9 +258,9 @@ struct Backend2MasterPacket {
     }
 
     // 反序列化 Backend2MasterPacket
-    bool deserialize(const std::vector<uint8_t>& data) {
+    bool deserialize(const PoolVector<uint8_t>& data) {
         if (data.size() < 1) {
-            Log.e(TAG, "data too short");
+            LOG_E(TAG, "data too short");
             return false;
         }
         message_id = data[0];
@@ -249,11 +272,11 @@ struct Backend2MasterPacket {
 struct Master2BackendPacket {
     static constexpr const char TAG[] = "Master2BackendPacket";
     uint8_t message_id;              // 消息类型标识
-    std::vector<uint8_t> payload;    // 消息的序列化数据
+    PoolVector<uint8_t> payload;    // 消息的序列化数据
 
     // 序列化 Master2BackendPacket
-    std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> data;
+    PoolVector<uint8_t> serialize() const {
+        PoolVector<uint8_t> data;
         data.reserve(1 + payload.size());    // 1 + payload size
         // 序列化消息ID
         data.push_back(message_id);
@@ -263,9 +286,9 @@ struct Master2BackendPacket {
     }
 
     // 反序列化 Master2BackendPacket
-    bool deserialize(const std::vector<uint8_t>& data) {
+    bool deserialize(const PoolVector<uint8_t>& data) {
         if (data.size() < 1) {
-            Log.e(TAG, "data too short");
+            LOG_E(TAG, "data too short");
             return false;
         }
         // 反序列化消息ID
@@ -292,11 +315,11 @@ struct Slave2BackendPacket {
     uint8_t message_id;              // 消息类型标识
     uint32_t slave_id;               // 新增: 本机ID (4字节)
     DeviceStatus device_status;      // 设备状态(2字节)
-    std::vector<uint8_t> payload;    // 消息的序列化数据
+    PoolVector<uint8_t> payload;    // 消息的序列化数据
 
     // 序列化 Slave2BackendPacket
-    std::vector<uint8_t> serialize() const {
-        std::vector<uint8_t> data;
+    PoolVector<uint8_t> serialize() const {
+        PoolVector<uint8_t> data;
         data.reserve(7 + payload.size());    // 1 + 4 + 2 + payload size
 
         // 序列化消息ID
@@ -316,9 +339,9 @@ struct Slave2BackendPacket {
     }
 
     // 反序列化 Slave2BackendPacket
-    bool deserialize(const std::vector<uint8_t>& data) {
+    bool deserialize(const PoolVector<uint8_t>& data) {
         if (data.size() < 7) {
-            Log.e(TAG, "data too short");
+            LOG_E(TAG, "data too short");
             return false;
         }
 
@@ -386,11 +409,11 @@ class PacketPacker {
 class FramePacker {
    public:
     // 将 Master2SlavePacket 打包为帧
-    static std::vector<uint8_t> pack(const Master2SlavePacket& packet,
+    static PoolVector<uint8_t> pack(const Master2SlavePacket& packet,
                                      uint8_t slot = 0, uint8_t fragment_seq = 0,
                                      uint8_t more_fragments = 0) {
         // 序列化 Master2SlavePacket
-        std::vector<uint8_t> packet_data = packet.serialize();
+        PoolVector<uint8_t> packet_data = packet.serialize();
 
         // 构建帧头
         FrameHeader header;
@@ -400,17 +423,17 @@ class FramePacker {
         header.data_length = static_cast<uint16_t>(packet_data.size());
 
         // 合并帧头和 Master2SlavePacket 数据
-        std::vector<uint8_t> frame = header.serialize();
+        PoolVector<uint8_t> frame = header.serialize();
         frame.insert(frame.end(), packet_data.begin(), packet_data.end());
         return frame;
     }
 
     // 将 Slave2MasterPacket 打包为帧
-    static std::vector<uint8_t> pack(const Slave2MasterPacket& packet,
+    static PoolVector<uint8_t> pack(const Slave2MasterPacket& packet,
                                      uint8_t slot = 0, uint8_t fragment_seq = 0,
                                      uint8_t more_fragments = 0) {
         // 序列化 Slave2MasterPacket
-        std::vector<uint8_t> packet_data = packet.serialize();
+        PoolVector<uint8_t> packet_data = packet.serialize();
 
         // 构建帧头
         FrameHeader header;
@@ -420,15 +443,15 @@ class FramePacker {
         header.data_length = static_cast<uint16_t>(packet_data.size());
 
         // 合并帧头和 Master2SlavePacket 数据
-        std::vector<uint8_t> frame = header.serialize();
+        PoolVector<uint8_t> frame = header.serialize();
         frame.insert(frame.end(), packet_data.begin(), packet_data.end());
         return frame;
     }
 
-    static std::vector<uint8_t> pack(const Backend2MasterPacket& packet,
+    static PoolVector<uint8_t> pack(const Backend2MasterPacket& packet,
                                      uint8_t slot = 0, uint8_t fragment_seq = 0,
                                      uint8_t more_fragments = 0) {
-        std::vector<uint8_t> packet_data = packet.serialize();
+        PoolVector<uint8_t> packet_data = packet.serialize();
 
         // 构建帧头
         FrameHeader header;
@@ -438,15 +461,15 @@ class FramePacker {
         header.data_length = static_cast<uint16_t>(packet_data.size());
 
         // 合并帧头和 Master2SlavePacket 数据
-        std::vector<uint8_t> frame = header.serialize();
+        PoolVector<uint8_t> frame = header.serialize();
         frame.insert(frame.end(), packet_data.begin(), packet_data.end());
         return frame;
     }
 
-    static std::vector<uint8_t> pack(const Master2BackendPacket& packet,
+    static PoolVector<uint8_t> pack(const Master2BackendPacket& packet,
                                      uint8_t slot = 0, uint8_t fragment_seq = 0,
                                      uint8_t more_fragments = 0) {
-        std::vector<uint8_t> packet_data = packet.serialize();
+        PoolVector<uint8_t> packet_data = packet.serialize();
 
         // 构建帧头
         FrameHeader header;
@@ -456,15 +479,15 @@ class FramePacker {
         header.data_length = static_cast<uint16_t>(packet_data.size());
 
         // 合并帧头和 Master2SlavePacket 数据
-        std::vector<uint8_t> frame = header.serialize();
+        PoolVector<uint8_t> frame = header.serialize();
         frame.insert(frame.end(), packet_data.begin(), packet_data.end());
         return frame;
     }
 
-    static std::vector<uint8_t> pack(const Slave2BackendPacket& packet,
+    static PoolVector<uint8_t> pack(const Slave2BackendPacket& packet,
                                      uint8_t slot = 0, uint8_t fragment_seq = 0,
                                      uint8_t more_fragments = 0) {
-        std::vector<uint8_t> packet_data = packet.serialize();
+        PoolVector<uint8_t> packet_data = packet.serialize();
 
         // 构建帧头
         FrameHeader header;
@@ -474,7 +497,7 @@ class FramePacker {
         header.data_length = static_cast<uint16_t>(packet_data.size());
 
         // 合并帧头和 Master2SlavePacket 数据
-        std::vector<uint8_t> frame = header.serialize();
+        PoolVector<uint8_t> frame = header.serialize();
         frame.insert(frame.end(), packet_data.begin(), packet_data.end());
         return frame;
     }
@@ -492,19 +515,19 @@ class SyncMsg : public Message {
         timestamp = ts;
     }
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.clear();    // 清空传入的vector
         data.push_back(mode);
         ProtocolUtils::serializeUint32(data, timestamp);
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 5) {
-            Log.e(TAG, "Invalid SyncMsg data size");
+            LOG_E(TAG, "Invalid SyncMsg data size");
         }
         mode = data[0];
         timestamp = ProtocolUtils::deserializeUint32(data, 1);
-        Log.v(TAG, "mode = 0x%02X, timestamp = 0x%08X", mode, timestamp);
+        LOG_V(TAG, "mode = 0x%02X, timestamp = 0x%08X", mode, timestamp);
     }
 
     void process() override;
@@ -523,7 +546,7 @@ class CondCfgMsg : public Message {
     static uint16_t startConductionNum;    // 起始导通数量
     static uint16_t conductionNum;         // 导通检测数量
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(timeSlot);
         data.push_back(interval);    // 序列化采集间隔
         data.push_back(static_cast<uint8_t>(totalConductionNum));
@@ -534,9 +557,9 @@ class CondCfgMsg : public Message {
         data.push_back(static_cast<uint8_t>(conductionNum >> 8));
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 8) {    // 修改为8字节
-            Log.e(TAG, "Invalid CondCfgMsg data size");
+            LOG_E(TAG, "Invalid CondCfgMsg data size");
             return;
         }
         timeSlot = data[0];
@@ -544,7 +567,7 @@ class CondCfgMsg : public Message {
         totalConductionNum = (data[3] << 8) | data[2];
         startConductionNum = (data[5] << 8) | data[4];
         conductionNum = (data[7] << 8) | data[6];
-        Log.v(TAG,
+        LOG_V(TAG,
               "timeSlot = 0x%02X, interval = 0x%02X, "
               "totalConductionNum "
               "= 0x%04X, startConductionNum = 0x%04X, conductionNum = 0x%04X",
@@ -567,7 +590,7 @@ class ResCfgMsg : public Message {
     static uint16_t startResistanceNum;    // 起始阻值数量
     static uint16_t resistanceNum;         // 阻值检测数量
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(timeSlot);
         data.push_back(interval);    // 序列化采集间隔
         data.push_back(static_cast<uint8_t>(totalResistanceNum));
@@ -578,9 +601,9 @@ class ResCfgMsg : public Message {
         data.push_back(static_cast<uint8_t>(resistanceNum >> 8));
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 8) {    // 修改为8字节
-            Log.e(TAG, "Invalid ResCfgMsg data size");
+            LOG_E(TAG, "Invalid ResCfgMsg data size");
             return;
         }
         timeSlot = data[0];
@@ -588,7 +611,7 @@ class ResCfgMsg : public Message {
         totalResistanceNum = (data[3] << 8) | data[2];
         startResistanceNum = (data[5] << 8) | data[4];
         resistanceNum = (data[7] << 8) | data[6];
-        Log.v(TAG,
+        LOG_V(TAG,
               "timeSlot = 0x%02X, interval = 0x%02X, "
               "totalResistanceNum = 0x%04X, "
               "startResistanceNum = 0x%04X, resistanceNum = 0x%04X",
@@ -611,22 +634,22 @@ class ClipCfgMsg : public Message {
     static uint16_t
         clipPin;    // 16 个卡钉激活信息，激活的位置 1，未激活的位置 0
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(interval);    // 序列化采集间隔
         data.push_back(mode);        // 序列化 mode
         data.push_back(static_cast<uint8_t>(clipPin));    // 低字节在前
         data.push_back(static_cast<uint8_t>(clipPin >> 8));    // 高字节在后
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 4) {    // 修改为4字节
-            Log.e(TAG, "Invalid ClipCfgMsg data size");
+            LOG_E(TAG, "Invalid ClipCfgMsg data size");
             return;
         }
         interval = data[0];                    // 反序列化采集间隔
         mode = data[1];                        // 反序列化 mode
         clipPin = data[2] | (data[3] << 8);    // 低字节在前，高字节在后
-        Log.v(TAG,
+        LOG_V(TAG,
               "interval = 0x%02X, mode = 0x%02X, clipPin = "
               "0x%04X",
               interval, mode, clipPin);
@@ -646,17 +669,17 @@ class ReadCondDataMsg : public Message {
 
     ReadCondDataMsg() : reserve(0) {}
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(reserve);    // 序列化保留字段
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 1) {
-            Log.e(TAG, "Invalid ReadCondDataMsg data size");
+            LOG_E(TAG, "Invalid ReadCondDataMsg data size");
             return;
         }
         reserve = data[0];    // 反序列化保留字段
-        Log.v(TAG, "reserve = 0x%02X", reserve);
+        LOG_V(TAG, "reserve = 0x%02X", reserve);
     }
 
     void process() override;
@@ -673,17 +696,17 @@ class ReadResDataMsg : public Message {
 
     ReadResDataMsg() : reserve(0) {}
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(reserve);    // 序列化保留字段
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 1) {
-            Log.e(TAG, "Invalid ReadResDataMsg data size");
+            LOG_E(TAG, "Invalid ReadResDataMsg data size");
             return;
         }
         reserve = data[0];    // 反序列化保留字段
-        Log.v(TAG, "reserve = 0x%02X", reserve);
+        LOG_V(TAG, "reserve = 0x%02X", reserve);
     }
 
     void process() override;
@@ -700,16 +723,16 @@ class ReadClipDataMsg : public Message {
 
     ReadClipDataMsg() : reserve(0) {}
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(reserve);    // 序列化保留字段
     }
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 1) {
-            Log.e(TAG, "Invalid ReadClipDataMsg data size");
+            LOG_E(TAG, "Invalid ReadClipDataMsg data size");
             return;
         }
         reserve = data[0];    // 反序列化保留字段
-        Log.v(TAG, "reserve = 0x%02X", reserve);
+        LOG_V(TAG, "reserve = 0x%02X", reserve);
     }
     void process() override;
 
@@ -724,21 +747,21 @@ class RstMsg : public Message {
     static uint8_t lock;
     static uint16_t clipLed;    // 新增卡钉灯位初始化信息
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(lock);
         // 新增 clipLed 序列化
         data.push_back(static_cast<uint8_t>(clipLed));         // 低字节
         data.push_back(static_cast<uint8_t>(clipLed >> 8));    // 高字节
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 3) {    // 修改为3字节
-            Log.e(TAG, "Invalid RstMsg data size");
+            LOG_E(TAG, "Invalid RstMsg data size");
         }
         lock = data[0];
         // 新增 clipLed 反序列化
         clipLed = data[1] | (data[2] << 8);    // 低字节在前，高字节在后
-        Log.v(TAG, "lock = 0x%02X, clipLed = 0x%04X", lock, clipLed);
+        LOG_V(TAG, "lock = 0x%02X, clipLed = 0x%04X", lock, clipLed);
     }
 
     void process() override;
@@ -761,7 +784,7 @@ class CondCfgMsg : public Message {
     static uint16_t startConductionNum;    // 起始导通数量
     static uint16_t conductionNum;         // 导通检测数量
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(status);    // 新增状态码序列化
         data.push_back(timeSlot);
         data.push_back(interval);    // 序列化采集间隔
@@ -773,9 +796,9 @@ class CondCfgMsg : public Message {
         data.push_back(static_cast<uint8_t>(conductionNum >> 8));
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 9) {    // 修改为9字节(原8+新增1)
-            Log.e(TAG, "Invalid CondCfgMsg data size");
+            LOG_E(TAG, "Invalid CondCfgMsg data size");
             return;
         }
         status = data[0];    // 新增状态码反序列化
@@ -784,7 +807,7 @@ class CondCfgMsg : public Message {
         totalConductionNum = (data[4] << 8) | data[3];
         startConductionNum = (data[6] << 8) | data[5];
         conductionNum = (data[8] << 8) | data[7];
-        Log.v(TAG,
+        LOG_V(TAG,
               "status=0x%02X, timeSlot = 0x%02X, interval = 0x%02X, "
               "totalConductionNum = 0x%04X, "
               "startConductionNum = 0x%04X, conductionNum = 0x%04X",
@@ -808,7 +831,7 @@ class ResCfgMsg : public Message {
     static uint16_t startResistanceNum;    // 起始阻值数量
     static uint16_t resistanceNum;         // 阻值检测数量
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(status);    // 新增状态码序列化
         data.push_back(timeSlot);
         data.push_back(interval);    // 序列化采集间隔
@@ -820,9 +843,9 @@ class ResCfgMsg : public Message {
         data.push_back(static_cast<uint8_t>(resistanceNum));
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 9) {    // 修改为9字节(原8+新增1)
-            Log.e(TAG, "Invalid ResCfgMsg data size");
+            LOG_E(TAG, "Invalid ResCfgMsg data size");
             return;
         }
         status = data[0];    // 新增状态码反序列化
@@ -831,7 +854,7 @@ class ResCfgMsg : public Message {
         totalResistanceNum = (data[4] << 8) | data[3];
         startResistanceNum = (data[6] << 8) | data[5];
         resistanceNum = (data[8] << 8) | data[7];
-        Log.v(TAG,
+        LOG_V(TAG,
               "status=0x%02X, timeSlot = 0x%02X, interval = 0x%02X, "
               "totalResistanceNum = 0x%04X, "
               "startResistanceNum = 0x%04X, resistanceNum = 0x%04X",
@@ -855,7 +878,7 @@ class ClipCfgMsg : public Message {
     static uint16_t
         clipPin;    // 16 个卡钉激活信息，激活的位置 1，未激活的位置 0
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(status);      // 新增状态码序列化
         data.push_back(interval);    // 序列化采集间隔
         data.push_back(mode);        // 序列化 mode
@@ -863,16 +886,16 @@ class ClipCfgMsg : public Message {
         data.push_back(static_cast<uint8_t>(clipPin >> 8));    // 高字节在后
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 5) {    // 修改为5字节(原4+新增1)
-            Log.e(TAG, "Invalid ClipCfgMsg data size");
+            LOG_E(TAG, "Invalid ClipCfgMsg data size");
             return;
         }
         status = data[0];                      // 新增状态码反序列化
         interval = data[1];                    // 调整字段索引(+1)
         mode = data[2];                        // 调整字段索引(+1)
         clipPin = data[3] | (data[4] << 8);    // 调整字段索引(+1)
-        Log.v(TAG,
+        LOG_V(TAG,
               "status=0x%02X, interval = 0x%02X, mode = 0x%02X, "
               "clipPin = 0x%04X",
               status, interval, mode, clipPin);
@@ -891,7 +914,7 @@ class RstMsg : public Message {
     static uint8_t lockStatus;    // 锁状态
     static uint16_t clipLed;      // 卡钉灯位初始化信息
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(status);    // 新增状态码序列化
         data.push_back(lockStatus);
         // 序列化卡钉灯位信息
@@ -899,16 +922,16 @@ class RstMsg : public Message {
         data.push_back(static_cast<uint8_t>(clipLed >> 8));    // 高字节
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 4) {    // 修改为4字节(原3+新增1)
-            Log.e(TAG, "Invalid RstMsg data size");
+            LOG_E(TAG, "Invalid RstMsg data size");
             return;
         }
 
         status = data[0];                      // 新增状态码反序列化
         lockStatus = data[1];                  // 调整字段索引(+1)
         clipLed = data[2] | (data[3] << 8);    // 调整字段索引(+1)
-        Log.v(TAG, "status=0x%02X, lockStatus = 0x%02X, clipLed = 0x%04X",
+        LOG_V(TAG, "status=0x%02X, lockStatus = 0x%02X, clipLed = 0x%04X",
               status, lockStatus, clipLed);
     }
 
@@ -935,7 +958,7 @@ class SlaveCfgMsg : public Message {
     static uint8_t slaveNum;                   // 从机数量
     static std::vector<SlaveConfig> slaves;    // 从机配置列表
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(slaveNum);    // 序列化从机数量
         // 序列化每个从机配置
         for (const auto& slave : slaves) {
@@ -951,9 +974,9 @@ class SlaveCfgMsg : public Message {
         }
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() < 1 || (data.size() - 1) % 9 != 0) {    // 每个从机9字节
-            Log.e(TAG, "", "Invalid data size");
+            LOG_E(TAG, "", "Invalid data size");
             return;
         }
 
@@ -983,10 +1006,10 @@ class SlaveCfgMsg : public Message {
         }
 
         // 日志输出
-        Log.v(TAG, "", "slaveNum = %d", slaveNum);
+        LOG_V(TAG, "", "slaveNum = %d", slaveNum);
         for (size_t i = 0; i < slaves.size(); i++) {
             const auto& s = slaves[i];
-            Log.v(TAG, "",
+            LOG_V(TAG, "",
                   "Slave %d: id=0x%08X, cond=%d, res=%d, mode=%d, clip=0x%04X",
                   i, s.id, s.conductionNum, s.resistanceNum, s.clipMode,
                   s.clipStatus);
@@ -1006,17 +1029,17 @@ class ModeCfgMsg : public Message {
     static constexpr const char TAG[] = "ModeCfgMsg";
     static uint8_t mode;    // 模式配置
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(mode);    // 序列化模式
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 1) {
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
         mode = data[0];
-        Log.v(TAG, "mode = 0x%02X", mode);
+        LOG_V(TAG, "mode = 0x%02X", mode);
     }
 
     void process() override;
@@ -1038,7 +1061,7 @@ class RstMsg : public Message {
     static uint8_t slaveNum;                        // 从机数量
     static std::vector<SlaveResetConfig> slaves;    // 从机复位配置列表
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(slaveNum);    // 序列化从机数量
         // 序列化每个从机配置
         for (const auto& slave : slaves) {
@@ -1052,9 +1075,9 @@ class RstMsg : public Message {
         }
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() < 1 || (data.size() - 1) % 7 != 0) {    // 每个从机7字节
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
 
@@ -1082,10 +1105,10 @@ class RstMsg : public Message {
         }
 
         // 日志输出
-        Log.v(TAG, "slaveNum = %d", slaveNum);
+        LOG_V(TAG, "slaveNum = %d", slaveNum);
         for (size_t i = 0; i < slaves.size(); i++) {
             const auto& s = slaves[i];
-            Log.v(TAG, "Slave %d: id=0x%08X, lock=%d, clipStatus=0x%04X", i,
+            LOG_V(TAG, "Slave %d: id=0x%08X, lock=%d, clipStatus=0x%04X", i,
                   s.id, s.lock, s.clipStatus);
         }
     }
@@ -1102,17 +1125,17 @@ class CtrlMsg : public Message {
     static constexpr const char TAG[] = "CtrlMsg";
     static uint8_t runningStatus;    // 运行状态控制
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(runningStatus);    // 序列化运行状态
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 1) {
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
         runningStatus = data[0];
-        Log.v(TAG, "runningStatus = 0x%02X", runningStatus);
+        LOG_V(TAG, "runningStatus = 0x%02X", runningStatus);
     }
 
     void process() override;
@@ -1122,6 +1145,185 @@ class CtrlMsg : public Message {
     }
 };
 
+/**
+ * @brief 结果流重传请求，列出上位机缺失的结果序号
+ * @note 序号列表可以为空，此时仅用于查询主机下一个序号，以发现尾部丢包
+ */
+class NackMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "NackMsg";
+    static std::vector<uint32_t> seqs;    // 缺失的结果序号
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        data.push_back(static_cast<uint8_t>(seqs.size()));
+        for (const auto& seq : seqs) {
+            ProtocolUtils::serializeUint32(data, seq);
+        }
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        seqs.clear();
+        if (data.size() < 1) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        uint8_t num = data[0];
+        if (data.size() != 1 + num * 4) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        seqs.reserve(num);
+        for (uint8_t i = 0; i < num; i++) {
+            seqs.push_back(ProtocolUtils::deserializeUint32(data, 1 + i * 4));
+        }
+        LOG_V(TAG, "num = %u", num);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Backend2MasterMessageID::NACK_MSG);
+    }
+};
+
+/**
+ * @brief 带请求号的指令，负载为原Backend2Master报文(消息ID + 数据)
+ * @note 主机用同一请求号的RESPONSE_MSG应答，多条指令可同时在途、乱序完成
+ */
+class RequestMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "RequestMsg";
+    static uint16_t reqId;                 // 请求号，由上位机分配
+    static PoolVector<uint8_t> packet;    // Backend2Master报文
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        data.push_back(static_cast<uint8_t>(reqId));
+        data.push_back(static_cast<uint8_t>(reqId >> 8));
+        data.insert(data.end(), packet.begin(), packet.end());
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        packet.clear();
+        if (data.size() < 3) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        reqId = data[0] | (data[1] << 8);
+        packet.assign(data.begin() + 2, data.end());
+        LOG_V(TAG, "reqId = %u, msg = 0x%02X", reqId, packet[0]);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Backend2MasterMessageID::REQUEST_MSG);
+    }
+};
+
+/**
+ * @brief 查询主机缓存的各从机最新结果，不经过无线链路
+ * @note 从机数为0时查询全部从机；引脚数为0时返回完整导通矩阵，否则只返回
+ *       驱动引脚(矩阵行)在[pinStart, pinStart + pinNum)内的部分。
+ *       引脚范围可省略
+ */
+class QueryMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "QueryMsg";
+    static std::vector<uint32_t> ids;    // 查询的从机ID，为空时查询全部
+    static uint16_t pinStart;            // 起始驱动引脚
+    static uint16_t pinNum;              // 驱动引脚数，0为全部
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        data.push_back(static_cast<uint8_t>(ids.size()));
+        for (const auto& id : ids) {
+            ProtocolUtils::serializeUint32(data, id);
+        }
+        ProtocolUtils::serializeUint16(data, pinStart);
+        ProtocolUtils::serializeUint16(data, pinNum);
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        ids.clear();
+        pinStart = 0;
+        pinNum = 0;
+        if (data.size() < 1) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        uint8_t num = data[0];
+        size_t len = 1 + num * 4;
+        if (data.size() != len && data.size() != len + 4) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        ids.reserve(num);
+        for (uint8_t i = 0; i < num; i++) {
+            ids.push_back(ProtocolUtils::deserializeUint32(data, 1 + i * 4));
+        }
+        if (data.size() == len + 4) {
+            pinStart = ProtocolUtils::deserializeUint16(data, len);
+            pinNum = ProtocolUtils::deserializeUint16(data, len + 2);
+        }
+        LOG_V(TAG, "num = %u, pin %u+%u", num, pinStart, pinNum);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Backend2MasterMessageID::QUERY_MSG);
+    }
+};
+
+class DiagMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "DiagMsg";
+    static uint8_t sections;    // Diag::Section位组合，负载为空时为全部
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        data.push_back(sections);
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        sections = data.empty() ? 0xFF : data[0];
+        LOG_V(TAG, "sections = 0x%02X", sections);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Backend2MasterMessageID::DIAG_MSG);
+    }
+};
+
+class TraceMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "TraceMsg";
+    enum Cmd : uint8_t {
+        READ = 0,      // 读取一段，start为0时先停止记录
+        RESUME = 1,    // 清空并重新开始记录
+    };
+    static uint8_t cmd;
+    static uint16_t start;    // 起始记录
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        data.push_back(cmd);
+        ProtocolUtils::serializeUint16(data, start);
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        cmd = data.empty() ? READ : data[0];
+        start = data.size() >= 3 ? ProtocolUtils::deserializeUint16(data, 1)
+                                 : 0;
+        LOG_V(TAG, "cmd = %u, start = %u", cmd, start);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Backend2MasterMessageID::TRACE_MSG);
+    }
+};
+
 }    // namespace Backend2Master
 
 namespace Master2Backend {
@@ -1140,7 +1342,7 @@ class SlaveCfgMsg : public Message {
     static uint8_t slaveNum;                   // 从机数量
     static std::vector<SlaveConfig> slaves;    // 从机配置列表
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(status);      // 序列化响应状态
         data.push_back(slaveNum);    // 序列化从机数量
         // 序列化每个从机配置
@@ -1157,10 +1359,10 @@ class SlaveCfgMsg : public Message {
         }
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() < 2 ||
             (data.size() - 2) % 9 != 0) {    // 2字节头部 + 每个从机9字节
-            Log.e(TAG, "", "Invalid data size");
+            LOG_E(TAG, "", "Invalid data size");
             return;
         }
 
@@ -1191,10 +1393,10 @@ class SlaveCfgMsg : public Message {
         }
 
         // 日志输出
-        Log.v(TAG, "", "status=0x%02X, slaveNum=%d", status, slaveNum);
+        LOG_V(TAG, "", "status=0x%02X, slaveNum=%d", status, slaveNum);
         for (size_t i = 0; i < slaves.size(); i++) {
             const auto& s = slaves[i];
-            Log.v(TAG, "",
+            LOG_V(TAG, "",
                   "Slave %d: id=0x%08X, cond=%d, res=%d, mode=%d, clip=0x%04X",
                   i, s.id, s.conductionNum, s.resistanceNum, s.clipMode,
                   s.clipStatus);
@@ -1214,19 +1416,19 @@ class ModeCfgMsg : public Message {
     static uint8_t status;    // 响应状态
     static uint8_t mode;      // 模式配置
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(status);    // 序列化响应状态
         data.push_back(mode);      // 序列化模式
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 2) {
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
         status = data[0];    // 反序列化响应状态
         mode = data[1];      // 反序列化模式
-        Log.v(TAG, "status=0x%02X, mode=0x%02X", status, mode);
+        LOG_V(TAG, "status=0x%02X, mode=0x%02X", status, mode);
     }
 
     void process() override;
@@ -1249,7 +1451,7 @@ class RstMsg : public Message {
     static uint8_t slaveNum;                        // 从机数量
     static std::vector<SlaveResetConfig> slaves;    // 从机复位配置列表
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(status);      // 序列化响应状态
         data.push_back(slaveNum);    // 序列化从机数量
         for (const auto& slave : slaves) {
@@ -1263,10 +1465,10 @@ class RstMsg : public Message {
         }
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() < 2 ||
             (data.size() - 2) % 7 != 0) {    // 2字节头部 + 每个从机7字节
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
 
@@ -1295,10 +1497,10 @@ class RstMsg : public Message {
         }
 
         // 日志输出
-        Log.v(TAG, "status=0x%02X, slaveNum=%d", status, slaveNum);
+        LOG_V(TAG, "status=0x%02X, slaveNum=%d", status, slaveNum);
         for (size_t i = 0; i < slaves.size(); i++) {
             const auto& s = slaves[i];
-            Log.v(TAG, "Slave %d: id=0x%08X, clipStatus=0x%04X, lock=%d", i,
+            LOG_V(TAG, "Slave %d: id=0x%08X, clipStatus=0x%04X, lock=%d", i,
                   s.id, s.clipStatus, s.lock);
         }
     }
@@ -1316,19 +1518,19 @@ class CtrlMsg : public Message {
     static uint8_t status;           // 响应状态
     static uint8_t runningStatus;    // 运行状态控制
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         data.push_back(status);           // 序列化响应状态
         data.push_back(runningStatus);    // 序列化运行状态
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 2) {
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
         status = data[0];           // 反序列化响应状态
         runningStatus = data[1];    // 反序列化运行状态
-        Log.v(TAG, "status=0x%02X, runningStatus=0x%02X", status,
+        LOG_V(TAG, "status=0x%02X, runningStatus=0x%02X", status,
               runningStatus);
     }
 
@@ -1338,6 +1540,255 @@ class CtrlMsg : public Message {
         return static_cast<uint8_t>(Master2BackendMessageID::CTRL_MSG);
     }
 };
+/**
+ * @brief 结果流重传应答
+ * @note 重传的结果先于本应答发出，lostSeqs为历史中已淘汰、无法重传的序号
+ */
+class NackMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "NackMsg";
+    static uint32_t nextSeq;                  // 主机下一个结果序号
+    static std::vector<uint32_t> lostSeqs;    // 无法重传的序号
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        ProtocolUtils::serializeUint32(data, nextSeq);
+        data.push_back(static_cast<uint8_t>(lostSeqs.size()));
+        for (const auto& seq : lostSeqs) {
+            ProtocolUtils::serializeUint32(data, seq);
+        }
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        lostSeqs.clear();
+        if (data.size() < 5 || data.size() != 5 + data[4] * 4) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        nextSeq = ProtocolUtils::deserializeUint32(data, 0);
+        for (uint8_t i = 0; i < data[4]; i++) {
+            lostSeqs.push_back(
+                ProtocolUtils::deserializeUint32(data, 5 + i * 4));
+        }
+        LOG_V(TAG, "nextSeq = %lu, lost num = %u", (unsigned long)nextSeq,
+              data[4]);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Master2BackendMessageID::NACK_MSG);
+    }
+};
+
+/**
+ * @brief 带序号的结果流，负载为原Slave2Backend完整帧
+ */
+class ResultStreamMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "ResultStreamMsg";
+    static constexpr uint8_t FLAG_RETRANSMIT = 0x01;
+
+    static uint32_t seq;                  // 结果序号，从0递增
+    static uint8_t flags;                 // bit0: 重传
+    static PoolVector<uint8_t> frame;    // Slave2Backend完整帧
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        ProtocolUtils::serializeUint32(data, seq);
+        data.push_back(flags);
+        data.insert(data.end(), frame.begin(), frame.end());
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        if (data.size() < 5) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        seq = ProtocolUtils::deserializeUint32(data, 0);
+        flags = data[4];
+        frame.assign(data.begin() + 5, data.end());
+        LOG_V(TAG, "seq = %lu, flags = 0x%02X", (unsigned long)seq, flags);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(
+            Master2BackendMessageID::RESULT_STREAM_MSG);
+    }
+};
+
+/**
+ * @brief 带请求号的应答，负载为原Master2Backend报文(消息ID + 数据)
+ */
+class ResponseMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "ResponseMsg";
+    static uint16_t reqId;                 // 对应指令的请求号
+    static PoolVector<uint8_t> packet;    // Master2Backend报文
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        data.push_back(static_cast<uint8_t>(reqId));
+        data.push_back(static_cast<uint8_t>(reqId >> 8));
+        data.insert(data.end(), packet.begin(), packet.end());
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        packet.clear();
+        if (data.size() < 3) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        reqId = data[0] | (data[1] << 8);
+        packet.assign(data.begin() + 2, data.end());
+        LOG_V(TAG, "reqId = %u, msg = 0x%02X", reqId, packet[0]);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Master2BackendMessageID::RESPONSE_MSG);
+    }
+};
+/**
+ * @brief 缓存结果查询应答，每个从机一条记录
+ * @note 应答长度受限时只包含前slaves.size()个匹配的从机，matchNum为匹配总数，
+ *       上位机可按ID分批查询其余从机。cycle为0表示该从机尚无结果
+ */
+class QueryMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "QueryMsg";
+
+    struct SlaveResult {
+        uint32_t id;
+        uint32_t cycle;         // 结果所属检测周期
+        uint32_t age;           // 结果缓存至今的时间(ms)
+        uint16_t status;        // DeviceStatus
+        uint16_t okNum;         // 读取成功次数
+        uint16_t failNum;       // 读取失败次数
+        uint16_t retryNum;      // 累计重试次数
+        uint16_t condNum;       // 本从机导通线数，即矩阵列数
+        uint16_t pinStart;      // 返回的起始驱动引脚
+        uint16_t pinNum;        // 返回的驱动引脚数，即矩阵行数
+        PoolVector<uint8_t> data;    // 按行展开的导通位图，高位在前
+    };
+
+    static uint32_t cycle;      // 主机当前检测周期
+    static uint8_t matchNum;    // 匹配的从机总数
+    static std::vector<SlaveResult> slaves;
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        ProtocolUtils::serializeUint32(data, cycle);
+        data.push_back(matchNum);
+        data.push_back(static_cast<uint8_t>(slaves.size()));
+        for (const auto& slave : slaves) {
+            ProtocolUtils::serializeUint32(data, slave.id);
+            ProtocolUtils::serializeUint32(data, slave.cycle);
+            ProtocolUtils::serializeUint32(data, slave.age);
+            ProtocolUtils::serializeUint16(data, slave.status);
+            ProtocolUtils::serializeUint16(data, slave.okNum);
+            ProtocolUtils::serializeUint16(data, slave.failNum);
+            ProtocolUtils::serializeUint16(data, slave.retryNum);
+            ProtocolUtils::serializeUint16(data, slave.condNum);
+            ProtocolUtils::serializeUint16(data, slave.pinStart);
+            ProtocolUtils::serializeUint16(data, slave.pinNum);
+            ProtocolUtils::serializeUint16(data, slave.data.size());
+            data.insert(data.end(), slave.data.begin(), slave.data.end());
+        }
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        slaves.clear();
+        if (data.size() < 6) {
+            LOG_E(TAG, "Invalid data size");
+            return;
+        }
+        cycle = ProtocolUtils::deserializeUint32(data, 0);
+        matchNum = data[4];
+        uint8_t num = data[5];
+        size_t pos = 6;
+        for (uint8_t i = 0; i < num; i++) {
+            if (data.size() < pos + RECORD_SIZE) {
+                LOG_E(TAG, "Invalid data size");
+                slaves.clear();
+                return;
+            }
+            SlaveResult slave;
+            slave.id = ProtocolUtils::deserializeUint32(data, pos);
+            slave.cycle = ProtocolUtils::deserializeUint32(data, pos + 4);
+            slave.age = ProtocolUtils::deserializeUint32(data, pos + 8);
+            slave.status = ProtocolUtils::deserializeUint16(data, pos + 12);
+            slave.okNum = ProtocolUtils::deserializeUint16(data, pos + 14);
+            slave.failNum = ProtocolUtils::deserializeUint16(data, pos + 16);
+            slave.retryNum = ProtocolUtils::deserializeUint16(data, pos + 18);
+            slave.condNum = ProtocolUtils::deserializeUint16(data, pos + 20);
+            slave.pinStart = ProtocolUtils::deserializeUint16(data, pos + 22);
+            slave.pinNum = ProtocolUtils::deserializeUint16(data, pos + 24);
+            uint16_t len = ProtocolUtils::deserializeUint16(data, pos + 26);
+            pos += RECORD_SIZE;
+            if (data.size() < pos + len) {
+                LOG_E(TAG, "Invalid data size");
+                slaves.clear();
+                return;
+            }
+            slave.data.assign(data.begin() + pos, data.begin() + pos + len);
+            pos += len;
+            slaves.push_back(std::move(slave));
+        }
+        LOG_V(TAG, "cycle = %lu, num = %u/%u", (unsigned long)cycle, num,
+              matchNum);
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Master2BackendMessageID::QUERY_MSG);
+    }
+
+    // 每条记录除位图外的字节数
+    static constexpr size_t RECORD_SIZE = 28;
+};
+
+class DiagMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "DiagMsg";
+    static PoolVector<uint8_t> snapshot;    // 诊断快照，格式见bsp_diag.hpp
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        data.insert(data.end(), snapshot.begin(), snapshot.end());
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        snapshot = data;
+        LOG_V(TAG, "size = %u", (unsigned)snapshot.size());
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Master2BackendMessageID::DIAG_MSG);
+    }
+};
+
+class TraceMsg : public Message {
+   public:
+    static constexpr const char TAG[] = "TraceMsg";
+    static PoolVector<uint8_t> dump;    // 跟踪导出段，格式见bsp_trace.hpp
+
+    void serialize(PoolVector<uint8_t>& data) const override {
+        data.insert(data.end(), dump.begin(), dump.end());
+    }
+
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        dump = data;
+        LOG_V(TAG, "size = %u", (unsigned)dump.size());
+    }
+
+    void process() override;
+
+    uint8_t message_type() const override {
+        return static_cast<uint8_t>(Master2BackendMessageID::TRACE_MSG);
+    }
+};
 }    // namespace Master2Backend
 
 namespace Slave2Backend {
@@ -1346,9 +1797,12 @@ class CondDataMsg : public Message {
    public:
     static constexpr const char TAG[] = "CondDataMsg";
     static uint16_t conductionLength;              // 导通数据字段长度
-    static std::vector<uint8_t> conductionData;    // 导通数据
+    static PoolVector<uint8_t> conductionData;    // 导通数据
+    // 从机运行诊断快照(格式见bsp_diag.hpp)，不为空时以长度+数据附在导通
+    // 数据之后，主机原样转发给上位机
+    static PoolVector<uint8_t> diagData;
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         // 序列化导通数据长度
         data.push_back(static_cast<uint8_t>(conductionLength));    // 低字节
         data.push_back(
@@ -1356,26 +1810,38 @@ class CondDataMsg : public Message {
 
         // 序列化导通数据
         data.insert(data.end(), conductionData.begin(), conductionData.end());
+
+        if (!diagData.empty()) {
+            ProtocolUtils::serializeUint16(data, diagData.size());
+            data.insert(data.end(), diagData.begin(), diagData.end());
+        }
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
+        diagData.clear();
         if (data.size() < 2) {
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
 
         // 反序列化导通数据长度
         conductionLength = data[0] | (data[1] << 8);
 
-        // 反序列化导通数据
-        if (data.size() != 2 + conductionLength) {
-            Log.e(TAG, "Invalid conduction data size");
-            return;
+        // 反序列化导通数据，之后可能带诊断快照
+        size_t end = 2 + conductionLength;
+        if (data.size() != end) {
+            if (data.size() < end + 2 ||
+                data.size() !=
+                    end + 2 + ProtocolUtils::deserializeUint16(data, end)) {
+                LOG_E(TAG, "Invalid conduction data size");
+                return;
+            }
+            diagData.assign(data.begin() + end + 2, data.end());
         }
-        conductionData.assign(data.begin() + 2, data.end());
+        conductionData.assign(data.begin() + 2, data.begin() + end);
 
-        Log.v(TAG, "length=%d, dataSize=%d", conductionLength,
-              conductionData.size());
+        LOG_V(TAG, "length=%d, dataSize=%d, diag=%d", conductionLength,
+              conductionData.size(), diagData.size());
     }
 
     void process() override;
@@ -1389,9 +1855,9 @@ class ResDataMsg : public Message {
    public:
     static constexpr const char TAG[] = "ResDataMsg";
     static uint16_t resistanceLength;              // 阻值数据长度
-    static std::vector<uint8_t> resistanceData;    // 阻值数据
+    static PoolVector<uint8_t> resistanceData;    // 阻值数据
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         // 序列化阻值数据长度
         data.push_back(static_cast<uint8_t>(resistanceLength));    // 低字节
         data.push_back(
@@ -1401,9 +1867,9 @@ class ResDataMsg : public Message {
         data.insert(data.end(), resistanceData.begin(), resistanceData.end());
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() < 2) {
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
 
@@ -1412,12 +1878,12 @@ class ResDataMsg : public Message {
 
         // 反序列化阻值数据
         if (data.size() != 2 + resistanceLength) {
-            Log.e(TAG, "Invalid resistance data size");
+            LOG_E(TAG, "Invalid resistance data size");
             return;
         }
         resistanceData.assign(data.begin() + 2, data.end());
 
-        Log.v(TAG, "length=%d, dataSize=%d", resistanceLength,
+        LOG_V(TAG, "length=%d, dataSize=%d", resistanceLength,
               resistanceData.size());
     }
 
@@ -1433,22 +1899,22 @@ class ClipDataMsg : public Message {
     static constexpr const char TAG[] = "ClipDataMsg";
     static uint16_t clipData;    // 卡钉板数据
 
-    void serialize(std::vector<uint8_t>& data) const override {
+    void serialize(PoolVector<uint8_t>& data) const override {
         // 序列化卡钉板数据
         data.push_back(static_cast<uint8_t>(clipData));         // 低字节
         data.push_back(static_cast<uint8_t>(clipData >> 8));    // 高字节
     }
 
-    void deserialize(const std::vector<uint8_t>& data) override {
+    void deserialize(const PoolVector<uint8_t>& data) override {
         if (data.size() != 2) {
-            Log.e(TAG, "Invalid data size");
+            LOG_E(TAG, "Invalid data size");
             return;
         }
 
         // 反序列化卡钉板数据
         clipData = data[0] | (data[1] << 8);
 
-        Log.v(TAG, "clipData=0x%04X", clipData);
+        LOG_V(TAG, "clipData=0x%04X", clipData);
     }
 
     void process() override;
@@ -1460,24 +1926,93 @@ class ClipDataMsg : public Message {
 
 }    // namespace Slave2Backend
 
+/**
+ * @brief 字节流分帧器，从TCP等字节流中按帧分隔符和帧头长度恢复帧边界
+ * @note 分隔符不匹配或长度超限时丢弃一个字节后重新查找分隔符
+ */
+class FrameDecoder {
+   public:
+    /**
+     * @param max_frame 最大帧长(含帧头)，超过的视为错误帧
+     */
+    explicit FrameDecoder(size_t max_frame) : max_frame(max_frame) {
+        buf.reserve(max_frame);
+    }
+
+    /**
+     * @brief 输入一段字节流，每恢复出一个完整帧调用一次on_frame
+     * @param on_frame void(const uint8_t* frame, size_t len)，
+     *        frame仅在回调内有效
+     */
+    template <typename F>
+    void feed(const uint8_t* data, size_t len, F&& on_frame) {
+        while (len > 0) {
+            size_t need = __frame_len();
+            if (need == 0) {
+                // 帧头未完整，逐字节收取以便重新同步
+                buf.push_back(*data++);
+                len--;
+                __sync();
+                continue;
+            }
+            // 帧头已确认，负载整段拷贝
+            size_t take = std::min(need - buf.size(), len);
+            buf.insert(buf.end(), data, data + take);
+            data += take;
+            len -= take;
+            if (buf.size() == need) {
+                on_frame(buf.data(), buf.size());
+                buf.clear();
+            }
+        }
+    }
+
+    void reset() { buf.clear(); }
+
+   private:
+    size_t max_frame;
+    PoolVector<uint8_t> buf;
+
+    // 帧头完整且合法时返回整帧长度，否则返回0
+    size_t __frame_len() const {
+        if (buf.size() < FrameHeader::HEADER_SIZE) {
+            return 0;
+        }
+        return FrameHeader::HEADER_SIZE + (buf[5] | (buf[6] << 8));
+    }
+
+    void __sync() {
+        while (!buf.empty()) {
+            if (buf[0] != FrameHeader::FRAME_DELIMITER[0] ||
+                (buf.size() >= 2 &&
+                 buf[1] != FrameHeader::FRAME_DELIMITER[1]) ||
+                __frame_len() > max_frame) {
+                buf.erase(buf.begin());
+                continue;
+            }
+            return;
+        }
+    }
+};
+
 class FrameParser {
    public:
     static constexpr const char TAG[] = "FrameParser";
-    std::unique_ptr<Message> parse(const std::vector<uint8_t>& raw_data) {
+    std::unique_ptr<Message> parse(const PoolVector<uint8_t>& raw_data) {
         // 1. 解析帧头
         FrameHeader header;
-        Log.v(TAG, "raw_data size=%d", raw_data.size());
+        LOG_V(TAG, "raw_data size=%d", raw_data.size());
         if (!header.deserialize(raw_data)) {
-            Log.e(TAG, "Frame header parse failed");
+            LOG_E(TAG, "Frame header parse failed");
             return nullptr;
         }
 
-        Log.v(TAG, "Header parsed: Packet Type=0x%02X Len=%d", header.packet_id,
+        LOG_V(TAG, "Header parsed: Packet Type=0x%02X Len=%d", header.packet_id,
               header.data_length);
 
         // 数据完整性验证
         if (raw_data.size() != FrameHeader::HEADER_SIZE + header.data_length) {
-            Log.e(TAG, "Invalid frame, expected=%d, actual=%d",
+            LOG_E(TAG, "Invalid frame, expected=%d, actual=%d",
                   8 + header.data_length, raw_data.size());
             return nullptr;
         }
@@ -1485,8 +2020,8 @@ class FrameParser {
         // 2. 提取 Master2SlavePacket 数据
         auto packet_start = raw_data.begin() + FrameHeader::HEADER_SIZE;
         auto packet_end = packet_start + header.data_length;
-        std::vector<uint8_t> packet_data(packet_start, packet_end);
-        Log.v(TAG, "Payload extracted, len=%d", packet_data.size());
+        PoolVector<uint8_t> packet_data(packet_start, packet_end);
+        LOG_V(TAG, "Payload extracted, len=%d", packet_data.size());
 
 #ifdef MASTER
         if (header.packet_id ==
@@ -1495,7 +2030,7 @@ class FrameParser {
 
             // 3. 反序列化 Slave2MasterPacket
             if (!packet.deserialize(packet_data)) {
-                Log.e(TAG, "Failed to deserialize Slave2MasterPacket");
+                LOG_E(TAG, "Failed to deserialize Slave2MasterPacket");
                 return nullptr;
             }
 
@@ -1517,38 +2052,38 @@ class FrameParser {
                     break;
             }
 
-            Log.v(TAG,
+            LOG_V(TAG,
                   "packet parsed, type=%s (0x%02X), "
                   "source_id=0x%08X",
                   msgTypeStr, packet.message_id, packet.source_id);
 
             switch (static_cast<Slave2MasterMessageID>(packet.message_id)) {
                 case Slave2MasterMessageID::COND_CFG_MSG: {
-                    Log.v(TAG, "processing COND_CFG_MSG message");
+                    LOG_V(TAG, "processing COND_CFG_MSG message");
                     auto msg = std::make_unique<Slave2Master::CondCfgMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Slave2MasterMessageID::RES_CFG_MSG: {
-                    Log.v(TAG, "processing RES_CFG_MSG message");
+                    LOG_V(TAG, "processing RES_CFG_MSG message");
                     auto msg = std::make_unique<Slave2Master::ResCfgMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Slave2MasterMessageID::CLIP_CFG_MSG: {
-                    Log.v(TAG, "processing CLIP_CFG_MSG message");
+                    LOG_V(TAG, "processing CLIP_CFG_MSG message");
                     auto msg = std::make_unique<Slave2Master::ClipCfgMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Slave2MasterMessageID::RST_MSG: {
-                    Log.v(TAG, "processing RST_MSG message");
+                    LOG_V(TAG, "processing RST_MSG message");
                     auto msg = std::make_unique<Slave2Master::RstMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 default:
-                    Log.e(TAG,
+                    LOG_E(TAG,
                           "unsupported Slave message "
                           "type=0x%02X",
                           static_cast<uint8_t>(packet.message_id));
@@ -1560,7 +2095,7 @@ class FrameParser {
             Backend2MasterPacket packet;
             // 3. 反序列化 Slave2MasterPacket
             if (!packet.deserialize(packet_data)) {
-                Log.e("B2M", "Failed to deserialize packet");
+                LOG_E("B2M", "Failed to deserialize packet");
                 return nullptr;
             }
 
@@ -1578,40 +2113,85 @@ class FrameParser {
                 case Backend2MasterMessageID::CTRL_MSG:
                     msgTypeStr = "CTRL_MSG";
                     break;
+                case Backend2MasterMessageID::NACK_MSG:
+                    msgTypeStr = "NACK_MSG";
+                    break;
+                case Backend2MasterMessageID::REQUEST_MSG:
+                    msgTypeStr = "REQUEST_MSG";
+                    break;
+                case Backend2MasterMessageID::QUERY_MSG:
+                    msgTypeStr = "QUERY_MSG";
+                    break;
+                case Backend2MasterMessageID::DIAG_MSG:
+                    msgTypeStr = "DIAG_MSG";
+                    break;
+                case Backend2MasterMessageID::TRACE_MSG:
+                    msgTypeStr = "TRACE_MSG";
+                    break;
                 default:
                     break;
             }
 
-            Log.v(TAG, "packet parsed, msg type=%s (0x%02X) ", msgTypeStr,
+            LOG_V(TAG, "packet parsed, msg type=%s (0x%02X) ", msgTypeStr,
                   packet.message_id);
 
             switch (static_cast<Backend2MasterMessageID>(packet.message_id)) {
                 case Backend2MasterMessageID::SLAVE_CFG_MSG: {
-                    Log.v(TAG, "processing SLAVE_CFG_MSG message");
+                    LOG_V(TAG, "processing SLAVE_CFG_MSG message");
                     auto msg = std::make_unique<Backend2Master::SlaveCfgMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Backend2MasterMessageID::MODE_CFG_MSG: {
-                    Log.v(TAG, "processing MODE_CFG_MSG message");
+                    LOG_V(TAG, "processing MODE_CFG_MSG message");
                     auto msg = std::make_unique<Backend2Master::ModeCfgMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Backend2MasterMessageID::RST_MSG: {
-                    Log.v(TAG, "processing RST_MSG message");
+                    LOG_V(TAG, "processing RST_MSG message");
                     auto msg = std::make_unique<Backend2Master::RstMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Backend2MasterMessageID::CTRL_MSG: {
-                    Log.v(TAG, "processing CTRL_MSG message");
+                    LOG_V(TAG, "processing CTRL_MSG message");
                     auto msg = std::make_unique<Backend2Master::CtrlMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
+                case Backend2MasterMessageID::NACK_MSG: {
+                    LOG_V(TAG, "processing NACK_MSG message");
+                    auto msg = std::make_unique<Backend2Master::NackMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Backend2MasterMessageID::REQUEST_MSG: {
+                    LOG_V(TAG, "processing REQUEST_MSG message");
+                    auto msg = std::make_unique<Backend2Master::RequestMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Backend2MasterMessageID::QUERY_MSG: {
+                    LOG_V(TAG, "processing QUERY_MSG message");
+                    auto msg = std::make_unique<Backend2Master::QueryMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Backend2MasterMessageID::DIAG_MSG: {
+                    LOG_V(TAG, "processing DIAG_MSG message");
+                    auto msg = std::make_unique<Backend2Master::DiagMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Backend2MasterMessageID::TRACE_MSG: {
+                    LOG_V(TAG, "processing TRACE_MSG message");
+                    auto msg = std::make_unique<Backend2Master::TraceMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
                 default:
-                    Log.e(TAG,
+                    LOG_E(TAG,
                           "unsupported Slave message "
                           "type=0x%02X",
                           static_cast<uint8_t>(packet.message_id));
@@ -1621,7 +2201,7 @@ class FrameParser {
                    static_cast<uint8_t>(PacketType::Slave2Backend)) {
             Slave2BackendPacket packet;
             if (!packet.deserialize(packet_data)) {
-                Log.e("S2BP", "Failed to deserialize packet");
+                LOG_E("S2BP", "Failed to deserialize packet");
                 return nullptr;
             }
 
@@ -1640,36 +2220,36 @@ class FrameParser {
                     break;
             }
 
-            Log.v(TAG, "packet parsed, msg type=%s (0x%02X) ", msgTypeStr,
+            LOG_V(TAG, "packet parsed, msg type=%s (0x%02X) ", msgTypeStr,
                   packet.message_id);
             switch (static_cast<Slave2BackendMessageID>(packet.message_id)) {
                 case Slave2BackendMessageID::COND_DATA_MSG: {
-                    Log.v(TAG, "processing COND_DATA_MSG message");
+                    LOG_V(TAG, "processing COND_DATA_MSG message");
                     auto msg = std::make_unique<Slave2Backend::CondDataMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Slave2BackendMessageID::RES_DATA_MSG: {
-                    Log.v(TAG, "processing RES_DATA_MSG message");
+                    LOG_V(TAG, "processing RES_DATA_MSG message");
                     auto msg = std::make_unique<Slave2Backend::ResDataMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Slave2BackendMessageID::CLIP_DATA_MSG: {
-                    Log.v(TAG, "processing CLIP_DATA_MSG message");
+                    LOG_V(TAG, "processing CLIP_DATA_MSG message");
                     auto msg = std::make_unique<Slave2Backend::ClipDataMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 default:
-                    Log.e(TAG,
+                    LOG_E(TAG,
                           "unsupported Slave2Backend message "
                           "type=0x%02X",
                           static_cast<uint8_t>(packet.message_id));
                     return nullptr;
             }
         } else {
-            Log.e(TAG, "unsupported Packet type=0x%02X", header.packet_id);
+            LOG_E(TAG, "unsupported Packet type=0x%02X", header.packet_id);
             return nullptr;
         }
 #elif defined(SLAVE)
@@ -1678,7 +2258,7 @@ class FrameParser {
             // 3. 反序列化 Master2SlavePacket
             Master2SlavePacket packet;
             if (!packet.deserialize(packet_data)) {
-                Log.e(TAG, "Failed to deserialize Master2SlavePacket");
+                LOG_E(TAG, "Failed to deserialize Master2SlavePacket");
                 return nullptr;
             }
 
@@ -1706,98 +2286,98 @@ class FrameParser {
                     break;
             }
 
-            Log.v(TAG,
+            LOG_V(TAG,
                   "packet parsed, type=%s (0x%02X), "
                   "destination_id=0x%08X",
                   msgTypeStr, packet.message_id, packet.destination_id);
 
             if (packet.destination_id != 0xFFFFFFFF &&
                 packet.destination_id != UIDReader::get()) {
-                Log.e(TAG, "id compare fail");
+                LOG_E(TAG, "id compare fail");
                 return nullptr;
             }
-            Log.v(TAG, "id compare success");
+            LOG_V(TAG, "id compare success");
 
             switch (static_cast<Master2SlaveMessageID>(packet.message_id)) {
                 case Master2SlaveMessageID::SYNC_MSG: {
-                    Log.v(TAG, "processing SYNC_MSG message");
+                    LOG_V(TAG, "processing SYNC_MSG message");
                     auto msg = std::make_unique<Master2Slave::SyncMsg>();
                     msg->deserialize(packet.payload);
-                    Log.v(TAG, "SYNC_MSG message deserialized");
+                    LOG_V(TAG, "SYNC_MSG message deserialized");
                     return msg;
                 }
                 case Master2SlaveMessageID::COND_CFG_MSG: {
-                    Log.v(TAG,
+                    LOG_V(TAG,
                           "processing COND_CFG_MSG "
                           "message");
                     auto msg = std::make_unique<Master2Slave::CondCfgMsg>();
                     msg->deserialize(packet.payload);
-                    Log.v(TAG,
+                    LOG_V(TAG,
                           "COND_CFG_MSG message "
                           "deserialized");
                     return msg;
                 }
                 case Master2SlaveMessageID::RES_CFG_MSG: {
-                    Log.v(TAG,
+                    LOG_V(TAG,
                           "processing RES_CFG_MSG "
                           "message");
                     auto msg = std::make_unique<Master2Slave::ResCfgMsg>();
                     msg->deserialize(packet.payload);
-                    Log.v(TAG,
+                    LOG_V(TAG,
                           "RES_CFG_MSG message "
                           "deserialized");
                     return msg;
                 }
                 case Master2SlaveMessageID::CLIP_CFG_MSG: {
-                    Log.v(TAG,
+                    LOG_V(TAG,
                           "processing CLIP_CFG_MSG "
                           "message");
                     auto msg = std::make_unique<Master2Slave::ClipCfgMsg>();
                     msg->deserialize(packet.payload);
-                    Log.v(TAG,
+                    LOG_V(TAG,
                           "CLIP_CFG_MSG message "
                           "deserialized");
                     return msg;
                 }
                 case Master2SlaveMessageID::READ_COND_DATA_MSG: {
-                    Log.v(TAG, "processing READ_COND_DATA_MSG message");
+                    LOG_V(TAG, "processing READ_COND_DATA_MSG message");
                     auto msg =
                         std::make_unique<Master2Slave::ReadCondDataMsg>();
                     msg->deserialize(packet.payload);
-                    Log.v(TAG, "READ_COND_DATA_MSG message deserialized");
+                    LOG_V(TAG, "READ_COND_DATA_MSG message deserialized");
                     return msg;
                 }
                 case Master2SlaveMessageID::READ_RES_DATA_MSG: {
-                    Log.v(TAG, "processing READ_RES_DATA_MSG message");
+                    LOG_V(TAG, "processing READ_RES_DATA_MSG message");
                     auto msg = std::make_unique<Master2Slave::ReadResDataMsg>();
                     msg->deserialize(packet.payload);
-                    Log.v(TAG, "READ_RES_DATA_MSG message deserialized");
+                    LOG_V(TAG, "READ_RES_DATA_MSG message deserialized");
                     return msg;
                 }
                 case Master2SlaveMessageID::READ_CLIP_DATA_MSG: {
-                    Log.v(TAG, "processing READ_CLIP_DATA_MSG message");
+                    LOG_V(TAG, "processing READ_CLIP_DATA_MSG message");
                     auto msg =
                         std::make_unique<Master2Slave::ReadClipDataMsg>();
                     msg->deserialize(packet.payload);
-                    Log.v(TAG, "READ_CLIP_DATA_MSG message deserialized");
+                    LOG_V(TAG, "READ_CLIP_DATA_MSG message deserialized");
                     return msg;
                 }
                 case Master2SlaveMessageID::RST_MSG: {
-                    Log.v(TAG, "processing RST_MSG message");
+                    LOG_V(TAG, "processing RST_MSG message");
                     auto msg = std::make_unique<Master2Slave::RstMsg>();
                     msg->deserialize(packet.payload);
-                    Log.v(TAG, "RST_MSG message deserialized");
+                    LOG_V(TAG, "RST_MSG message deserialized");
                     return msg;
                 }
                 default:
-                    Log.e(TAG,
+                    LOG_E(TAG,
                           "unsupported Master message "
                           "type=0x%02X",
                           static_cast<uint8_t>(packet.message_id));
                     return nullptr;
             }
         } else {
-            Log.e(TAG, "unsupported Packet type=0x%02X", header.packet_id);
+            LOG_E(TAG, "unsupported Packet type=0x%02X", header.packet_id);
             return nullptr;
         }
 
@@ -1806,7 +2386,7 @@ class FrameParser {
             static_cast<uint8_t>(PacketType::Master2Backend)) {
             Master2BackendPacket packet;
             if (!packet.deserialize(packet_data)) {
-                Log.e("M2BP", "Failed to deserialize packet");
+                LOG_E("M2BP", "Failed to deserialize packet");
                 return nullptr;
             }
 
@@ -1824,46 +2404,101 @@ class FrameParser {
                 case Master2BackendMessageID::CTRL_MSG:
                     msgTypeStr = "CTRL_MSG";
                     break;
+                case Master2BackendMessageID::NACK_MSG:
+                    msgTypeStr = "NACK_MSG";
+                    break;
+                case Master2BackendMessageID::RESPONSE_MSG:
+                    msgTypeStr = "RESPONSE_MSG";
+                    break;
+                case Master2BackendMessageID::QUERY_MSG:
+                    msgTypeStr = "QUERY_MSG";
+                    break;
+                case Master2BackendMessageID::DIAG_MSG:
+                    msgTypeStr = "DIAG_MSG";
+                    break;
+                case Master2BackendMessageID::TRACE_MSG:
+                    msgTypeStr = "TRACE_MSG";
+                    break;
+                case Master2BackendMessageID::RESULT_STREAM_MSG:
+                    msgTypeStr = "RESULT_STREAM_MSG";
+                    break;
                 default:
                     break;
             }
 
-            Log.v(TAG, "packet parsed, msg type=%s (0x%02X) ", msgTypeStr,
+            LOG_V(TAG, "packet parsed, msg type=%s (0x%02X) ", msgTypeStr,
                   packet.message_id);
             switch (static_cast<Master2BackendMessageID>(packet.message_id)) {
                 case Master2BackendMessageID::SLAVE_CFG_MSG: {
-                    Log.v(TAG, "processing SLAVE_CFG_MSG message");
+                    LOG_V(TAG, "processing SLAVE_CFG_MSG message");
                     auto msg = std::make_unique<Master2Backend::SlaveCfgMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Master2BackendMessageID::MODE_CFG_MSG: {
-                    Log.v(TAG, "processing MODE_CFG_MSG message");
+                    LOG_V(TAG, "processing MODE_CFG_MSG message");
                     auto msg = std::make_unique<Master2Backend::ModeCfgMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Master2BackendMessageID::RST_MSG: {
-                    Log.v(TAG, "processing RST_MSG message");
+                    LOG_V(TAG, "processing RST_MSG message");
                     auto msg = std::make_unique<Master2Backend::RstMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
                 case Master2BackendMessageID::CTRL_MSG: {
-                    Log.v(TAG, "processing CTRL_MSG message");
+                    LOG_V(TAG, "processing CTRL_MSG message");
                     auto msg = std::make_unique<Master2Backend::CtrlMsg>();
                     msg->deserialize(packet.payload);
                     return msg;
                 }
+                case Master2BackendMessageID::NACK_MSG: {
+                    LOG_V(TAG, "processing NACK_MSG message");
+                    auto msg = std::make_unique<Master2Backend::NackMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Master2BackendMessageID::RESPONSE_MSG: {
+                    LOG_V(TAG, "processing RESPONSE_MSG message");
+                    auto msg = std::make_unique<Master2Backend::ResponseMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Master2BackendMessageID::QUERY_MSG: {
+                    LOG_V(TAG, "processing QUERY_MSG message");
+                    auto msg = std::make_unique<Master2Backend::QueryMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Master2BackendMessageID::DIAG_MSG: {
+                    LOG_V(TAG, "processing DIAG_MSG message");
+                    auto msg = std::make_unique<Master2Backend::DiagMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Master2BackendMessageID::TRACE_MSG: {
+                    LOG_V(TAG, "processing TRACE_MSG message");
+                    auto msg = std::make_unique<Master2Backend::TraceMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
+                case Master2BackendMessageID::RESULT_STREAM_MSG: {
+                    LOG_V(TAG, "processing RESULT_STREAM_MSG message");
+                    auto msg =
+                        std::make_unique<Master2Backend::ResultStreamMsg>();
+                    msg->deserialize(packet.payload);
+                    return msg;
+                }
                 default:
-                    Log.e(TAG,
+                    LOG_E(TAG,
                           "unsupported Master2Backend message "
                           "type=0x%02X",
                           static_cast<uint8_t>(packet.message_id));
                     return nullptr;
             }
         } else {
-            Log.e(TAG, "unsupported Packet type=0x%02X", header.packet_id);
+            LOG_E(TAG, "unsupported Packet type=0x%02X", header.packet_id);
             return nullptr;
         }
 #endif
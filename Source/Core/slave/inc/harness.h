@@ -8,11 +8,15 @@
 #include "TimerCPP.h"
 #include "bsp_gpio.hpp"
 #include "bsp_log.hpp"
+#include "bsp_tcm.hpp"
+#include "bsp_trace.hpp"
 #include "peripherals.hpp"
 
 class BinaryMatrix {
    private:
-    std::vector<std::vector<int>> matrix;
+    // 扫描时逐行写入，优先放在TCM
+    using Row = std::vector<int, TcmAllocator<int>>;
+    std::vector<Row, TcmAllocator<Row>> matrix;
 
    public:
     size_t rows, cols;
@@ -51,8 +55,8 @@ class BinaryMatrix {
         cols = new_cols;
     }
 
-    std::vector<uint8_t> flatten() const {
-        std::vector<uint8_t> result;
+    PoolVector<uint8_t> flatten() const {
+        PoolVector<uint8_t> result;
         size_t byteCount = (rows * cols + 7) / 8;    // 计算需要的字节数
         result.reserve(byteCount);                   // 预分配空间
 
@@ -169,6 +173,7 @@ class Harness {
         if (count > 0) {
             triggerCount = 0;
             maxTriggerCount = count;
+            TRACE_BEGIN(SCAN, count);
             harnessTimer.start();
         }
     }
@@ -176,6 +181,7 @@ class Harness {
     void myTimerCallback() {
         if (maxTriggerCount > 0 && triggerCount++ >= maxTriggerCount) {
             harnessTimer.stop();
+            TRACE_END(SCAN, rowIndex);
             reload();
             runLed.toggle();
             return;
@@ -207,6 +213,7 @@ class Harness {
     }
 
     void run() {
+        TRACE_BEGIN(SCAN_ROW, rowIndex);
         // set current pin
         int lastIndex = rowIndex - startConductionNum - 1;
         if (lastIndex >= 0 && lastIndex < conductionNum) {
@@ -223,9 +230,12 @@ class Harness {
             }
         }
         TaskBase::delay(4);
+        TRACE_BEGIN(SCAN_SAMPLE, data.cols);
         for (size_t i = 0; i < data.cols; i++) {
             data.setValue(rowIndex, i, pins[i].input_bit_get());
         }
+        TRACE_END(SCAN_SAMPLE, rowIndex);
+        TRACE_END(SCAN_ROW, rowIndex);
     }
 
     void init(uint8_t conductionNum, uint16_t totalConductionNum,
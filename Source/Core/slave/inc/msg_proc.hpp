@@ -5,9 +5,12 @@
 #include "QueueCPP.h"
 #include "SemaphoreCPP.h"
 #include "TaskCPP.h"
+#include "bsp_allocate.hpp"
+#include "bsp_diag.hpp"
 #include "bsp_log.hpp"
 #include "harness.h"
 #include "protocol.hpp"
+#include "uwb_aggregator.hpp"
 #include "uwb_interface.hpp"
 
 #define SLAVE_USE_UWB
@@ -16,6 +19,17 @@
 #define MsgProc_TX_QUEUE_TIMEOUT 1000
 // 发送超时
 #define MsgProc_TX_TIMEOUT 1000
+// 回复帧聚合等待时间，ms，0表示立即发送
+#define ManagerDataTransferTask_TX_FLUSH_DEADLINE_MS 0
+// 每多少次导通数据回复附带一次运行诊断快照，0为不附带。
+// 未更新的主机会拒收带快照的回复帧，缺省不附带，全部主机支持后
+// 以-DDIAG_SLAVE_PERIOD=10等方式打开
+#ifndef DIAG_SLAVE_PERIOD
+#define DIAG_SLAVE_PERIOD 0
+#endif
+// 从机快照包含的内容(Diag::Section)，从机没有网络协议栈
+#define DIAG_SLAVE_SECTIONS \
+    (Diag::HEAP | Diag::POOL | Diag::SUBSYS | Diag::QUEUE | Diag::TASK)
 
 #define ManagerDataTransferTask_SIZE     1024
 #define ManagerDataTransferTask_PRIORITY TaskPrio_High
@@ -28,7 +42,10 @@ class ManagerDataTransferMsg {
           tx_done_sem("tx_done_sem"),
 
           tx_data_queue("manager_tx_data_queue"),
-          rx_data_queue("manager_rx_data_queue") {}
+          rx_data_queue("manager_rx_data_queue") {
+        Diag::watch_queue(tx_data_queue, "uwb_tx");
+        Diag::watch_queue(rx_data_queue, "uwb_rx");
+    }
 
    public:
     BinarySemaphore rx_done_sem;
@@ -49,12 +66,18 @@ class ManagerDataTransferTask
    private:
     ManagerDataTransferMsg& transfer_msg;
     void task() override {
+        Diag::set_subsystem(Diag::Subsystem::UWB);
         UWB<UwbUartInterface> uwb;
-        Log.i("ManagerDataTransferTask", "uwb.size=%d", sizeof(uwb));
-        std::vector<uint8_t> buffer = {1, 2, 3, 4, 5};
+        UwbAggregator<UWB<UwbUartInterface>> aggregator(
+            uwb, ManagerDataTransferTask_TX_FLUSH_DEADLINE_MS);
+        LOG_I("ManagerDataTransferTask", "uwb.size=%d", sizeof(uwb));
+        PoolVector<uint8_t> buffer = {1, 2, 3, 4, 5};
         uint8_t data = 0;
-        std::vector<uint8_t> rx;
-        uwb.set_recv_mode();
+        PoolVector<uint8_t> rx;
+        // 已入队、所在批次尚未发出的帧，发出后才通知发送完成
+        bool tx_pending = false;
+        // 接收模式由UWB层维护，发送后在update中重新进入
+        uwb.keep_recv_mode();
 
         for (;;) {
             if (transfer_msg.tx_request_sem.take(0)) {
@@ -63,12 +86,18 @@ class ManagerDataTransferTask
                 while (transfer_msg.tx_data_queue.pop(data, 0)) {
                     buffer.push_back(data);
                 }
-                uwb.data_transmit(buffer);
+                if (!aggregator.push(buffer.data(), buffer.size())) {
+                    LOG_E("ManagerDataTransferTask", "uwb transmit failed");
+                }
+                tx_pending = true;
+            }
+            aggregator.update();
+            if (tx_pending && !aggregator.pending()) {
+                tx_pending = false;
                 transfer_msg.tx_done_sem.give();
-                uwb.set_recv_mode();
             }
 
-            if (uwb.get_recv_data(buffer)) {
+            while (aggregator.pop(buffer)) {
                 for (auto it = buffer.begin(); it != buffer.end(); it++) {
                     transfer_msg.rx_data_queue.add(*it);
                 }
@@ -87,7 +116,7 @@ class MsgProc {
         : transfer_msg(__transfer_msg) {}
 
     static constexpr const char TAG[] = "MsgProc";
-    std::vector<uint8_t> recv_data;
+    PoolVector<uint8_t> recv_data;
 
    public:
     ManagerDataTransferMsg& transfer_msg;
@@ -106,18 +135,18 @@ class MsgProc {
                 // 处理解析后的数据
                 msg->process();
             } else {
-                Log.e(TAG, "parse failed");
+                LOG_E(TAG, "parse failed");
             }
             recv_data.clear();
         }
     }
 
-    bool send(std::vector<uint8_t>& frame) {
+    bool send(PoolVector<uint8_t>& frame) {
         // 将发送数据写入队列
         for (auto it = frame.begin(); it != frame.end(); it++) {
             if (transfer_msg.tx_data_queue.add(*it, MsgProc_TX_QUEUE_TIMEOUT) ==
                 false) {
-                Log.e(TAG, "tx_data_queue.add failed");
+                LOG_E(TAG, "tx_data_queue.add failed");
                 return false;
             }
         }
@@ -127,7 +156,7 @@ class MsgProc {
 
         // 等待数据发送完成
         if (transfer_msg.tx_done_sem.take(MsgProc_TX_TIMEOUT) == false) {
-            Log.e(TAG, "tx_done_sem.take failed, timeout");
+            LOG_E(TAG, "tx_done_sem.take failed, timeout");
             return false;
         }
         return true;
@@ -10,7 +10,9 @@
 #include "QueueCPP.h"
 #include "SemaphoreCPP.h"
 #include "TaskCPP.h"
+#ifndef HOST_SIM
 #include "battery.hpp"
+#endif
 #include "bsp_gpio.hpp"
 #include "bsp_led.hpp"
 #include "bsp_log.hpp"
@@ -31,5 +33,17 @@ extern "C" {
 }
 #endif
 
+// 从机启动任务栈大小(字)：栈上有LOG格式化缓冲区和vsnprintf，
+// 并执行任务对象的构造及CPU占用、事件跟踪日志输出，留出一倍余量
+#define SlaveTask_SIZE 2 * 1024
+
 #define MsgProcTask_SIZE     1024
-#define MsgProcTask_PRIORITY TaskPrio_High
\ No newline at end of file
+#define MsgProcTask_PRIORITY TaskPrio_High
+
+// RUN_TIME_STATS构建中输出CPU占用日志的间隔(秒)
+#define RUN_TIME_STATS_LOG_INTERVAL 10
+
+// EVENT_TRACE构建中导出事件跟踪到日志的间隔(秒)，每段记录数和每行字节数
+#define TRACE_LOG_INTERVAL 30
+#define TRACE_LOG_CHUNK    16
+#define TRACE_LOG_LINE     32
\ No newline at end of file
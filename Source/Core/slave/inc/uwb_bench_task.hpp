@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+
+#include "TaskCPP.h"
+#include "bsp_log.hpp"
+#include "uwb.hpp"
+#include "uwb_bench.hpp"
+#include "uwb_interface.hpp"
+
+#define UwbBenchTask_SIZE     1024
+#define UwbBenchTask_PRIORITY TaskPrio_High
+
+/**
+ * @brief UWB链路基准测试应答端，收到测试包后打上接收时间原样回复
+ */
+class UwbBenchTask : public TaskClassS<UwbBenchTask_SIZE> {
+   public:
+    UwbBenchTask() : TaskClassS("UwbBenchTask", UwbBenchTask_PRIORITY) {}
+
+   private:
+    void task() override {
+        UWB<UwbUartInterface> uwb;
+        uwb.keep_recv_mode();
+        UwbBench<UWB<UwbUartInterface>> bench(uwb);
+        uint32_t served = 0;
+        uint32_t last_log = uwb.get_system_1ms_ticks();
+        for (;;) {
+            served += bench.serve();
+            if (uwb.get_system_1ms_ticks() - last_log >= 10000) {
+                last_log = uwb.get_system_1ms_ticks();
+                LOG_I("UwbBenchTask", "served %lu packets",
+                      (unsigned long)served);
+            }
+            TaskBase::delay(1);
+        }
+    }
+};
@@ -4,20 +4,22 @@
 
 #include "bsp_led.hpp"
 #include "bsp_log.hpp"
+#include "bsp_tcm.hpp"
 
 extern Uart uart3;
 extern MsgProc msgProc;
 
-Harness harness;
+// 扫描状态每行都访问，放在TCM
+TCM_BSS Harness harness;
 namespace Master2Slave {
 void SyncMsg::process() {
-    Log.d("SyncMsg","process");
+    LOG_D("SyncMsg","process");
     runLed.off();
     harness.startWithCount(CondCfgMsg::totalConductionNum);
 }
 
 void CondCfgMsg::process() {
-    Log.d("CondCfgMsg","process");
+    LOG_D("CondCfgMsg","process");
 
     // 1. REPLY
     // 1.1 构造 CondCfgMsg
@@ -40,13 +42,21 @@ void CondCfgMsg::process() {
     msgProc.send(condInfoFrame);
 }
 
-void ResCfgMsg::process() { Log.d("ResCfgMsg","process"); }
-void ClipCfgMsg::process() { Log.d("ClipCfgMsg","process"); }
+void ResCfgMsg::process() { LOG_D("ResCfgMsg","process"); }
+void ClipCfgMsg::process() { LOG_D("ClipCfgMsg","process"); }
 void ReadCondDataMsg::process() {
-    Log.d("ReadCondDataMsg","process");
+    LOG_D("ReadCondDataMsg","process");
+    TRACE_BEGIN(COND_REPLY, 0);
     Slave2Backend::CondDataMsg condDataMsg;
     condDataMsg.conductionData = harness.data.flatten();
     condDataMsg.conductionLength = condDataMsg.conductionData.size();
+    // 每DIAG_SLAVE_PERIOD次回复附带一次运行诊断快照
+    static uint16_t diag_count = 0;
+    condDataMsg.diagData.clear();
+    if (DIAG_SLAVE_PERIOD != 0 && ++diag_count >= DIAG_SLAVE_PERIOD) {
+        diag_count = 0;
+        Diag::serialize(condDataMsg.diagData, DIAG_SLAVE_SECTIONS);
+    }
     // 2. 打包为 Packet
     uint32_t uid = UIDReader::get();
     auto condDataPacket = PacketPacker::slave2BackendPack(condDataMsg, uid);
@@ -54,35 +64,51 @@ void ReadCondDataMsg::process() {
     auto master_data = FramePacker::pack(condDataPacket);
     // 1.4 发送
     msgProc.send(master_data);
+    TRACE_END(COND_REPLY, master_data.size());
 }
-void ReadResDataMsg::process() { Log.d("ReadResDataMsg","process"); }
-void ReadClipDataMsg::process() { Log.d("ReadClipDataMsg","process"); }
-void RstMsg::process() { Log.d("RstMsg","process"); }
+void ReadResDataMsg::process() { LOG_D("ReadResDataMsg","process"); }
+void ReadClipDataMsg::process() { LOG_D("ReadClipDataMsg","process"); }
+void RstMsg::process() { LOG_D("RstMsg","process"); }
 };    // namespace Master2Slave
 
 namespace Slave2Master {
-void Slave2Master::CondCfgMsg::process() { Log.d("CondCfgMsg","process"); }
-void Slave2Master::ResCfgMsg::process() { Log.d("ResCfgMsg","process"); }
-void Slave2Master::ClipCfgMsg::process() { Log.d("ClipCfgMsg","process"); }
-void Slave2Master::RstMsg::process() { Log.d("RstMsg","process"); }
+void Slave2Master::CondCfgMsg::process() { LOG_D("CondCfgMsg","process"); }
+void Slave2Master::ResCfgMsg::process() { LOG_D("ResCfgMsg","process"); }
+void Slave2Master::ClipCfgMsg::process() { LOG_D("ClipCfgMsg","process"); }
+void Slave2Master::RstMsg::process() { LOG_D("RstMsg","process"); }
 }    // namespace Slave2Master
 
 namespace Backend2Master {
-void Backend2Master::SlaveCfgMsg::process() { Log.d("SlaveCfgMsg"," process"); }
-void Backend2Master::ModeCfgMsg::process() { Log.d("ModeCfgMsg","process"); }
-void Backend2Master::RstMsg::process() { Log.d("RstMsg","process"); }
-void Backend2Master::CtrlMsg::process() { Log.d("CtrlMsg","process"); }
+void Backend2Master::SlaveCfgMsg::process() { LOG_D("SlaveCfgMsg"," process"); }
+void Backend2Master::ModeCfgMsg::process() { LOG_D("ModeCfgMsg","process"); }
+void Backend2Master::RstMsg::process() { LOG_D("RstMsg","process"); }
+void Backend2Master::CtrlMsg::process() { LOG_D("CtrlMsg","process"); }
+void Backend2Master::NackMsg::process() { LOG_D("NackMsg","process"); }
+void Backend2Master::RequestMsg::process() { LOG_D("RequestMsg","process"); }
+void Backend2Master::QueryMsg::process() { LOG_D("QueryMsg", "process"); }
+void Backend2Master::DiagMsg::process() { LOG_D("DiagMsg", "process"); }
+void Backend2Master::TraceMsg::process() { LOG_D("TraceMsg", "process"); }
 }    // namespace Backend2Master
 
 namespace Master2Backend {
-void Master2Backend::SlaveCfgMsg::process() { Log.d("SlaveCfgMsg"," process"); }
-void Master2Backend::ModeCfgMsg::process() { Log.d("ModeCfgMsg","process"); }
-void Master2Backend::RstMsg::process() { Log.d("RstMsg","process"); }
-void Master2Backend::CtrlMsg::process() { Log.d("CtrlMsg","process"); }
+void Master2Backend::SlaveCfgMsg::process() { LOG_D("SlaveCfgMsg"," process"); }
+void Master2Backend::ModeCfgMsg::process() { LOG_D("ModeCfgMsg","process"); }
+void Master2Backend::RstMsg::process() { LOG_D("RstMsg","process"); }
+void Master2Backend::CtrlMsg::process() { LOG_D("CtrlMsg","process"); }
+void Master2Backend::NackMsg::process() { LOG_D("NackMsg","process"); }
+void Master2Backend::ResultStreamMsg::process() {
+    LOG_D("ResultStreamMsg", "process");
+}
+void Master2Backend::ResponseMsg::process() {
+    LOG_D("ResponseMsg", "process");
+}
+void Master2Backend::QueryMsg::process() { LOG_D("QueryMsg", "process"); }
+void Master2Backend::DiagMsg::process() { LOG_D("DiagMsg", "process"); }
+void Master2Backend::TraceMsg::process() { LOG_D("TraceMsg", "process"); }
 }    // namespace Master2Backend
 
 namespace Slave2Backend {
-void Slave2Backend::CondDataMsg::process() { Log.d("CondDataMsg","process"); }
-void Slave2Backend::ResDataMsg::process() { Log.d("ResDataMsg","process"); }
-void Slave2Backend::ClipDataMsg::process() { Log.d("ClipDataMsg","process"); }
+void Slave2Backend::CondDataMsg::process() { LOG_D("CondDataMsg","process"); }
+void Slave2Backend::ResDataMsg::process() { LOG_D("ResDataMsg","process"); }
+void Slave2Backend::ClipDataMsg::process() { LOG_D("ClipDataMsg","process"); }
 }    // namespace Slave2Backend
\ No newline at end of file
@@ -1,5 +1,10 @@
 
 #include "slave_mode.hpp"
+
+#include "bsp_allocate.hpp"
+#include "bsp_tcm.hpp"
+#include "bsp_trace.hpp"
+#include "uwb_bench_task.hpp"
 #ifdef SLAVE
 
 ManagerDataTransferMsg manager_transfer_msg;
@@ -11,6 +16,7 @@ class MsgProcTask : public TaskClassS<MsgProcTask_SIZE> {
         : TaskClassS<MsgProcTask_SIZE>("MsgProcTask", MsgProcTask_PRIORITY) {}
 
     void task() override {
+        Diag::set_subsystem(Diag::Subsystem::PROTOCOL);
         for (;;) {
             msgProc.proc();
             TaskBase::delay(1);
@@ -18,36 +24,128 @@ class MsgProcTask : public TaskClassS<MsgProcTask_SIZE> {
     }
 };
 
+#ifdef RUN_TIME_STATS
+// 输出自上次采样以来的CPU占用，千分比按百分比一位小数显示
+static void log_cpu_load() {
+    static constexpr const char TAG[] = "CPU";
+    static Diag::CpuSample cpu;
+    if (!Diag::cpu_sample(cpu)) {
+        return;
+    }
+    LOG_I(TAG, "window %lu us, isr %u.%u%%", (unsigned long)cpu.window_us,
+          cpu.isr_permille / 10, cpu.isr_permille % 10);
+    for (const Diag::CpuLoad& isr : cpu.isr) {
+        LOG_I(TAG, "  isr %-8s %u.%u%% %lu", isr.name, isr.permille / 10,
+              isr.permille % 10, (unsigned long)isr.count);
+    }
+    for (uint8_t i = 0; i < cpu.task_num; i++) {
+        LOG_I(TAG, "  task %-12s %u.%u%%", cpu.task[i].name,
+              cpu.task[i].permille / 10, cpu.task[i].permille % 10);
+    }
+}
+#endif
+
+#ifdef EVENT_TRACE
+// 以十六进制行把事件跟踪导出到日志，由Scripts/trace_export.py还原；
+// 每行之后让出，避免日志队列满丢行
+static void log_trace_dump() {
+    static constexpr const char TAG[] = "TRACE";
+    static constexpr char hex[] = "0123456789ABCDEF";
+    PoolVector<uint8_t> chunk;
+    char line[TRACE_LOG_LINE * 2 + 1];
+    Trace::freeze();
+    LOG_I(TAG, "dump begin");
+    uint16_t start = 0;
+    do {
+        chunk.clear();
+        start = Trace::serialize(chunk, start, TRACE_LOG_CHUNK);
+        for (size_t pos = 0; pos < chunk.size(); pos += TRACE_LOG_LINE) {
+            size_t n = std::min(chunk.size() - pos, (size_t)TRACE_LOG_LINE);
+            for (size_t i = 0; i < n; i++) {
+                line[i * 2] = hex[chunk[pos + i] >> 4];
+                line[i * 2 + 1] = hex[chunk[pos + i] & 0xF];
+            }
+            line[n * 2] = '\0';
+            LOG_I(TAG, "%s", line);
+            TaskBase::delay(2);
+        }
+    } while (start != 0);
+    LOG_I(TAG, "dump end");
+    Trace::resume();
+}
+#endif
+
 static void Slave_Task(void* pvParameters) {
     static constexpr const char TAG[] = "BOOT";
-    Log.d(TAG,"Slave Firmware %s, Build: %s %s", FIRMWARE_VERSION, __DATE__, __TIME__);
+    LOG_D(TAG,"Slave Firmware %s, Build: %s %s", FIRMWARE_VERSION, __DATE__, __TIME__);
     uint32_t myUid = UIDReader::get();
-    Log.d(TAG, "Slave UID: %08X", myUid);
+    LOG_D(TAG, "Slave UID: %08X", myUid);
 
-    LogTask logTask(Log);
+    // 任务对象定义为静态对象放在.bss，STATIC_ALLOCATION构建中其任务栈
+    // 不占用本任务的栈
+    static LogTask logTask(Log);
     logTask.give();
-    Log.d(TAG, "LogTask initialized");
+    LOG_D(TAG, "LogTask initialized");
 
-    ManagerDataTransferTask manageDataTransferTask(manager_transfer_msg);
-    MsgProcTask msgProcTask;
+#ifdef UWB_BENCHMARK
+    // UWB链路基准测试应答端，独占UWB
+    static UwbBenchTask uwbBenchTask;
+    uwbBenchTask.give();
+    LOG_D(TAG, "UwbBenchTask initialized");
+#else
+    static ManagerDataTransferTask manageDataTransferTask(
+        manager_transfer_msg);
+    static MsgProcTask msgProcTask;
 
     manageDataTransferTask.give();
-    Log.d(TAG, "ManagerDataTransferTask initialized");
+    LOG_D(TAG, "ManagerDataTransferTask initialized");
     msgProcTask.give();
-    Log.d(TAG, "MsgProcTask initialized");
+    LOG_D(TAG, "MsgProcTask initialized");
+#endif
 
     // 系统初始化完成，打开电源指示灯
     pwrLed.on();
 
+#ifdef RUN_TIME_STATS
+    uint32_t cpu_log_count = 0;
+#endif
+#ifdef EVENT_TRACE
+    uint32_t trace_log_count = 0;
+#endif
+#ifdef TCM_PLACEMENT
+    uint32_t dma_fallback = 0;
+#endif
     while (1) {
-        // Log.d("heap minimum: %d", xPortGetMinimumEverFreeHeapSize());
+        // LOG_D("heap minimum: %d", xPortGetMinimumEverFreeHeapSize());
         sysLed.toggle();
         vTaskDelay(pdMS_TO_TICKS(1000));
+#ifdef TCM_PLACEMENT
+        // TCM中的缓冲区退回逐字节发送时提示
+        uint32_t n = TcmHeap::stats().dma_fallback;
+        if (n != dma_fallback) {
+            LOG_W(TAG, "TCM buffers sent without DMA: %lu", (unsigned long)n);
+            dma_fallback = n;
+        }
+#endif
+#ifdef RUN_TIME_STATS
+        if (++cpu_log_count >= RUN_TIME_STATS_LOG_INTERVAL) {
+            cpu_log_count = 0;
+            log_cpu_load();
+        }
+#endif
+#ifdef EVENT_TRACE
+        if (++trace_log_count >= TRACE_LOG_INTERVAL) {
+            trace_log_count = 0;
+            log_trace_dump();
+        }
+#endif
     }
 }
 
 int Slave_Init(void) {
-    xTaskCreate(Slave_Task, "MasterTask", 4 * 1024, NULL, 2, NULL);
+    // STATIC_ALLOCATION构建中TCB和栈为静态存储
+    static TaskS<SlaveTask_SIZE> slave_task("MasterTask", Slave_Task,
+                                            static_cast<TaskPriority>(2));
 
     return 0;
 }
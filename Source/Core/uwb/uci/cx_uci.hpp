@@ -5,6 +5,7 @@
 #include <cstring>
 #include <vector>
 
+#include "bsp_allocate.hpp"
 #include "cx_uci_def.hpp"
 
 // extern Logger Log;
@@ -18,7 +19,7 @@ class UciCtrlPcketBase {
     uint8_t mt;                     // Message Type
     uint8_t gid;                    // Group ID
     uint8_t oid;                    // Object ID
-    std::vector<uint8_t> packet;    // Packet
+    PoolVector<uint8_t> packet;    // Packet
 };
 
 class UciCtrlPacket : public UciCtrlPcketBase {
@@ -46,6 +47,8 @@ class UciCtrlPacket : public UciCtrlPcketBase {
     ParserSta parser_sta = PARSE_START;
     uint16_t pkt_recv_len = 0;
     bool recv_packet = false;
+    const uint8_t* view = nullptr;    // 已接收数据包的负载
+    uint16_t view_len = 0;
 
    public:
     void reset() {
@@ -57,10 +60,12 @@ class UciCtrlPacket : public UciCtrlPcketBase {
         parser_sta = PARSE_START;
         pkt_recv_len = 0;
         recv_packet = false;
+        view = nullptr;
+        view_len = 0;
     }
-    bool build_packet(const std::vector<uint8_t>& total_payload) {
+    bool build_packet(const uint8_t* total_payload, uint16_t total_len) {
         size_t residual_len =
-            total_payload.size() - payload_offset;    // 剩余待发送的字节长度
+            total_len - payload_offset;    // 剩余待发送的字节长度
         sending = true;
 
         if (residual_len > MAX_PAYLOAD_LEN) {
@@ -77,7 +82,7 @@ class UciCtrlPacket : public UciCtrlPcketBase {
         current_packet_len =
             currunt_payload_len + UCI_CTRL_PKT_HDR_SIZE;    // 加上头4个字节
 
-        // 清空output数组，长度为current_packet_len
+        // packet容量复用，resize不会重复分配内存
         packet.resize(current_packet_len);
 
         // 构建uci control packet header
@@ -85,10 +90,8 @@ class UciCtrlPacket : public UciCtrlPcketBase {
 
         // 复制payload到output，从output的第4个字节开始复制，长度为currunt_payload_len
         if (currunt_payload_len > 0) {
-            std::copy(
-                total_payload.begin() + payload_offset,
-                total_payload.begin() + payload_offset + currunt_payload_len,
-                packet.begin() + UCI_CTRL_PKT_HDR_SIZE);
+            memcpy(packet.data() + UCI_CTRL_PKT_HDR_SIZE,
+                   total_payload + payload_offset, currunt_payload_len);
         }
 
         // 更新payload_offset，以便下一次调用时可以正确地复制payload
@@ -103,19 +106,80 @@ class UciCtrlPacket : public UciCtrlPcketBase {
         return is_last_packet;
     }
 
-    bool flow_parse(uint8_t& data, std::vector<uint8_t>& total_payload) {
-        switch (parser_sta) {
-            case PARSE_START: {
-                recv_packet = false;
-                total_payload.clear();
-                parser_sta = MT_PBF_GID_BYTE;
+    bool build_packet(const PoolVector<uint8_t>& total_payload) {
+        return build_packet(total_payload.data(), total_payload.size());
+    }
+
+    /**
+     * @brief 从连续缓冲区解析UCI控制包
+     * @param data 数据起始地址
+     * @param len 数据长度
+     * @return 本次消耗的字节数。收到完整数据包后立即返回，由ready()判断，
+     *         负载通过payload()/payload_len()访问。
+     *         不分段且整块位于data内的负载原地引用data，不拷贝，在调用方
+     *         释放data前有效，需要保留时调用keep()；分段或跨越缓冲区边界
+     *         的负载按段拷贝到packet，下一次parse前有效
+     */
+    uint16_t parse(const uint8_t* data, uint16_t len) {
+        uint16_t used = 0;
+        if (parser_sta == PARSE_START) {
+            recv_packet = false;
+            packet.clear();
+            view = nullptr;
+            view_len = 0;
+            parser_sta = MT_PBF_GID_BYTE;
+        }
+        while (used < len) {
+            if (parser_sta == PAYLOAD_BYTES) {
+                uint16_t n = std::min<uint16_t>(
+                    len - used, currunt_payload_len - pkt_recv_len);
+                if (is_last_packet && packet.empty() &&
+                    n == currunt_payload_len) {
+                    view = data + used;
+                    view_len = n;
+                } else {
+                    packet.insert(packet.end(), data + used, data + used + n);
+                }
+                used += n;
+                pkt_recv_len += n;
+                if (pkt_recv_len == currunt_payload_len) {
+                    __segment_done();
+                }
+            } else {
+                __parse_header_byte(data[used++]);
+            }
+            if (recv_packet) {
+                break;
             }
+        }
+        return used;
+    }
+
+    /* 是否已收到完整数据包 */
+    bool ready() const { return recv_packet; }
+
+    /* 已接收数据包的负载 */
+    const uint8_t* payload() const { return view; }
+    uint16_t payload_len() const { return view_len; }
+
+    /* 原地引用的负载拷贝到packet，释放接收缓冲区后继续有效 */
+    void keep() {
+        if (view != packet.data()) {
+            packet.assign(view, view + view_len);
+            view = packet.data();
+        }
+    }
+
+   private:
+    void __parse_header_byte(uint8_t data) {
+        switch (parser_sta) {
             case MT_PBF_GID_BYTE: {
                 mt = (data >> 5) & 0x07;
                 pbf = (data >> 4) & 0x01;
                 gid = data & 0x0F;
                 if ((mt != MT_CMD) && (mt != MT_RSP) && (mt != MT_NTF)) {
-                    parser_sta = PARSE_START;
+                    // 非法包头，丢弃已收到的分段，重新同步
+                    packet.clear();
                     break;
                 }
                 if (pbf == PBF_COMPLETE) {
@@ -143,32 +207,32 @@ class UciCtrlPacket : public UciCtrlPcketBase {
                 if (currunt_payload_len > 0) {
                     parser_sta = PAYLOAD_BYTES;
                 } else {
-                    recv_packet = true;
-                    parser_sta = PARSE_START;
+                    __segment_done();
                 }
                 break;
             }
-            case PAYLOAD_BYTES: {
-                total_payload.push_back(data);
-                pkt_recv_len++;
-                if (pkt_recv_len == currunt_payload_len) {
-                    recv_packet = true;
-                    if (is_last_packet) {
-                        // 是最后一个数据包，重置状态
-                        parser_sta = PARSE_START;
-                    } else {
-                        // 不是最后一个数据包，等待下一个数据包的开始
-                        parser_sta = MT_PBF_GID_BYTE;
-                    }
-                }
+            default: {
                 break;
             }
         }
-        return (is_last_packet & recv_packet);
     }
 
-   private:
-    void __build_header(std::vector<uint8_t>& output) {
+    void __segment_done() {
+        if (is_last_packet) {
+            // 是最后一个数据包，重置状态
+            if (view == nullptr) {
+                view = packet.data();
+                view_len = packet.size();
+            }
+            recv_packet = true;
+            parser_sta = PARSE_START;
+        } else {
+            // 不是最后一个数据包，等待下一个数据包的开始
+            parser_sta = MT_PBF_GID_BYTE;
+        }
+    }
+
+    void __build_header(PoolVector<uint8_t>& output) {
         output[0] = (mt & 0x07) << 5;
         output[0] |= ((pbf & 0x01) << 4);
         output[0] |= (gid & 0x0F);
@@ -176,20 +240,6 @@ class UciCtrlPacket : public UciCtrlPcketBase {
         output[2] = currunt_payload_len >> 8;
         output[3] = currunt_payload_len & 0xFF;
     }
-
-    void __parse_header(std::vector<uint8_t>& input) {
-        mt = input[0] >> 5;
-        pbf = (input[0] >> 4) & 0x01;
-        gid = input[0] & 0x0F;
-        oid = input[1] & 0x3F;
-        currunt_payload_len = input[3];
-
-        if (pbf == PBF_COMPLETE) {
-            is_last_packet = true;
-        } else {
-            is_last_packet = false;
-        }
-    }
 };
 
 class UciCMD : private UciCtrlPacket {
@@ -197,10 +247,10 @@ class UciCMD : private UciCtrlPacket {
     UciCMD() : packet(UciCtrlPacket::packet) {}
 
    public:
-    std::vector<uint8_t>& packet;
+    PoolVector<uint8_t>& packet;
 
    private:
-    std::vector<uint8_t> payload;
+    PoolVector<uint8_t> payload;
 
    public:
     uint16_t payload_len() { return payload.size(); }
@@ -225,7 +275,7 @@ class UciCMD : private UciCtrlPacket {
         if (rsp.oid != CORE_DEVICE_RESET_CMD) {
             return false;
         }
-        if (rsp.packet[0] != STATUS_OK) {
+        if (rsp.payload_len() == 0 || rsp.payload()[0] != STATUS_OK) {
             return false;
         }
         return true;
@@ -251,16 +301,19 @@ class UciCMD : private UciCtrlPacket {
 
     bool core_set_config() { return false; }
 
-    bool cx_app_data_tx(const std::vector<uint8_t>& data) {
-        if (data.size() > CX_APP_DATA_TX_MAX_PAYLOAD_LEN) {
+    bool cx_app_data_tx(const uint8_t* data, uint16_t len) {
+        if (len > CX_APP_DATA_TX_MAX_PAYLOAD_LEN) {
             return false;
         }
-        payload.resize(data.size());
-        payload.assign(data.begin(), data.end());
+        // 应用数据直接打包进packet，不经过payload中转
         mt = MT_CMD;
         gid = GID0x03;
         oid = CX_APP_DATA_TX_CMD;
-        return build_packet(payload);
+        return build_packet(data, len);
+    }
+
+    bool cx_app_data_tx(const PoolVector<uint8_t>& data) {
+        return cx_app_data_tx(data.data(), data.size());
     }
 
     bool check_cx_app_data_tx_rsp(const UciCtrlPacket& rsp) {
@@ -273,7 +326,7 @@ class UciCMD : private UciCtrlPacket {
         if (rsp.oid != CX_APP_DATA_TX_CMD) {
             return false;
         }
-        if (rsp.packet[0] != STATUS_OK) {
+        if (rsp.payload_len() == 0 || rsp.payload()[0] != STATUS_OK) {
             return false;
         }
         return true;
@@ -298,7 +351,7 @@ class UciCMD : private UciCtrlPacket {
         if (rsp.oid != CX_APP_DATA_RX_CMD) {
             return false;
         }
-        if (rsp.packet[0] != STATUS_OK) {
+        if (rsp.payload_len() == 0 || rsp.payload()[0] != STATUS_OK) {
             return false;
         }
         return true;
@@ -322,7 +375,7 @@ class UciCMD : private UciCtrlPacket {
         if (rsp.oid != CX_APP_DATA_STOP_RX_CMD) {
             return false;
         }
-        if (rsp.packet[0] != STATUS_OK) {
+        if (rsp.payload_len() == 0 || rsp.payload()[0] != STATUS_OK) {
             return false;
         }
         return true;
@@ -333,16 +386,20 @@ class UciNTF : private UciCtrlPacket {
    public:
     UciNTF() = default;
 
-    uint8_t parse_core_device_status_ntf(std::vector<uint8_t>& payload) {
-        return payload[0];
+    uint8_t parse_core_device_status_ntf(const uint8_t* payload,
+                                         uint16_t len) {
+        return len > 0 ? payload[0] : DEVICE_STATE_ERROR;
     }
 
-    uint8_t parse_cx_app_data_tx_ntf(std::vector<uint8_t>& payload) {
-        return payload[0];
+    uint8_t parse_cx_app_data_tx_ntf(const uint8_t* payload, uint16_t len) {
+        return len > 0 ? payload[0] : STATUS_FAILED;
     }
-    bool parse_cx_app_data_rx_ntf(std::vector<uint8_t>& payload) {
+    bool parse_cx_app_data_rx_ntf(const uint8_t* payload, uint16_t len) {
+        if (len < 2) {
+            return false;
+        }
         uint16_t data_len = payload[0] | (payload[1] << 8);
-        if (data_len != payload.size() - 2) {
+        if (data_len != len - 2) {
             return false;
         }
         return true;
@@ -8,6 +8,7 @@
 #include <queue>
 #include <vector>
 
+#include "bsp_trace.hpp"
 #include "cx_uci.hpp"
 
 // #include "bsp_log.hpp"
@@ -53,15 +54,20 @@ class CxUwbInterface {
      * @param tx_data 发送数据
      * @return 发送成功返回true，失败返回false
      */
-    virtual bool send(std::vector<uint8_t>& tx_data) = 0;
+    virtual bool send(PoolVector<uint8_t>& tx_data) = 0;
 
     /**
-     * @brief 接收数据
-     * @param rx_data 接收数据
-     * @return 接收成功返回true，失败返回false
+     * @brief 获取一段连续的接收数据，不拷贝
+     * @param rx_data 连续数据的起始地址
+     * @return 连续数据长度，无数据返回0
      */
-    // virtual bool get_recv_data(std::vector<uint8_t>& rx_data) = 0;
-    virtual bool get_recv_data(std::queue<uint8_t>& rx_data) = 0;
+    virtual uint16_t get_recv_span(const uint8_t*& rx_data) = 0;
+
+    /**
+     * @brief 释放get_recv_span取得的数据
+     * @param len 已处理的字节数
+     */
+    virtual void release_recv_span(uint16_t len) = 0;
 
     /* 获取系统1ms时间戳 */
     virtual uint32_t get_system_1ms_ticks() = 0;
@@ -91,11 +97,14 @@ class UWB {
     UciCMD uci_cmd;
     UciNTF uci_ntf;
 
-    std::vector<uint8_t> rx_raw_buffer_vec;
-    std::vector<uint8_t> rx_payload;
-    std::queue<uint8_t, std::deque<uint8_t>> rx_data_queue;
-    std::queue<uint8_t, std::deque<uint8_t>> transparent_data;
-    uint8_t _data;
+    PoolVector<uint8_t> rx_frame;    // 透传数据直接追加到帧缓冲
+
+    bool rx_persistent = false;    // 保持接收模式
+    bool rx_armed = false;         // CX310处于接收模式
+    bool rx_arming = false;        // 已发送接收指令，等待响应
+    uint32_t rx_arm_tick = 0;
+    uint8_t wait_gid = 0;          // 阻塞等待响应的指令
+    uint8_t wait_oid = 0;
 
     std::function<bool(const UciCtrlPacket&)> check_rsp = nullptr;
     std::function<bool()> cmd_packer = nullptr;
@@ -111,6 +120,8 @@ class UWB {
      */
     bool reset(uint16_t timeout_ms = UWB_GENERAL_TIMEOUT_MS) {
         uwbs_sta = BOOT;
+        rx_armed = false;
+        rx_arming = false;
         uci_cmd.core_device_reset();
         check_rsp = [this](const UciCtrlPacket& rsp) {
             return uci_cmd.check_core_device_reset_rsp(rsp);
@@ -151,21 +162,34 @@ class UWB {
      * @param data 发送数据
      * @return 发送成功返回true，失败返回false
      */
-    bool data_transmit(const std::vector<uint8_t>& data) {
+    bool data_transmit(const PoolVector<uint8_t>& data) {
+        return data_transmit(data.data(), data.size());
+    }
+
+    /**
+     * @brief 数据透传，数据直接打包进UCI数据包
+     * @param data 发送数据
+     * @param len 数据长度
+     * @return 发送成功返回true，失败返回false
+     */
+    bool data_transmit(const uint8_t* data, uint16_t len) {
         if (uwbs_sta != READY) {
             interface.log("[UWB]: error: UWBS not ready");
             return false;
         }
 
-        if (data.size() == 0) {
+        if (len == 0) {
             return true;
         }
 
-        cmd_packer = [this, &data]() { return uci_cmd.cx_app_data_tx(data); };
+        cmd_packer = [this, data, len]() {
+            return uci_cmd.cx_app_data_tx(data, len);
+        };
         check_rsp = [this](const UciCtrlPacket& rsp) {
             return uci_cmd.check_cx_app_data_tx_rsp(rsp);
         };
 
+        // 发送完成通知表示CX310已离开接收模式，保持接收时由update重新进入
         if (__send_packet()) {
             // interface.log("[UWB]: data transmit");
             return true;
@@ -174,22 +198,31 @@ class UWB {
         return false;
     }
 
-    bool data_transmit_tx_test(uint16_t pack_size, uint16_t pack_num) {
+    bool data_transmit_tx_test(uint16_t pack_size, uint16_t pack_num,
+                               uint16_t gap_ms = 0) {
         if (uwbs_sta != READY) {
             interface.log("[UWB]: error: UWBS not ready");
             return false;
         }
-        std::vector<uint8_t> data(pack_size, 0xff);
+        PoolVector<uint8_t> data(pack_size, 0xff);
 
-        int delay_cnt = 20;
+        uint32_t start_tick = interface.get_system_1ms_ticks();
         for (uint16_t i = 0; i < pack_num; i++) {
             data[0] = i & 0xff;
             data[1] = i >> 8;
             data_transmit(data);
+            // 保持接收时每次发送后重新进入接收，计入单次交互耗时
+            update();
 
-            while (delay_cnt--);
-            delay_cnt = 20;
+            if (gap_ms > 0) {
+                __delay_ms(gap_ms);
+            }
         }
+        uint32_t time_ms = interface.get_system_1ms_ticks() - start_tick;
+        interface.log(
+            "[UWB]: data transmit tx test: transmit pack = %u, time = %ums, "
+            "per pack = %uus",
+            pack_num, time_ms, pack_num ? time_ms * 1000 / pack_num : 0);
         return true;
     }
 
@@ -198,13 +231,14 @@ class UWB {
             interface.log("[UWB]: error: UWBS not ready");
             return false;
         }
-        std::vector<uint8_t> data(pack_size);
+        PoolVector<uint8_t> data(pack_size);
         uint16_t loss_pack = 0;
         uint32_t time_ms = 0;
         bool start_flag = false;
         uint16_t recv_cnt = 0;
         uint16_t pack_id = 0;
         uint32_t start_tick = 0;
+        keep_recv_mode();
         while (true) {
             if (get_recv_data(data)) {
                 pack_id = data[0] | (data[1] << 8);
@@ -258,6 +292,7 @@ class UWB {
         };
 
         if (__send_packet()) {
+            rx_armed = true;
             interface.log("[UWB]: set recv mode");
             return true;
         }
@@ -266,25 +301,34 @@ class UWB {
     }
 
     /**
-     * @brief 获取透传数据
+     * @brief 保持接收模式，CX310离开接收后由update重新进入
+     * @note 接收指令只发送不等待，响应在监听通知时处理，
+     *       连续多次发送之间不会重复进入接收模式
+     * @param enable 是否保持接收
+     */
+    void keep_recv_mode(bool enable = true) {
+        rx_persistent = enable;
+        if (enable) {
+            __keep_recv_mode();
+        }
+    }
+
+    /**
+     * @brief 获取透传数据，与内部帧缓冲交换，不拷贝
      * @param recv_data 接收数据
      * @return 获取成功返回true，失败返回false
      */
-    bool get_recv_data(std::vector<uint8_t>& recv_data) {
+    bool get_recv_data(PoolVector<uint8_t>& recv_data) {
         update();
         if (uwbs_sta != READY) {
             interface.log("[UWB]: error: UWBS not ready");
             return false;
         }
-        if (transparent_data.empty()) {
+        if (rx_frame.empty()) {
             return false;
         }
-        recv_data.clear();
-        recv_data.reserve(transparent_data.size());
-        while (transparent_data.empty() == false) {
-            recv_data.push_back(transparent_data.front());
-            transparent_data.pop();
-        }
+        recv_data.swap(rx_frame);
+        rx_frame.clear();
         return true;
     }
 
@@ -301,7 +345,9 @@ class UWB {
         check_rsp = [this](const UciCtrlPacket& rsp) {
             return uci_cmd.check_cx_app_data_stop_rx_rsp(rsp);
         };
+        rx_persistent = false;
         if (__send_packet()) {
+            rx_armed = false;
             interface.log("[UWB]: stop recv");
             return true;
         }
@@ -309,6 +355,14 @@ class UWB {
         return false;
     }
 
+    /* 获取系统1ms时间戳 */
+    uint32_t get_system_1ms_ticks() {
+        return interface.get_system_1ms_ticks();
+    }
+
+    /* 延迟，让出CPU */
+    void delay_ms(uint32_t ms) { interface.delay_ms(ms); }
+
     /**
      * @brief 更新，监听通知和更新状态机
      * @return 无
@@ -317,6 +371,7 @@ class UWB {
         __listening_ntf();
         // printf("[UWB]: update\n");
         __uwbs_state_machine();
+        __keep_recv_mode();
     }
 
    private:
@@ -340,56 +395,113 @@ class UWB {
         }
     }
 
-    void __load_recv_data() {
-        interface.get_recv_data(rx_data_queue);
+    /**
+     * @brief 直接在接口的接收缓冲区上解析，处理完所有通知
+     * @note 负载原地引用接收缓冲区，数据包处理完成后才释放
+     * @param stop_at_rsp 收到阻塞指令的响应时停止解析并返回true
+     * @return 收到阻塞指令的响应返回true
+     */
+    bool __parse_recv_data(bool stop_at_rsp) {
+        const uint8_t* span;
+        uint16_t len;
+        while ((len = interface.get_recv_span(span)) > 0) {
+            TRACE_BEGIN(UCI_PARSE, len);
+            uint16_t used = recv_packet.parse(span, len);
+            TRACE_END(UCI_PARSE, used);
+            bool rsp = recv_packet.ready() && __packet_process(stop_at_rsp);
+            interface.release_recv_span(used);
+            if (rsp) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 按类型和GID/OID分发收到的数据包
+     * @note 异步接收指令的响应在此处理，与wait_gid/wait_oid一致的响应
+     *       交给阻塞等待的指令，负载拷贝保留到接收缓冲区释放之后
+     * @param stop_at_rsp 是否有指令在阻塞等待响应
+     * @return 是阻塞指令的响应返回true
+     */
+    bool __packet_process(bool stop_at_rsp) {
+        if (recv_packet.mt == MT_NTF) {
+            __notify_process();
+        } else if (recv_packet.mt == MT_RSP && rx_arming &&
+                   recv_packet.gid == GID0x03 &&
+                   recv_packet.oid == CX_APP_DATA_RX_RSP) {
+            // 异步接收指令的响应
+            rx_arming = false;
+            rx_armed = uci_cmd.check_cx_app_data_rx_rsp(recv_packet);
+            if (!rx_armed) {
+                interface.log("[UWB]: error: set recv mode fail");
+            }
+        } else if (recv_packet.mt == MT_RSP && stop_at_rsp &&
+                   recv_packet.gid == wait_gid && recv_packet.oid == wait_oid) {
+            // 接收到响应
+            recv_packet.keep();
+            return true;
+        } else {
+            interface.log("[UWB]: error: unexpected rsp packet");
+        }
+        return false;
     }
 
     bool __rsp_process(uint32_t timeout_ms) {
         uint32_t start_tick = interface.get_system_1ms_ticks();
         while (interface.get_system_1ms_ticks() - start_tick < timeout_ms) {
-            __load_recv_data();
-            while (rx_data_queue.empty() == false) {
-                _data = rx_data_queue.front();
-                rx_data_queue.pop();
-
-                if (recv_packet.flow_parse(_data, rx_payload)) {
-                    if (recv_packet.mt == MT_RSP) {
-                        // 接收到响应
-                        return true;
-                    } else if (recv_packet.mt == MT_NTF) {
-                        // 接收到通知
-                        __notify_process();
-                    }
-                }
+            if (__parse_recv_data(true)) {
+                return true;
             }
         }
         interface.log("[UWB]: error: wait rsp timeout");
         return false;
     }
 
-    void __listening_ntf() {
-        __load_recv_data();
-        while (rx_data_queue.empty() == false) {
-            _data = rx_data_queue.front();
-            rx_data_queue.pop();
+    void __listening_ntf() { __parse_recv_data(false); }
 
-            if (recv_packet.flow_parse(_data, rx_payload)) {
-                if (recv_packet.mt == MT_NTF) {
-                    __notify_process();
-                } else {
-                    interface.log("[UWB]: error: unexpected rsp packet");
-                }
-            }
+    /**
+     * @brief 等待异步接收指令的响应
+     * @note 阻塞指令发送前调用，两条路径串行，
+     *       异步接收指令的响应不会被阻塞指令当作自己的响应
+     */
+    void __wait_rx_arm() {
+        while (rx_arming && interface.get_system_1ms_ticks() - rx_arm_tick <
+                                UWB_GENERAL_TIMEOUT_MS) {
+            __parse_recv_data(false);
+        }
+        if (rx_arming) {
+            rx_arming = false;
+            interface.log("[UWB]: error: wait recv mode rsp timeout");
         }
     }
 
+    void __keep_recv_mode() {
+        if (!rx_persistent || rx_armed || uwbs_sta != READY) {
+            return;
+        }
+        uint32_t now = interface.get_system_1ms_ticks();
+        if (rx_arming && now - rx_arm_tick < UWB_GENERAL_TIMEOUT_MS) {
+            return;
+        }
+        // 只发送接收指令，不阻塞等待响应
+        uci_cmd.cx_app_data_rx();
+        interface.send(uci_cmd.packet);
+        uci_cmd.reset_packer();
+        rx_arming = true;
+        rx_arm_tick = now;
+    }
+
     void __notify_process() {
         if (recv_packet.gid == GID0x00) {
             switch (recv_packet.oid) {
                 case CORE_DEVICE_STATUS_NTF: {
-                    uint8_t sta =
-                        uci_ntf.parse_core_device_status_ntf(rx_payload);
+                    uint8_t sta = uci_ntf.parse_core_device_status_ntf(
+                        recv_packet.payload(), recv_packet.payload_len());
                     if (sta == DEVICE_STATE_READY) {
+                        // 复位后CX310不在接收模式
+                        rx_armed = false;
+                        rx_arming = false;
                         if (uwbs_sta == BOOT) {
                             uwbs_sta = READY;
                             interface.log("[UWB]: UWBS move to active state");
@@ -408,30 +520,35 @@ class UWB {
         if (recv_packet.gid == GID0x03) {
             switch (recv_packet.oid) {
                 case CX_APP_DATA_TX_NTF: {
-                    if (uci_ntf.parse_cx_app_data_tx_ntf(rx_payload) !=
-                        STATUS_OK) {
+                    if (uci_ntf.parse_cx_app_data_tx_ntf(
+                            recv_packet.payload(),
+                            recv_packet.payload_len()) != STATUS_OK) {
                         interface.log("[UWB]: error: parse data tx ntf fail");
                     } else {
                         // interface.log("[UWB]: data transmit");
                     }
+                    // 数据已从空口发出，CX310离开接收模式
+                    rx_armed = false;
                     break;
                 }
                 case CX_APP_DATA_RX_NTF: {
-                    if (!uci_ntf.parse_cx_app_data_rx_ntf(rx_payload)) {
+                    const uint8_t* payload = recv_packet.payload();
+                    uint16_t payload_len = recv_packet.payload_len();
+                    if (!uci_ntf.parse_cx_app_data_rx_ntf(payload,
+                                                          payload_len)) {
                         interface.log("[UWB]: error: parse data rx ntf fail");
                     }
 
-                    if (rx_payload.size() < 2) {
+                    if (payload_len < 2) {
                         interface.log(
                             "[UWB]: error: rx payload size is too small");
                         break;
                     }
-                    for (auto it = rx_payload.begin() + 2;
-                         it != rx_payload.end(); it++) {
-                        transparent_data.push(*it);
-                    }
+                    // 负载原地引用接收缓冲区，接收数据只在此处拷贝一次
+                    rx_frame.insert(rx_frame.end(), payload + 2,
+                                    payload + payload_len);
                     // interface.log("[UWB]: data receive, size=%u",
-                    //               rx_payload.size() - 2);
+                    //               payload_len - 2);
                     break;
                 }
                 default: {
@@ -489,6 +606,8 @@ class UWB {
         if ((cmd_packer == nullptr) || (check_rsp == nullptr)) {
             return false;
         }
+        TRACE_BEGIN(UWB_SEND, 0);
+        __wait_rx_arm();
         bool send_flag = true;
         bool pack_all_payload = false;
         bool ret = false;
@@ -497,8 +616,12 @@ class UWB {
             if (send_flag) {
                 send_flag = false;
                 pack_all_payload = cmd_packer();
+                if (uci_cmd.packet.size() >= UCI_CTRL_PKT_HDR_SIZE) {
+                    wait_gid = uci_cmd.packet[0] & 0x0F;
+                    wait_oid = uci_cmd.packet[1] & 0x3F;
+                }
                 interface.send(uci_cmd.packet);
-                // Log.r(uci_cmd.packet.data(), uci_cmd.packet.size());
+                // LOG_R(uci_cmd.packet.data(), uci_cmd.packet.size());
             }
             if (__rsp_process(UWB_GENERAL_TIMEOUT_MS)) {
                 if (check_rsp(recv_packet)) {
@@ -520,6 +643,7 @@ class UWB {
         uci_cmd.reset_packer();
         cmd_packer = nullptr;
         check_rsp = nullptr;
+        TRACE_END(UWB_SEND, ret);
         return ret;
     }
 };
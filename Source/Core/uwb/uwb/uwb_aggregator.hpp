@@ -0,0 +1,134 @@
+#ifndef _UWB_AGGREGATOR_HPP
+#define _UWB_AGGREGATOR_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "bsp_allocate.hpp"
+#include "cx_uci_def.hpp"
+
+// 每条记录前的长度字段，小端
+#define UWB_AGG_RECORD_HDR_SIZE 2
+
+/**
+ * @brief UWB发送聚合层
+ * @note 多个协议帧按[len_lo, len_hi, frame...]依次打包进一次app data发送，
+ *       总长不超过CX_APP_DATA_TX_MAX_PAYLOAD_LEN，接收端按记录拆分。
+ *       收发两端必须同时使用该层
+ */
+template <class Uwb>
+class UwbAggregator {
+   public:
+    /**
+     * @param uwb UWB实例
+     * @param flush_deadline_ms 第一帧入队后最长等待时间，0表示每次update都发送
+     */
+    explicit UwbAggregator(Uwb& uwb, uint32_t flush_deadline_ms = 0)
+        : uwb(uwb), flush_deadline_ms(flush_deadline_ms) {
+        tx_batch.reserve(CX_APP_DATA_TX_MAX_PAYLOAD_LEN);
+    }
+
+   private:
+    Uwb& uwb;
+    uint32_t flush_deadline_ms;
+    uint32_t first_frame_tick = 0;
+
+    PoolVector<uint8_t> tx_batch;
+    PoolVector<uint8_t> rx_batch;
+    size_t rx_offset = 0;
+
+   public:
+    /**
+     * @brief 帧入队，放不下时先发送已聚合的数据
+     * @param frame 协议帧
+     * @param len 帧长度
+     * @param flush 入队后立即发送(需要对端回复的帧)
+     * @return 成功返回true，帧过长或发送失败返回false
+     */
+    bool push(const uint8_t* frame, uint16_t len, bool flush = false) {
+        if (len + UWB_AGG_RECORD_HDR_SIZE > CX_APP_DATA_TX_MAX_PAYLOAD_LEN) {
+            return false;
+        }
+        if (tx_batch.size() + UWB_AGG_RECORD_HDR_SIZE + len >
+            CX_APP_DATA_TX_MAX_PAYLOAD_LEN) {
+            if (!this->flush()) {
+                return false;
+            }
+        }
+        if (tx_batch.empty()) {
+            first_frame_tick = uwb.get_system_1ms_ticks();
+        }
+        tx_batch.push_back(len & 0xFF);
+        tx_batch.push_back(len >> 8);
+        tx_batch.insert(tx_batch.end(), frame, frame + len);
+        return flush ? this->flush() : true;
+    }
+
+    /**
+     * @brief 立即发送已聚合的数据
+     * @return 发送成功返回true，失败返回false
+     */
+    bool flush() {
+        if (tx_batch.empty()) {
+            return true;
+        }
+        bool ret = uwb.data_transmit(tx_batch);
+        tx_batch.clear();
+        return ret;
+    }
+
+    /**
+     * @brief 是否有已入队但尚未发出的帧
+     */
+    bool pending() const { return !tx_batch.empty(); }
+
+    /**
+     * @brief 超过发送期限时发送已聚合的数据，在任务循环中调用
+     */
+    void update() {
+        if (tx_batch.empty()) {
+            return;
+        }
+        if (uwb.get_system_1ms_ticks() - first_frame_tick >=
+            flush_deadline_ms) {
+            flush();
+        }
+    }
+
+    /**
+     * @brief 取出一个接收到的协议帧
+     * @param frame 协议帧
+     * @return 取到返回true，没有数据返回false
+     */
+    bool pop(PoolVector<uint8_t>& frame) {
+        while (true) {
+            if (rx_offset >= rx_batch.size()) {
+                rx_offset = 0;
+                rx_batch.clear();
+                if (!uwb.get_recv_data(rx_batch)) {
+                    return false;
+                }
+            }
+            if (rx_batch.size() - rx_offset < UWB_AGG_RECORD_HDR_SIZE) {
+                // 残缺记录，丢弃
+                rx_offset = rx_batch.size();
+                continue;
+            }
+            uint16_t len =
+                rx_batch[rx_offset] | (rx_batch[rx_offset + 1] << 8);
+            rx_offset += UWB_AGG_RECORD_HDR_SIZE;
+            if (len > rx_batch.size() - rx_offset) {
+                // 长度非法，丢弃本批剩余数据
+                rx_offset = rx_batch.size();
+                continue;
+            }
+            frame.assign(rx_batch.begin() + rx_offset,
+                         rx_batch.begin() + rx_offset + len);
+            rx_offset += len;
+            return true;
+        }
+    }
+};
+
+#endif
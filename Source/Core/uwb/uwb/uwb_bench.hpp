@@ -0,0 +1,301 @@
+#ifndef _UWB_BENCH_HPP
+#define _UWB_BENCH_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include "uwb_aggregator.hpp"
+
+// 直方图分辨率为1个tick(1ms)，超出范围的样本计入最后一格
+#define UWB_BENCH_HIST_BINS 256
+// 每个测试点最后一包发出后等待回复的时间
+#define UWB_BENCH_RX_TIMEOUT_MS 500
+// 时钟偏差校准的往返次数
+#define UWB_BENCH_CALIB_NUM 16
+
+#define UWB_BENCH_MAGIC   0xBE
+#define UWB_BENCH_REQ     0x00
+#define UWB_BENCH_RSP     0x01
+#define UWB_BENCH_HDR_LEN 12
+
+/**
+ * @brief 延迟直方图，1ms一格，按格计算分位数
+ */
+class UwbBenchHistogram {
+   public:
+    void clear() {
+        memset(bins, 0, sizeof(bins));
+        count = 0;
+        max_ms = 0;
+    }
+
+    void add(int32_t ms) {
+        if (ms < 0) {
+            ms = 0;
+        }
+        bins[ms < UWB_BENCH_HIST_BINS ? ms : UWB_BENCH_HIST_BINS - 1]++;
+        count++;
+        if ((uint32_t)ms > max_ms) {
+            max_ms = ms;
+        }
+    }
+
+    /**
+     * @brief 计算分位数
+     * @param permille 千分位，例如500为p50，990为p99
+     * @return 延迟，ms
+     */
+    uint32_t percentile(uint16_t permille) const {
+        if (count == 0) {
+            return 0;
+        }
+        uint32_t rank = (count * permille + 999) / 1000;
+        uint32_t sum = 0;
+        for (uint16_t i = 0; i < UWB_BENCH_HIST_BINS; i++) {
+            sum += bins[i];
+            if (sum >= rank) {
+                return i;
+            }
+        }
+        return max_ms;
+    }
+
+    uint32_t max() const { return max_ms; }
+
+   private:
+    uint16_t bins[UWB_BENCH_HIST_BINS] = {};
+    uint32_t count = 0;
+    uint32_t max_ms = 0;
+};
+
+/* 单个测试点(负载长度, 发包间隔)的结果 */
+struct UwbBenchResult {
+    uint16_t payload_size;
+    uint16_t gap_ms;
+    uint16_t sent;
+    uint16_t received;
+    uint16_t lost;
+    uint16_t reordered;
+    uint32_t rtt_p50;
+    uint32_t rtt_p99;
+    uint32_t rtt_max;
+    uint32_t oneway_p50;
+    uint32_t oneway_p99;
+    uint32_t oneway_max;
+    uint32_t goodput_Bps;    // 往返成功的负载字节数/耗时
+    uint32_t elapsed_ms;
+};
+
+/**
+ * @brief UWB链路基准测试
+ * @note 发起端(主机)按负载长度和发包间隔扫描，应答端(从机)收到请求后
+ *       打上本地接收时间原样回复。往返时延直接由发起端tick计算，单程时延
+ *       用最小往返时延校准两端tick偏差后估算。
+ *       Uwb只需提供data_transmit/get_recv_data/update/get_system_1ms_ticks/
+ *       delay_ms，可替换为模拟链路
+ */
+template <class Uwb>
+class UwbBench {
+   public:
+    using Report = std::function<void(const UwbBenchResult&)>;
+
+    explicit UwbBench(Uwb& uwb) : uwb(uwb), aggregator(uwb) {}
+
+   private:
+    Uwb& uwb;
+    UwbAggregator<Uwb> aggregator;
+    PoolVector<uint8_t> tx_frame;
+    PoolVector<uint8_t> rx_frame;
+
+    UwbBenchHistogram rtt_hist;
+    UwbBenchHistogram oneway_hist;
+    int32_t clock_offset = 0;    // 应答端tick - 发起端tick
+
+    // 当前测试点统计
+    uint16_t recv_cnt = 0;
+    uint16_t reorder_cnt = 0;
+    int32_t max_seq = -1;
+    uint32_t recv_bytes = 0;
+
+   public:
+    /**
+     * @brief 发起端：校准时钟偏差
+     * @return 校准成功返回true
+     */
+    bool calibrate() {
+        uint32_t best_rtt = UINT32_MAX;
+        for (uint16_t i = 0; i < UWB_BENCH_CALIB_NUM; i++) {
+            uint32_t t_tx = uwb.get_system_1ms_ticks();
+            if (!__send(UWB_BENCH_REQ, i, t_tx, 0, 0)) {
+                continue;
+            }
+            uint32_t t_peer = 0;
+            while (uwb.get_system_1ms_ticks() - t_tx <
+                   UWB_BENCH_RX_TIMEOUT_MS) {
+                uwb.update();
+                if (aggregator.pop(rx_frame) && __is_rsp(rx_frame, i)) {
+                    uint32_t rtt = uwb.get_system_1ms_ticks() - t_tx;
+                    memcpy(&t_peer, rx_frame.data() + 8, 4);
+                    if (rtt < best_rtt) {
+                        best_rtt = rtt;
+                        clock_offset = (int32_t)(t_peer - t_tx - rtt / 2);
+                    }
+                    break;
+                }
+                // 时延分辨率为1个tick，等待期间让出CPU给低优先级任务
+                uwb.delay_ms(1);
+            }
+        }
+        return best_rtt != UINT32_MAX;
+    }
+
+    /**
+     * @brief 发起端：测试一个点
+     * @param payload_size 负载长度(含测试包头)
+     * @param gap_ms 发包间隔，0表示连续发送
+     * @param count 发包数
+     * @return 测试结果
+     */
+    UwbBenchResult run_point(uint16_t payload_size, uint16_t gap_ms,
+                             uint16_t count) {
+        UwbBenchResult result = {};
+        if (payload_size < UWB_BENCH_HDR_LEN) {
+            payload_size = UWB_BENCH_HDR_LEN;
+        }
+        result.payload_size = payload_size;
+        result.gap_ms = gap_ms;
+
+        rtt_hist.clear();
+        oneway_hist.clear();
+        recv_cnt = 0;
+        reorder_cnt = 0;
+        max_seq = -1;
+        recv_bytes = 0;
+
+        uint32_t start = uwb.get_system_1ms_ticks();
+        for (uint16_t seq = 0; seq < count; seq++) {
+            uint32_t t_tx = uwb.get_system_1ms_ticks();
+            if (__send(UWB_BENCH_REQ, seq, t_tx, 0,
+                       payload_size - UWB_BENCH_HDR_LEN)) {
+                result.sent++;
+            }
+            do {
+                __pump();
+                if (gap_ms > 0) {
+                    uwb.delay_ms(1);
+                }
+            } while (uwb.get_system_1ms_ticks() - t_tx < gap_ms);
+        }
+        uint32_t last_tx = uwb.get_system_1ms_ticks();
+        while (recv_cnt < result.sent && uwb.get_system_1ms_ticks() - last_tx <
+                                             UWB_BENCH_RX_TIMEOUT_MS) {
+            __pump();
+            if (recv_cnt < result.sent) {
+                uwb.delay_ms(1);
+            }
+        }
+
+        result.elapsed_ms = uwb.get_system_1ms_ticks() - start;
+        result.received = recv_cnt;
+        result.lost = result.sent - recv_cnt;
+        result.reordered = reorder_cnt;
+        result.rtt_p50 = rtt_hist.percentile(500);
+        result.rtt_p99 = rtt_hist.percentile(990);
+        result.rtt_max = rtt_hist.max();
+        result.oneway_p50 = oneway_hist.percentile(500);
+        result.oneway_p99 = oneway_hist.percentile(990);
+        result.oneway_max = oneway_hist.max();
+        result.goodput_Bps =
+            result.elapsed_ms ? recv_bytes * 1000 / result.elapsed_ms : 0;
+        return result;
+    }
+
+    /**
+     * @brief 发起端：按负载长度和发包间隔扫描
+     */
+    void sweep(const uint16_t* sizes, uint8_t size_num, const uint16_t* gaps,
+               uint8_t gap_num, uint16_t count, const Report& report) {
+        calibrate();
+        for (uint8_t i = 0; i < size_num; i++) {
+            for (uint8_t j = 0; j < gap_num; j++) {
+                report(run_point(sizes[i], gaps[j], count));
+            }
+        }
+    }
+
+    /**
+     * @brief 应答端：处理收到的测试包，在任务循环中调用
+     * @return 本次回复的包数
+     */
+    uint16_t serve() {
+        uint16_t cnt = 0;
+        uwb.update();
+        while (aggregator.pop(rx_frame)) {
+            uint32_t t_rx = uwb.get_system_1ms_ticks();
+            if (rx_frame.size() < UWB_BENCH_HDR_LEN ||
+                rx_frame[0] != UWB_BENCH_MAGIC ||
+                rx_frame[1] != UWB_BENCH_REQ) {
+                continue;
+            }
+            // 原样回复，填入应答端接收时间
+            rx_frame[1] = UWB_BENCH_RSP;
+            memcpy(rx_frame.data() + 8, &t_rx, 4);
+            if (aggregator.push(rx_frame.data(), rx_frame.size(), true)) {
+                cnt++;
+            }
+        }
+        return cnt;
+    }
+
+   private:
+    bool __send(uint8_t type, uint16_t seq, uint32_t t_tx, uint32_t t_peer,
+                uint16_t fill_len) {
+        tx_frame.resize(UWB_BENCH_HDR_LEN + fill_len);
+        tx_frame[0] = UWB_BENCH_MAGIC;
+        tx_frame[1] = type;
+        tx_frame[2] = seq & 0xFF;
+        tx_frame[3] = seq >> 8;
+        memcpy(tx_frame.data() + 4, &t_tx, 4);
+        memcpy(tx_frame.data() + 8, &t_peer, 4);
+        for (uint16_t i = 0; i < fill_len; i++) {
+            tx_frame[UWB_BENCH_HDR_LEN + i] = (uint8_t)(seq + i);
+        }
+        return aggregator.push(tx_frame.data(), tx_frame.size(), true);
+    }
+
+    bool __is_rsp(const PoolVector<uint8_t>& frame, uint16_t seq) {
+        return frame.size() >= UWB_BENCH_HDR_LEN &&
+               frame[0] == UWB_BENCH_MAGIC && frame[1] == UWB_BENCH_RSP &&
+               (frame[2] | (frame[3] << 8)) == seq;
+    }
+
+    void __pump() {
+        uwb.update();
+        while (aggregator.pop(rx_frame)) {
+            uint32_t now = uwb.get_system_1ms_ticks();
+            if (rx_frame.size() < UWB_BENCH_HDR_LEN ||
+                rx_frame[0] != UWB_BENCH_MAGIC ||
+                rx_frame[1] != UWB_BENCH_RSP) {
+                continue;
+            }
+            uint16_t seq = rx_frame[2] | (rx_frame[3] << 8);
+            uint32_t t_tx, t_peer;
+            memcpy(&t_tx, rx_frame.data() + 4, 4);
+            memcpy(&t_peer, rx_frame.data() + 8, 4);
+
+            if ((int32_t)seq < max_seq) {
+                reorder_cnt++;
+            } else {
+                max_seq = seq;
+            }
+            recv_cnt++;
+            recv_bytes += rx_frame.size();
+            rtt_hist.add(now - t_tx);
+            oneway_hist.add((int32_t)(t_peer - t_tx) - clock_offset);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,131 @@
+// uci_bench.cpp
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "cx_uci.hpp"
+
+/**
+ * @brief UCI解析基准测试，回放主机仿真以--uci-record记录的UCI字节流
+ * @note 按UWB::__parse_recv_data的方式把记录分段交给UciCtrlPacket::parse，
+ *       接收通知的负载追加到帧缓冲后交给使用者(清空)，统计吞吐量。
+ *       记录视为环形接收缓冲区的内容，连续段在RING的整数倍处断开，
+ *       跨越断点的数据包负载由解析器拷贝，其余原地引用
+ *
+ *   usage: UciBench FILE [RING] [REPEAT]
+ *     RING    环形接收缓冲区大小，缺省1024(DMA_RX_BUFFER_SIZE)
+ *     REPEAT  回放次数，缺省1000
+ */
+
+// 基准只测解析，不链接FreeRTOS，OSallocator的分配由malloc代替
+void* MemPool::alloc(size_t size) { return malloc(size); }
+void MemPool::free(void* p) { ::free(p); }
+
+struct Stats {
+    uint64_t packets = 0;
+    uint64_t ntf = 0;
+    uint64_t rsp = 0;
+    uint64_t rx_frames = 0;
+    uint64_t rx_bytes = 0;
+    uint64_t in_place = 0;
+};
+
+static std::vector<uint8_t> load(const char* path) {
+    std::vector<uint8_t> data;
+    FILE* f = fopen(path, "rb");
+    if (f == nullptr) {
+        return data;
+    }
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(f);
+    return data;
+}
+
+static void replay(const std::vector<uint8_t>& stream, uint16_t ring,
+                   UciCtrlPacket& packet, std::vector<uint8_t>& frame,
+                   Stats& stats) {
+    const uint8_t* begin = stream.data();
+    const uint8_t* end = begin + stream.size();
+    size_t pos = 0;
+    while (pos < stream.size()) {
+        // 连续段到环形缓冲区末尾为止
+        size_t span = ring - pos % ring;
+        if (span > stream.size() - pos) {
+            span = stream.size() - pos;
+        }
+        pos += packet.parse(begin + pos, span);
+        if (!packet.ready()) {
+            continue;
+        }
+        stats.packets++;
+        const uint8_t* payload = packet.payload();
+        uint16_t len = packet.payload_len();
+        if (payload >= begin && payload < end) {
+            stats.in_place++;
+        }
+        if (packet.mt == MT_RSP) {
+            stats.rsp++;
+        } else if (packet.mt == MT_NTF) {
+            stats.ntf++;
+            if (packet.gid == GID0x03 && packet.oid == CX_APP_DATA_RX_NTF &&
+                len >= 2) {
+                frame.insert(frame.end(), payload + 2, payload + len);
+                stats.rx_frames++;
+                stats.rx_bytes += len - 2;
+                frame.clear();
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s FILE [RING] [REPEAT]\n", argv[0]);
+        return 2;
+    }
+    uint16_t ring = argc > 2 ? atoi(argv[2]) : 1024;
+    int repeat = argc > 3 ? atoi(argv[3]) : 1000;
+    if (ring == 0 || repeat <= 0) {
+        fprintf(stderr, "RING and REPEAT must be positive\n");
+        return 2;
+    }
+    std::vector<uint8_t> stream = load(argv[1]);
+    if (stream.empty()) {
+        fprintf(stderr, "%s: empty or unreadable\n", argv[1]);
+        return 1;
+    }
+
+    UciCtrlPacket packet;
+    std::vector<uint8_t> frame;
+    frame.reserve(CX_APP_DATA_TX_MAX_PAYLOAD_LEN);
+    // 预热一轮，统计只取计时部分
+    Stats stats;
+    replay(stream, ring, packet, frame, stats);
+    stats = Stats();
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        replay(stream, ring, packet, frame, stats);
+    }
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    double bytes = (double)stream.size() * repeat;
+
+    printf("stream %zu B x %d, ring %u B\n", stream.size(), repeat, ring);
+    printf("packets %llu (rsp %llu, ntf %llu), payload in place %.1f%%\n",
+           (unsigned long long)stats.packets, (unsigned long long)stats.rsp,
+           (unsigned long long)stats.ntf,
+           stats.packets ? 100.0 * stats.in_place / stats.packets : 0.0);
+    printf("rx frames %llu, rx data %llu B\n",
+           (unsigned long long)stats.rx_frames,
+           (unsigned long long)stats.rx_bytes);
+    printf("parse %.1f MB/s, %.1f ns/packet, %.2f ns/B\n", bytes * 1e3 / ns,
+           stats.packets ? ns / stats.packets : 0.0, ns / bytes);
+    return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef GD32F4XX_H
+#define GD32F4XX_H
+/* 主机仿真构建(HOST_SIM)替代的设备头文件，只提供BSP公共部分和应用层
+ * 用到的类型与变量，外设寄存器和库函数不可用 */
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum { RESET = 0, SET = !RESET } FlagStatus;
+
+/* 跟踪导出等按核心时钟换算时间，主机上取configCPU_CLOCK_HZ */
+extern uint32_t SystemCoreClock;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
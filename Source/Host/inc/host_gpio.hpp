@@ -0,0 +1,108 @@
+#ifndef HOST_GPIO_HPP
+#define HOST_GPIO_HPP
+#include <cstdint>
+
+#include "gd32f4xx.h"
+
+/**
+ * @brief 主机仿真构建的GPIO，接口与bsp_gpio.hpp一致
+ * @note 引脚状态保存在进程内的端口表中，引脚之间没有连接：输出引脚读回
+ *       输出锁存值，输入引脚读上下拉决定的电平。导通扫描中只有被驱动的
+ *       引脚自身读到高电平
+ */
+class GPIO {
+   public:
+    enum class Mode { INPUT = 0, OUTPUT, AF, ANALOG };
+
+    enum class PullUpDown { NONE = 0, PULLUP, PULLDOWN };
+
+    enum class OType { PP = 0, OD };
+
+    enum class Speed { SPEED_2MHZ = 0, SPEED_25MHZ, SPEED_50MHZ, SPEED_MAX };
+
+    enum class BitStatus { RESET = 0, SET = 1 };
+
+    enum class Port { A = 0, B, C, D, E, F, G };
+
+    enum class Pin {
+        PIN_0 = 1 << 0,
+        PIN_1 = 1 << 1,
+        PIN_2 = 1 << 2,
+        PIN_3 = 1 << 3,
+        PIN_4 = 1 << 4,
+        PIN_5 = 1 << 5,
+        PIN_6 = 1 << 6,
+        PIN_7 = 1 << 7,
+        PIN_8 = 1 << 8,
+        PIN_9 = 1 << 9,
+        PIN_10 = 1 << 10,
+        PIN_11 = 1 << 11,
+        PIN_12 = 1 << 12,
+        PIN_13 = 1 << 13,
+        PIN_14 = 1 << 14,
+        PIN_15 = 1 << 15,
+        ALL = 0xFFFF
+    };
+
+    GPIO(Port port, Pin pin, Mode mode, PullUpDown pull = PullUpDown::PULLDOWN,
+         OType otype = OType::PP, Speed speed = Speed::SPEED_50MHZ)
+        : port(port), pin(pin) {
+        mode_set(mode, pull);
+        output_options_set(otype, speed);
+        if (mode == Mode::OUTPUT) {
+            bit_reset();
+        }
+    }
+
+    void mode_set(Mode mode, PullUpDown pull = PullUpDown::PULLDOWN);
+
+    void switch_to_input() { mode_set(Mode::INPUT); }
+
+    void switch_to_output() { mode_set(Mode::OUTPUT); }
+
+    void output_options_set(OType otype, Speed speed) {}
+
+    void bit_set() { state().odr |= pin_mask(); }
+
+    void bit_reset() { state().odr &= ~pin_mask(); }
+
+    void bit_write(BitStatus bit_value) {
+        if (bit_value == BitStatus::SET) {
+            bit_set();
+        } else {
+            bit_reset();
+        }
+    }
+
+    uint16_t input_port_get() { return state().idr(); }
+
+    FlagStatus input_bit_get() const {
+        return (state().idr() & pin_mask()) ? SET : RESET;
+    }
+
+    void af_set(uint32_t alt_func_num) {}
+
+    void toggle() { state().odr ^= pin_mask(); }
+
+   private:
+    struct PortState {
+        uint16_t odr;       // 输出锁存
+        uint16_t output;    // 输出模式的引脚
+        uint16_t pullup;    // 上拉的引脚
+
+        uint16_t idr() const {
+            return (odr & output) | (pullup & ~output);
+        }
+    };
+
+    // 调度器保证同一时刻只有一个任务运行，不需要加锁
+    static PortState ports[7];
+
+    Port port;
+    Pin pin;
+
+    PortState& state() const { return ports[static_cast<uint32_t>(port)]; }
+    uint16_t pin_mask() const { return static_cast<uint16_t>(pin); }
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef HOST_NET_HPP
+#define HOST_NET_HPP
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#include <cstdint>
+
+/**
+ * @brief 主机仿真构建的网络接口，替代lwIP的socket API和EthDevice
+ * @note 套接字为非阻塞的Linux套接字，阻塞的接收在任务中按tick轮询：
+ *       POSIX移植下阻塞的系统调用不会让出CPU，会使低优先级任务得不到运行。
+ *       发往netcfg.h中上位机地址(IP_S_ADDR)的数据改发到--backend指定的地址，
+ *       绑定INADDR_ANY时改为--bind指定的地址
+ */
+typedef struct {
+    uint32_t addr;
+} ip_addr_t;
+
+#define IP4_ADDR(ipaddr, a, b, c, d)                                   \
+    (ipaddr)->addr = htonl(((uint32_t)((a) & 0xFF) << 24) |            \
+                           ((uint32_t)((b) & 0xFF) << 16) |            \
+                           ((uint32_t)((c) & 0xFF) << 8) |             \
+                           (uint32_t)((d) & 0xFF))
+
+int lwip_socket(int domain, int type, int protocol);
+int lwip_bind(int s, const struct sockaddr* name, socklen_t namelen);
+ssize_t lwip_recvfrom(int s, void* mem, size_t len, int flags,
+                      struct sockaddr* from, socklen_t* fromlen);
+ssize_t lwip_sendto(int s, const void* dataptr, size_t size, int flags,
+                    const struct sockaddr* to, socklen_t tolen);
+int lwip_close(int s);
+
+// 与lwIP的LWIP_COMPAT_SOCKETS相同，标准名称映射到上面的实现
+#define socket(domain, type, protocol) lwip_socket(domain, type, protocol)
+#define bind(s, name, namelen)         lwip_bind(s, name, namelen)
+#define recvfrom(s, mem, len, flags, from, fromlen) \
+    lwip_recvfrom(s, mem, len, flags, from, fromlen)
+#define sendto(s, dataptr, size, flags, to, tolen) \
+    lwip_sendto(s, dataptr, size, flags, to, tolen)
+
+class EthDevice {
+   public:
+    int init();
+};
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef HOST_SIM_HPP
+#define HOST_SIM_HPP
+#include <cstdint>
+
+/**
+ * @brief 主机仿真构建(HOST_SIM)的运行参数，由main在启动调度器前解析命令行
+ * @note 同一台主机上运行一个主机进程和多个从机进程，从机需以--uid区分；
+ *       UWB空口为回环网卡上的UDP组播，同一组播地址和端口的进程互相可见
+ *
+ *   --uid HEX          本机UID(UIDReader::get)，缺省由进程号生成
+ *   --air GROUP:PORT   UWB空口组播地址，缺省239.255.42.1:47100
+ *   --backend IP       上位机地址，替代netcfg.h中的IP_S_ADDR，缺省127.0.0.1
+ *   --bind IP          主机绑定的本地地址，替代INADDR_ANY，缺省不替换；
+ *                      上位机在同一台主机上时两者使用不同的回环地址，
+ *                      如--bind 127.0.0.1 --backend 127.0.0.2
+ *   --uci-record FILE  把模拟CX310发给UWB层的UCI字节流写入FILE，
+ *                      供UciBench回放，缺省不记录
+ */
+class HostSim {
+   public:
+    static void init(int argc, char** argv);
+
+    static uint32_t uid() { return __uid; }
+
+    // 地址为网络字节序，端口为主机字节序
+    static uint32_t air_group() { return __air_group; }
+    static uint16_t air_port() { return __air_port; }
+    static uint32_t backend_addr() { return __backend_addr; }
+    static uint32_t bind_addr() { return __bind_addr; }
+    static const char* uci_record() { return __uci_record; }
+
+   private:
+    HostSim() = delete;
+
+    static uint32_t __uid;
+    static uint32_t __air_group;
+    static uint16_t __air_port;
+    static uint32_t __backend_addr;
+    static uint32_t __bind_addr;
+    static const char* __uci_record;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#ifndef HOST_UART_HPP
+#define HOST_UART_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "QueueCPP.h"
+#include "bsp_runtime_stats.h"
+#include "bsp_tcm.hpp"
+#include "host_gpio.hpp"
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "semphr.h"
+#include "task.h"
+}
+
+#define ARRAYNUM(arr_name) (uint32_t)(sizeof(arr_name) / sizeof(*(arr_name)))
+#define DMA_RX_BUFFER_SIZE 1024
+
+/**
+ * @brief 主机仿真构建的串口信息，与bsp_uart.hpp中同名的外设一一对应
+ * @note 日志串口(主机UART7、从机UART3)输出到标准输出，其余串口发送丢弃、
+ *       接收始终为空
+ */
+typedef struct {
+    const char* name;
+    int fd;    // 发送写入的文件描述符，-1丢弃
+    uint16_t rx_count;
+    SemaphoreHandle_t dmaRxDoneSema;
+    bool use_dma;
+    bool rx_ring;
+} UasrtInfo;
+
+class UartConfig {
+   public:
+    UasrtInfo& info;
+    uint16_t* rx_count;      // 接收计数
+    bool use_dma;            // 是否使用DMA
+    uint16_t rxQueueSize;    // 接收队列大小
+    bool rx_ring;            // 环形DMA接收
+
+    UartConfig(UasrtInfo& info, bool enable_dma = true,
+               uint16_t _rxQueueSize = 1, bool enable_rx_ring = false)
+        : info(info),
+          rx_count(&info.rx_count),
+          use_dma(enable_dma || enable_rx_ring),
+          rxQueueSize(_rxQueueSize),
+          rx_ring(enable_rx_ring) {
+        info.use_dma = use_dma;
+        info.rx_ring = rx_ring;
+    }
+};
+
+extern UasrtInfo usart0_info;
+extern UasrtInfo usart0_info_PA9PA10;
+extern UasrtInfo usart1_info;
+extern UasrtInfo usart2_info;
+extern UasrtInfo uart3_info;
+extern UasrtInfo usart5_info;
+extern UasrtInfo uart6_info;
+extern UasrtInfo uart7_info;
+
+class Uart {
+   public:
+    Uart(UartConfig& config);
+
+    void data_send(const uint8_t* data, uint16_t len) { send(data, len); }
+
+    void data_send(const std::string& str) {
+        data_send((const uint8_t*)str.c_str(), str.size());
+    }
+
+    void data_send(std::vector<uint8_t>& data) {
+        data_send(data.data(), data.size());
+    }
+
+    /**
+     * @brief 写入串口对应的文件描述符，写完才返回
+     */
+    void send(const uint8_t* data, uint16_t len);
+
+    // 没有DMA，发送环形缓冲区只记录大小，tx_free总是返回整个缓冲区
+    void tx_ring_init(uint8_t* buf, uint16_t size) { tx_size = size; }
+
+    uint16_t tx_write(const uint8_t* data, uint16_t len) {
+        send(data, len);
+        return len;
+    }
+
+    uint16_t tx_free() const { return tx_size; }
+
+    uint32_t tx_drop_count() const { return 0; }
+
+    static bool tx_ring_write(uint32_t usart_periph, const uint8_t* data,
+                              uint16_t len) {
+        return false;
+    }
+
+    bool recv_1byte(uint8_t& data, TickType_t time = portMAX_DELAY) {
+        vTaskDelay(time);
+        return false;
+    }
+
+    uint16_t rx_peek(const uint8_t*& data) { return 0; }
+
+    void rx_consume(uint16_t len) {}
+
+    uint32_t rx_overrun_count() const { return 0; }
+
+    std::vector<uint8_t> getReceivedData() { return {}; }
+
+   private:
+    UartConfig& config;
+    uint16_t tx_size = 0;
+};
+
+class Rs485 {
+   public:
+    Rs485(Uart& uart, GPIO::Port port, GPIO::Pin pin)
+        : uart(uart), ctrl(port, pin, GPIO::Mode::OUTPUT) {}
+    Uart& uart;
+
+    std::vector<uint8_t> getReceivedData() {
+        ctrl.bit_reset();
+        return uart.getReceivedData();
+    }
+
+    void data_send(std::vector<uint8_t>& data) {
+        ctrl.bit_set();
+        uart.data_send(data);
+    }
+
+   private:
+    GPIO ctrl;
+};
+#endif
@@ -0,0 +1,88 @@
+#ifndef HOST_UWB_HPP
+#define HOST_UWB_HPP
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "TaskCPP.h"
+#include "bsp_log.hpp"
+#include "cx_uci.hpp"
+#include "uwb.hpp"
+
+extern Logger Log;
+
+/**
+ * @brief 主机仿真构建的UWB接口，在UCI层模拟CX310，替代UwbUartInterface
+ * @note 发送给模块的命令在send中立即处理，响应和通知追加到接收缓冲区，
+ *       由get_recv_span交给UWB层解析：
+ *       复位命令回复响应后发出READY通知；数据发送命令回复响应，把数据作为
+ *       一帧发到空口后发出发送完成通知；接收命令进入接收模式，停止接收命令
+ *       退出，其他命令回复UNKNOWN_GID/OID。
+ *       空口为回环网卡上的UDP组播(HostSim::air_group)，数据报为
+ *       magic u16、发送方UID u32和数据，自己发出的帧丢弃。接收模式下收到的
+ *       帧转为接收通知；不在接收模式时帧留在套接字缓冲区，重新进入接收后
+ *       送出，上电和复位时清空。不模拟空口时延和丢帧。
+ *       指定--uci-record时响应和通知同时写入记录文件
+ */
+class HostUwbInterface : public CxUwbInterface {
+   public:
+    HostUwbInterface() = default;
+    ~HostUwbInterface();
+
+    void reset_pin_init() override {}
+    void generate_reset_signal() override { __power_off(); }
+    void turn_of_reset_signal() override { __boot(); }
+    void chip_en_init() override {}
+    void chip_enable() override { __boot(); }
+    void chip_disable() override { __power_off(); }
+    void commuication_peripheral_init() override;
+
+    bool send(PoolVector<uint8_t>& tx_data) override;
+
+    uint32_t get_system_1ms_ticks() override {
+        return xTaskGetTickCount() * portTICK_PERIOD_MS;
+    }
+    uint16_t get_recv_span(const uint8_t*& rx_data) override;
+    void release_recv_span(uint16_t len) override { rx_pos += len; }
+
+    void delay_ms(uint32_t ms) override { TaskBase::delay(ms); }
+
+    void log(const char* format, ...) override {
+        if constexpr (Logger::compiled(Logger::Level::DEBUGL, "uwb")) {
+            va_list args;
+            va_start(args, format);
+            char buffer[256];
+            vsnprintf(buffer, sizeof(buffer), format, args);
+            va_end(args);
+            LOG_D("uwb", "%s", buffer);
+        }
+    }
+
+   private:
+    static constexpr uint16_t AIR_MAGIC = 0x5557;
+    static constexpr uint16_t AIR_HEADER = 6;
+
+    UciCtrlPacket cmd;                 // 命令解析
+    UciCtrlPacket out;                 // 响应和通知打包
+    PoolVector<uint8_t> rx_buf;       // 发给UWB层的字节流
+    size_t rx_pos = 0;                 // 已被UWB层取走的位置
+    PoolVector<uint8_t> air_buf;      // 空口数据报
+    int sock = -1;
+    FILE* record = nullptr;
+    bool powered = false;
+    bool rx_on = false;
+
+    void __boot();
+    void __power_off();
+    void __command();
+    void __reply(uint8_t mt, uint8_t gid, uint8_t oid, const uint8_t* payload,
+                 uint16_t len);
+    void __reply_status(uint8_t mt, uint8_t gid, uint8_t oid, uint8_t status) {
+        __reply(mt, gid, oid, &status, 1);
+    }
+    void __air_send(const uint8_t* data, uint16_t len);
+    bool __air_recv();
+    void __air_flush();
+};
+
+#endif
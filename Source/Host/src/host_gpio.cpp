@@ -0,0 +1,17 @@
+#include "host_gpio.hpp"
+
+GPIO::PortState GPIO::ports[7];
+
+void GPIO::mode_set(Mode mode, PullUpDown pull) {
+    PortState& s = state();
+    if (mode == Mode::OUTPUT) {
+        s.output |= pin_mask();
+    } else {
+        s.output &= ~pin_mask();
+    }
+    if (pull == PullUpDown::PULLUP) {
+        s.pullup |= pin_mask();
+    } else {
+        s.pullup &= ~pin_mask();
+    }
+}
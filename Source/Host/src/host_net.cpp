@@ -0,0 +1,97 @@
+#include "host_net.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "bsp_log.hpp"
+#include "host_sim.hpp"
+#include "netcfg.h"
+
+extern "C" {
+#include "FreeRTOS.h"
+#include "task.h"
+}
+
+// 以下调用Linux的套接字函数
+#undef socket
+#undef bind
+#undef recvfrom
+#undef sendto
+
+extern Logger Log;
+
+int lwip_socket(int domain, int type, int protocol) {
+    int s = socket(domain, type, protocol);
+    if (s >= 0 && fcntl(s, F_SETFL, fcntl(s, F_GETFL) | O_NONBLOCK) < 0) {
+        close(s);
+        return -1;
+    }
+    return s;
+}
+
+int lwip_bind(int s, const struct sockaddr* name, socklen_t namelen) {
+    struct sockaddr_in addr;
+    if (name != nullptr && name->sa_family == AF_INET &&
+        namelen >= sizeof(addr)) {
+        memcpy(&addr, name, sizeof(addr));
+        if (addr.sin_addr.s_addr == htonl(INADDR_ANY)) {
+            addr.sin_addr.s_addr = HostSim::bind_addr();
+            name = (const struct sockaddr*)&addr;
+        }
+    }
+    int ret = bind(s, name, namelen);
+    if (ret < 0) {
+        LOG_E("NET", "bind failed, errno %d", errno);
+    }
+    return ret;
+}
+
+ssize_t lwip_recvfrom(int s, void* mem, size_t len, int flags,
+                      struct sockaddr* from, socklen_t* fromlen) {
+    for (;;) {
+        ssize_t n = recvfrom(s, mem, len, flags, from, fromlen);
+        if (n >= 0 || (errno != EAGAIN && errno != EINTR)) {
+            return n;
+        }
+        if (errno == EAGAIN) {
+            if (flags & MSG_DONTWAIT) {
+                return n;
+            }
+            vTaskDelay(1);
+        }
+    }
+}
+
+ssize_t lwip_sendto(int s, const void* dataptr, size_t size, int flags,
+                    const struct sockaddr* to, socklen_t tolen) {
+    ip_addr_t backend;
+    IP4_ADDR(&backend, IP_S_ADDR0, IP_S_ADDR1, IP_S_ADDR2, IP_S_ADDR3);
+    struct sockaddr_in addr;
+    if (to != nullptr && to->sa_family == AF_INET &&
+        tolen >= sizeof(addr)) {
+        memcpy(&addr, to, sizeof(addr));
+        if (addr.sin_addr.s_addr == backend.addr) {
+            addr.sin_addr.s_addr = HostSim::backend_addr();
+            to = (const struct sockaddr*)&addr;
+        }
+    }
+    for (;;) {
+        ssize_t n = sendto(s, dataptr, size, flags, to, tolen);
+        if (n >= 0 || errno != EINTR) {
+            return n;
+        }
+    }
+}
+
+int lwip_close(int s) { return close(s); }
+
+int EthDevice::init() {
+    char backend[INET_ADDRSTRLEN];
+    in_addr addr = {HostSim::backend_addr()};
+    inet_ntop(AF_INET, &addr, backend, sizeof(backend));
+    LOG_I("ETH", "host network, backend %s", backend);
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include "host_sim.hpp"
+
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "FreeRTOS.h"
+#include "gd32f4xx.h"
+
+uint32_t SystemCoreClock = configCPU_CLOCK_HZ;
+
+uint32_t HostSim::__uid = 0;
+uint32_t HostSim::__air_group = 0;
+uint16_t HostSim::__air_port = 47100;
+uint32_t HostSim::__backend_addr = 0;
+uint32_t HostSim::__bind_addr = INADDR_ANY;
+const char* HostSim::__uci_record = nullptr;
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "usage: %s [--uid HEX] [--air GROUP:PORT] [--backend IP] "
+            "[--bind IP] [--uci-record FILE]\n",
+            prog);
+}
+
+static bool parse_addr(const char* text, uint32_t& addr) {
+    in_addr a;
+    if (inet_pton(AF_INET, text, &a) != 1) {
+        return false;
+    }
+    addr = a.s_addr;
+    return true;
+}
+
+void HostSim::init(int argc, char** argv) {
+    static const option options[] = {
+        {"uid", required_argument, nullptr, 'u'},
+        {"air", required_argument, nullptr, 'a'},
+        {"backend", required_argument, nullptr, 'b'},
+        {"bind", required_argument, nullptr, 'l'},
+        {"uci-record", required_argument, nullptr, 'r'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0},
+    };
+    // 缺省UID由进程号生成，同时运行的多个从机互不相同
+    __uid = 0x48530000U | ((uint32_t)getpid() & 0xFFFF);
+    parse_addr("239.255.42.1", __air_group);
+    parse_addr("127.0.0.1", __backend_addr);
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", options, nullptr)) != -1) {
+        bool ok = true;
+        switch (opt) {
+            case 'u': {
+                char* end;
+                __uid = strtoul(optarg, &end, 16);
+                ok = *optarg != '\0' && *end == '\0';
+                break;
+            }
+            case 'a': {
+                char group[INET_ADDRSTRLEN];
+                const char* colon = strchr(optarg, ':');
+                size_t len = colon ? colon - optarg : strlen(optarg);
+                ok = len < sizeof(group);
+                if (ok) {
+                    memcpy(group, optarg, len);
+                    group[len] = '\0';
+                    ok = parse_addr(group, __air_group);
+                }
+                if (ok && colon != nullptr) {
+                    __air_port = atoi(colon + 1);
+                    ok = __air_port != 0;
+                }
+                break;
+            }
+            case 'b':
+                ok = parse_addr(optarg, __backend_addr);
+                break;
+            case 'l':
+                ok = parse_addr(optarg, __bind_addr);
+                break;
+            case 'r':
+                __uci_record = optarg;
+                break;
+            default:
+                ok = false;
+                break;
+        }
+        if (!ok) {
+            usage(argv[0]);
+            exit(opt == 'h' ? 0 : 2);
+        }
+    }
+}
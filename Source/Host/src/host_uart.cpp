@@ -0,0 +1,39 @@
+#include "host_uart.hpp"
+
+#include <unistd.h>
+
+#include <cerrno>
+
+UasrtInfo usart0_info = {"USART0", -1};
+UasrtInfo usart0_info_PA9PA10 = {"USART0", -1};
+UasrtInfo usart1_info = {"USART1", -1};
+UasrtInfo usart2_info = {"USART2", -1};
+UasrtInfo uart3_info = {"UART3", STDOUT_FILENO};
+UasrtInfo usart5_info = {"USART5", -1};
+UasrtInfo uart6_info = {"UART6", -1};
+UasrtInfo uart7_info = {"UART7", STDOUT_FILENO};
+
+Uart::Uart(UartConfig& config) : config(config) {
+    // 接收完成信号量不会被释放，只供轮询的任务取用
+    if (config.use_dma && config.info.dmaRxDoneSema == nullptr) {
+        config.info.dmaRxDoneSema = xSemaphoreCreateBinary();
+    }
+}
+
+void Uart::send(const uint8_t* data, uint16_t len) {
+    if (config.info.fd < 0) {
+        return;
+    }
+    // 调度器以信号切换任务，write可能被打断
+    while (len > 0) {
+        ssize_t n = write(config.info.fd, data, len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += n;
+        len -= n;
+    }
+}
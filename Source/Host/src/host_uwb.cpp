@@ -0,0 +1,247 @@
+#include "host_uwb.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "host_sim.hpp"
+
+HostUwbInterface::~HostUwbInterface() {
+    if (sock >= 0) {
+        close(sock);
+    }
+    if (record != nullptr) {
+        fclose(record);
+    }
+}
+
+void HostUwbInterface::commuication_peripheral_init() {
+    if (HostSim::uci_record() != nullptr) {
+        record = fopen(HostSim::uci_record(), "wb");
+        if (record == nullptr) {
+            LOG_E("uwb", "open %s failed, errno %d", HostSim::uci_record(),
+                  errno);
+        }
+    }
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) {
+        LOG_E("uwb", "air socket create failed, errno %d", errno);
+        return;
+    }
+    int on = 1;
+    in_addr loopback = {htonl(INADDR_LOOPBACK)};
+    ip_mreq mreq = {};
+    mreq.imr_multiaddr.s_addr = HostSim::air_group();
+    mreq.imr_interface = loopback;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(HostSim::air_port());
+    addr.sin_addr.s_addr = HostSim::air_group();
+    // 同一台主机上的多个进程绑定同一组播端口
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+        bind(sock, (sockaddr*)&addr, sizeof(addr)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+                   sizeof(mreq)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &loopback,
+                   sizeof(loopback)) < 0 ||
+        setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &on, sizeof(on)) <
+            0) {
+        LOG_E("uwb", "air socket setup failed, errno %d", errno);
+        close(sock);
+        sock = -1;
+        return;
+    }
+    air_buf.resize(AIR_HEADER + CX_APP_DATA_TX_MAX_PAYLOAD_LEN);
+    LOG_I("uwb", "air %s:%u, uid %08lX", inet_ntoa(mreq.imr_multiaddr),
+          HostSim::air_port(), (unsigned long)HostSim::uid());
+}
+
+bool HostUwbInterface::send(PoolVector<uint8_t>& tx_data) {
+    // 模块未上电，命令丢失
+    if (!powered) {
+        return true;
+    }
+    // 分段命令的每一段都有响应，最后一段收齐后执行
+    if (tx_data.size() >= UCI_CTRL_PKT_HDR_SIZE &&
+        ((tx_data[0] >> 4) & 0x01) == PBF_SEGMENT) {
+        __reply_status(MT_RSP, tx_data[0] & 0x0F, tx_data[1] & 0x3F,
+                       STATUS_OK);
+    }
+    size_t pos = 0;
+    while (pos < tx_data.size()) {
+        pos += cmd.parse(tx_data.data() + pos, tx_data.size() - pos);
+        if (cmd.ready()) {
+            __command();
+        }
+    }
+    return true;
+}
+
+uint16_t HostUwbInterface::get_recv_span(const uint8_t*& rx_data) {
+    if (rx_pos >= rx_buf.size()) {
+        rx_buf.clear();
+        rx_pos = 0;
+        // 已有的响应和通知取完后才从空口取下一帧
+        if (powered && rx_on) {
+            __air_recv();
+        }
+    }
+    rx_data = rx_buf.data() + rx_pos;
+    return std::min<size_t>(rx_buf.size() - rx_pos, UINT16_MAX);
+}
+
+void HostUwbInterface::__boot() {
+    __power_off();
+    powered = true;
+    __air_flush();
+    __reply_status(MT_NTF, GID0x00, CORE_DEVICE_STATUS_NTF,
+                   DEVICE_STATE_READY);
+}
+
+void HostUwbInterface::__power_off() {
+    powered = false;
+    rx_on = false;
+    rx_buf.clear();
+    rx_pos = 0;
+    cmd.reset();
+}
+
+void HostUwbInterface::__command() {
+    if (cmd.mt != MT_CMD) {
+        return;
+    }
+    if (cmd.gid == GID0x00) {
+        if (cmd.oid != CORE_DEVICE_RESET_CMD) {
+            __reply_status(MT_RSP, cmd.gid, cmd.oid, STATUS_UNKNOWN_OID);
+            return;
+        }
+        __reply_status(MT_RSP, GID0x00, CORE_DEVICE_RESET_RSP, STATUS_OK);
+        rx_on = false;
+        __air_flush();
+        __reply_status(MT_NTF, GID0x00, CORE_DEVICE_STATUS_NTF,
+                       DEVICE_STATE_READY);
+        return;
+    }
+    if (cmd.gid != GID0x03) {
+        __reply_status(MT_RSP, cmd.gid, cmd.oid, STATUS_UNKNOWN_GID);
+        return;
+    }
+    switch (cmd.oid) {
+        case CX_APP_DATA_TX_CMD: {
+            if (cmd.payload_len() > CX_APP_DATA_TX_MAX_PAYLOAD_LEN) {
+                __reply_status(MT_RSP, GID0x03, CX_APP_DATA_TX_RSP,
+                               STATUS_INVALID_MESSAGE_SIZE);
+                break;
+            }
+            __reply_status(MT_RSP, GID0x03, CX_APP_DATA_TX_RSP, STATUS_OK);
+            // 发送时模块离开接收模式
+            rx_on = false;
+            __air_send(cmd.payload(), cmd.payload_len());
+            __reply_status(MT_NTF, GID0x03, CX_APP_DATA_TX_NTF, STATUS_OK);
+            break;
+        }
+        case CX_APP_DATA_RX_CMD: {
+            __reply_status(MT_RSP, GID0x03, CX_APP_DATA_RX_RSP, STATUS_OK);
+            rx_on = true;
+            break;
+        }
+        case CX_APP_DATA_STOP_RX_CMD: {
+            __reply_status(MT_RSP, GID0x03, CX_APP_DATA_STOP_RX_RSP,
+                           STATUS_OK);
+            rx_on = false;
+            break;
+        }
+        default: {
+            __reply_status(MT_RSP, cmd.gid, cmd.oid, STATUS_UNKNOWN_OID);
+            break;
+        }
+    }
+}
+
+void HostUwbInterface::__reply(uint8_t mt, uint8_t gid, uint8_t oid,
+                               const uint8_t* payload, uint16_t len) {
+    out.mt = mt;
+    out.gid = gid;
+    out.oid = oid;
+    bool last;
+    do {
+        last = out.build_packet(payload, len);
+        rx_buf.insert(rx_buf.end(), out.packet.begin(), out.packet.end());
+        if (record != nullptr) {
+            // 仿真进程通常由信号结束，逐包刷新
+            fwrite(out.packet.data(), 1, out.packet.size(), record);
+            fflush(record);
+        }
+    } while (!last);
+}
+
+void HostUwbInterface::__air_send(const uint8_t* data, uint16_t len) {
+    if (sock < 0) {
+        return;
+    }
+    uint32_t uid = HostSim::uid();
+    air_buf[0] = AIR_MAGIC & 0xFF;
+    air_buf[1] = AIR_MAGIC >> 8;
+    for (int i = 0; i < 4; i++) {
+        air_buf[2 + i] = uid >> (8 * i);
+    }
+    memcpy(air_buf.data() + AIR_HEADER, data, len);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(HostSim::air_port());
+    addr.sin_addr.s_addr = HostSim::air_group();
+    while (sendto(sock, air_buf.data(), AIR_HEADER + len, MSG_DONTWAIT,
+                  (sockaddr*)&addr, sizeof(addr)) < 0) {
+        if (errno != EINTR) {
+            LOG_W("uwb", "air send failed, errno %d", errno);
+            break;
+        }
+    }
+}
+
+bool HostUwbInterface::__air_recv() {
+    if (sock < 0) {
+        return false;
+    }
+    for (;;) {
+        ssize_t n = recv(sock, air_buf.data(), air_buf.size(), MSG_DONTWAIT);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n < AIR_HEADER) {
+            continue;
+        }
+        uint16_t magic = air_buf[0] | air_buf[1] << 8;
+        uint32_t src = 0;
+        for (int i = 0; i < 4; i++) {
+            src |= (uint32_t)air_buf[2 + i] << (8 * i);
+        }
+        if (magic != AIR_MAGIC || src == HostSim::uid()) {
+            continue;
+        }
+        // 接收通知负载为数据长度(小端)和数据，长度就地写在帧头末尾
+        uint16_t len = n - AIR_HEADER;
+        air_buf[AIR_HEADER - 2] = len & 0xFF;
+        air_buf[AIR_HEADER - 1] = len >> 8;
+        __reply(MT_NTF, GID0x03, CX_APP_DATA_RX_NTF,
+                air_buf.data() + AIR_HEADER - 2, len + 2);
+        return true;
+    }
+}
+
+void HostUwbInterface::__air_flush() {
+    if (sock < 0) {
+        return;
+    }
+    while (recv(sock, air_buf.data(), air_buf.size(), MSG_DONTWAIT) >= 0 ||
+           errno == EINTR) {
+    }
+}
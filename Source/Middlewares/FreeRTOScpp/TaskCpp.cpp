@@ -33,7 +33,7 @@
  */
 
 
-#include "TaskCpp.h"
+#include "TaskCPP.h"
 
 #if FREERTOSCPP_USE_NAMESPACE
 using namespace FreeRTOScpp;
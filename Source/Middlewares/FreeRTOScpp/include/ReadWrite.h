@@ -39,7 +39,7 @@
 #ifndef READWRITE_H
 #define READWRITE_H
 
-#include "EventCpp.h"
+#include "EventCPP.h"
 #include "TaskCPP.h"
 #include "Lock.h"
 